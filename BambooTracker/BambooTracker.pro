@@ -129,6 +129,7 @@ SOURCES += \
     command/pattern/change_values_in_pattern_command.cpp \
     command/pattern/paste_insert_copied_data_to_pattern_command.cpp \
     command/pattern/pattern_command_utils.cpp \
+    command/pattern/pattern_cell_block.cpp \
     command/pattern/transpose_note_in_pattern_command.cpp \
     gui/bookmark_manager_form.cpp \
     gui/color_palette_handler.cpp \
@@ -155,6 +156,9 @@ SOURCES += \
     gui/transpose_song_dialog.cpp \
     instrument/waveform_adpcm.cpp \
     io/wav_container.cpp \
+    io/wav_writer.cpp \
+    io/wav_reader.cpp \
+    io/adpcm_sample_importer.cpp \
     main.cpp \
     gui/mainwindow.cpp \
     chips/chip.cpp \
@@ -169,6 +173,8 @@ SOURCES += \
     bamboo_tracker.cpp \
     module/effect.cpp \
     playback.cpp \
+    offline_renderer.cpp \
+    stem_exporter.cpp \
     song_length_calculator.cpp \
     stream/audio_stream.cpp \
     jam_manager.cpp \
@@ -190,10 +196,12 @@ SOURCES += \
     instrument/instrument.cpp \
     instrument/envelope_fm.cpp \
     gui/event_guard.cpp \
+    gui/glyph_atlas.cpp \
     stream/audio_stream_rtaudio.cpp \
     tick_counter.cpp \
     module/module.cpp \
     module/song.cpp \
+    module/song_timeline.cpp \
     module/pattern.cpp \
     module/track.cpp \
     module/step.cpp \
@@ -201,6 +209,7 @@ SOURCES += \
     gui/order_list_editor/order_list_editor.cpp \
     gui/pattern_editor/pattern_editor_panel.cpp \
     gui/pattern_editor/pattern_editor.cpp \
+    gui/pattern_editor/pattern_clipboard.cpp \
     gui/instrument_editor/instrument_editor_ssg_form.cpp \
     gui/command/pattern/set_key_off_to_step_qt_command.cpp \
     command/pattern/set_key_off_to_step_command.cpp \
@@ -315,6 +324,7 @@ HEADERS += \
     command/pattern/change_values_in_pattern_command.hpp \
     command/pattern/paste_insert_copied_data_to_pattern_command.hpp \
     command/pattern/pattern_command_utils.hpp \
+    command/pattern/pattern_cell_block.hpp \
     command/pattern/transpose_note_in_pattern_command.hpp \
     enum_hash.hpp \
     gui/bookmark_manager_form.hpp \
@@ -353,18 +363,27 @@ HEADERS += \
     chips/chip.hpp \
     chips/opna.hpp \
     chips/resampler.hpp \
+    chips/register_write_queue.hpp \
+    chips/dsp_kernel.hpp \
     bamboo_tracker.hpp \
     gui/swap_tracks_dialog.hpp \
     gui/track_visibility_memory_handler.hpp \
     gui/transpose_song_dialog.hpp \
     instrument/waveform_adpcm.hpp \
     io/wav_container.hpp \
+    io/wav_writer.hpp \
+    io/wav_reader.hpp \
+    io/adpcm_sample_importer.hpp \
     module/effect.hpp \
     playback.hpp \
+    offline_renderer.hpp \
+    stem_exporter.hpp \
     song_length_calculator.hpp \
     stream/audio_stream.hpp \
     chips/chip_def.h \
     jam_manager.hpp \
+    jam_event_queue.hpp \
+    spsc_queue.hpp \
     misc.hpp \
     pitch_converter.hpp \
     instrument/instruments_manager.hpp \
@@ -386,10 +405,12 @@ HEADERS += \
     instrument/instrument.hpp \
     instrument/envelope_fm.hpp \
     gui/event_guard.hpp \
+    gui/glyph_atlas.hpp \
     stream/audio_stream_rtaudio.hpp \
     tick_counter.hpp \
     module/module.hpp \
     module/song.hpp \
+    module/song_timeline.hpp \
     module/pattern.hpp \
     module/track.hpp \
     module/step.hpp \
@@ -397,6 +418,7 @@ HEADERS += \
     gui/order_list_editor/order_list_editor.hpp \
     gui/pattern_editor/pattern_editor_panel.hpp \
     gui/pattern_editor/pattern_editor.hpp \
+    gui/pattern_editor/pattern_clipboard.hpp \
     gui/instrument_editor/instrument_editor_ssg_form.hpp \
     gui/command/pattern/set_key_off_to_step_qt_command.hpp \
     command/pattern/set_key_off_to_step_command.hpp \
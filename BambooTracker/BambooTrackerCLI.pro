@@ -0,0 +1,163 @@
+#-------------------------------------------------
+#
+# Headless renderer of BambooTracker modules
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = BambooTrackerCLI
+TEMPLATE = app
+CONFIG += console c++14
+CONFIG -= app_bundle qt
+
+isEmpty(PREFIX) {
+    win32:PREFIX = C:/BambooTracker
+    else:PREFIX = /usr/local
+}
+INSTALLS += target
+win32|install_flat {
+    target.path = $$PREFIX
+}
+else {
+    target.path = $$PREFIX/bin
+}
+
+# C/C++ compiler flags
+msvc {
+  CPP_WARNING_FLAGS += /Wall /Wp64 /WX
+  CPP_WARNING_FLAGS += /source-charset:utf-8
+}
+else:clang|if(gcc:!intel_icc) {
+  CPP_WARNING_FLAGS += -Wall -Wextra -Werror -pedantic -pedantic-errors
+  QMAKE_CFLAGS += -std=gnu11
+}
+QMAKE_CFLAGS_WARN_ON += $$CPP_WARNING_FLAGS
+QMAKE_CXXFLAGS_WARN_ON += $$CPP_WARNING_FLAGS
+
+unix:LIBS += -lpthread
+
+SOURCES += \
+    cli/render_main.cpp \
+    cli/benchmark.cpp \
+    cli/timeline_check.cpp \
+    batch_exporter.cpp \
+    offline_renderer.cpp \
+    stem_exporter.cpp \
+    opna_controller.cpp \
+    playback.cpp \
+    tick_counter.cpp \
+    song_length_calculator.cpp \
+    pitch_converter.cpp \
+    chips/chip.cpp \
+    chips/opna.cpp \
+    chips/resampler.cpp \
+    chips/export_container.cpp \
+    chips/c86ctl/c86ctl_wrapper.cpp \
+    chips/mame/2608intf.c \
+    chips/mame/emu2149.c \
+    chips/mame/fm.c \
+    chips/mame/ymdeltat.c \
+    chips/nuked/nuke2608intf.c \
+    chips/nuked/ym3438.c \
+    format/wopn_file.c \
+    instrument/abstract_instrument_property.cpp \
+    instrument/bank.cpp \
+    instrument/command_sequence.cpp \
+    instrument/effect_iterator.cpp \
+    instrument/envelope_fm.cpp \
+    instrument/instrument.cpp \
+    instrument/instruments_manager.cpp \
+    instrument/lfo_fm.cpp \
+    instrument/waveform_adpcm.cpp \
+    io/bank_io.cpp \
+    io/binary_container.cpp \
+    io/export_handler.cpp \
+    io/file_io.cpp \
+    io/instrument_io.cpp \
+    io/module_io.cpp \
+    io/wav_container.cpp \
+    io/wav_writer.cpp \
+    module/effect.cpp \
+    module/groove.cpp \
+    module/module.cpp \
+    module/pattern.cpp \
+    module/song.cpp \
+    module/song_timeline.cpp \
+    module/step.cpp \
+    module/track.cpp
+
+HEADERS += \
+    cli/benchmark.hpp \
+    cli/timeline_check.hpp \
+    batch_exporter.hpp \
+    offline_renderer.hpp \
+    stem_exporter.hpp \
+    opna_controller.hpp \
+    playback.hpp \
+    tick_counter.hpp \
+    song_length_calculator.hpp \
+    pitch_converter.hpp \
+    enum_hash.hpp \
+    misc.hpp \
+    version.hpp \
+    spsc_queue.hpp \
+    chips/chip.hpp \
+    chips/chip_def.h \
+    chips/chip_misc.hpp \
+    chips/opna.hpp \
+    chips/resampler.hpp \
+    chips/register_write_queue.hpp \
+    chips/dsp_kernel.hpp \
+    chips/export_container.hpp \
+    chips/c86ctl/c86ctl.h \
+    chips/c86ctl/c86ctl_wrapper.hpp \
+    chips/scci/SCCIDefines.hpp \
+    chips/scci/scci.hpp \
+    chips/codec/ymb_codec.hpp \
+    chips/mame/2608intf.h \
+    chips/mame/emu2149.h \
+    chips/mame/emutypes.h \
+    chips/mame/fm.h \
+    chips/mame/mamedef.h \
+    chips/mame/ymdeltat.h \
+    chips/nuked/nuke2608intf.h \
+    chips/nuked/ym3438.h \
+    format/wopn_file.h \
+    instrument/abstract_instrument_property.hpp \
+    instrument/bank.hpp \
+    instrument/command_sequence.hpp \
+    instrument/effect_iterator.hpp \
+    instrument/envelope_fm.hpp \
+    instrument/instrument.hpp \
+    instrument/instruments_manager.hpp \
+    instrument/lfo_fm.hpp \
+    instrument/sequence_iterator_interface.hpp \
+    instrument/waveform_adpcm.hpp \
+    io/bank_io.hpp \
+    io/binary_container.hpp \
+    io/export_handler.hpp \
+    io/file_io.hpp \
+    io/file_io_error.hpp \
+    io/gd3_tag.hpp \
+    io/instrument_io.hpp \
+    io/module_io.hpp \
+    io/s98_tag.hpp \
+    io/wav_container.hpp \
+    io/wav_writer.hpp \
+    module/effect.hpp \
+    module/groove.hpp \
+    module/module.hpp \
+    module/pattern.hpp \
+    module/song.hpp \
+    module/song_timeline.hpp \
+    module/step.hpp \
+    module/track.hpp
+
+INCLUDEPATH += \
+    $$PWD/chips \
+    $$PWD/stream \
+    $$PWD/instrument \
+    $$PWD/command \
+    $$PWD/module \
+    $$PWD/io
@@ -28,6 +28,8 @@
 #include <utility>
 #include <unordered_set>
 #include <exception>
+#include <future>
+#include <stdexcept>
 #include <unordered_map>
 #include "commands.hpp"
 #include "io_handlers.hpp"
@@ -38,8 +40,11 @@ const uint32_t BambooTracker::CHIP_CLOCK = 3993600 * 2;
 
 BambooTracker::BambooTracker(std::weak_ptr<Configuration> config)
 	: instMan_(std::make_shared<InstrumentsManager>(config.lock()->getOverwriteUnusedUneditedPropety())),
+	  midiJamEvents_(MIDI_JAM_QUEUE_SIZE_),
 	  tickCounter_(std::make_shared<TickCounter>()),
 	  mod_(std::make_shared<Module>()),
+	  isLoadingModule_(false),
+	  loadProgress_(0),
 	  curOctave_(4),
 	  curSongNum_(0),
 	  curTrackNum_(0),
@@ -51,8 +56,9 @@ BambooTracker::BambooTracker(std::weak_ptr<Configuration> config)
 	  mkStep_(-1),
 	  isFollowPlay_(true)
 {
+	emu_ = static_cast<chip::Emu>(config.lock()->getEmulator());
 	opnaCtrl_ = std::make_shared<OPNAController>(
-					static_cast<chip::Emu>(config.lock()->getEmulator()),
+					emu_,
 					CHIP_CLOCK,
 					config.lock()->getSampleRate(),
 					config.lock()->getBufferLength());
@@ -68,6 +74,12 @@ BambooTracker::BambooTracker(std::weak_ptr<Configuration> config)
 
 	storeOnlyUsedSamples_ = config.lock()->getWriteOnlyUsedSamples();
 	volFMReversed_ = config.lock()->getReverseFMVolumeOrder();
+	updateMidiJamStatus();
+}
+
+BambooTracker::~BambooTracker()
+{
+	if (loadThread_.joinable()) loadThread_.join();
 }
 
 /********** Change configuration **********/
@@ -84,6 +96,7 @@ void BambooTracker::changeConfiguration(std::weak_ptr<Configuration> config)
 	instMan_->setPropertyFindMode(config.lock()->getOverwriteUnusedUneditedPropety());
 	storeOnlyUsedSamples_ = config.lock()->getWriteOnlyUsedSamples();
 	volFMReversed_ = config.lock()->getReverseFMVolumeOrder();
+	updateMidiJamStatus();
 }
 
 /********** Current octave **********/
@@ -101,6 +114,7 @@ int BambooTracker::getCurrentOctave() const
 void BambooTracker::setCurrentVolume(int volume)
 {
 	curVolume_ = volume;
+	updateMidiJamStatus();
 }
 
 int BambooTracker::getCurrentVolume() const
@@ -112,6 +126,7 @@ int BambooTracker::getCurrentVolume() const
 void BambooTracker::setCurrentTrack(int num)
 {
 	curTrackNum_ = num;
+	updateMidiJamStatus();
 }
 
 TrackAttribute BambooTracker::getCurrentTrackAttribute() const
@@ -124,6 +139,7 @@ TrackAttribute BambooTracker::getCurrentTrackAttribute() const
 void BambooTracker::setCurrentInstrument(int n)
 {
 	curInstNum_ = n;
+	updateMidiJamStatus();
 }
 
 int BambooTracker::getCurrentInstrumentNumber() const
@@ -135,11 +151,13 @@ int BambooTracker::getCurrentInstrumentNumber() const
 void BambooTracker::addInstrument(int num, InstrumentType type, std::string name)
 {
 	comMan_.invoke(std::make_unique<AddInstrumentCommand>(instMan_, num, type, name));
+	updateMidiJamStatus();
 }
 
 void BambooTracker::removeInstrument(int num)
 {
 	comMan_.invoke(std::make_unique<RemoveInstrumentCommand>(instMan_, num));
+	updateMidiJamStatus();
 }
 
 std::unique_ptr<AbstractInstrument> BambooTracker::getInstrument(int num)
@@ -152,11 +170,13 @@ std::unique_ptr<AbstractInstrument> BambooTracker::getInstrument(int num)
 void BambooTracker::cloneInstrument(int num, int refNum)
 {
 	comMan_.invoke(std::make_unique<cloneInstrumentCommand>(instMan_, num, refNum));
+	updateMidiJamStatus();
 }
 
 void BambooTracker::deepCloneInstrument(int num, int refNum)
 {
 	comMan_.invoke(std::make_unique<DeepCloneInstrumentCommand>(instMan_, num, refNum));
+	updateMidiJamStatus();
 }
 
 void BambooTracker::swapInstruments(int a, int b, bool patternChange)
@@ -169,6 +189,7 @@ void BambooTracker::loadInstrument(BinaryContainer& container, std::string path,
 	auto inst = InstrumentIO::loadInstrument(container, path, instMan_, instNum);
 	comMan_.invoke(std::make_unique<AddInstrumentCommand>(
 					   instMan_, std::unique_ptr<AbstractInstrument>(inst)));
+	updateMidiJamStatus();
 }
 
 void BambooTracker::saveInstrument(BinaryContainer& container, int instNum)
@@ -181,6 +202,7 @@ void BambooTracker::importInstrument(const AbstractBank &bank, size_t index, int
 	auto inst = bank.loadInstrument(index, instMan_, instNum);
 	comMan_.invoke(std::make_unique<AddInstrumentCommand>(
 					   instMan_, std::unique_ptr<AbstractInstrument>(inst)));
+	updateMidiJamStatus();
 }
 
 void BambooTracker::exportInstruments(BinaryContainer& container, std::vector<int> instNums)
@@ -201,6 +223,7 @@ void BambooTracker::setInstrumentName(int num, std::string name)
 void BambooTracker::clearAllInstrument()
 {
 	instMan_->clearAll();
+	updateMidiJamStatus();
 }
 
 std::vector<int> BambooTracker::getInstrumentIndices() const
@@ -934,6 +957,8 @@ void BambooTracker::setCurrentSongNumber(int num)
 		muteState_[pair.first] = std::vector<bool>(pair.second, false);
 		for (int i = 0; i < pair.second; ++i) opnaCtrl_->setMuteState(pair.first, i, false);
 	}
+
+	updateMidiJamStatus();
 }
 
 /********** Order edit **********/
@@ -962,11 +987,18 @@ void BambooTracker::setCurrentStepNumber(int num)
 void BambooTracker::undo()
 {
 	comMan_.undo();
+	updateMidiJamStatus();
 }
 
 void BambooTracker::redo()
 {
 	comMan_.redo();
+	updateMidiJamStatus();
+}
+
+bool BambooTracker::canUndo() const
+{
+	return comMan_.canUndo();
 }
 
 void BambooTracker::clearCommandHistory()
@@ -974,9 +1006,20 @@ void BambooTracker::clearCommandHistory()
 	comMan_.clear();
 }
 
+void BambooTracker::setCommandHistoryMemoryBudget(size_t bytes)
+{
+	comMan_.setMemoryBudget(bytes);
+}
+
+CommandManager::Statistics BambooTracker::getCommandHistoryStatistics() const
+{
+	return comMan_.getStatistics();
+}
+
 /********** Jam mode **********/
 void BambooTracker::toggleJamMode()
 {
+	std::lock_guard<std::mutex> lock(jamMutex_);
 	if (jamMan_->toggleJamMode() && !isPlaySong()) {
 		jamMan_->polyphonic(true);
 	}
@@ -992,52 +1035,66 @@ bool BambooTracker::isJamMode() const
 
 void BambooTracker::jamKeyOn(JamKey key, bool volumeSet)
 {
+	std::lock_guard<std::mutex> lock(jamMutex_);
 	int keyNum = octaveAndNoteToNoteNumber(curOctave_, JamManager::jamKeyToNote(key));
 	const TrackAttribute& attrib = songStyle_.trackAttribs[static_cast<size_t>(curTrackNum_)];
-	funcJamKeyOn(key, keyNum, attrib, volumeSet);
+	funcJamKeyOn(key, keyNum, makeJamTarget(attrib, volumeSet));
 }
 
 void BambooTracker::jamKeyOn(int keyNum, bool volumeSet)
 {
+	std::lock_guard<std::mutex> lock(jamMutex_);
 	const TrackAttribute& attrib = songStyle_.trackAttribs[static_cast<size_t>(curTrackNum_)];
-	funcJamKeyOn(JamKey::MidiKey, keyNum, attrib, volumeSet);
+	funcJamKeyOn(JamKey::MidiKey, keyNum, makeJamTarget(attrib, volumeSet));
 }
 
 void BambooTracker::jamKeyOnForced(JamKey key, SoundSource src, bool volumeSet, std::shared_ptr<AbstractInstrument> inst)
 {
+	std::lock_guard<std::mutex> lock(jamMutex_);
 	int keyNum = octaveAndNoteToNoteNumber(curOctave_, JamManager::jamKeyToNote(key));
 	const TrackAttribute& attrib = songStyle_.trackAttribs[static_cast<size_t>(curTrackNum_)];
 	if (attrib.source == src) {
-		funcJamKeyOn(key, keyNum, attrib, volumeSet);
+		funcJamKeyOn(key, keyNum, makeJamTarget(attrib, volumeSet));
 	}
 	else {
 		auto it = std::find_if(songStyle_.trackAttribs.begin(), songStyle_.trackAttribs.end(),
 							   [src](TrackAttribute& attrib) { return attrib.source == src; });
-		funcJamKeyOn(key, keyNum, *it, volumeSet, inst);
+		funcJamKeyOn(key, keyNum, makeJamTarget(*it, volumeSet, inst));
 	}
 }
 
 void BambooTracker::jamKeyOnForced(int keyNum, SoundSource src, bool volumeSet, std::shared_ptr<AbstractInstrument> inst)
 {
+	std::lock_guard<std::mutex> lock(jamMutex_);
 	const TrackAttribute& attrib = songStyle_.trackAttribs[static_cast<size_t>(curTrackNum_)];
 	if (attrib.source == src) {
-		funcJamKeyOn(JamKey::MidiKey, keyNum, attrib, volumeSet);
+		funcJamKeyOn(JamKey::MidiKey, keyNum, makeJamTarget(attrib, volumeSet));
 	}
 	else {
 		auto it = std::find_if(songStyle_.trackAttribs.begin(), songStyle_.trackAttribs.end(),
 							   [src](TrackAttribute& attrib) { return attrib.source == src; });
-		funcJamKeyOn(JamKey::MidiKey, keyNum, *it, volumeSet, inst);
+		funcJamKeyOn(JamKey::MidiKey, keyNum, makeJamTarget(*it, volumeSet, inst));
 	}
 }
 
-void BambooTracker::funcJamKeyOn(JamKey key, int keyNum, const TrackAttribute& attrib, bool volumeSet,
-								 std::shared_ptr<AbstractInstrument> inst)
+JamTarget BambooTracker::makeJamTarget(const TrackAttribute& attrib, bool volumeSet,
+									   std::shared_ptr<AbstractInstrument> inst)
+{
+	if (!inst) {	// Use current instrument if not specified
+		inst = instMan_->getInstrumentSharedPtr(curInstNum_);
+	}
+	return { attrib, songStyle_.type, inst, volumeSet ? curVolume_ : -1, volFMReversed_ };
+}
+
+void BambooTracker::funcJamKeyOn(JamKey key, int keyNum, const JamTarget& target)
 {
 	if (playback_->isPlayingStep()) playback_->stopPlaySong();	// Reset
 
+	const TrackAttribute& attrib = target.attrib;
+	const int volume = target.volume;
 	if (attrib.source == SoundSource::RHYTHM) {
-		if (volumeSet)
-			opnaCtrl_->setVolumeRhythm(attrib.channelInSource, std::min(curVolume_, 0x1f));
+		if (volume >= 0)
+			opnaCtrl_->setVolumeRhythm(attrib.channelInSource, std::min(volume, 0x1f));
 		opnaCtrl_->setKeyOnFlagRhythm(attrib.channelInSource);
 		opnaCtrl_->updateRegisterStates();
 	}
@@ -1047,7 +1104,7 @@ void BambooTracker::funcJamKeyOn(JamKey key, int keyNum, const TrackAttribute& a
 			JamKeyData& offData = list[1];
 			switch (offData.source) {
 			case SoundSource::FM:
-				if (songStyle_.type == SongType::FM3chExpanded && offData.channelInSource == 2) {
+				if (target.songType == SongType::FM3chExpanded && offData.channelInSource == 2) {
 					opnaCtrl_->keyOffFM(2, true);
 					opnaCtrl_->keyOffFM(6, true);
 					opnaCtrl_->keyOffFM(7, true);
@@ -1068,9 +1125,7 @@ void BambooTracker::funcJamKeyOn(JamKey key, int keyNum, const TrackAttribute& a
 			}
 		}
 
-		if (!inst) {	// Use current instrument if not specified
-			inst = instMan_->getInstrumentSharedPtr(curInstNum_);
-		}
+		const std::shared_ptr<AbstractInstrument>& inst = target.inst;
 		JamKeyData& onData = list.front();
 
 		Note note;
@@ -1094,13 +1149,13 @@ void BambooTracker::funcJamKeyOn(JamKey key, int keyNum, const TrackAttribute& a
 		case SoundSource::FM:
 			if (auto fm = std::dynamic_pointer_cast<InstrumentFM>(inst))
 				opnaCtrl_->setInstrumentFM(onData.channelInSource, fm);
-			if (volumeSet) {
+			if (volume >= 0) {
 				int vol;
-				if (volFMReversed_) vol = (curVolume_ < 0x80) ? (0x7f - curVolume_) : 0;
-				else vol = std::min(curVolume_, 0x7f);
+				if (target.isFMVolumeReversed) vol = (volume < 0x80) ? (0x7f - volume) : 0;
+				else vol = std::min(volume, 0x7f);
 				opnaCtrl_->setVolumeFM(onData.channelInSource, vol);
 			}
-			if (songStyle_.type == SongType::FM3chExpanded && onData.channelInSource == 2) {
+			if (target.songType == SongType::FM3chExpanded && onData.channelInSource == 2) {
 				opnaCtrl_->keyOnFM(2, note, octave, pitch, true);
 				opnaCtrl_->keyOnFM(6, note, octave, pitch, true);
 				opnaCtrl_->keyOnFM(7, note, octave, pitch, true);
@@ -1113,8 +1168,8 @@ void BambooTracker::funcJamKeyOn(JamKey key, int keyNum, const TrackAttribute& a
 		case SoundSource::SSG:
 			if (auto ssg = std::dynamic_pointer_cast<InstrumentSSG>(inst))
 				opnaCtrl_->setInstrumentSSG(onData.channelInSource, ssg);
-			if (volumeSet)
-				opnaCtrl_->setVolumeSSG(onData.channelInSource, std::min(curVolume_, 0xf));
+			if (volume >= 0)
+				opnaCtrl_->setVolumeSSG(onData.channelInSource, std::min(volume, 0xf));
 			opnaCtrl_->keyOnSSG(onData.channelInSource, note, octave, pitch, true);
 			break;
 		case SoundSource::ADPCM:
@@ -1122,7 +1177,7 @@ void BambooTracker::funcJamKeyOn(JamKey key, int keyNum, const TrackAttribute& a
 				opnaCtrl_->setInstrumentADPCM(adpcm);
 			else if (auto kit = std::dynamic_pointer_cast<InstrumentDrumkit>(inst))
 				opnaCtrl_->setInstrumentDrumkit(kit);
-			if (volumeSet) opnaCtrl_->setVolumeADPCM(curVolume_);
+			if (volume >= 0) opnaCtrl_->setVolumeADPCM(volume);
 			opnaCtrl_->keyOnADPCM(note, octave, pitch, true);
 			break;
 		default:
@@ -1133,45 +1188,49 @@ void BambooTracker::funcJamKeyOn(JamKey key, int keyNum, const TrackAttribute& a
 
 void BambooTracker::jamKeyOff(JamKey key)
 {
+	std::lock_guard<std::mutex> lock(jamMutex_);
 	int keyNum = octaveAndNoteToNoteNumber(curOctave_, JamManager::jamKeyToNote(key));
 	const TrackAttribute& attrib = songStyle_.trackAttribs[static_cast<size_t>(curTrackNum_)];
-	funcJamKeyOff(key, keyNum, attrib);
+	funcJamKeyOff(key, keyNum, attrib, songStyle_.type);
 }
 
 void BambooTracker::jamKeyOff(int keyNum)
 {
+	std::lock_guard<std::mutex> lock(jamMutex_);
 	const TrackAttribute& attrib = songStyle_.trackAttribs[static_cast<size_t>(curTrackNum_)];
-	funcJamKeyOff(JamKey::MidiKey, keyNum, attrib);
+	funcJamKeyOff(JamKey::MidiKey, keyNum, attrib, songStyle_.type);
 }
 
 void BambooTracker::jamKeyOffForced(JamKey key, SoundSource src)
 {
+	std::lock_guard<std::mutex> lock(jamMutex_);
 	int keyNum = octaveAndNoteToNoteNumber(curOctave_, JamManager::jamKeyToNote(key));
 	const TrackAttribute& attrib = songStyle_.trackAttribs[static_cast<size_t>(curTrackNum_)];
 	if (attrib.source == src) {
-		funcJamKeyOff(key, keyNum, attrib);
+		funcJamKeyOff(key, keyNum, attrib, songStyle_.type);
 	}
 	else {
 		auto it = std::find_if(songStyle_.trackAttribs.begin(), songStyle_.trackAttribs.end(),
 							   [src](TrackAttribute& attrib) { return attrib.source == src; });
-		funcJamKeyOff(key, keyNum, *it);
+		funcJamKeyOff(key, keyNum, *it, songStyle_.type);
 	}
 }
 
 void BambooTracker::jamKeyOffForced(int keyNum, SoundSource src)
 {
+	std::lock_guard<std::mutex> lock(jamMutex_);
 	const TrackAttribute& attrib = songStyle_.trackAttribs[static_cast<size_t>(curTrackNum_)];
 	if (attrib.source == src) {
-		funcJamKeyOff(JamKey::MidiKey, keyNum, attrib);
+		funcJamKeyOff(JamKey::MidiKey, keyNum, attrib, songStyle_.type);
 	}
 	else {
 		auto it = std::find_if(songStyle_.trackAttribs.begin(), songStyle_.trackAttribs.end(),
 							   [src](TrackAttribute& attrib) { return attrib.source == src; });
-		funcJamKeyOff(JamKey::MidiKey, keyNum, *it);
+		funcJamKeyOff(JamKey::MidiKey, keyNum, *it, songStyle_.type);
 	}
 }
 
-void BambooTracker::funcJamKeyOff(JamKey key, int keyNum, const TrackAttribute& attrib)
+void BambooTracker::funcJamKeyOff(JamKey key, int keyNum, const TrackAttribute& attrib, SongType songType)
 {
 	if (attrib.source == SoundSource::RHYTHM) {
 		opnaCtrl_->setKeyOffFlagRhythm(attrib.channelInSource);
@@ -1183,7 +1242,7 @@ void BambooTracker::funcJamKeyOff(JamKey key, int keyNum, const TrackAttribute&
 		if (data.channelInSource > -1) {	// Key still sound
 			switch (data.source) {
 			case SoundSource::FM:
-				if (songStyle_.type == SongType::FM3chExpanded && data.channelInSource == 2) {
+				if (songType == SongType::FM3chExpanded && data.channelInSource == 2) {
 					opnaCtrl_->keyOffFM(2, true);
 					opnaCtrl_->keyOffFM(6, true);
 					opnaCtrl_->keyOffFM(7, true);
@@ -1206,6 +1265,36 @@ void BambooTracker::funcJamKeyOff(JamKey key, int keyNum, const TrackAttribute&
 	}
 }
 
+bool BambooTracker::queueMidiJamKeyEvent(int keyNum, bool isKeyOn, bool isForced, SoundSource src, bool volumeSet)
+{
+	auto status = std::atomic_load(&midiJamStatus_);
+	if (!status) return false;
+
+	const std::vector<TrackAttribute>& attribs = status->style.trackAttribs;
+	if (status->track < 0 || static_cast<size_t>(status->track) >= attribs.size()) return false;
+	auto it = attribs.begin() + status->track;
+	if (isForced && it->source != src) {
+		it = std::find_if(attribs.begin(), attribs.end(),
+						  [src](const TrackAttribute& a) { return a.source == src; });
+		if (it == attribs.end()) return false;
+	}
+
+	JamTarget target = { *it, status->style.type, status->inst,
+						 volumeSet ? status->volume : -1, status->isFMVolumeReversed };
+	return midiJamEvents_.push({ std::chrono::steady_clock::now(), keyNum, isKeyOn, target });
+}
+
+void BambooTracker::updateMidiJamStatus()
+{
+	auto status = std::make_shared<MidiJamStatus>();
+	status->style = songStyle_;
+	status->track = curTrackNum_;
+	status->inst = instMan_->getInstrumentSharedPtr(curInstNum_);
+	status->volume = curVolume_;
+	status->isFMVolumeReversed = volFMReversed_;
+	std::atomic_store(&midiJamStatus_, std::shared_ptr<const MidiJamStatus>(std::move(status)));
+}
+
 std::vector<std::vector<size_t>> BambooTracker::assignADPCMBeforeForcedJamKeyOn(std::shared_ptr<AbstractInstrument> inst)
 {
 	switch (inst->getType()) {
@@ -1290,7 +1379,10 @@ void BambooTracker::playStep()
 
 void BambooTracker::startPlay()
 {
-	jamMan_->polyphonic(false);
+	{
+		std::lock_guard<std::mutex> lock(jamMutex_);
+		jamMan_->polyphonic(false);
+	}
 
 	for (auto& pair : muteState_) {
 		for (size_t i = 0; i < pair.second.size(); ++i) {
@@ -1302,7 +1394,10 @@ void BambooTracker::startPlay()
 void BambooTracker::stopPlaySong()
 {
 	playback_->stopPlaySong();
-	jamMan_->polyphonic(true);
+	{
+		std::lock_guard<std::mutex> lock(jamMutex_);
+		jamMan_->polyphonic(true);
+	}
 
 	for (auto& pair : muteState_) {
 		for (size_t i = 0; i < pair.second.size(); ++i) {
@@ -1379,272 +1474,64 @@ int BambooTracker::getMarkerStep() const
 }
 
 /********** Export **********/
-bool BambooTracker::exportToWav(WavContainer& container, int loopCnt, std::function<bool()> bar)
-{
-	int tmpRate = opnaCtrl_->getRate();
-	opnaCtrl_->setRate(static_cast<int>(container.getSampleRate()));
-	size_t sampCnt = static_cast<size_t>(opnaCtrl_->getRate() * opnaCtrl_->getDuration() / 1000);
-	size_t intrCnt = static_cast<size_t>(opnaCtrl_->getRate()) / mod_->getTickFrequency();
-	size_t intrCntRest = 0;
-	std::vector<int16_t> dumbuf(sampCnt << 1);
-
-	int endOrder = 0;
-	int endStep = 0;
-	size_t dummy = 0;
-	checkNextPositionOfLastStepAndStepSize(curSongNum_, endOrder, endStep, dummy, dummy);
-	bool endFlag = false;
-	bool tmpFollow = std::exchange(isFollowPlay_, false);
-	std::shared_ptr<chip::WavExportContainer> exCntr = std::make_shared<chip::WavExportContainer>();
-	opnaCtrl_->setExportContainer(exCntr);
-	startPlayFromStart();
-
-	while (true) {
-		size_t sampCntRest = sampCnt;
-		while (sampCntRest) {
-			if (!intrCntRest) {	// Interruption
-				intrCntRest = intrCnt;    // Set counts to next interruption
-
-				if (!streamCountUp()) {
-					if (bar()) {	// Update lambda function
-						stopPlaySong();
-						isFollowPlay_ = tmpFollow;
-						return false;
-					}
-
-					int playOrder = playback_->getPlayingOrderNumber();
-					int playStep = playback_->getPlayingStepNumber();
-					if ((playOrder == -1 && playStep == -1)
-							|| (playOrder == endOrder && playStep == endStep && !(loopCnt--))){
-						endFlag = true;
-						break;
-					}
-				}
-			}
-
-			size_t count = std::min(intrCntRest, sampCntRest);
-			sampCntRest -= count;
-			intrCntRest -= count;
-
-			opnaCtrl_->getStreamSamples(&dumbuf[0], count);
-		}
-
-		if (endFlag) break;
-	}
-
-	opnaCtrl_->setExportContainer();
-	stopPlaySong();
-	isFollowPlay_ = tmpFollow;
-	opnaCtrl_->setRate(tmpRate);
-
-	container.storeSample(exCntr->getStream());
-
-	return true;
+bool BambooTracker::exportToWav(WavWriter& writer, int loopCnt, std::function<bool()> bar)
+{
+	std::unique_ptr<OfflineRenderer> renderer = createOfflineRenderer();
+	return renderer->renderToWav(writer, loopCnt, bar);
 }
 
 bool BambooTracker::exportToVgm(BinaryContainer& container, int target, bool gd3TagEnabled,
 								GD3Tag tag, std::function<bool()> bar)
 {
-	int tmpRate = opnaCtrl_->getRate();
-	opnaCtrl_->setRate(44100);
-	double dblIntrCnt = 44100.0 / static_cast<double>(mod_->getTickFrequency());
-	size_t intrCnt = static_cast<size_t>(dblIntrCnt);
-	double intrCntDiff = dblIntrCnt - intrCnt;
-	double intrCntRest = 0;
-	std::vector<int16_t> dumbuf((intrCnt + 1) << 1);
-
-	int loopOrder = 0;
-	int loopStep = 0;
-	size_t dummy = 0;
-	checkNextPositionOfLastStepAndStepSize(curSongNum_, loopOrder, loopStep, dummy, dummy);
-	bool loopFlag = (loopOrder != -1);
-	int endCnt = (loopOrder == -1) ? 0 : 1;
-	bool tmpFollow = std::exchange(isFollowPlay_, false);
-	uint32_t loopPoint = 0;
-	uint32_t loopPointSamples = 0;
-
-	std::shared_ptr<chip::VgmExportContainer> exCntr
-			= std::make_shared<chip::VgmExportContainer>(target, mod_->getTickFrequency());
-
-	// Set ADPCM
-	opnaCtrl_->clearSamplesADPCM();
-	std::vector<uint8_t> rom;
-	for (auto sampNum : instMan_->getSampleADPCMValidIndices()) {
-		std::vector<uint8_t> sample = instMan_->getSampleADPCMRawSample(sampNum);
-		std::vector<size_t> addresses = opnaCtrl_->storeSampleADPCM(sample);
-		instMan_->setSampleADPCMStartAddress(sampNum, addresses[0]);
-		instMan_->setSampleADPCMStopAddress(sampNum, addresses[1]);
-
-		rom.resize((addresses[1] + 1) << 5);
-		std::copy(sample.begin(), sample.end(), rom.begin() + static_cast<int>(addresses[0] << 5));
-	}
-	exCntr->setDataBlock(std::move(rom));
-
-	opnaCtrl_->setExportContainer(exCntr);
-	startPlayFromStart();
-	exCntr->forceMoveLoopPoint();
-
-	while (true) {
-		if (!streamCountUp()) {
-			if (bar()) {	// Update lambda function
-				stopPlaySong();
-				isFollowPlay_ = tmpFollow;
-				return false;
-			}
-
-			int playOrder = playback_->getPlayingOrderNumber();
-			int playStep = playback_->getPlayingStepNumber();
-			if (playOrder == loopOrder && playStep == loopStep && !(endCnt--)) break;
-
-			if (loopFlag && loopOrder == playOrder && loopStep == playStep) {
-				loopPoint = exCntr->setLoopPoint();
-				loopPointSamples = exCntr->getSampleLength();
-			}
-		}
-
-		intrCntRest += intrCntDiff;
-		size_t extraIntrCnt = static_cast<size_t>(intrCntRest);
-		intrCntRest -= extraIntrCnt;
-		opnaCtrl_->getStreamSamples(&dumbuf[0], intrCnt + extraIntrCnt);
-	}
-
-	opnaCtrl_->setExportContainer();
-	stopPlaySong();
-	isFollowPlay_ = tmpFollow;
-	opnaCtrl_->setRate(tmpRate);
-
-	try {
-		ExportHandler::writeVgm(container, target, exCntr->getData(), CHIP_CLOCK, mod_->getTickFrequency(),
-								loopFlag, loopPoint, exCntr->getSampleLength() - loopPointSamples,
-								exCntr->getSampleLength(), gd3TagEnabled, tag);
-		return true;
-	} catch (...) {
-		throw;
-	}
+	std::unique_ptr<OfflineRenderer> renderer = createOfflineRenderer();
+	return renderer->renderToVgm(container, target, gd3TagEnabled, tag, bar);
 }
 
 bool BambooTracker::exportToS98(BinaryContainer& container, int target, bool tagEnabled,
 								S98Tag tag, int rate, std::function<bool()> bar)
 {
-	int tmpRate = opnaCtrl_->getRate();
-	opnaCtrl_->setRate(rate);
-	double dblIntrCnt = static_cast<double>(rate) / static_cast<double>(mod_->getTickFrequency());
-	size_t intrCnt = static_cast<size_t>(dblIntrCnt);
-	double intrCntDiff = dblIntrCnt - intrCnt;
-	double intrCntRest = 0;
-	std::vector<int16_t> dumbuf((intrCnt + 1) << 1);
-
-	int loopOrder = 0;
-	int loopStep = 0;
-	size_t dummy = 0;
-	checkNextPositionOfLastStepAndStepSize(curSongNum_, loopOrder, loopStep, dummy, dummy);
-	bool loopFlag = (loopOrder != -1);
-	int endCnt = (loopOrder == -1) ? 0 : 1;
-	bool tmpFollow = std::exchange(isFollowPlay_, false);
-	uint32_t loopPoint = 0;
-	std::shared_ptr<chip::S98ExportContainer> exCntr = std::make_shared<chip::S98ExportContainer>(target);
-	opnaCtrl_->setExportContainer(exCntr);
-	startPlayFromStart();
-	assignSampleADPCMRawSamples();
-	exCntr->forceMoveLoopPoint();
-
-	while (true) {
-		exCntr->getData();	// Set wait counts
-		if (!streamCountUp()) {
-			if (bar()) {	// Update lambda function
-				stopPlaySong();
-				isFollowPlay_ = tmpFollow;
-				return false;
-			}
-
-			int playOrder = playback_->getPlayingOrderNumber();
-			int playStep = playback_->getPlayingStepNumber();
-			if (playOrder == loopOrder && playStep == loopStep && !(endCnt--)) break;
+	std::unique_ptr<OfflineRenderer> renderer = createOfflineRenderer();
+	return renderer->renderToS98(container, target, tagEnabled, tag, rate, bar);
+}
 
-			if (loopFlag && loopOrder == playOrder && loopStep == playStep) {
-				loopPoint = exCntr->setLoopPoint();
-			}
+std::unique_ptr<StemExporter> BambooTracker::createStemExporter() const
+{
+	// Each stem parses its own copy of the module
+	auto data = std::make_shared<BinaryContainer>();
+	ModuleIO::saveModule(*data, mod_, instMan_);
+	auto exporter = std::make_unique<StemExporter>(data, curSongNum_, emu_, opnaCtrl_->getDuration());
+	exporter->setStoreOnlyUsedSamples(storeOnlyUsedSamples_);
+	exporter->setMasterVolume(masterVol_);
+	exporter->setMasterVolumeFM(masterVolFM_);
+	exporter->setMasterVolumeSSG(masterVolSSG_);
+	for (auto& pair : muteState_) {
+		for (size_t i = 0; i < pair.second.size(); ++i) {
+			exporter->setMuteState(pair.first, static_cast<int>(i), pair.second[i]);
 		}
-
-		intrCntRest += intrCntDiff;
-		size_t extraIntrCnt = static_cast<size_t>(intrCntRest);
-		intrCntRest -= extraIntrCnt;
-		opnaCtrl_->getStreamSamples(&dumbuf[0], intrCnt + extraIntrCnt);
 	}
+	return exporter;
+}
 
-	opnaCtrl_->setExportContainer();
-	stopPlaySong();
-	isFollowPlay_ = tmpFollow;
-	opnaCtrl_->setRate(tmpRate);
-
-	try {
-		ExportHandler::writeS98(container, target, exCntr->getData(), CHIP_CLOCK, static_cast<uint32_t>(rate),
-								loopFlag, loopPoint, tagEnabled, tag);
-		return true;
-	} catch (...) {
-		throw;
+std::unique_ptr<OfflineRenderer> BambooTracker::createOfflineRenderer() const
+{
+	auto renderer = std::make_unique<OfflineRenderer>(*mod_, instMan_, curSongNum_,
+													  emu_, opnaCtrl_->getDuration());
+	renderer->setStoreOnlyUsedSamples(storeOnlyUsedSamples_);
+	renderer->setMasterVolume(masterVol_);
+	renderer->setMasterVolumeFM(masterVolFM_);
+	renderer->setMasterVolumeSSG(masterVolSSG_);
+	for (auto& pair : muteState_) {
+		for (size_t i = 0; i < pair.second.size(); ++i) {
+			renderer->setMuteState(pair.first, static_cast<int>(i), pair.second[i]);
+		}
 	}
+	return renderer;
 }
 
 void BambooTracker::checkNextPositionOfLastStepAndStepSize(int songNum, int& endOrder, int& endStep, size_t& nIntroStep, size_t& nLoopStep) const
 {
-	Song& song = mod_->getSong(songNum);
-	endOrder = 0;
-	endStep = 0;
-
-	int lastOrder = static_cast<int>(song.getOrderSize()) - 1;
-	std::unordered_map<int, int> orderStepMap;
-	int orderN = 0;
-	size_t stepCnt = 0;
-	do {
-		endOrder = (endOrder + 1) % (lastOrder + 1);
-		endStep = 0;
-
-		int stepN = static_cast<int>(getPatternSizeFromOrderNumber(songNum, orderN)) - 1;
-		for (auto attrib : songStyle_.trackAttribs) {
-			Step& step = song.getTrack(attrib.number).getPatternFromOrderNumber(orderN).getStep(stepN);
-			for (int i = 0; i < 4; ++i) {
-				Effect&& eff = Effect::makeEffectData(attrib.source, step.getEffectID(i), step.getEffectValue(i));
-				switch (eff.type) {
-				case EffectType::PositionJump:
-					if (eff.value <= lastOrder) {
-						endOrder = eff.value;
-						endStep = 0;
-					}
-					break;
-				case EffectType::SongEnd:
-					endOrder = -1;
-					endStep = -1;
-					break;
-				case EffectType::PatternBreak:
-					if (orderN == lastOrder
-							&& eff.value < static_cast<int>(getPatternSizeFromOrderNumber(songNum, 0))) {
-						endOrder = 0;
-						endStep = eff.value;
-					}
-					else if (eff.value < static_cast<int>(getPatternSizeFromOrderNumber(songNum, orderN + 1))) {
-						endOrder = orderN + 1;
-						endStep = eff.value;
-					}
-					break;
-				default:
-					break;
-				}
-			}
-		}
-
-		orderStepMap[orderN] = stepCnt;
-		stepCnt += song.getPatternSizeFromOrderNumber(orderN);
-		orderN = endOrder;
-	} while (orderN != -1 && !orderStepMap.count(orderN));	// stopped song or jumped to played order
-
-	if (orderN == -1) {
-		nIntroStep = stepCnt;
-		nLoopStep = 0;
-	}
-	else {
-		nIntroStep = orderStepMap[orderN];
-		nLoopStep = stepCnt - orderStepMap[orderN];
-	}
+	SongLengthCalculator calculator(*mod_.get(), songNum);
+	calculator.checkNextPositionOfLastStepAndStepSize(endOrder, endStep, nIntroStep, nLoopStep);
 }
 
 /********** Real chip interface **********/
@@ -1666,8 +1553,34 @@ RealChipInterface BambooTracker::getRealChipinterface() const
 }
 
 /********** Stream events **********/
-int BambooTracker::streamCountUp()
+int BambooTracker::streamCountUp(size_t offset)
+{
+	std::unique_lock<std::mutex> lock(loadMutex_, std::try_to_lock);
+	if (!lock.owns_lock()) return -1;	// The module loader is using the chip
+
+	return countUpStream(offset);
+}
+
+int BambooTracker::streamCountUpOnRealChip()
 {
+	std::unique_lock<std::mutex> lock(loadMutex_, std::try_to_lock);
+	if (!lock.owns_lock()) return -1;
+
+	int state = countUpStream(0);
+	opnaCtrl_->flushRegisterWrites();
+	return state;
+}
+
+void BambooTracker::getStreamSamples(float *container, size_t nSamples)
+{
+	std::unique_lock<std::mutex> lock(loadMutex_, std::try_to_lock);
+	if (lock.owns_lock()) opnaCtrl_->getStreamSamples(container, nSamples);
+	else std::fill_n(container, nSamples << 1, 0.f);	// Mute while a module is loaded
+}
+
+int BambooTracker::countUpStream(size_t offset)
+{
+	opnaCtrl_->setRegisterWriteOffset(offset);
 	int state = playback_->streamCountUp();
 	if (!state && isFollowPlay_ && !playback_->isPlayingStep()) {	// Step
 		int odr = playback_->getPlayingOrderNumber();
@@ -1679,14 +1592,50 @@ int BambooTracker::streamCountUp()
 	return state;
 }
 
-void BambooTracker::getStreamSamples(int16_t *container, size_t nSamples)
+void BambooTracker::streamMidiJamEvents(size_t offset, size_t nSamples,
+										std::chrono::steady_clock::time_point begin,
+										std::chrono::steady_clock::time_point end)
 {
-	opnaCtrl_->getStreamSamples(container, nSamples);
+	if (!nSamples) return;
+
+	std::unique_lock<std::mutex> lock(jamMutex_, std::try_to_lock);
+	if (!lock.owns_lock()) return;
+
+	std::unique_lock<std::mutex> loadLock(loadMutex_, std::try_to_lock);
+	if (!loadLock.owns_lock()) {	// Drop keys played while a module is loaded
+		while (const JamEvent* event = midiJamEvents_.front()) {
+			if (event->time > end) break;
+			midiJamEvents_.pop();
+		}
+		return;
+	}
+
+	const auto period = (end - begin).count();
+	while (const JamEvent* event = midiJamEvents_.front()) {
+		if (event->time > end) break;	// Play in the next block
+
+		size_t evOffset = 0;
+		if (event->time > begin && period > 0) {
+			auto pos = (event->time - begin).count() * static_cast<int64_t>(nSamples) / period;
+			evOffset = std::min(nSamples - 1, static_cast<size_t>(pos));
+		}
+		if (offset < nSamples && evOffset >= offset) break;
+
+		// The target was resolved when the event was queued
+		const JamTarget& target = event->target;
+		opnaCtrl_->setRegisterWriteOffset(evOffset);
+		funcJamKeyOff(JamKey::MidiKey, event->keyNum, target.attrib, target.songType);	// Possibility to recover on stuck note
+		if (event->isKeyOn) funcJamKeyOn(JamKey::MidiKey, event->keyNum, target);
+		midiJamEvents_.pop();
+	}
 }
 
 void BambooTracker::killSound()
 {
-	jamMan_->clear();
+	{
+		std::lock_guard<std::mutex> lock(jamMutex_);
+		jamMan_->clear();
+	}
 	opnaCtrl_->reset();
 }
 
@@ -1728,16 +1677,19 @@ bool BambooTracker::getStreamGrooveEnabled() const
 
 void BambooTracker::setMasterVolume(int percentage)
 {
+	masterVol_ = percentage;
 	opnaCtrl_->setMasterVolume(percentage);
 }
 
 void BambooTracker::setMasterVolumeFM(double dB)
 {
+	masterVolFM_ = dB;
 	opnaCtrl_->setMasterVolumeFM(dB);
 }
 
 void BambooTracker::setMasterVolumeSSG(double dB)
 {
+	masterVolSSG_ = dB;
 	opnaCtrl_->setMasterVolumeSSG(dB);
 }
 
@@ -1756,26 +1708,111 @@ void BambooTracker::makeNewModule()
 	tickCounter_->setInterruptRate(mod_->getTickFrequency());
 
 	setCurrentSongNumber(0);
-	curInstNum_ = -1;
+	setCurrentInstrument(-1);
 
 	clearCommandHistory();
 }
 
-void BambooTracker::loadModule(BinaryContainer& container)
+void BambooTracker::startLoadingModule(BinaryContainer container)
 {
-	makeNewModule();
+	if (isLoadingModule_.load()) throw std::logic_error("A module is already being loaded");
+	if (loadThread_.joinable()) loadThread_.join();	// Not finished by finishLoadingModule
 
-	std::exception_ptr ep;
-	try {
-		ModuleIO::loadModule(container, mod_, instMan_);
-	}
-	catch (...) {
-		ep = std::current_exception();
-	}
+	stopPlaySong();
 
-	tickCounter_->setInterruptRate(mod_->getTickFrequency());
-	setCurrentSongNumber(0);
-	clearCommandHistory();
+	loadedMod_ = std::make_shared<Module>();
+	loadedInstMan_ = std::make_shared<InstrumentsManager>(instMan_->getPropertyFindMode());
+	loadError_ = nullptr;
+	loadProgress_.store(0);
+	isLoadingModule_.store(true);
+
+	loadThread_ = std::thread([this, container = std::move(container)] {
+		{
+			std::lock_guard<std::mutex> lock(loadMutex_);
+			{
+				std::lock_guard<std::mutex> jamLock(jamMutex_);
+				jamMan_->clear();
+			}
+			opnaCtrl_->reset();
+			opnaCtrl_->clearSamplesADPCM();
+
+			// Write samples to the chip while the rest sections are parsed
+			std::vector<int> sampNums;
+			std::future<std::vector<std::vector<size_t>>> storing;
+			auto startStoring = [&] {
+				sampNums = storeOnlyUsedSamples_ ? loadedInstMan_->getSampleADPCMValidIndices()
+												 : loadedInstMan_->getSampleADPCMEntriedIndices();
+				std::vector<std::vector<uint8_t>> samples;
+				for (auto sampNum : sampNums)
+					samples.push_back(loadedInstMan_->getSampleADPCMRawSample(sampNum));
+				storing = std::async(std::launch::async, [this, samples = std::move(samples)]() mutable {
+					std::vector<std::vector<size_t>> addrs;
+					for (auto& sample : samples)
+						addrs.push_back(opnaCtrl_->storeSampleADPCM(std::move(sample)));
+					return addrs;
+				});
+			};
+
+			try {
+				bool hasInsts = false, hasProps = false;
+				ModuleIO::loadModule(container, loadedMod_, loadedInstMan_,
+									 [&](ModuleIO::Section section, size_t pos) {
+					loadProgress_.store(static_cast<int>(100 * pos / container.size()));
+					if (section == ModuleIO::Section::Instrument) hasInsts = true;
+					else if (section == ModuleIO::Section::InstrumentProperty) hasProps = true;
+					if (hasInsts && hasProps && !storing.valid()) startStoring();
+				});
+				if (!storing.valid()) startStoring();
+
+				std::vector<std::vector<size_t>> addrs = storing.get();
+				for (size_t i = 0; i < sampNums.size(); ++i) {
+					loadedInstMan_->setSampleADPCMStartAddress(sampNums[i], addrs[i][0]);
+					loadedInstMan_->setSampleADPCMStopAddress(sampNums[i], addrs[i][1]);
+				}
+			}
+			catch (...) {
+				if (storing.valid()) storing.wait();
+				loadError_ = std::current_exception();
+			}
+		}
+		isLoadingModule_.store(false);
+	});
+}
+
+bool BambooTracker::isLoadingModule() const
+{
+	return isLoadingModule_.load();
+}
+
+int BambooTracker::getModuleLoadingProgress() const
+{
+	return loadProgress_.load();
+}
+
+void BambooTracker::finishLoadingModule()
+{
+	if (loadThread_.joinable()) loadThread_.join();
+
+	std::exception_ptr ep = loadError_;
+	{
+		std::lock_guard<std::mutex> lock(loadMutex_);
+		if (ep) {
+			assignSampleADPCMRawSamples();	// Restore samples of the current module
+		}
+		else {
+			mod_ = loadedMod_;
+			instMan_ = loadedInstMan_;
+			playback_->setInstrumentsManager(instMan_);
+
+			tickCounter_->setInterruptRate(mod_->getTickFrequency());
+			setCurrentSongNumber(0);
+			setCurrentInstrument(-1);
+			clearCommandHistory();
+		}
+	}
+	loadedMod_.reset();
+	loadedInstMan_.reset();
+	loadError_ = nullptr;
 
 	if (ep) std::rethrow_exception(ep);
 }
@@ -2305,64 +2342,69 @@ void BambooTracker::deletePreviousStep(int songNum, int trackNum, int orderNum,
 }
 
 void BambooTracker::pastePatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
-									  std::vector<std::vector<std::string>> cells)
+									  PatternCellBlock cells)
 {
-	std::vector<std::vector<std::string>> d
-			= arrangePatternDataCells(songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(cells));
+	PatternCellBlock d = arrangePatternDataCells(songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(cells));
 
 	comMan_.invoke(std::make_unique<PasteCopiedDataToPatternCommand>(
 					   mod_, songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(d)));
 }
 
 void BambooTracker::pasteMixPatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
-										 std::vector<std::vector<std::string>> cells)
+										 PatternCellBlock cells)
 {
-	std::vector<std::vector<std::string>> d
-			= arrangePatternDataCells(songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(cells));
+	PatternCellBlock d = arrangePatternDataCells(songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(cells));
 
 	comMan_.invoke(std::make_unique<PasteMixCopiedDataToPatternCommand>(
 					   mod_, songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(d)));
 }
 
 void BambooTracker::pasteOverwritePatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder,
-											   int beginStep, std::vector<std::vector<std::string>> cells)
+											   int beginStep, PatternCellBlock cells)
 {
-	std::vector<std::vector<std::string>> d
-			= arrangePatternDataCells(songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(cells));
+	PatternCellBlock d = arrangePatternDataCells(songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(cells));
 
 	comMan_.invoke(std::make_unique<PasteOverwriteCopiedDataToPatternCommand>(
 					   mod_, songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(d)));
 }
 
 void BambooTracker::pasteInsertPatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder,
-											int beginStep, std::vector<std::vector<std::string>> cells)
+											int beginStep, PatternCellBlock cells)
 {
-	std::vector<std::vector<std::string>> d
-			= arrangePatternDataCells(songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(cells));
+	PatternCellBlock d = arrangePatternDataCells(songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(cells));
 
 	comMan_.invoke(std::make_unique<PasteInsertCopiedDataToPatternCommand>(
 					   mod_, songNum, beginTrack, beginColmn, beginOrder, beginStep, std::move(d)));
 }
 
-std::vector<std::vector<std::string>> BambooTracker::arrangePatternDataCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
-																			 std::vector<std::vector<std::string>> cells)
+PatternCellBlock BambooTracker::arrangePatternDataCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
+														PatternCellBlock cells)
 {
-	std::vector<std::vector<std::string>> d;
 	size_t w = (songStyle_.trackAttribs.size() - static_cast<size_t>(beginTrack) - 1) * 11
 			   + (11 - static_cast<size_t>(beginColmn));
 	size_t h = getPatternSizeFromOrderNumber(songNum, beginOrder) - static_cast<size_t>(beginStep);
 
-	size_t width = std::min(cells.at(0).size(), w);
-	size_t height = std::min(cells.size(), h);
+	size_t width = std::min(cells.getWidth(), w);
+	size_t height = std::min(cells.getHeight(), h);
+	if (width == cells.getWidth() && height == cells.getHeight()) return cells;	// Fit without clipping
 
+	std::vector<uint16_t> src = cells.unpack();
+	std::vector<uint16_t> d;
+	d.reserve(width * height);
 	for (size_t i = 0; i < height; ++i) {
-		d.emplace_back();
-		for (size_t j = 0; j < width; ++j) {
-			d.at(i).push_back(cells.at(i).at(j));
-		}
+		auto it = src.cbegin() + static_cast<int>(i * cells.getWidth());
+		d.insert(d.end(), it, it + static_cast<int>(width));
 	}
 
-	return d;
+	return PatternCellBlock(d, width, beginColmn);
+}
+
+PatternCellBlock BambooTracker::getPatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
+												int endTrack, int endColmn, int endStep)
+{
+	size_t w = static_cast<size_t>((endTrack * 11 + endColmn) - (beginTrack * 11 + beginColmn) + 1);
+	size_t h = static_cast<size_t>(endStep - beginStep + 1);
+	return PatternCellBlock(mod_->getSong(songNum), w, h, beginTrack, beginColmn, beginOrder, beginStep);
 }
 
 void BambooTracker::erasePatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
@@ -31,23 +31,33 @@
 #include <vector>
 #include <functional>
 #include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <chrono>
 #include "configuration.hpp"
 #include "opna_controller.hpp"
 #include "jam_manager.hpp"
+#include "jam_event_queue.hpp"
 #include "command_manager.hpp"
 #include "instruments_manager.hpp"
 #include "instrument.hpp"
 #include "tick_counter.hpp"
 #include "module.hpp"
 #include "song.hpp"
+#include "pattern/pattern_cell_block.hpp"
 #include "gd3_tag.hpp"
 #include "s98_tag.hpp"
 #include "chips/scci/scci.hpp"
 #include "chips/c86ctl/c86ctl_wrapper.hpp"
 #include "effect.hpp"
 #include "playback.hpp"
+#include "offline_renderer.hpp"
+#include "stem_exporter.hpp"
 #include "binary_container.hpp"
 #include "wav_container.hpp"
+#include "wav_writer.hpp"
 #include "enum_hash.hpp"
 #include "misc.hpp"
 
@@ -57,6 +67,7 @@ class BambooTracker
 {
 public:
 	explicit BambooTracker(std::weak_ptr<Configuration> config);
+	~BambooTracker();
 
 	// Change confuguration
 	void changeConfiguration(std::weak_ptr<Configuration> config);
@@ -255,7 +266,11 @@ public:
 	// Undo-Redo
 	void undo();
 	void redo();
+	bool canUndo() const;
 	void clearCommandHistory();
+	/// Set the upper limit of the bytes used by the undo history, 0 is unlimited
+	void setCommandHistoryMemoryBudget(size_t bytes);
+	CommandManager::Statistics getCommandHistoryStatistics() const;
 
 	// Jam mode
 	void toggleJamMode();
@@ -269,6 +284,11 @@ public:
 	void jamKeyOffForced(JamKey key, SoundSource src);
 	void jamKeyOffForced(int keyNum, SoundSource src);
 	std::vector<std::vector<size_t>> assignADPCMBeforeForcedJamKeyOn(std::shared_ptr<AbstractInstrument> inst);
+	/// Queue a key event from the MIDI input thread. It is played by the audio stream
+	/// at the sample position of its arrival instead of waiting for the GUI thread.
+	/// The key is released before it is pressed again, same as jamKeyOff and jamKeyOn by MIDI.
+	/// [src] is used if [isForced] is true. Return false if the queue is full.
+	bool queueMidiJamKeyEvent(int keyNum, bool isKeyOn, bool isForced, SoundSource src, bool volumeSet);
 
 	// Play song
 	void startPlaySong();
@@ -290,11 +310,13 @@ public:
 	int getMarkerStep() const;
 
 	// Export
-	bool exportToWav(WavContainer& container, int loopCnt, std::function<bool()> bar);
+	bool exportToWav(WavWriter& writer, int loopCnt, std::function<bool()> bar);
 	bool exportToVgm(BinaryContainer& container, int target, bool gd3TagEnabled,
 					 GD3Tag tag, std::function<bool()> bar);
 	bool exportToS98(BinaryContainer& container, int target, bool tagEnabled, S98Tag tag,
 					 int rate, std::function<bool()> bar);
+	/// Create an exporter of the current song with the mixer and mute settings of this session
+	std::unique_ptr<StemExporter> createStemExporter() const;
 
 	// Real chip interface
 	void useSCCI(scci::SoundInterfaceManager* manager);
@@ -305,8 +327,17 @@ public:
 	/// 0<: Tick
 	///  0: Step
 	/// -1: Stop
-	int streamCountUp();
-	void getStreamSamples(int16_t *container, size_t nSamples);
+	/// [offset]: sample offset of the tick in the next generated block
+	int streamCountUp(size_t offset = 0);
+	/// Process a tick when a real chip is used without the audio stream,
+	/// and apply the register writes to the emulator immediately.
+	int streamCountUpOnRealChip();
+	void getStreamSamples(float *container, size_t nSamples);
+	/// Play queued MIDI key events placed before [offset] of the next generated block of [nSamples].
+	/// Events that arrived in [begin, end] are spread over the block at the same spacing.
+	void streamMidiJamEvents(size_t offset, size_t nSamples,
+							 std::chrono::steady_clock::time_point begin,
+							 std::chrono::steady_clock::time_point end);
 	void killSound();
 
 	// Stream details
@@ -324,7 +355,19 @@ public:
 	// Module details
 	/*----- Module -----*/
 	void makeNewModule();
-	void loadModule(BinaryContainer& container);
+	/// Start loading the module into a fresh module on a worker thread.
+	/// The stream keeps running but skips ticks and MIDI jam and outputs silence
+	/// until the loading is finished, and ADPCM samples are written to the chip
+	/// while songs are still parsed.
+	/// [container] must be valid until finishLoadingModule is called.
+	/// Throw std::logic_error if another module is still being loaded
+	void startLoadingModule(BinaryContainer container);
+	bool isLoadingModule() const;
+	/// Progress of loading in percentage, updated when each section is loaded
+	int getModuleLoadingProgress() const;
+	/// Wait for the worker and replace the current module with the loaded one.
+	/// When loading has failed, the current module is kept and the error is rethrown
+	void finishLoadingModule();
 	void saveModule(BinaryContainer& container);
 	void setModulePath(std::string path);
 	std::string getModulePath() const;
@@ -431,15 +474,18 @@ public:
 	///		3: effect id
 	///		4: effect value
 	void pastePatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
-						   std::vector<std::vector<std::string>> cells);
+						   PatternCellBlock cells);
 	void pasteMixPatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
-							  std::vector<std::vector<std::string>> cells);
+							  PatternCellBlock cells);
 	void pasteOverwritePatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder,
-									int beginStep, std::vector<std::vector<std::string>> cells);
+									int beginStep, PatternCellBlock cells);
 	void pasteInsertPatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder,
-								 int beginStep, std::vector<std::vector<std::string>> cells);
-	std::vector<std::vector<std::string>> arrangePatternDataCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
-																  std::vector<std::vector<std::string>> cells);
+								 int beginStep, PatternCellBlock cells);
+	PatternCellBlock arrangePatternDataCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
+											 PatternCellBlock cells);
+	/// Copy the cells in the region as they are stored in the pattern
+	PatternCellBlock getPatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
+									 int endTrack, int endColmn, int endStep);
 	void erasePatternCells(int songNum, int beginTrack, int beginColmn, int beginOrder, int beginStep,
 						   int endTrack, int endColmn, int endStep);
 	void transposeNoteInPattern(int songNum, int beginTrack, int beginOrder, int beginStep,
@@ -466,11 +512,36 @@ private:
 	CommandManager comMan_;
 	std::shared_ptr<InstrumentsManager> instMan_;
 	std::unique_ptr<JamManager> jamMan_;
+	/// Jam is played from the GUI thread and the audio stream, jamMutex_ guards jamMan_.
+	/// The audio stream never waits for it, and leaves queued events to the next call.
+	JamEventQueue midiJamEvents_;
+	std::mutex jamMutex_;
+	/// Copy of the current status read by the MIDI input thread to resolve queued keys.
+	/// It is rebuilt on the GUI thread and swapped with std::atomic_store.
+	struct MidiJamStatus
+	{
+		SongStyle style;
+		int track;
+		std::shared_ptr<AbstractInstrument> inst;
+		int volume;
+		bool isFMVolumeReversed;
+	};
+	std::shared_ptr<const MidiJamStatus> midiJamStatus_;
 	std::shared_ptr<OPNAController> opnaCtrl_;
 	std::shared_ptr<TickCounter> tickCounter_;
 	std::unique_ptr<PlaybackManager> playback_;
 	std::shared_ptr<Module> mod_;
 
+	/// The loader keeps loadMutex_ locked while it uses the chip,
+	/// and the stream skips its events and outputs silence if it cannot get the lock.
+	std::thread loadThread_;
+	std::mutex loadMutex_;
+	std::atomic_bool isLoadingModule_;
+	std::atomic_int loadProgress_;
+	std::shared_ptr<Module> loadedMod_;
+	std::shared_ptr<InstrumentsManager> loadedInstMan_;
+	std::exception_ptr loadError_;
+
 	// Current status
 	int curOctave_;	// 0-7
 	int curSongNum_;
@@ -487,16 +558,30 @@ private:
 	bool isFollowPlay_;
 	bool storeOnlyUsedSamples_;
 
+	chip::Emu emu_;
+	int masterVol_;
+	double masterVolFM_, masterVolSSG_;
+
 	static const uint32_t CHIP_CLOCK;
+	static constexpr size_t MIDI_JAM_QUEUE_SIZE_ = 256;
 
 	// Jam mode
-	void funcJamKeyOn(JamKey key, int keyNum, const TrackAttribute& attrib, bool volumeSet,
-					  std::shared_ptr<AbstractInstrument> inst = nullptr);
-	void funcJamKeyOff(JamKey key, int keyNum, const TrackAttribute& attrib);
+	JamTarget makeJamTarget(const TrackAttribute& attrib, bool volumeSet,
+							std::shared_ptr<AbstractInstrument> inst = nullptr);
+	void funcJamKeyOn(JamKey key, int keyNum, const JamTarget& target);
+	void funcJamKeyOff(JamKey key, int keyNum, const TrackAttribute& attrib, SongType songType);
+	void updateMidiJamStatus();
 
 	// Play song
 	void startPlay();
 
+	// Stream events
+	/// Caller must hold loadMutex_
+	int countUpStream(size_t offset);
+
+	// Export
+	std::unique_ptr<OfflineRenderer> createOfflineRenderer() const;
+
 	void checkNextPositionOfLastStepAndStepSize(
 			int songNum, int& endOrder, int& endStep, size_t& nIntroStep, size_t& nLoopStep) const;
 };
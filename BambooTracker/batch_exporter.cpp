@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "batch_exporter.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+#include <exception>
+#include "offline_renderer.hpp"
+#include "stem_exporter.hpp"
+#include "module.hpp"
+#include "instruments_manager.hpp"
+#include "module_io.hpp"
+#include "wav_writer.hpp"
+#include "file_io_error.hpp"
+
+namespace
+{
+/// Convert to 16-bit null-terminated string used in GD3 tag (ASCII only)
+std::string toGD3String(const std::string& str)
+{
+	std::string gd3;
+	for (const auto& c : str) {
+		gd3 += (static_cast<unsigned char>(c) < 0x80) ? c : '?';
+		gd3 += '\0';
+	}
+	gd3 += '\0';
+	gd3 += '\0';
+	return gd3;
+}
+
+template <class Renderer>
+void setMixer(Renderer& renderer, const Module& mod)
+{
+	switch (mod.getMixerType()) {
+	case MixerType::UNSPECIFIED:
+		renderer.setMasterVolumeFM(0);
+		renderer.setMasterVolumeSSG(0);
+		break;
+	case MixerType::CUSTOM:
+		renderer.setMasterVolumeFM(mod.getCustomMixerFMLevel());
+		renderer.setMasterVolumeSSG(mod.getCustomMixerSSGLevel());
+		break;
+	case MixerType::PC_9821_PC_9801_86:
+		renderer.setMasterVolumeFM(0);
+		renderer.setMasterVolumeSSG(-5.5);
+		break;
+	case MixerType::PC_9821_SPEAK_BOARD:
+		renderer.setMasterVolumeFM(0);
+		renderer.setMasterVolumeSSG(-3.0);
+		break;
+	case MixerType::PC_8801_VA2:
+		renderer.setMasterVolumeFM(0);
+		renderer.setMasterVolumeSSG(1.5);
+		break;
+	case MixerType::PC_8801_MKII_SR:
+		renderer.setMasterVolumeFM(0);
+		renderer.setMasterVolumeSSG(2.5);
+		break;
+	}
+}
+
+/// Insert "-[suffix]" before the extension
+std::string appendToBaseName(const std::string& path, const std::string& suffix)
+{
+	size_t sep = path.find_last_of("/\\");
+	size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos || (sep != std::string::npos && dot < sep)) dot = path.size();
+	return path.substr(0, dot) + "-" + suffix + path.substr(dot);
+}
+}
+
+BatchExporter::BatchExporter(Settings settings)
+	: settings_(settings)
+{
+}
+
+void BatchExporter::addModule(const std::string& inputPath, const std::string& outputPath, int songNum)
+{
+	std::ifstream ifs(inputPath, std::ios::binary);
+	if (!ifs) throw FileNotExistError(FileIO::FileType::Mod);
+	auto data = std::make_shared<const BinaryContainer>(
+					std::vector<char>((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>()));
+
+	auto mod = std::make_shared<Module>();
+	auto instMan = std::make_shared<InstrumentsManager>(false);
+	ModuleIO::loadModule(*data, mod, instMan);
+	int cnt = static_cast<int>(mod->getSongCount());
+
+	if (songNum == -1) {
+		for (int i = 0; i < cnt; ++i) {
+			jobs_.push_back({ data, inputPath, (cnt == 1) ? outputPath : appendToBaseName(outputPath, std::to_string(i)), i });
+		}
+	}
+	else if (-1 < songNum && songNum < cnt) {
+		jobs_.push_back({ data, inputPath, outputPath, songNum });
+	}
+	else {
+		throw std::out_of_range("Invalid song number");
+	}
+}
+
+size_t BatchExporter::getJobCount() const
+{
+	return jobs_.size();
+}
+
+std::vector<BatchExporter::Result> BatchExporter::run(size_t nThreads, std::function<void(const Result&)> notifier)
+{
+	std::vector<Result> results(jobs_.size());
+	if (!nThreads) nThreads = std::max(1u, std::thread::hardware_concurrency());
+	// Spare threads render stems of the songs concurrently
+	size_t nStemThreads = std::max<size_t>(1, nThreads / std::max<size_t>(1, jobs_.size()));
+	nThreads = std::min(nThreads, jobs_.size());
+
+	std::atomic<size_t> next(0);
+	std::mutex notifierMutex;
+	auto work = [&] {
+		for (size_t i = next++; i < jobs_.size(); i = next++) {
+			const Job& job = jobs_[i];
+			Result& res = results[i];
+			res.inputPath = job.inputPath;
+			res.outputPath = job.outputPath;
+			res.songNum = job.songNum;
+			try {
+				exportSong(job, nStemThreads);
+				res.succeeded = true;
+			}
+			catch (std::exception& e) {
+				res.succeeded = false;
+				res.message = e.what();
+			}
+
+			if (notifier) {
+				std::lock_guard<std::mutex> lg(notifierMutex);
+				notifier(res);
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < nThreads; ++i) workers.emplace_back(work);
+	work();	// Use this thread as a worker too
+	for (auto& th : workers) th.join();
+
+	return results;
+}
+
+void BatchExporter::exportSong(const Job& job, size_t nStemThreads) const
+{
+	if (settings_.format == FileIO::FileType::WAV && settings_.stems) {
+		exportStems(job, nStemThreads);
+		return;
+	}
+
+	auto mod = std::make_shared<Module>();
+	auto instMan = std::make_shared<InstrumentsManager>(false);
+	ModuleIO::loadModule(*job.data, mod, instMan);
+
+	OfflineRenderer renderer(*mod, instMan, job.songNum, settings_.emu);
+	setMixer(renderer, *mod);
+	renderer.setStoreOnlyUsedSamples(settings_.storeOnlyUsedSamples);
+	renderer.assignSampleADPCMRawSamples();
+
+	auto bar = [] { return false; };
+	std::ofstream ofs(job.outputPath, std::ios::binary);
+	if (!ofs) throw std::runtime_error("Failed to open " + job.outputPath);
+
+	BinaryContainer container;
+	switch (settings_.format) {
+	case FileIO::FileType::WAV:
+	{
+		// Stream samples to the file directly
+		WavWriter writer([&ofs](const char* data, size_t size) {
+			return static_cast<bool>(ofs.write(data, static_cast<std::streamsize>(size)));
+		}, [&ofs](size_t pos) {
+			return static_cast<bool>(ofs.seekp(static_cast<std::streamoff>(pos)));
+		}, static_cast<uint32_t>(settings_.rate), settings_.sampleFormat);
+		renderer.renderToWav(writer, settings_.loopCount, bar);
+		return;
+	}
+	case FileIO::FileType::VGM:
+	{
+		GD3Tag tag;
+		tag.trackNameEn = toGD3String(mod->getSong(job.songNum).getTitle());
+		tag.trackNameJp = toGD3String("");
+		tag.gameNameEn = toGD3String(mod->getTitle());
+		tag.gameNameJp = toGD3String("");
+		tag.systemNameEn = toGD3String("");
+		tag.systemNameJp = toGD3String("");
+		tag.authorEn = toGD3String(mod->getAuthor());
+		tag.authorJp = toGD3String("");
+		tag.releaseDate = toGD3String("");
+		tag.vgmCreator = toGD3String("");
+		tag.notes = toGD3String("");
+		renderer.renderToVgm(container, settings_.target, true, tag, bar);
+		break;
+	}
+	case FileIO::FileType::S98:
+	{
+		S98Tag tag;
+		tag.title = mod->getSong(job.songNum).getTitle();
+		tag.artist = mod->getAuthor();
+		tag.game = mod->getTitle();
+		tag.copyright = mod->getCopyright();
+		renderer.renderToS98(container, settings_.target, true, tag, settings_.rate, bar);
+		break;
+	}
+	default:
+		throw std::invalid_argument("Unsupported export format");
+	}
+
+	ofs.write(container.getPointer(), static_cast<std::streamsize>(container.size()));
+	if (!ofs) throw std::runtime_error("Failed to write " + job.outputPath);
+}
+
+void BatchExporter::exportStems(const Job& job, size_t nThreads) const
+{
+	StemExporter exporter(job.data, job.songNum, settings_.emu);
+	{
+		auto mod = std::make_shared<Module>();
+		auto instMan = std::make_shared<InstrumentsManager>(false);
+		ModuleIO::loadModule(*job.data, mod, instMan);
+		setMixer(exporter, *mod);
+	}
+	exporter.setStoreOnlyUsedSamples(settings_.storeOnlyUsedSamples);
+
+	// The master is written to the output path
+	std::vector<StemExporter::Stem> stems = exporter.getStems();
+	std::vector<std::unique_ptr<std::ofstream>> files;
+	std::vector<std::unique_ptr<WavWriter>> writers;
+	std::vector<WavWriter*> writerPtrs;
+	for (const auto& stem : stems) {
+		std::string path = stem.isMaster ? job.outputPath : appendToBaseName(job.outputPath, stem.name);
+		files.push_back(std::make_unique<std::ofstream>(path, std::ios::binary));
+		std::ofstream& ofs = *files.back();
+		if (!ofs) throw std::runtime_error("Failed to open " + path);
+		writers.push_back(std::make_unique<WavWriter>([&ofs](const char* data, size_t size) {
+			return static_cast<bool>(ofs.write(data, static_cast<std::streamsize>(size)));
+		}, [&ofs](size_t pos) {
+			return static_cast<bool>(ofs.seekp(static_cast<std::streamoff>(pos)));
+		}, static_cast<uint32_t>(settings_.rate), settings_.sampleFormat));
+		writerPtrs.push_back(writers.back().get());
+	}
+
+	exporter.render(writerPtrs, settings_.loopCount, [] { return false; }, nThreads);
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include "binary_container.hpp"
+#include "file_io.hpp"
+#include "export_handler.hpp"
+#include "wav_writer.hpp"
+#include "chips/chip_misc.hpp"
+
+/// Render songs of modules to files on a pool of worker threads.
+/// Each job parses its own module and instruments from the shared file data,
+/// so workers never share mutable state.
+class BatchExporter
+{
+public:
+	struct Settings
+	{
+		FileIO::FileType format = FileIO::FileType::WAV;	// WAV, VGM or S98
+		chip::Emu emu = chip::Emu::Mame;
+		int rate = 44100;	// Sample rate of WAV or resolution of S98
+		int loopCount = 1;	// WAV only
+		WavWriter::SampleFormat sampleFormat = WavWriter::SampleFormat::Int16;	// WAV only
+		bool stems = false;	// WAV only, also write each channel to "<output>-<track name>.wav"
+		int target = Export_YM2608;	// VGM and S98 only
+		bool storeOnlyUsedSamples = true;
+	};
+
+	struct Result
+	{
+		std::string inputPath, outputPath;
+		int songNum;
+		bool succeeded;
+		std::string message;
+	};
+
+	explicit BatchExporter(Settings settings);
+
+	/// Add jobs of the module
+	/// [songNum] -1: all songs (song number is appended to the output file name)
+	/// throw FileIOError when the module cannot be loaded
+	void addModule(const std::string& inputPath, const std::string& outputPath, int songNum = -1);
+	size_t getJobCount() const;
+
+	/// Process all jobs and return results in the order of addition
+	/// [nThreads] 0: hardware concurrency
+	/// [notifier] called from worker threads (serialized) when each job is finished
+	std::vector<Result> run(size_t nThreads = 0, std::function<void(const Result&)> notifier = nullptr);
+
+private:
+	struct Job
+	{
+		std::shared_ptr<const BinaryContainer> data;
+		std::string inputPath, outputPath;
+		int songNum;
+	};
+
+	Settings settings_;
+	std::vector<Job> jobs_;
+
+	void exportSong(const Job& job, size_t nStemThreads) const;
+	void exportStems(const Job& job, size_t nThreads) const;
+};
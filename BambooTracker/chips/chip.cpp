@@ -24,44 +24,32 @@
  */
 
 #include "chip.hpp"
+#include <thread>
 #include <utility>
 #include "chip_misc.hpp"
 
-#ifdef  __cplusplus
-extern "C"
-{
-#endif //  __cplusplus
-
-#include "mame/mamedef.h"
-
-UINT8 CHIP_SAMPLING_MODE = 0x00;
-INT32 CHIP_SAMPLE_RATE;
-stream_sample_t* DUMMYBUF[] = { nullptr, nullptr };
-
-#ifdef __cplusplus
-}
-#endif // __cplusplus
-
 namespace chip
 {
-	Chip::Chip(int id, int clock, int rate, int autoRate, size_t maxDuration,
+	Chip::Chip(int clock, int rate, int autoRate, size_t maxDuration,
 			   std::unique_ptr<AbstractResampler> resampler1, std::unique_ptr<AbstractResampler> resampler2,
 			   std::shared_ptr<ExportContainerInterface> exportContainer)
-		: id_(id),
+		: coreBusy_(false),
 		  rate_(rate),	// Dummy set
 		  clock_(clock),
 		  autoRate_(autoRate),
 		  maxDuration_(maxDuration),
-		  masterVolumeRatio_(100),
+		  masterVolumeRatio_(1.0),	// 100%
 		  exCntr_(exportContainer),
 		  needSampleGen_(isNeedSampleGeneration(exportContainer))
 	{
 		resampler_[0] = std::move(resampler1);
 		resampler_[1] = std::move(resampler2);
 
+		for (auto& ratio : volumeRatio_) ratio.store(1.0);
+
 		for (int pan = LEFT; pan <= RIGHT; ++pan) {
 			for (auto& buf : buffer_) {
-				buf[pan] = new stream_sample_t[SMPL_BUF_SIZE_];
+				buf[pan] = new sample[SMPL_BUF_SIZE_];
 			}
 		}
 	}
@@ -75,6 +63,31 @@ namespace chip
 		}
 	}
 
+	Chip::CoreClaim::CoreClaim(Chip& chip)
+		: lg_(chip.mutex_),
+		  busy_(chip.coreBusy_)
+	{
+		// The mixer holds the core for at most a block
+		while (busy_.exchange(true, std::memory_order_acquire))
+			std::this_thread::yield();
+	}
+
+	Chip::CoreClaim::~CoreClaim()
+	{
+		busy_.store(false, std::memory_order_release);
+	}
+
+	void Chip::acquireCore()
+	{
+		while (coreBusy_.exchange(true, std::memory_order_acquire))
+			std::this_thread::yield();
+	}
+
+	void Chip::releaseCore()
+	{
+		coreBusy_.store(false, std::memory_order_release);
+	}
+
 	void Chip::initResampler()
 	{
 		for (int snd = 0; snd < 2; ++snd) {
@@ -84,7 +97,7 @@ namespace chip
 
 	void Chip::setRate(int rate)
 	{
-		std::lock_guard<std::mutex> lg(mutex_);
+		CoreClaim claim(*this);
 
 		funcSetRate(rate);
 
@@ -95,7 +108,7 @@ namespace chip
 
 	void Chip::funcSetRate(int rate)
 	{
-		rate_ = CHIP_SAMPLE_RATE = ((rate) ? rate : autoRate_);
+		rate_ = ((rate) ? rate : autoRate_);
 	}
 
 	int Chip::getClock() const
@@ -110,6 +123,7 @@ namespace chip
 
 	void Chip::setMaxDuration(size_t maxDuration)
 	{
+		CoreClaim claim(*this);
 		maxDuration_ = maxDuration;
 		for (int snd = 0; snd < 2; ++snd) {
 			resampler_[snd]->setMaxDuration(maxDuration);
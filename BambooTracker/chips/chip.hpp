@@ -26,6 +26,7 @@
 #pragma once
 
 #include "chip_def.h"
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -39,7 +40,7 @@ namespace chip
 	public:
 		// [rate]
 		// 0 = auto-set mode (set internal chip rate)
-		Chip(int id, int clock, int rate, int autoRate, size_t maxDuration,
+		Chip(int clock, int rate, int autoRate, size_t maxDuration,
 			 std::unique_ptr<AbstractResampler> resampler1, std::unique_ptr<AbstractResampler> resampler2,
 			 std::shared_ptr<ExportContainerInterface> exportContainer);
 		virtual ~Chip();
@@ -56,23 +57,46 @@ namespace chip
 		void setMaxDuration(size_t maxDuration);
 		size_t getMaxDuration() const;
 		
-		void setExportContainer(std::shared_ptr<ExportContainerInterface> cntr = nullptr);
+		virtual void setExportContainer(std::shared_ptr<ExportContainerInterface> cntr = nullptr);
 
 		void setMasterVolume(int percentage);
 
+		/// Interleaved 16-bit output clipped to the full scale
 		virtual void mix(int16_t* stream, size_t nSamples) = 0;
+		/// Interleaved float output without clipping, 1.0 is the 16-bit full scale
+		virtual void mix(float* stream, size_t nSamples) = 0;
 
 	protected:
-		const int id_;
+		/// The mixer owns the emulator core while it synthesizes a block.
+		/// Other threads take the core with CoreClaim only for short work
+		/// (a reset, a DRAM transfer or a queue drain), and the mixer spins until it is released.
+		class CoreClaim
+		{
+		public:
+			explicit CoreClaim(Chip& chip);
+			~CoreClaim();
+
+		private:
+			std::lock_guard<std::mutex> lg_;
+			std::atomic_bool& busy_;
+		};
+
+		/// Serializes the non-mixer threads
 		std::mutex mutex_;
+		std::atomic_bool coreBusy_;
+
+		/// Called by the mixer, wait for a CoreClaim to be released
+		void acquireCore();
+		void releaseCore();
 
 		int rate_, clock_;
 		const int autoRate_;
 		int internalRate_[2];
 		size_t maxDuration_;
 
-		double masterVolumeRatio_;
-		double volumeRatio_[2];
+		// Read by the mixer once per block
+		std::atomic<double> masterVolumeRatio_;
+		std::atomic<double> volumeRatio_[2];
 
 		sample* buffer_[2][2];
 		std::unique_ptr<AbstractResampler> resampler_[2];
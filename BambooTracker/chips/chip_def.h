@@ -4,19 +4,21 @@
 
 typedef int32_t	sample;
 
+/* Emulator interface. device_start allocates the chip state and returns
+   its handle (NULL on failure), which is passed to the other functions. */
 struct intf2608
 {
-	void (*set_ay_emu_core)(uint8_t Emulator);
-	int (*device_start)(uint8_t ChipID, int clock, uint8_t AYDisable, uint8_t AYFlags, int* AYrate, uint32_t dramSize);
-	void (*device_stop)(uint8_t ChipID);
-	void (*device_reset)(uint8_t ChipID);
-	void (*control_port_a_w)(uint8_t ChipID, uint32_t offset, uint8_t data);
-	void (*control_port_b_w)(uint8_t ChipID, uint32_t offset, uint8_t data);
-	void (*data_port_a_w)(uint8_t ChipID, uint32_t offset, uint8_t data);
-	void (*data_port_b_w)(uint8_t ChipID, uint32_t offset, uint8_t data);
-	uint8_t (*read_port_r)(uint8_t ChipID, uint32_t offset);
-	void (*stream_update)(uint8_t ChipID, sample **outputs, int samples);
-	void (*stream_update_ay)(uint8_t ChipID, sample **outputs, int samples);
+	void* (*device_start)(int clock, uint8_t AYEmuCore, uint8_t AYDisable, uint8_t AYFlags, int* rate, int* AYrate, uint32_t dramSize);
+	void (*device_stop)(void* chip);
+	void (*device_reset)(void* chip);
+	void (*control_port_a_w)(void* chip, uint32_t offset, uint8_t data);
+	void (*control_port_b_w)(void* chip, uint32_t offset, uint8_t data);
+	void (*data_port_a_w)(void* chip, uint32_t offset, uint8_t data);
+	void (*data_port_b_w)(void* chip, uint32_t offset, uint8_t data);
+	uint8_t (*read_port_r)(void* chip, uint32_t offset);
+	void (*write_dram)(void* chip, uint32_t address, const uint8_t* data, uint32_t size);
+	void (*stream_update)(void* chip, sample **outputs, int samples);
+	void (*stream_update_ay)(void* chip, sample **outputs, int samples);
 };
 
 #ifndef INCLUDE_AY8910_H
@@ -37,19 +37,20 @@ namespace codec
 		return newval;
 	}
 
-	void ymb_encode(int16_t *buffer,uint8_t *outbuffer,long len)
+	// Encode a block continuing from the given encoder state.
+	// [len] must be even except for the last block so that each block starts on a byte boundary.
+	inline void ymb_encode_block(int16_t *buffer,uint8_t *outbuffer,long len,int16_t *history,int16_t *step_size)
 	{
 		long i;
-		int16_t step_size = 127;
-		int16_t history = 0;
 		uint8_t buf_sample = 0, nibble = 0;
 		unsigned int adpcm_sample;
 
 		for(i=0;i<len;i++)
 		{
 			// we remove a few bits of accuracy to reduce some noise.
-			int step = ((*buffer++) & -8) - history;
-			adpcm_sample = (abs(step)<<16) / (step_size<<14);
+			int step = ((*buffer++) & -8) - *history;
+			// Same as (abs(step)<<16) / (step_size<<14) without overflowing on large steps
+			adpcm_sample = static_cast<unsigned int>(abs(step)<<2) / static_cast<unsigned int>(*step_size);
 			adpcm_sample = CLAMP_ZERO(adpcm_sample, 7);
 			if(step < 0)
 				adpcm_sample |= 8;
@@ -58,11 +59,18 @@ namespace codec
 			else
 				buf_sample = (adpcm_sample&15)<<4;
 			nibble^=1;
-			ymb_step(adpcm_sample, &history, &step_size);
+			ymb_step(adpcm_sample, history, step_size);
 		}
 	}
 
-	void ymb_decode(uint8_t *buffer,int16_t *outbuffer,long len)
+	inline void ymb_encode(int16_t *buffer,uint8_t *outbuffer,long len)
+	{
+		int16_t step_size = 127;
+		int16_t history = 0;
+		ymb_encode_block(buffer, outbuffer, len, &history, &step_size);
+	}
+
+	inline void ymb_decode(uint8_t *buffer,int16_t *outbuffer,long len)
 	{
 		long i;
 
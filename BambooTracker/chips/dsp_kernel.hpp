@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "chip_def.h"
+#include "chip_misc.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHIP_DSP_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CHIP_DSP_NEON
+#include <arm_neon.h>
+#endif
+
+namespace chip
+{
+	/// Dot product of [n] floats, [n] must be a multiple of 8.
+	/// The portable version keeps the same partial sums as the vectorized versions.
+	inline float dotProductScalar(const float* a, const float* b, size_t n)
+	{
+		float acc[8] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+		for (size_t k = 0; k < n; k += 8) {
+			for (size_t j = 0; j < 8; ++j) acc[j] += a[k + j] * b[k + j];
+		}
+		return ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+	}
+
+	inline float dotProduct(const float* a, const float* b, size_t n)
+	{
+#if defined(CHIP_DSP_SSE2)
+		__m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+		for (size_t k = 0; k < n; k += 8) {
+			acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + k), _mm_loadu_ps(b + k)));
+			acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + k + 4), _mm_loadu_ps(b + k + 4)));
+		}
+		__m128 sum = _mm_add_ps(acc0, acc1);	// [0+4, 1+5, 2+6, 3+7]
+		sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtss_f32(_mm_add_ss(sum, _mm_movehl_ps(sum, sum)));
+#elif defined(CHIP_DSP_NEON)
+		float32x4_t acc0 = vdupq_n_f32(0.f), acc1 = vdupq_n_f32(0.f);
+		for (size_t k = 0; k < n; k += 8) {
+			acc0 = vaddq_f32(acc0, vmulq_f32(vld1q_f32(a + k), vld1q_f32(b + k)));
+			acc1 = vaddq_f32(acc1, vmulq_f32(vld1q_f32(a + k + 4), vld1q_f32(b + k + 4)));
+		}
+		float32x4_t sum = vaddq_f32(acc0, acc1);
+		return (vgetq_lane_f32(sum, 0) + vgetq_lane_f32(sum, 1))
+				+ (vgetq_lane_f32(sum, 2) + vgetq_lane_f32(sum, 3));
+#else
+		return dotProductScalar(a, b, n);
+#endif
+	}
+
+	/// Mix FM and SSG planes down to interleaved 16-bit samples with Q16 gains.
+	/// The shift rounds toward negative infinity, and the result is saturated.
+	inline void mixDownQ16(int16_t* dest, const sample* fmL, const sample* fmR,
+						   const sample* ssgL, const sample* ssgR,
+						   int64_t gainFM, int64_t gainSSG, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			int64_t l = (gainFM * fmL[i] + gainSSG * ssgL[i]) >> 16;
+			int64_t r = (gainFM * fmR[i] + gainSSG * ssgR[i]) >> 16;
+			*dest++ = static_cast<int16_t>(clamp<int64_t>(l, -32768, 32767));
+			*dest++ = static_cast<int16_t>(clamp<int64_t>(r, -32768, 32767));
+		}
+	}
+
+	/// Mix FM and SSG planes down to interleaved 16-bit samples with Q16 gains, 4 samples at a time.
+	/// The products are taken in float and the packing saturates to 16 bits,
+	/// so the result is within 1 LSB of mixDownQ16 which processes the remainder.
+	inline void mixDown(int16_t* dest, const sample* fmL, const sample* fmR,
+						const sample* ssgL, const sample* ssgR,
+						int64_t gainFM, int64_t gainSSG, size_t n)
+	{
+#if defined(CHIP_DSP_SSE2) || defined(CHIP_DSP_NEON)
+		const float gf = static_cast<float>(gainFM) / 65536.f;
+		const float gs = static_cast<float>(gainSSG) / 65536.f;
+		const size_t nVec = n & ~static_cast<size_t>(3);
+#endif
+#if defined(CHIP_DSP_SSE2)
+		const __m128 vgf = _mm_set1_ps(gf), vgs = _mm_set1_ps(gs);
+		// Keep the float to int conversion in range, the pack saturates the rest
+		const __m128 vmin = _mm_set1_ps(-65536.f), vmax = _mm_set1_ps(65536.f);
+		auto load = [](const sample* p) {
+			return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+		};
+		for (size_t i = 0; i < nVec; i += 4) {
+			__m128 l = _mm_add_ps(_mm_mul_ps(load(fmL + i), vgf), _mm_mul_ps(load(ssgL + i), vgs));
+			__m128 r = _mm_add_ps(_mm_mul_ps(load(fmR + i), vgf), _mm_mul_ps(load(ssgR + i), vgs));
+			__m128i li = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(l, vmin), vmax));
+			__m128i ri = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(r, vmin), vmax));
+			__m128i lr = _mm_packs_epi32(_mm_unpacklo_epi32(li, ri), _mm_unpackhi_epi32(li, ri));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 2 * i), lr);
+		}
+#elif defined(CHIP_DSP_NEON)
+		const float32x4_t vmin = vdupq_n_f32(-65536.f), vmax = vdupq_n_f32(65536.f);
+		for (size_t i = 0; i < nVec; i += 4) {
+			float32x4_t l = vmlaq_n_f32(vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(fmL + i)), gf),
+										vcvtq_f32_s32(vld1q_s32(ssgL + i)), gs);
+			float32x4_t r = vmlaq_n_f32(vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(fmR + i)), gf),
+										vcvtq_f32_s32(vld1q_s32(ssgR + i)), gs);
+			int16x4x2_t lr;
+			lr.val[0] = vqmovn_s32(vcvtq_s32_f32(vminq_f32(vmaxq_f32(l, vmin), vmax)));
+			lr.val[1] = vqmovn_s32(vcvtq_s32_f32(vminq_f32(vmaxq_f32(r, vmin), vmax)));
+			vst2_s16(dest + 2 * i, lr);
+		}
+#endif
+#if defined(CHIP_DSP_SSE2) || defined(CHIP_DSP_NEON)
+		mixDownQ16(dest + 2 * nVec, fmL + nVec, fmR + nVec, ssgL + nVec, ssgR + nVec,
+				   gainFM, gainSSG, n - nVec);
+#else
+		mixDownQ16(dest, fmL, fmR, ssgL, ssgR, gainFM, gainSSG, n);
+#endif
+	}
+}
@@ -25,6 +25,7 @@
 
 #include "export_container.hpp"
 #include "export_handler.hpp"
+#include "chip_misc.hpp"
 #include <algorithm>
 
 namespace chip
@@ -42,11 +43,26 @@ namespace chip
 		(void)value;
 	}
 
+	void WavExportContainer::recordDRAMWrite(size_t memorySize, size_t address, const uint8_t* data, size_t size)
+	{
+		(void)memorySize;
+		(void)address;
+		(void)data;
+		(void)size;
+	}
+
 	void WavExportContainer::recordStream(int16_t* stream, size_t nSamples)
 	{
 		std::copy(stream, stream + (nSamples << 1), std::back_inserter(samples_));
 	}
 
+	void WavExportContainer::recordStream(float* stream, size_t nSamples)
+	{
+		std::transform(stream, stream + (nSamples << 1), std::back_inserter(samples_), [](float s) {
+			return static_cast<int16_t>(clamp(s * 32768.f, -32768.f, 32767.f));
+		});
+	}
+
 	bool WavExportContainer::empty() const
 	{
 		return samples_.empty();
@@ -132,6 +148,14 @@ namespace chip
 		}
 	}
 
+	void VgmExportContainer::recordDRAMWrite(size_t memorySize, size_t address, const uint8_t* data, size_t size)
+	{
+		if ((target_ & Export_FmMask) != Export_YM2608) return;
+
+		if (lastWait_) setWait();
+		setDataBlock(memorySize, address, data, size);
+	}
+
 	void VgmExportContainer::recordStream(int16_t* stream, size_t nSamples)
 	{
 		(void)stream;
@@ -139,6 +163,13 @@ namespace chip
 		totalSampCnt_ += nSamples;
 	}
 
+	void VgmExportContainer::recordStream(float* stream, size_t nSamples)
+	{
+		(void)stream;
+		lastWait_ += nSamples;
+		totalSampCnt_ += nSamples;
+	}
+
 	void VgmExportContainer::clear()
 	{
 		buf_.clear();
@@ -178,21 +209,29 @@ namespace chip
 	}
 
 	void VgmExportContainer::setDataBlock(std::vector<uint8_t> data)
+	{
+		setDataBlock(data.size(), 0, data.data(), data.size());
+	}
+
+	void VgmExportContainer::setDataBlock(size_t romSize, size_t address, const uint8_t* data, size_t size)
 	{
 		buf_.push_back(0x67);
 		buf_.push_back(0x66);
-		buf_.push_back(0x81);
-		size_t blockSize = data.size() + 8;
+		buf_.push_back(0x81);	// YM2608 DELTA-T ROM data
+		size_t blockSize = size + 8;
 		buf_.push_back(blockSize & 0xff);
 		buf_.push_back((blockSize >> 8) & 0xff);
 		buf_.push_back((blockSize >> 16) & 0xff);
 		buf_.push_back(blockSize >> 24);
-		buf_.push_back(data.size() & 0xff);
-		buf_.push_back((data.size() >> 8) & 0xff);
-		buf_.push_back((data.size() >> 16) & 0xff);
-		buf_.push_back(data.size() >> 24);
-		buf_.resize(buf_.size() + 4);	// Start address is 0
-		std::copy(data.begin(), data.end(), std::back_inserter(buf_));
+		buf_.push_back(romSize & 0xff);
+		buf_.push_back((romSize >> 8) & 0xff);
+		buf_.push_back((romSize >> 16) & 0xff);
+		buf_.push_back(romSize >> 24);
+		buf_.push_back(address & 0xff);
+		buf_.push_back((address >> 8) & 0xff);
+		buf_.push_back((address >> 16) & 0xff);
+		buf_.push_back(address >> 24);
+		buf_.insert(buf_.end(), data, data + size);
 	}
 
 	void VgmExportContainer::setWait()
@@ -395,6 +434,16 @@ namespace chip
 		}
 	}
 
+	void S98ExportContainer::recordDRAMWrite(size_t memorySize, size_t address, const uint8_t* data, size_t size)
+	{
+		// S98 has no data blocks, so replay the transfer through the ADPCM data register
+		(void)memorySize;
+		(void)address;
+		for (size_t i = 0; i < size; ++i) {
+			recordRegisterChange(0x108, data[i]);
+		}
+	}
+
 	void S98ExportContainer::recordStream(int16_t* stream, size_t nSamples)
 	{
 		(void)stream;
@@ -402,6 +451,13 @@ namespace chip
 		totalSampCnt_ += nSamples;
 	}
 
+	void S98ExportContainer::recordStream(float* stream, size_t nSamples)
+	{
+		(void)stream;
+		lastWait_ += nSamples;
+		totalSampCnt_ += nSamples;
+	}
+
 	void S98ExportContainer::clear()
 	{
 		buf_.clear();
@@ -37,7 +37,10 @@ namespace chip
 		virtual ~ExportContainerInterface();
 		virtual bool isNeedSampleGeneration() const = 0;
 		virtual void recordRegisterChange(uint32_t offset, uint8_t value) = 0;
+		/// Record a block transfer into the ADPCM DRAM of memorySize bytes
+		virtual void recordDRAMWrite(size_t memorySize, size_t address, const uint8_t* data, size_t size) = 0;
 		virtual void recordStream(int16_t* stream, size_t nSamples) = 0;
+		virtual void recordStream(float* stream, size_t nSamples) = 0;
 		virtual bool empty() const = 0;
 		virtual void clear() = 0;
 	};
@@ -48,7 +51,9 @@ namespace chip
 		WavExportContainer();
 		bool isNeedSampleGeneration() const override { return true; }
 		void recordRegisterChange(uint32_t offset, uint8_t value) override;
+		void recordDRAMWrite(size_t memorySize, size_t address, const uint8_t* data, size_t size) override;
 		void recordStream(int16_t* stream, size_t nSamples) override;
+		void recordStream(float* stream, size_t nSamples) override;
 		bool empty() const override;
 		void clear() override;
 		std::vector<int16_t> getStream() const;
@@ -63,7 +68,9 @@ namespace chip
 		VgmExportContainer(int target, uint32_t intrRate);
 		bool isNeedSampleGeneration() const override { return false; }
 		void recordRegisterChange(uint32_t offset, uint8_t value) override;
+		void recordDRAMWrite(size_t memorySize, size_t address, const uint8_t* data, size_t size) override;
 		void recordStream(int16_t* stream, size_t nSamples) override;
+		void recordStream(float* stream, size_t nSamples) override;
 		void clear() override;
 		bool empty() const override;
 		std::vector<uint8_t> getData();
@@ -81,6 +88,7 @@ namespace chip
 		uint32_t loopPoint_;
 
 		void setWait();
+		void setDataBlock(size_t romSize, size_t address, const uint8_t* data, size_t size);
 	};
 
 	class S98ExportContainer : public ExportContainerInterface
@@ -89,7 +97,9 @@ namespace chip
 		explicit S98ExportContainer(int target);
 		bool isNeedSampleGeneration() const override { return false; }
 		void recordRegisterChange(uint32_t offset, uint8_t value) override;
+		void recordDRAMWrite(size_t memorySize, size_t address, const uint8_t* data, size_t size) override;
 		void recordStream(int16_t* stream, size_t nSamples) override;
+		void recordStream(float* stream, size_t nSamples) override;
 		void clear() override;
 		bool empty() const override;
 		std::vector<uint8_t> getData();
@@ -2,7 +2,8 @@
 
   2608intf.c
 
-  The YM2608 emulator supports up to 2 chips.
+  Each YM2608 chip state is allocated by device_start_ym2608 and
+  passed back to the other functions as an opaque handle.
   Each chip has the following connections:
   - Status Read / Control Write A
   - Port Read / Data Write A
@@ -35,6 +36,8 @@ struct _ym2608_state
 	emu_timer *	timer[2];*/
 	void *			chip;
 	void *			psg;
+	UINT8			ay_emu_core;
+	offs_t			dram_size;
 	ym2608_interface intf;
 	/*const device_config *device;*/
 };
@@ -42,14 +45,8 @@ struct _ym2608_state
 #define CHTYPE_YM2608	0x21
 
 
-extern UINT8 CHIP_SAMPLING_MODE;
-extern INT32 CHIP_SAMPLE_RATE;
-static UINT8 AY_EMU_CORE = 0x00;
 /*extern UINT32 SampleRate;*/
 
-#define MAX_CHIPS	0x02
-static ym2608_state YM2608Data[MAX_CHIPS];
-
 /*INLINE ym2608_state *get_safe_token(const device_config *device)
 {
 	assert(device != NULL);
@@ -66,7 +63,7 @@ static void psg_set_clock(void *param, int clock)
 	ym2608_state *info = (ym2608_state *)param;
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -85,7 +82,7 @@ static void psg_write(void *param, int address, int data)
 	ym2608_state *info = (ym2608_state *)param;
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -104,7 +101,7 @@ static int psg_read(void *param)
 	ym2608_state *info = (ym2608_state *)param;
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -122,7 +119,7 @@ static void psg_reset(void *param)
 	ym2608_state *info = (ym2608_state *)param;
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -185,30 +182,31 @@ static TIMER_CALLBACK( timer_callback_2608_1 )
 void ym2608_update_request(void *param)
 {
 	ym2608_state *info = (ym2608_state *)param;
+	stream_sample_t* dummybuf[] = { NULL, NULL };
 	/*stream_update(info->stream);*/
 	
-	ym2608_update_one(info->chip, DUMMYBUF, 0);
+	ym2608_update_one(info->chip, dummybuf, 0);
 	/*// Not necessary.
 	//if (info->psg != NULL)
-	//	ay8910_update_one(info->psg, DUMMYBUF, 0);*/
+	//	ay8910_update_one(info->psg, dummybuf, 0);*/
 }
 
 /*static STREAM_UPDATE( ym2608_stream_update )*/
-void ym2608_stream_update(UINT8 ChipID, stream_sample_t **outputs, int samples)
+void ym2608_stream_update(void *chip, stream_sample_t **outputs, int samples)
 {
 	/*ym2608_state *info = (ym2608_state *)param;*/
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	ym2608_update_one(info->chip, outputs, samples);
 }
 
-void ym2608_stream_update_ay(UINT8 ChipID, stream_sample_t **outputs, int samples)
+void ym2608_stream_update_ay(void *chip, stream_sample_t **outputs, int samples)
 {
 	/*ym2608_state *info = (ym2608_state *)param;*/
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -229,16 +227,16 @@ void ym2608_stream_update_ay(UINT8 ChipID, stream_sample_t **outputs, int sample
 
 
 /*static STATE_POSTLOAD( ym2608_intf_postload )*/
-/*static void ym2608_intf_postload(UINT8 ChipID)
+/*static void ym2608_intf_postload(void *chip)
 {
 	//ym2608_state *info = (ym2608_state *)param;
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	ym2608_postload(info->chip);
 }*/
 
 
 /*static DEVICE_START( ym2608 )*/
-int device_start_ym2608(UINT8 ChipID, int clock, UINT8 AYDisable, UINT8 AYFlags, int* AYrate, offs_t dramSize)
+void* device_start_ym2608(int clock, UINT8 AYEmuCore, UINT8 AYDisable, UINT8 AYFlags, int* rate, int* AYrate, offs_t dramSize)
 {
 	static const ym2608_interface generic_2608 =
 	{
@@ -251,7 +249,6 @@ int device_start_ym2608(UINT8 ChipID, int clock, UINT8 AYDisable, UINT8 AYFlags,
 	};
 	/*const ym2608_interface *intf = device->static_config ? (const ym2608_interface *)device->static_config : &generic_2608;*/
 	ym2608_interface *intf;
-	int rate;
 	int ay_clock;
 	/*void *pcmbufa;
 	int  pcmsizea;*/
@@ -259,15 +256,18 @@ int device_start_ym2608(UINT8 ChipID, int clock, UINT8 AYDisable, UINT8 AYFlags,
 	/*ym2608_state *info = get_safe_token(device);*/
 	ym2608_state *info;
 
-	if (ChipID >= MAX_CHIPS)
-		return 0;
-	
-	info = &YM2608Data[ChipID];
-	rate = clock / 144;	/* FM synthesis rate is clock / 2 / 72 */
+	info = (ym2608_state *)calloc(1, sizeof(ym2608_state));
+	if (info == NULL)
+		return NULL;
+
+	*rate = clock / 144;	/* FM synthesis rate is clock / 2 / 72 */
 	/*rate = clock/72;*/
-	if ((CHIP_SAMPLING_MODE == 0x01 && rate < CHIP_SAMPLE_RATE) ||
-			CHIP_SAMPLING_MODE == 0x02)
-		rate = CHIP_SAMPLE_RATE;
+#ifdef ENABLE_ALL_CORES
+	info->ay_emu_core = (AYEmuCore < 0x02) ? AYEmuCore : 0x00;
+#else
+	(void)AYEmuCore;
+	info->ay_emu_core = EC_EMU2149;
+#endif
 	info->intf = generic_2608;
 	intf = &info->intf;
 	if (AYFlags)
@@ -280,7 +280,7 @@ int device_start_ym2608(UINT8 ChipID, int clock, UINT8 AYDisable, UINT8 AYFlags,
 	{
 		ay_clock = clock / 4;
 		*AYrate = ay_clock / 8;
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -290,7 +290,10 @@ int device_start_ym2608(UINT8 ChipID, int clock, UINT8 AYDisable, UINT8 AYFlags,
 		case EC_EMU2149:
 			info->psg = PSG_new(ay_clock, *AYrate);
 			if (info->psg == NULL)
-				return 0;
+			{
+				free(info);
+				return NULL;
+			}
 			PSG_setVolumeMode((PSG*)info->psg, 1);	/* YM2149 volume mode */
 			break;
 		}
@@ -318,21 +321,22 @@ int device_start_ym2608(UINT8 ChipID, int clock, UINT8 AYDisable, UINT8 AYFlags,
 	//	           timer_handler,IRQHandler,&psgintf);*/
 	/*info->chip = ym2608_init(info, clock, rate, NULL, NULL, &psgintf);
 	assert_always(info->chip != NULL, "Error creating YM2608 chip");*/
-	info->chip = ym2608_init(info, clock, rate, dramSize, NULL, NULL, &psgintf);
+	info->dram_size = dramSize;
+	info->chip = ym2608_init(info, clock, *rate, dramSize, NULL, NULL, &psgintf);
 	/*state_save_register_postload(device->machine, ym2608_intf_postload, info);*/
 	
-	return rate;
+	return info;
 }
 
 /*static DEVICE_STOP( ym2608 )*/
-void device_stop_ym2608(UINT8 ChipID)
+void device_stop_ym2608(void *chip)
 {
 	/*ym2608_state *info = get_safe_token(device);*/
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	ym2608_shutdown(info->chip);
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -345,103 +349,99 @@ void device_stop_ym2608(UINT8 ChipID)
 		}
 		info->psg = NULL;
 	}
+	free(info);
 }
 
 /*static DEVICE_RESET( ym2608 )*/
-void device_reset_ym2608(UINT8 ChipID)
+void device_reset_ym2608(void *chip)
 {
 	/*ym2608_state *info = get_safe_token(device);*/
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	ym2608_reset_chip(info->chip);	/* also resets the AY clock */
 	/*//psg_reset(info);	// already done as a callback in ym2608_reset_chip*/
 }
 
 
 /*READ8_DEVICE_HANDLER( ym2608_r )*/
-UINT8 ym2608_r(UINT8 ChipID, offs_t offset)
+UINT8 ym2608_r(void *chip, offs_t offset)
 {
 	/*ym2608_state *info = get_safe_token(device);*/
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	return ym2608_read(info->chip, offset & 3);
 }
 
 /*WRITE8_DEVICE_HANDLER( ym2608_w )*/
-void ym2608_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ym2608_w(void *chip, offs_t offset, UINT8 data)
 {
 	/*ym2608_state *info = get_safe_token(device);*/
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	ym2608_write(info->chip, offset & 3, data);
 }
 
 /*READ8_DEVICE_HANDLER( ym2608_read_port_r )*/
-UINT8 ym2608_read_port_r(UINT8 ChipID, offs_t offset)
+UINT8 ym2608_read_port_r(void *chip, offs_t offset)
 {
 	(void)offset;
-	return ym2608_r(ChipID, 1);
+	return ym2608_r(chip, 1);
 }
 /*//READ8_DEVICE_HANDLER( ym2608_status_port_a_r )
-//UINT8 ym2608_status_port_a_r(UINT8 ChipID, offs_t offset)
+//UINT8 ym2608_status_port_a_r(void *chip, offs_t offset)
 //{
-//	return ym2608_r(ChipID, 0);
+//	return ym2608_r(chip, 0);
 //}
 //READ8_DEVICE_HANDLER( ym2608_status_port_b_r )
-//UINT8 ym2608_status_port_b_r(UINT8 ChipID, offs_t offset)
+//UINT8 ym2608_status_port_b_r(void *chip, offs_t offset)
 //{
-//	return ym2608_r(ChipID, 2);
+//	return ym2608_r(chip, 2);
 //}*/
 
 /*WRITE8_DEVICE_HANDLER( ym2608_control_port_a_w )*/
-void ym2608_control_port_a_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ym2608_control_port_a_w(void *chip, offs_t offset, UINT8 data)
 {
 	(void)offset;
-	ym2608_w(ChipID, 0, data);
+	ym2608_w(chip, 0, data);
 }
 /*WRITE8_DEVICE_HANDLER( ym2608_control_port_b_w )*/
-void ym2608_control_port_b_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ym2608_control_port_b_w(void *chip, offs_t offset, UINT8 data)
 {
 	(void)offset;
-	ym2608_w(ChipID, 2, data);
+	ym2608_w(chip, 2, data);
 }
 /*WRITE8_DEVICE_HANDLER( ym2608_data_port_a_w )*/
-void ym2608_data_port_a_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ym2608_data_port_a_w(void *chip, offs_t offset, UINT8 data)
 {
 	(void)offset;
-	ym2608_w(ChipID, 1, data);
+	ym2608_w(chip, 1, data);
 }
 /*WRITE8_DEVICE_HANDLER( ym2608_data_port_b_w )*/
-void ym2608_data_port_b_w(UINT8 ChipID, offs_t offset, UINT8 data)
+void ym2608_data_port_b_w(void *chip, offs_t offset, UINT8 data)
 {
 	(void)offset;
-	ym2608_w(ChipID, 3, data);
+	ym2608_w(chip, 3, data);
 }
 
 
-void ym2608_set_ay_emu_core(UINT8 Emulator)
-{
-#ifdef ENABLE_ALL_CORES
-	AY_EMU_CORE = (Emulator < 0x02) ? Emulator : 0x00;
-#else
-	(void)Emulator;
-	AY_EMU_CORE = EC_EMU2149;
-#endif
-	
-	return;
-}
-
-/*void ym2608_write_data_pcmrom(UINT8 ChipID, UINT8 rom_id, offs_t ROMSize, offs_t DataStart,
+/*void ym2608_write_data_pcmrom(void *chip, UINT8 rom_id, offs_t ROMSize, offs_t DataStart,
 							  offs_t DataLength, const UINT8* ROMData)
 {
-	ym2608_state* info = &YM2608Data[ChipID];
+	ym2608_state* info = (ym2608_state *)chip;
 	ym2608_write_pcmrom(info->chip, rom_id, ROMSize, DataStart, DataLength, ROMData);
 }*/
 
-void ym2608_set_mute_mask(UINT8 ChipID, UINT32 MuteMaskFM, UINT32 MuteMaskAY)
+/* Copy data into the DELTA-T DRAM directly instead of writing register $08 byte by byte */
+void ym2608_write_dram(void *chip, offs_t address, const UINT8* data, offs_t size)
+{
+	ym2608_state* info = (ym2608_state *)chip;
+	ym2608_write_pcmrom(info->chip, 0x02, info->dram_size, address, size, data);
+}
+
+void ym2608_set_mute_mask(void *chip, UINT32 MuteMaskFM, UINT32 MuteMaskAY)
 {
-	ym2608_state* info = &YM2608Data[ChipID];
+	ym2608_state* info = (ym2608_state *)chip;
 	ym2608_set_mutemask(info->chip, MuteMaskFM);
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -455,13 +455,13 @@ void ym2608_set_mute_mask(UINT8 ChipID, UINT32 MuteMaskFM, UINT32 MuteMaskAY)
 	}
 }
 
-/*void ym2608_set_srchg_cb(UINT8 ChipID, SRATE_CALLBACK CallbackFunc, void* DataPtr, void* AYDataPtr)
+/*void ym2608_set_srchg_cb(void *chip, SRATE_CALLBACK CallbackFunc, void* DataPtr, void* AYDataPtr)
 {
-	ym2608_state* info = &YM2608Data[ChipID];
+	ym2608_state* info = (ym2608_state *)chip;
 
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -504,7 +504,6 @@ void ym2608_set_mute_mask(UINT8 ChipID, UINT32 MuteMaskFM, UINT32 MuteMaskAY)
 
 struct intf2608 mame_intf2608 =
 {
-	/*.set_ay_emu_core =*/ &ym2608_set_ay_emu_core,
 	/*.device_start =*/ &device_start_ym2608,
 	/*.device_stop =*/ &device_stop_ym2608,
 	/*.device_reset =*/ &device_reset_ym2608,
@@ -513,6 +512,7 @@ struct intf2608 mame_intf2608 =
 	/*.data_port_a_w =*/ &ym2608_data_port_a_w,
 	/*.data_port_b_w =*/ &ym2608_data_port_b_w,
 	/*.read_port_r =*/ &ym2608_read_port_r,
+	/*.write_dram =*/ &ym2608_write_dram,
 	/*.stream_update =*/ &ym2608_stream_update,
 	/*.stream_update_ay =*/ &ym2608_stream_update_ay,
 };
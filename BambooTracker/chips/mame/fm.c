@@ -1557,10 +1557,16 @@ static void reset_channels( FM_ST *ST , FM_CH *CH , int num )
 /* initialize generic tables */
 static int init_tables(void)
 {
+	/* Tables are shared by all chips, so build them only once
+	   (chip initialization is serialized by the caller) */
+	static int initialized = 0;
 	signed int i,x;
 	signed int n;
 	double o,m;
 
+	if (initialized)
+		return 1;
+
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
@@ -1666,6 +1672,7 @@ static int init_tables(void)
 	sample[0]=fopen("sampsum.pcm","wb");
 #endif
 
+	initialized = 1;
 	return 1;
 
 }
@@ -2508,8 +2515,12 @@ static int jedi_table[ 49*16 ];
 
 static void Init_ADPCMATable(void)
 {
+	static int initialized = 0;
 	int step, nib;
 
+	if (initialized)
+		return;
+
 	for (step = 0; step < 49; step++)
 	{
 		/* loop over all nibbles and compute the difference */
@@ -2519,6 +2530,8 @@ static void Init_ADPCMATable(void)
 			jedi_table[step*16 + nib] = (nib&0x08) ? -value : value;
 		}
 	}
+
+	initialized = 1;
 }
 
 /* ADPCM A (Non control type) : calculate one channel output */
@@ -3604,6 +3617,9 @@ void * ym2608_init(void *param, int clock, int rate, offs_t dram_size,
 	//F2608->deltaT.memory_size = 0x00;
 	//F2608->deltaT.memory_mask = 0x00;*/
 	F2608->deltaT.memory = (UINT8*)realloc(F2608->deltaT.memory, dram_size);
+	/* clear DRAM so that rendering does not depend on leftover heap data */
+	if (F2608->deltaT.memory)
+		memset(F2608->deltaT.memory, 0, dram_size);
 	F2608->deltaT.memory_size = dram_size;
 	YM_DELTAT_calc_mem_mask(&F2608->deltaT);
 
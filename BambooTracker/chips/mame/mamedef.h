@@ -71,8 +71,6 @@ typedef sample stream_sample_t;
 #define logerror
 #endif
 
-extern stream_sample_t* DUMMYBUF[];
-
 typedef void (*SRATE_CALLBACK)(void*, UINT32);
 
 #endif	/* __MAMEDEF_H__ */
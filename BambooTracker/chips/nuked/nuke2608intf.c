@@ -18,21 +18,17 @@ struct _ym2608_state
 	ym3438_t *		chip;
 	void *			psg;
 	int			clock;
+	uint8_t			ay_emu_core;
 	ym2608_interface intf;
 	uint32_t dramSize;
 };
 
-static uint8_t AY_EMU_CORE = 0x00;
-
-#define MAX_CHIPS	0x02
-static ym2608_state YM2608Data[MAX_CHIPS];
-
 static void psg_set_clock(void *param, int clock)
 {
 	ym2608_state *info = (ym2608_state *)param;
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -51,7 +47,7 @@ static void psg_write(void *param, int address, int data)
 	ym2608_state *info = (ym2608_state *)param;
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -70,7 +66,7 @@ static int psg_read(void *param)
 	ym2608_state *info = (ym2608_state *)param;
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -88,7 +84,7 @@ static void psg_reset(void *param)
 	ym2608_state *info = (ym2608_state *)param;
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -110,19 +106,7 @@ static const struct OPN2mod_psg_callbacks psgintf =
 	psg_reset
 };
 
-void nuke2608_set_ay_emu_core(uint8_t Emulator)
-{
-#ifdef ENABLE_ALL_CORES
-	AY_EMU_CORE = (Emulator < 0x02) ? Emulator : 0x00;
-#else
-	(void)Emulator;
-	AY_EMU_CORE = EC_EMU2149;
-#endif
-
-	return;
-}
-
-int device_start_nuke2608(uint8_t ChipID, int clock, uint8_t AYDisable, uint8_t AYFlags, int *AYrate, uint32_t dramSize)
+void* device_start_nuke2608(int clock, uint8_t AYEmuCore, uint8_t AYDisable, uint8_t AYFlags, int *rate, int *AYrate, uint32_t dramSize)
 {
 	static const ym2608_interface generic_2608 =
 	{
@@ -135,15 +119,20 @@ int device_start_nuke2608(uint8_t ChipID, int clock, uint8_t AYDisable, uint8_t
 	};
 	ym2608_interface *intf;
 	ym2608_state *info;
-	int rate;
 	int ay_clock;
 
-	if (ChipID >= MAX_CHIPS)
-		return 0;
+	info = (ym2608_state *)calloc(1, sizeof(ym2608_state));
+	if (!info)
+		return NULL;
 
-	info = &YM2608Data[ChipID];
 	info->clock = clock;
-	rate = clock / 144;	/* FM synthesis rate is clock / 2 / 72 */
+	*rate = clock / 144;	/* FM synthesis rate is clock / 2 / 72 */
+#ifdef ENABLE_ALL_CORES
+	info->ay_emu_core = (AYEmuCore < 0x02) ? AYEmuCore : 0x00;
+#else
+	(void)AYEmuCore;
+	info->ay_emu_core = EC_EMU2149;
+#endif
 
 	info->intf = generic_2608;
 	intf = &info->intf;
@@ -152,7 +141,10 @@ int device_start_nuke2608(uint8_t ChipID, int clock, uint8_t AYDisable, uint8_t
 
 	info->chip = (ym3438_t *)calloc(1, sizeof(ym3438_t));
 	if (!info->chip)
-		return 0;
+	{
+		free(info);
+		return NULL;
+	}
 
 	/* FIXME: Force to use single output */
 	/*info->psg = ay8910_start_ym(NULL, SOUND_YM2608, clock, &intf->ay8910_intf);*/
@@ -160,7 +152,7 @@ int device_start_nuke2608(uint8_t ChipID, int clock, uint8_t AYDisable, uint8_t
 	{
 		ay_clock = clock / 4;
 		*AYrate = ay_clock / 8;
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -170,7 +162,11 @@ int device_start_nuke2608(uint8_t ChipID, int clock, uint8_t AYDisable, uint8_t
 		case EC_EMU2149:
 			info->psg = PSG_new(ay_clock, *AYrate);
 			if (info->psg == NULL)
-				return 0;
+			{
+				free(info->chip);
+				free(info);
+				return NULL;
+			}
 			PSG_setVolumeMode((PSG*)info->psg, 1);	/* YM2149 volume mode */
 			break;
 		}
@@ -184,17 +180,17 @@ int device_start_nuke2608(uint8_t ChipID, int clock, uint8_t AYDisable, uint8_t
 	info->dramSize = dramSize;
 	OPN2_Reset(info->chip, clock, &psgintf, info, dramSize);
 
-	return rate;
+	return info;
 }
 
-void device_stop_nuke2608(uint8_t ChipID)
+void device_stop_nuke2608(void *chip)
 {
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	OPN2_Destroy(info->chip);
 	free(info->chip);
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -207,73 +203,76 @@ void device_stop_nuke2608(uint8_t ChipID)
 		}
 		info->psg = NULL;
 	}
+	free(info);
 }
 
-void device_reset_nuke2608(uint8_t ChipID)
+void device_reset_nuke2608(void *chip)
 {
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	OPN2_FlushBuffer(info->chip);
 	OPN2_Reset(info->chip, info->clock, &psgintf, info, info->dramSize);
 }
 
-void nuke2608_control_port_a_w(uint8_t ChipID, uint32_t offset, uint8_t data)
+void nuke2608_control_port_a_w(void *chip, uint32_t offset, uint8_t data)
 {
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	(void)offset;
 	OPN2_WriteBuffered(info->chip, 0, data);
 }
 
-void nuke2608_control_port_b_w(uint8_t ChipID, uint32_t offset, uint8_t data)
+void nuke2608_control_port_b_w(void *chip, uint32_t offset, uint8_t data)
 {
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	(void)offset;
 	OPN2_WriteBuffered(info->chip, 2, data);
 }
 
-void nuke2608_data_port_a_w(uint8_t ChipID, uint32_t offset, uint8_t data)
+void nuke2608_data_port_a_w(void *chip, uint32_t offset, uint8_t data)
 {
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	(void)offset;
 	OPN2_WriteBuffered(info->chip, 1, data);
 }
 
-void nuke2608_data_port_b_w(uint8_t ChipID, uint32_t offset, uint8_t data)
+void nuke2608_data_port_b_w(void *chip, uint32_t offset, uint8_t data)
 {
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	(void)offset;
 	OPN2_WriteBuffered(info->chip, 3, data);
 }
 
-uint8_t nuke2608_read_port_r(uint8_t ChipID, uint32_t offset)
+uint8_t nuke2608_read_port_r(void *chip, uint32_t offset)
 {
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 	(void)offset;
 	return OPN2_Read(info->chip, 1);
 }
 
-void nuke2608_stream_update(uint8_t ChipID, sample **outputs, int samples)
+void nuke2608_write_dram(void *chip, uint32_t address, const uint8_t *data, uint32_t size)
 {
-	int i;
-	ym2608_state *info = &YM2608Data[ChipID];
-	sample *bufl = outputs[0];
-	sample *bufr = outputs[1];
+	ym2608_state *info = (ym2608_state *)chip;
+	uint32_t memsize = info->chip->deltaT.memory_size;
+
+	if (address >= memsize)
+		return;
+	if (size > memsize - address)
+		size = memsize - address;
+	memcpy(info->chip->deltaT.memory + address, data, size);
+}
 
-	for (i = 0; i < samples; ++i)
-	{
-		sample lr[2];
-		OPN2_Generate(info->chip, lr);
-		*bufl++ = lr[0];
-		*bufr++ = lr[1];
-	}
+void nuke2608_stream_update(void *chip, sample **outputs, int samples)
+{
+	ym2608_state *info = (ym2608_state *)chip;
+	OPN2_GenerateStream(info->chip, outputs[0], outputs[1], (uint32_t)samples);
 }
 
-void nuke2608_stream_update_ay(uint8_t ChipID, sample **outputs, int samples)
+void nuke2608_stream_update_ay(void *chip, sample **outputs, int samples)
 {
-	ym2608_state *info = &YM2608Data[ChipID];
+	ym2608_state *info = (ym2608_state *)chip;
 
 	if (info->psg != NULL)
 	{
-		switch(AY_EMU_CORE)
+		switch(info->ay_emu_core)
 		{
 #ifdef ENABLE_ALL_CORES
 		case EC_MAME:
@@ -294,7 +293,6 @@ void nuke2608_stream_update_ay(uint8_t ChipID, sample **outputs, int samples)
 
 struct intf2608 nuked_intf2608 =
 {
-	/*.set_ay_emu_core =*/ &nuke2608_set_ay_emu_core,
 	/*.device_start =*/ &device_start_nuke2608,
 	/*.device_stop =*/ &device_stop_nuke2608,
 	/*.device_reset =*/ &device_reset_nuke2608,
@@ -303,6 +301,7 @@ struct intf2608 nuked_intf2608 =
 	/*.data_port_a_w =*/ &nuke2608_data_port_a_w,
 	/*.data_port_b_w =*/ &nuke2608_data_port_b_w,
 	/*.read_port_r =*/ &nuke2608_read_port_r,
+	/*.write_dram =*/ &nuke2608_write_dram,
 	/*.stream_update =*/ &nuke2608_stream_update,
 	/*.stream_update_ay =*/ &nuke2608_stream_update_ay,
 };
@@ -293,7 +293,7 @@ static const int adpcm_step_inc[8] = { -1*16, -1*16, -1*16, -1*16, 2*16, 5*16, 7
 static Bit32u chip_type = ym3438_mode_readmode;
 
 /*OPN-MOD: update ADPCM volume*/
-void OPNmod_RhythmUpdateVolume(ym3438_t *chip, Bit32u channel)
+static void OPNmod_RhythmUpdateVolume(ym3438_t *chip, Bit32u channel)
 {
     Bit8u volume = chip->rhythm_tl + chip->rhythm_level[channel];
 
@@ -311,7 +311,7 @@ void OPNmod_RhythmUpdateVolume(ym3438_t *chip, Bit32u channel)
     }
 }
 
-void OPN2_DoIO(ym3438_t *chip)
+static void OPN2_DoIO(ym3438_t *chip)
 {
     /* Write signal check */
     chip->write_a_en = (chip->write_a & 0x03) == 0x01;
@@ -325,7 +325,7 @@ void OPN2_DoIO(ym3438_t *chip)
     chip->write_busy_cnt &= 0x1f;
 }
 
-void OPN2_DoRegWrite(ym3438_t *chip)
+static void OPN2_DoRegWrite(ym3438_t *chip)
 {
     Bit32u i;
     Bit32u slot = chip->cycles % 12;
@@ -625,7 +625,7 @@ void OPN2_DoRegWrite(ym3438_t *chip)
     }
 }
 
-void OPN2_PhaseCalcIncrement(ym3438_t *chip)
+static void OPN2_PhaseCalcIncrement(ym3438_t *chip)
 {
     Bit32u chan = chip->channel;
     Bit32u slot = chip->cycles;
@@ -694,7 +694,7 @@ void OPN2_PhaseCalcIncrement(ym3438_t *chip)
     chip->pg_inc[slot] &= 0xfffff;
 }
 
-void OPN2_PhaseGenerate(ym3438_t *chip)
+static void OPN2_PhaseGenerate(ym3438_t *chip)
 {
     Bit32u slot;
     /* Mask increment */
@@ -713,7 +713,7 @@ void OPN2_PhaseGenerate(ym3438_t *chip)
     }
 }
 
-void OPN2_EnvelopeSSGEG(ym3438_t *chip)
+static void OPN2_EnvelopeSSGEG(ym3438_t *chip)
 {
     Bit32u slot = chip->cycles;
     Bit8u direction = 0;
@@ -760,7 +760,7 @@ void OPN2_EnvelopeSSGEG(ym3438_t *chip)
     chip->eg_ssg_enable[slot] = (chip->ssg_eg[slot] >> 3) & 0x01;
 }
 
-void OPN2_EnvelopeADSR(ym3438_t *chip)
+static void OPN2_EnvelopeADSR(ym3438_t *chip)
 {
     Bit32u slot = (chip->cycles + 22) % 24;
 
@@ -884,7 +884,7 @@ void OPN2_EnvelopeADSR(ym3438_t *chip)
     chip->eg_state[slot] = nextstate;
 }
 
-void OPN2_EnvelopePrepare(ym3438_t *chip)
+static void OPN2_EnvelopePrepare(ym3438_t *chip)
 {
     Bit8u rate;
     Bit8u sum;
@@ -972,7 +972,7 @@ void OPN2_EnvelopePrepare(ym3438_t *chip)
     chip->eg_sl[0] = chip->sl[slot];
 }
 
-void OPN2_EnvelopeGenerate(ym3438_t *chip)
+static void OPN2_EnvelopeGenerate(ym3438_t *chip)
 {
     Bit32u slot = (chip->cycles + 23) % 24;
     Bit16u level;
@@ -1005,7 +1005,7 @@ void OPN2_EnvelopeGenerate(ym3438_t *chip)
     chip->eg_out[slot] = level;
 }
 
-void OPN2_UpdateLFO(ym3438_t *chip)
+static void OPN2_UpdateLFO(ym3438_t *chip)
 {
     if ((chip->lfo_quotient & lfo_cycles[chip->lfo_freq]) == lfo_cycles[chip->lfo_freq])
     {
@@ -1019,7 +1019,7 @@ void OPN2_UpdateLFO(ym3438_t *chip)
     chip->lfo_cnt &= chip->lfo_en;
 }
 
-void OPN2_FMPrepare(ym3438_t *chip)
+static void OPN2_FMPrepare(ym3438_t *chip)
 {
     Bit32u slot = (chip->cycles + 6) % 24;
     Bit32u channel = chip->channel;
@@ -1081,7 +1081,7 @@ void OPN2_FMPrepare(ym3438_t *chip)
     }
 }
 
-void OPN2_ChGenerate(ym3438_t *chip)
+static void OPN2_ChGenerate(ym3438_t *chip)
 {
     Bit32u slot = (chip->cycles + 18) % 24;
     Bit32u channel = chip->channel;
@@ -1122,7 +1122,7 @@ void OPN2_ChGenerate(ym3438_t *chip)
     chip->ch_acc[channel] = sum;
 }
 
-void OPN2_ChOutput(ym3438_t *chip)
+static void OPN2_ChOutput(ym3438_t *chip)
 {
     Bit32u cycles = chip->cycles;
     Bit32u slot = chip->cycles;
@@ -1205,7 +1205,7 @@ void OPN2_ChOutput(ym3438_t *chip)
     }
 }
 
-void OPN2_FMGenerate(ym3438_t *chip)
+static void OPN2_FMGenerate(ym3438_t *chip)
 {
     Bit32u slot = (chip->cycles + 19) % 24;
     /* Calculate phase */
@@ -1244,7 +1244,7 @@ void OPN2_FMGenerate(ym3438_t *chip)
 }
 
 /*OPN-MOD: generate ADPCM rhythm*/
-void OPNmod_RhythmGenerate(ym3438_t *chip)
+static void OPNmod_RhythmGenerate(ym3438_t *chip)
 {
     Bit32u channel = chip->channel;
     Bit32s out = 0;
@@ -1328,7 +1328,7 @@ void OPNmod_RhythmGenerate(ym3438_t *chip)
 }
 
 /*OPN-MOD: generate ADPCM DeltaT*/
-void OPNmod_DeltaTGenerate(ym3438_t *chip)
+static void OPNmod_DeltaTGenerate(ym3438_t *chip)
 {
     Bit32u channel = chip->channel;
 
@@ -1353,7 +1353,7 @@ void OPNmod_DeltaTGenerate(ym3438_t *chip)
     }
 }
 
-void OPN2_DoTimerA(ym3438_t *chip)
+static void OPN2_DoTimerA(ym3438_t *chip)
 {
     Bit16u time;
     Bit8u load;
@@ -1402,7 +1402,7 @@ void OPN2_DoTimerA(ym3438_t *chip)
     chip->timer_a_cnt = time & 0x3ff;
 }
 
-void OPN2_DoTimerB(ym3438_t *chip)
+static void OPN2_DoTimerB(ym3438_t *chip)
 {
     Bit16u time;
     Bit8u load;
@@ -1447,7 +1447,7 @@ void OPN2_DoTimerB(ym3438_t *chip)
     chip->timer_b_cnt = time & 0xff;
 }
 
-void OPN2_KeyOn(ym3438_t*chip)
+static void OPN2_KeyOn(ym3438_t*chip)
 {
     Bit32u slot = chip->cycles;
     Bit32u chan = chip->channel;
@@ -1560,7 +1560,7 @@ void OPN2_SetChipType(Bit32u type)
     chip_type = type;
 }
 
-void OPN2_Clock(ym3438_t *chip, Bit16s *buffer)
+static void OPN2_DoClock(ym3438_t *chip, Bit16s *buffer)
 {
     Bit32u slot = chip->cycles;
     Bit16s *rhythml = &chip->rhythml[chip->channel];
@@ -1710,6 +1710,11 @@ void OPN2_Clock(ym3438_t *chip, Bit16s *buffer)
         chip->status_time--;
 }
 
+void OPN2_Clock(ym3438_t *chip, Bit16s *buffer)
+{
+    OPN2_DoClock(chip, buffer);
+}
+
 void OPN2_Write(ym3438_t *chip, Bit32u port, Bit8u data)
 {
     port &= 3;
@@ -1917,3 +1922,38 @@ void OPN2_Generate(ym3438_t *chip, sample *samples)
         chip->writebuf_samplecnt++;
     }
 }
+
+/*OPN-MOD: generate a block of samples, identical to calling OPN2_Generate for each*/
+void OPN2_GenerateStream(ym3438_t *chip, sample *bufl, sample *bufr, Bit32u numsamples)
+{
+    Bit32u i, j;
+    Bit16s buffer[6];
+    opn2_writebuf *wb;
+
+    for (i = 0; i < numsamples; i++)
+    {
+        sample l = 0;
+        sample r = 0;
+
+        for (j = 0; j < 24; j++)
+        {
+            OPN2_DoClock(chip, buffer);
+
+            l += buffer[0] * 11 + buffer[2] + buffer[4];
+            r += buffer[1] * 11 + buffer[3] + buffer[5];
+
+            wb = &chip->writebuf[chip->writebuf_cur];
+            while ((wb->port & 0x04) && wb->time <= chip->writebuf_samplecnt)
+            {
+                wb->port &= 0x03;
+                OPN2_Write(chip, wb->port, wb->data);
+                chip->writebuf_cur = (chip->writebuf_cur + 1) % OPN_WRITEBUF_SIZE;
+                wb = &chip->writebuf[chip->writebuf_cur];
+            }
+            chip->writebuf_samplecnt++;
+        }
+
+        *bufl++ = l;
+        *bufr++ = r;
+    }
+}
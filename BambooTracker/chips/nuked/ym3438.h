@@ -270,6 +270,7 @@ Bit8u OPN2_Read(ym3438_t *chip, Bit32u port);
 void OPN2_WriteBuffered(ym3438_t *chip, Bit32u port, Bit8u data);
 void OPN2_FlushBuffer(ym3438_t *chip);
 void OPN2_Generate(ym3438_t *chip, sample *samples);
+void OPN2_GenerateStream(ym3438_t *chip, sample *bufl, sample *bufr, Bit32u numsamples);
 
 /*OPN-MOD*/
 struct OPN2mod_psg_callbacks
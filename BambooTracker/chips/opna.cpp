@@ -26,7 +26,10 @@
 #include "opna.hpp"
 #include <cstdint>
 #include <cmath>
+#include <stdexcept>
+#include <thread>
 #include "chip_misc.hpp"
+#include "dsp_kernel.hpp"
 
 #ifdef  __cplusplus
 extern "C"
@@ -42,14 +45,19 @@ extern "C"
 
 namespace chip
 {
-	size_t OPNA::count_ = 0;
+	std::mutex OPNA::tableInitMutex_;
 
 	OPNA::OPNA(Emu emu, int clock, int rate, size_t maxDuration, size_t dramSize,
 			   std::unique_ptr<AbstractResampler> fmResampler, std::unique_ptr<AbstractResampler> ssgResampler,
 			   std::shared_ptr<ExportContainerInterface> exportContainer)
-		: Chip(count_++, clock, rate, 110933, maxDuration,
+		: Chip(clock, rate, 110933, maxDuration,
 			   std::move(fmResampler), std::move(ssgResampler),	// autoRate = 110933: FM internal rate
 			   exportContainer),
+		  core_(nullptr),
+		  dramSize_(dramSize),
+		  regWrites_(REG_WRITE_QUEUE_SIZE_),
+		  sampleTime_(0),
+		  writeOffset_(0),
 		  scciManager_(nullptr),
 		  scciChip_(nullptr),
 		  c86ctlBase_(nullptr),
@@ -72,14 +80,17 @@ namespace chip
 
 		funcSetRate(rate);
 
-		uint8_t EmuCore = 0;
-		intf_->set_ay_emu_core(EmuCore);
-
-		uint8_t AYDisable = 0;	// Enable
-		uint8_t AYFlags = 0;		// None
-		internalRate_[FM] = intf_->device_start(
-								id_, clock, AYDisable, AYFlags,
-								reinterpret_cast<int*>(&internalRate_[SSG]), dramSize);
+		{
+			// The first start builds the lookup tables shared by all instances
+			std::lock_guard<std::mutex> lg(tableInitMutex_);
+
+			uint8_t EmuCore = 0;
+			uint8_t AYDisable = 0;	// Enable
+			uint8_t AYFlags = 0;		// None
+			core_ = intf_->device_start(clock, EmuCore, AYDisable, AYFlags,
+										&internalRate_[FM], &internalRate_[SSG], static_cast<uint32_t>(dramSize));
+		}
+		if (!core_) throw std::runtime_error("Failed to start OPNA emulator");
 
 		initResampler();
 
@@ -91,9 +102,7 @@ namespace chip
 
 	OPNA::~OPNA()
 	{
-		intf_->device_stop(id_);
-
-		--count_;
+		intf_->device_stop(core_);
 
 		useSCCI(nullptr);
 		useC86CTL(nullptr);
@@ -101,9 +110,10 @@ namespace chip
 
 	void OPNA::reset()
 	{
-		std::lock_guard<std::mutex> lg(mutex_);
+		CoreClaim claim(*this);
 
-		intf_->device_reset(id_);
+		applyRegisterWrites();
+		intf_->device_reset(core_);
 
 		if (scciChip_) scciChip_->init();
 		if (c86ctlRC_) c86ctlRC_->resetChip();
@@ -111,50 +121,105 @@ namespace chip
 
 	void OPNA::setRegister(uint32_t offset, uint8_t value)
 	{
-		std::lock_guard<std::mutex> lg(mutex_);
+		std::lock_guard<std::mutex> lg(writeMutex_);
+
+		// The offset applies only to the thread that set it, the others write at the block head
+		uint64_t time = sampleTime_.load(std::memory_order_relaxed);
+		if (std::this_thread::get_id() == writeOffsetThread_) time += writeOffset_;
+		if (!regWrites_.push({ time, offset, value })) {
+			// The queue is full (e.g. bulk DRAM transfer), apply it synchronously
+			CoreClaim claim(*this);
+			applyRegisterWrites();
+			writeRegister(offset, value);
+		}
+
+		if (scciChip_) scciChip_->setRegister(offset, value);
+		if (c86ctlRC_) c86ctlRC_->out(offset, value);
+	}
 
+	void OPNA::writeRegister(uint32_t offset, uint8_t value)
+	{
 		if (needSampleGen_) {
 			if (offset & 0x100) {
-				intf_->control_port_b_w(id_, 2, offset & 0xff);
-				intf_->data_port_b_w(id_, 3, value & 0xff);
+				intf_->control_port_b_w(core_, 2, offset & 0xff);
+				intf_->data_port_b_w(core_, 3, value & 0xff);
 			}
 			else
 			{
-				intf_->control_port_a_w(id_, 0, offset & 0xff);
-				intf_->data_port_a_w(id_, 1, value & 0xff);
+				intf_->control_port_a_w(core_, 0, offset & 0xff);
+				intf_->data_port_a_w(core_, 1, value & 0xff);
 			}
 		}
 
-		if (scciChip_) scciChip_->setRegister(offset, value);
-		if (c86ctlRC_) c86ctlRC_->out(offset, value);
-
 		if (exCntr_) exCntr_->recordRegisterChange(offset, value);
 	}
 
+	void OPNA::flushRegisterWrites()
+	{
+		CoreClaim claim(*this);
+		applyRegisterWrites();
+	}
+
+	void OPNA::setRegisterWriteOffset(size_t offset)
+	{
+		std::lock_guard<std::mutex> lg(writeMutex_);
+		writeOffset_ = offset;
+		writeOffsetThread_ = std::this_thread::get_id();
+	}
+
+	void OPNA::writeDRAM(size_t address, const uint8_t* data, size_t size)
+	{
+		{
+			std::lock_guard<std::mutex> lg(writeMutex_);
+			CoreClaim claim(*this);
+
+			applyRegisterWrites();	// Apply the transfer setup in order
+			if (needSampleGen_)
+				intf_->write_dram(core_, static_cast<uint32_t>(address), data, static_cast<uint32_t>(size));
+			if (exCntr_) exCntr_->recordDRAMWrite(dramSize_, address, data, size);
+		}
+
+		// Real chips receive the data through the register
+		if (scciChip_ || c86ctlRC_) {
+			for (size_t i = 0; i < size; ++i) {
+				if (scciChip_) scciChip_->setRegister(0x108, data[i]);
+				if (c86ctlRC_) c86ctlRC_->out(0x108, data[i]);
+			}
+		}
+	}
+
+	void OPNA::applyRegisterWrites()
+	{
+		while (const RegisterWrite* w = regWrites_.front()) {
+			writeRegister(w->offset, w->value);
+			regWrites_.pop();
+		}
+	}
+
 	uint8_t OPNA::getRegister(uint32_t offset) const
 	{
 		if (offset & 0x100) {
-			intf_->control_port_b_w(id_, 2, offset & 0xff);
+			intf_->control_port_b_w(core_, 2, offset & 0xff);
 		}
 		else
 		{
-			intf_->control_port_a_w(id_, 0, offset & 0xff);
+			intf_->control_port_a_w(core_, 0, offset & 0xff);
 		}
-		return intf_->read_port_r(id_, 1);
+		return intf_->read_port_r(core_, 1);
 	}
 
 
 	void OPNA::setVolumeFM(double dB)
 	{
-		std::lock_guard<std::mutex> lg(mutex_);
 		volumeRatio_[FM] = std::pow(10.0, (dB - VOL_REDUC_) / 20.0);
 	}
 
 	void OPNA::setVolumeSSG(double dB)
 	{
-		std::lock_guard<std::mutex> lg(mutex_);
 		volumeRatio_[SSG] = std::pow(10.0, (dB - VOL_REDUC_) / 20.0);
 
+		std::lock_guard<std::mutex> lg(mutex_);
+
 		if (c86ctlGm_) {
 			// NOTE: estimate SSG volume roughly
 			uint8_t vol = static_cast<uint8_t>(std::round((dB < -3.0) ? (2.5 * dB + 45.5)
@@ -165,38 +230,108 @@ namespace chip
 
 	void OPNA::mix(int16_t* stream, size_t nSamples)
 	{
-		std::lock_guard<std::mutex> lg(mutex_);
+		mixStream(stream, nSamples);
+	}
+
+	void OPNA::mix(float* stream, size_t nSamples)
+	{
+		mixStream(stream, nSamples);
+	}
+
+	template <typename T>
+	void OPNA::mixStream(T* stream, size_t nSamples)
+	{
+		uint64_t time = sampleTime_.load(std::memory_order_relaxed);
+		const uint64_t end = time + nSamples;
+
+		acquireCore();
+
+		// Split the block at the sample positions of queued register writes
+		while (const RegisterWrite* w = regWrites_.front()) {
+			if (w->time >= end) break;
+			if (w->time > time) {
+				size_t count = static_cast<size_t>(w->time - time);
+				generateSamples(stream, count);
+				stream += (count << 1);
+				time = w->time;
+			}
+			writeRegister(w->offset, w->value);
+			regWrites_.pop();
+		}
+		generateSamples(stream, static_cast<size_t>(end - time));
+		releaseCore();
+
+		sampleTime_.store(end, std::memory_order_relaxed);
+	}
+
+	void OPNA::setExportContainer(std::shared_ptr<ExportContainerInterface> cntr)
+	{
+		CoreClaim claim(*this);
+
+		// Pending writes belong to the previous container
+		applyRegisterWrites();
+		Chip::setExportContainer(cntr);
+	}
+
+	void OPNA::synthesize(size_t nSamples, sample**& bufFM, sample**& bufSSG)
+	{
+		// Set FM buffer
+		if (internalRate_[FM] == rate_) {
+			intf_->stream_update(core_, buffer_[FM], nSamples);
+			bufFM = buffer_[FM];
+		}
+		else {
+			size_t intrSize = resampler_[FM]->calculateInternalSampleSize(nSamples);
+			intf_->stream_update(core_, buffer_[FM], intrSize);
+			bufFM = resampler_[FM]->interpolate(buffer_[FM], nSamples, intrSize);
+		}
+
+		// Set SSG buffer
+		if (internalRate_[SSG] == rate_) {
+			intf_->stream_update_ay(core_, buffer_[SSG], nSamples);
+			bufSSG = buffer_[SSG];
+		}
+		else {
+			size_t intrSize = resampler_[SSG]->calculateInternalSampleSize(nSamples);
+			intf_->stream_update_ay(core_, buffer_[SSG], intrSize);
+			bufSSG = resampler_[SSG]->interpolate(buffer_[SSG], nSamples, intrSize);
+		}
+	}
+
+	void OPNA::generateSamples(int16_t* stream, size_t nSamples)
+	{
+		if (!nSamples) return;
 
 		if (needSampleGen_) {
 			sample **bufFM, **bufSSG;
+			synthesize(nSamples, bufFM, bufSSG);
 
-			// Set FM buffer
-			if (internalRate_[FM] == rate_) {
-				intf_->stream_update(id_, buffer_[FM], nSamples);
-				bufFM = buffer_[FM];
-			}
-			else {
-				size_t intrSize = resampler_[FM]->calculateInternalSampleSize(nSamples);
-				intf_->stream_update(id_, buffer_[FM], intrSize);
-				bufFM = resampler_[FM]->interpolate(buffer_[FM], nSamples, intrSize);
-			}
+			// Mix down with Q16 fixed-point gains (master volume folded in)
+			const int64_t gainFM = std::llround(volumeRatio_[FM] * masterVolumeRatio_ * MIX_GAIN_ONE_);
+			const int64_t gainSSG = std::llround(volumeRatio_[SSG] * masterVolumeRatio_ * MIX_GAIN_ONE_);
+			mixDown(stream, bufFM[LEFT], bufFM[RIGHT], bufSSG[LEFT], bufSSG[RIGHT], gainFM, gainSSG, nSamples);
+		}
 
-			// Set SSG buffer
-			if (internalRate_[SSG] == rate_) {
-				intf_->stream_update_ay(id_, buffer_[SSG], nSamples);
-				bufSSG = buffer_[SSG];
-			}
-			else {
-				size_t intrSize = resampler_[SSG]->calculateInternalSampleSize(nSamples);
-				intf_->stream_update_ay(id_, buffer_[SSG], intrSize);
-				bufSSG = resampler_[SSG]->interpolate(buffer_[SSG], nSamples, intrSize);
-			}
-			int16_t* p = stream;
+		if (exCntr_) exCntr_->recordStream(stream, nSamples);
+	}
+
+	void OPNA::generateSamples(float* stream, size_t nSamples)
+	{
+		if (!nSamples) return;
+
+		if (needSampleGen_) {
+			sample **bufFM, **bufSSG;
+			synthesize(nSamples, bufFM, bufSSG);
+
+			// Mix down without clipping. 1.0 corresponds to the 16-bit full scale.
+			const float gainFM = static_cast<float>(volumeRatio_[FM] * masterVolumeRatio_ / 32768.0);
+			const float gainSSG = static_cast<float>(volumeRatio_[SSG] * masterVolumeRatio_ / 32768.0);
+			const sample *fmL = bufFM[LEFT], *fmR = bufFM[RIGHT];
+			const sample *ssgL = bufSSG[LEFT], *ssgR = bufSSG[RIGHT];
+			float* p = stream;
 			for (size_t i = 0; i < nSamples; ++i) {
-				for (int pan = LEFT; pan <= RIGHT; ++pan) {
-					double s = volumeRatio_[FM] * bufFM[pan][i] + volumeRatio_[SSG] * bufSSG[pan][i];
-					*p++ = static_cast<int16_t>(clamp(s * masterVolumeRatio_, -32768.0, 32767.0));
-				}
+				*p++ = gainFM * fmL[i] + gainSSG * ssgL[i];
+				*p++ = gainFM * fmR[i] + gainSSG * ssgR[i];
 			}
 		}
 
@@ -264,4 +399,9 @@ namespace chip
 	{
 		return (c86ctlBase_ != nullptr);
 	}
+
+	size_t OPNA::getDRAMSize() const
+	{
+		return dramSize_;
+	}
 }
@@ -27,7 +27,11 @@
 
 #include "chip.hpp"
 #include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
 #include "chip_misc.hpp"
+#include "register_write_queue.hpp"
 #include "scci/scci.hpp"
 #include "scci/SCCIDefines.hpp"
 #include "c86ctl/c86ctl_wrapper.hpp"
@@ -51,6 +55,16 @@ namespace chip
 		void setVolumeFM(double dB);
 		void setVolumeSSG(double dB);
 		void mix(int16_t* stream, size_t nSamples) override;
+		void mix(float* stream, size_t nSamples) override;
+		void setExportContainer(std::shared_ptr<ExportContainerInterface> cntr = nullptr) override;
+		/// Apply queued register writes immediately regardless of their sample position.
+		void flushRegisterWrites();
+		/// Stamp following register writes of the calling thread with the sample offset
+		/// in the next mixed block. Writes of other threads are placed at the block head.
+		void setRegisterWriteOffset(size_t offset);
+		/// Transfer data into the ADPCM DRAM in one block.
+		/// It is equivalent to writing each byte to $108 in memory write mode.
+		void writeDRAM(size_t address, const uint8_t* data, size_t size);
 		void useSCCI(scci::SoundInterfaceManager* manager);
 		bool isUsedSCCI() const;
 		void useC86CTL(C86ctlBase* base);
@@ -58,9 +72,32 @@ namespace chip
 		size_t getDRAMSize() const;
 
 	private:
-		static size_t count_;
+		/// Guard the lookup tables built by the emulator cores on their first start
+		static std::mutex tableInitMutex_;
 
 		intf2608* intf_;
+		/// Emulator state owned by this instance
+		void* core_;
+		const size_t dramSize_;
+
+		/// Register writes are queued by the producers and applied in mix()
+		/// at their sample position, so writers never wait for synthesis.
+		/// Producers are serialized by writeMutex_, consumers own the core
+		/// (the mixer or a CoreClaim).
+		RegisterWriteQueue regWrites_;
+		std::mutex writeMutex_;
+		std::atomic<uint64_t> sampleTime_;
+		/// Set by the stream thread for its tick, guarded by writeMutex_
+		size_t writeOffset_;
+		std::thread::id writeOffsetThread_;
+
+		void writeRegister(uint32_t offset, uint8_t value);
+		void applyRegisterWrites();
+		template <typename T>
+		void mixStream(T* stream, size_t nSamples);
+		void synthesize(size_t nSamples, sample**& bufFM, sample**& bufSSG);
+		void generateSamples(int16_t* stream, size_t nSamples);
+		void generateSamples(float* stream, size_t nSamples);
 
 		// For SCCI
 		scci::SoundInterfaceManager* scciManager_;
@@ -72,6 +109,8 @@ namespace chip
 		std::unique_ptr<C86ctlGimic> c86ctlGm_;
 
 		static constexpr double VOL_REDUC_ = 7.5;
+		static constexpr int64_t MIX_GAIN_ONE_ = 1 << 16;
+		static constexpr size_t REG_WRITE_QUEUE_SIZE_ = 0x2000;
 
 		enum SoundSource : int
 		{
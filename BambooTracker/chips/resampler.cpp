@@ -24,11 +24,14 @@
  */
 
 #include "resampler.hpp"
+#include <algorithm>
 #include "chip_misc.hpp"
+#include "dsp_kernel.hpp"
 
 namespace chip
 {
 	AbstractResampler::AbstractResampler()
+		: lastPan_(RIGHT)
 	{
 		for (int pan = LEFT; pan <= RIGHT; ++pan) {
 			destBuf_[pan] = new sample[SMPL_BUF_SIZE_]();
@@ -61,13 +64,18 @@ namespace chip
 		maxDuration_ = maxDuration;
 	}
 
+	void AbstractResampler::setMonaural(bool isMonaural)
+	{
+		lastPan_ = isMonaural ? LEFT : RIGHT;
+	}
+
 	/****************************************/
 	sample** LinearResampler::interpolate(sample** src, size_t nSamples, size_t intrSize)
 	{
 		(void)intrSize;
 
 		// Linear interplation
-		for (int pan = LEFT; pan <= RIGHT; ++pan) {
+		for (int pan = LEFT; pan <= lastPan_; ++pan) {
 			for (size_t n = 0; n < nSamples; ++n) {
 				float curnf = n * rateRatio_;
 				int curni = static_cast<int>(curnf);
@@ -83,4 +91,107 @@ namespace chip
 
 		return destBuf_;
 	}
+
+	/****************************************/
+	namespace
+	{
+		/// Modified Bessel function of the first kind, order 0
+		double besselI0(double x)
+		{
+			double sum = 1., term = 1.;
+			for (int k = 1; k < 32; ++k) {
+				term *= (x / (2. * k)) * (x / (2. * k));
+				sum += term;
+				if (term < sum * 1e-12) break;
+			}
+			return sum;
+		}
+	}
+
+	void SincResampler::init(int srcRate, int destRate, size_t maxDuration)
+	{
+		AbstractResampler::init(srcRate, destRate, maxDuration);
+		makeTable();
+	}
+
+	void SincResampler::setDestributionRate(int destRate)
+	{
+		AbstractResampler::setDestributionRate(destRate);
+		makeTable();
+	}
+
+	void SincResampler::makeTable()
+	{
+		// Cutoff by cycles per source sample
+		const double fc = 0.5 * std::min(1., static_cast<double>(destRate_) / srcRate_) * ROLLOFF_;
+		size_t halfLen = static_cast<size_t>(std::ceil(N_ZERO_CROSSINGS_ / (2. * fc)));
+		halfLen = (halfLen + 3) & ~static_cast<size_t>(3);	// Make taps multiple of 8
+		nTaps_ = halfLen * 2;
+
+		const double pi = std::acos(-1.);
+		const double i0Beta = besselI0(KAISER_BETA_);
+		table_.resize(N_PHASES_ * nTaps_);
+		for (int p = 0; p < N_PHASES_; ++p) {
+			float* row = &table_[p * nTaps_];
+			double sum = 0.;
+			for (size_t k = 0; k < nTaps_; ++k) {
+				// Distance from the output position to the tap
+				double d = static_cast<double>(k) - (halfLen - 1) - static_cast<double>(p) / N_PHASES_;
+				double x = 2. * fc * d;
+				double sinc = (d == 0.) ? 1. : std::sin(pi * x) / (pi * x);
+				double w = d / halfLen;
+				double win = (std::abs(w) < 1.) ? besselI0(KAISER_BETA_ * std::sqrt(1. - w * w)) / i0Beta : 0.;
+				double h = sinc * win;
+				row[k] = static_cast<float>(h);
+				sum += h;
+			}
+			for (size_t k = 0; k < nTaps_; ++k) row[k] = static_cast<float>(row[k] / sum);	// Unity gain
+		}
+
+		// Reset history, the first output is aligned with the first source sample
+		for (auto& buf : work_) buf.assign(nTaps_ + SMPL_BUF_SIZE_, 0.f);
+		nKept_ = halfLen - 1;
+		pos_ = 0;
+		phase_ = 0;
+	}
+
+	size_t SincResampler::calculateInternalSampleSize(size_t nSamples)
+	{
+		if (!nSamples) return 0;
+		uint64_t lastPos = pos_ + (phase_ + static_cast<uint64_t>(nSamples - 1) * srcRate_) / destRate_;
+		size_t need = static_cast<size_t>(lastPos) + nTaps_;
+		return (need > nKept_) ? std::min(need - nKept_, SMPL_BUF_SIZE_) : 0;
+	}
+
+	sample** SincResampler::interpolate(sample** src, size_t nSamples, size_t intrSize)
+	{
+		size_t pos = 0;
+		uint64_t phase = 0;
+		const size_t end = nKept_ + intrSize;	// End of valid source samples in work_
+		for (int pan = LEFT; pan <= lastPan_; ++pan) {
+			float* work = &work_[pan][0];
+			std::copy(src[pan], src[pan] + intrSize, work + nKept_);
+
+			pos = pos_;
+			phase = phase_;
+			// The window stays in the buffer even if the internal size was clamped
+			const size_t maxPos = work_[pan].size() - nTaps_;
+			for (size_t n = 0; n < nSamples; ++n) {
+				const float* coef = &table_[((phase * N_PHASES_) / static_cast<uint64_t>(destRate_)) * nTaps_];
+				destBuf_[pan][n] = static_cast<sample>(dotProduct(coef, work + pos, nTaps_));
+
+				phase += static_cast<uint64_t>(srcRate_);
+				pos = std::min(pos + static_cast<size_t>(phase / static_cast<uint64_t>(destRate_)), maxPos);
+				phase %= static_cast<uint64_t>(destRate_);
+			}
+
+			// Keep unused source samples for the next call
+			std::copy(work + std::min(pos, end), work + end, work);
+		}
+		nKept_ = (pos < end) ? end - pos : 0;
+		pos_ = 0;
+		phase_ = phase;
+
+		return destBuf_;
+	}
 }
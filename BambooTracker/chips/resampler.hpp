@@ -28,6 +28,8 @@
 #include "chip_def.h"
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace chip
 {
@@ -39,9 +41,11 @@ namespace chip
 		virtual void init(int srcRate, int destRate, size_t maxDuration);
 		virtual void setDestributionRate(int destRate);
 		virtual void setMaxDuration(size_t maxDuration);
+		/// Interpolate only the left channel if [isMonaural] is true
+		void setMonaural(bool isMonaural);
 		virtual sample** interpolate(sample** src, size_t nSamples, size_t intrSize) = 0;
 
-		inline size_t calculateInternalSampleSize(size_t nSamples)
+		virtual size_t calculateInternalSampleSize(size_t nSamples)
 		{
 			return static_cast<size_t>(std::ceil(nSamples * rateRatio_));
 		}
@@ -55,6 +59,7 @@ namespace chip
 		int srcRate_, destRate_;
 		size_t maxDuration_;
 		float rateRatio_;
+		int lastPan_;
 		sample* destBuf_[2];
 	};
 
@@ -64,4 +69,32 @@ namespace chip
 	public:
 		sample** interpolate(sample** src, size_t nSamples, size_t intrSize) override;
 	};
+
+
+	/// Band-limited resampler with a precomputed polyphase windowed-sinc table.
+	/// Source samples left over from the previous call and the fractional phase are kept,
+	/// so the number of internal samples requested in each call varies slightly.
+	class SincResampler : public AbstractResampler
+	{
+	public:
+		void init(int srcRate, int destRate, size_t maxDuration) override;
+		void setDestributionRate(int destRate) override;
+		size_t calculateInternalSampleSize(size_t nSamples) override;
+		sample** interpolate(sample** src, size_t nSamples, size_t intrSize) override;
+
+	private:
+		size_t nTaps_;
+		std::vector<float> table_;	// [phase][tap]
+		std::vector<float> work_[2];	// Kept source samples + new source samples
+		size_t nKept_;
+		size_t pos_;		// Start of the window of the next output sample in work_
+		uint64_t phase_;	// Fractional position of the next output sample (/ destRate_)
+
+		static constexpr int N_PHASES_ = 1024;
+		static constexpr int N_ZERO_CROSSINGS_ = 8;	// Per side
+		static constexpr double ROLLOFF_ = 0.9;
+		static constexpr double KAISER_BETA_ = 7.0;
+
+		void makeTable();
+	};
 }
@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "benchmark.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+#include <iomanip>
+#include <fstream>
+#include <iterator>
+#include "chips/chip_misc.hpp"
+#include "chips/dsp_kernel.hpp"
+#include "chips/resampler.hpp"
+#include "chips/nuked/ym3438.h"
+#include "binary_container.hpp"
+#include "module.hpp"
+#include "instruments_manager.hpp"
+#include "module_io.hpp"
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double elapsedNs(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+}
+
+void benchDotProduct(std::ostream& os)
+{
+	const size_t nTaps = 48;	// Taps of 110933 -> 44100 Hz
+	const size_t nRuns = 2000000;
+	std::vector<float> coef(nTaps), in(nTaps + 64);
+	std::mt19937 rnd(1);
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	for (auto& v : coef) v = dist(rnd);
+	for (auto& v : in) v = dist(rnd);
+
+	volatile float sink = 0.f;
+	auto begin = Clock::now();
+	for (size_t i = 0; i < nRuns; ++i) sink = sink + chip::dotProductScalar(&coef[0], &in[i & 63], nTaps);
+	double scalar = elapsedNs(begin) / nRuns;
+	begin = Clock::now();
+	for (size_t i = 0; i < nRuns; ++i) sink = sink + chip::dotProduct(&coef[0], &in[i & 63], nTaps);
+	double vect = elapsedNs(begin) / nRuns;
+
+	os << "dot product (" << nTaps << " taps): scalar " << scalar << " ns, "
+#if defined(CHIP_DSP_SSE2)
+	   << "SSE2 "
+#elif defined(CHIP_DSP_NEON)
+	   << "NEON "
+#else
+	   << "portable "
+#endif
+	   << vect << " ns" << std::endl;
+}
+
+void benchMixDown(std::ostream& os)
+{
+	const size_t blockSize = 1024;
+	const size_t nRuns = 20000;
+	std::vector<sample> planes[4];
+	std::mt19937 rnd(1);
+	std::uniform_int_distribution<sample> dist(-40000, 40000);
+	for (auto& plane : planes) {
+		plane.resize(blockSize);
+		for (auto& v : plane) v = dist(rnd);
+	}
+	std::vector<int16_t> out(blockSize * 2);
+	const int64_t gainFM = 27636, gainSSG = 19567;	// 0 dB and -3 dB
+
+	// The former division rounding toward zero
+	auto begin = Clock::now();
+	for (size_t i = 0; i < nRuns; ++i) {
+		int16_t* p = &out[0];
+		for (size_t n = 0; n < blockSize; ++n) {
+			int64_t l = (gainFM * planes[0][n] + gainSSG * planes[2][n]) / 65536;
+			int64_t r = (gainFM * planes[1][n] + gainSSG * planes[3][n]) / 65536;
+			*p++ = static_cast<int16_t>(chip::clamp<int64_t>(l, -32768, 32767));
+			*p++ = static_cast<int16_t>(chip::clamp<int64_t>(r, -32768, 32767));
+		}
+		planes[0][i % blockSize] ^= out[i % blockSize];	// Keep the loop
+	}
+	double division = elapsedNs(begin) / nRuns / 1000.;
+	begin = Clock::now();
+	for (size_t i = 0; i < nRuns; ++i) {
+		chip::mixDownQ16(&out[0], &planes[0][0], &planes[1][0], &planes[2][0], &planes[3][0],
+				gainFM, gainSSG, blockSize);
+		planes[0][i % blockSize] ^= out[i % blockSize];
+	}
+	double shift = elapsedNs(begin) / nRuns / 1000.;
+	begin = Clock::now();
+	for (size_t i = 0; i < nRuns; ++i) {
+		chip::mixDown(&out[0], &planes[0][0], &planes[1][0], &planes[2][0], &planes[3][0],
+				gainFM, gainSSG, blockSize);
+		planes[0][i % blockSize] ^= out[i % blockSize];
+	}
+	double vect = elapsedNs(begin) / nRuns / 1000.;
+
+	// Compare with the scalar kernel, also over the saturation range
+	int maxDiff = 0;
+	std::vector<int16_t> ref(blockSize * 2);
+	for (int64_t scale : { 1, 4 }) {
+		chip::mixDownQ16(&ref[0], &planes[0][0], &planes[1][0], &planes[2][0], &planes[3][0],
+				gainFM * scale, gainSSG * scale, blockSize - 1);
+		chip::mixDown(&out[0], &planes[0][0], &planes[1][0], &planes[2][0], &planes[3][0],
+				gainFM * scale, gainSSG * scale, blockSize - 1);
+		for (size_t n = 0; n < (blockSize - 1) * 2; ++n)
+			maxDiff = std::max(maxDiff, std::abs(out[n] - ref[n]));
+	}
+
+	os << "Q16 mix down (" << blockSize << " stereo samples): division " << division
+	   << " us, shift " << shift << " us, "
+#if defined(CHIP_DSP_SSE2)
+	   << "SSE2 "
+#elif defined(CHIP_DSP_NEON)
+	   << "NEON "
+#else
+	   << "portable "
+#endif
+	   << vect << " us (max difference " << maxDiff << " LSB)" << std::endl;
+}
+
+/// Resample 60 seconds of stereo noise in blocks as the chip does
+double benchResampler(chip::AbstractResampler& rsmp, int srcRate, int destRate)
+{
+	const size_t blockSize = 1024;
+	const size_t nBlocks = static_cast<size_t>(destRate) * 60 / blockSize;
+	rsmp.init(srcRate, destRate, 40);
+
+	std::vector<sample> bufL(chip::SMPL_BUF_SIZE_), bufR(chip::SMPL_BUF_SIZE_);
+	std::mt19937 rnd(1);
+	std::uniform_int_distribution<sample> dist(-16384, 16383);
+	for (size_t i = 0; i < chip::SMPL_BUF_SIZE_; ++i) {
+		bufL[i] = dist(rnd);
+		bufR[i] = dist(rnd);
+	}
+	sample* src[2] = { &bufL[0], &bufR[0] };
+
+	volatile sample sink = 0;
+	auto begin = Clock::now();
+	for (size_t i = 0; i < nBlocks; ++i) {
+		size_t intrSize = rsmp.calculateInternalSampleSize(blockSize);
+		sink = sink + rsmp.interpolate(src, blockSize, intrSize)[chip::LEFT][blockSize - 1];
+	}
+	return elapsedNs(begin) / 1e6;
+}
+
+void benchResamplers(std::ostream& os)
+{
+	const int rates[][2] = { { 110933, 44100 }, { 55466, 48000 }, { 249600, 44100 } };
+	for (auto& r : rates) {
+		chip::LinearResampler linear;
+		chip::SincResampler sinc;
+		double tl = benchResampler(linear, r[0], r[1]);
+		double ts = benchResampler(sinc, r[0], r[1]);
+		os << "resample 60 s stereo " << r[0] << " -> " << r[1] << " Hz: linear "
+		   << tl << " ms, sinc " << ts << " ms" << std::endl;
+	}
+}
+
+/// Generate 1 second of a sounding FM channel with Nuked OPN-Mod per sample and in blocks of 1024
+void benchNuked(std::ostream& os)
+{
+	static const OPN2mod_psg_callbacks noPsg = {
+		[](void*, int) {}, [](void*, int, int) {}, [](void*) { return 0; }, [](void*) {}
+	};
+	const uint8_t regs[][2] = {
+		{ 0xb0, 0x07 }, { 0xb4, 0xc0 },	// Algorithm 7, both sides
+		{ 0x30, 0x01 }, { 0x34, 0x02 }, { 0x38, 0x03 }, { 0x3c, 0x04 },
+		{ 0x40, 0x10 }, { 0x44, 0x10 }, { 0x48, 0x10 }, { 0x4c, 0x10 },
+		{ 0x50, 0x1f }, { 0x54, 0x1f }, { 0x58, 0x1f }, { 0x5c, 0x1f },
+		{ 0x80, 0x0f }, { 0x84, 0x0f }, { 0x88, 0x0f }, { 0x8c, 0x0f },
+		{ 0xa4, 0x22 }, { 0xa0, 0x69 }, { 0x28, 0xf0 }
+	};
+	const size_t nSamples = 110933;	// 1 second at the internal rate
+	const size_t blockSize = 1024;
+
+	const int nRounds = 5;
+
+	// Alternate the two ways and keep the fastest round of each
+	std::vector<sample> out[2][2];
+	double time[2] = { 0., 0. };
+	for (int round = 0; round < nRounds * 2; ++round) {
+		int mode = round & 1;
+		auto chip = std::make_unique<ym3438_t>();
+		OPN2_Reset(chip.get(), 3993600 * 2, &noPsg, nullptr, 0x40000);
+		for (auto& reg : regs) {
+			OPN2_WriteBuffered(chip.get(), 0, reg[0]);
+			OPN2_WriteBuffered(chip.get(), 1, reg[1]);
+		}
+		for (auto& buf : out[mode]) buf.resize(nSamples);
+
+		auto begin = Clock::now();
+		if (mode) {
+			for (size_t i = 0; i < nSamples; i += blockSize) {
+				Bit32u n = static_cast<Bit32u>(std::min(blockSize, nSamples - i));
+				OPN2_GenerateStream(chip.get(), &out[mode][0][i], &out[mode][1][i], n);
+			}
+		}
+		else {
+			for (size_t i = 0; i < nSamples; ++i) {
+				sample lr[2];
+				OPN2_Generate(chip.get(), lr);
+				out[mode][0][i] = lr[0];
+				out[mode][1][i] = lr[1];
+			}
+		}
+		double t = elapsedNs(begin) / nSamples;
+		if (round < 2 || t < time[mode]) time[mode] = t;
+		OPN2_Destroy(chip.get());
+	}
+
+	os << "Nuked OPN-Mod (" << nSamples << " samples): per sample " << time[0]
+	   << " ns/sample, block " << time[1] << " ns/sample ("
+	   << ((out[0][0] == out[1][0] && out[0][1] == out[1][1]) ? "identical" : "different")
+	   << " output)" << std::endl;
+}
+
+/// The former container which builds a temporary vector for each integer
+class FormerContainer
+{
+public:
+	void appendUint8(uint8_t v) { buf_.push_back(static_cast<char>(v)); }
+	void appendUint16(uint16_t v) { append({ static_cast<char>(0x00ff & v), static_cast<char>(v >> 8) }); }
+	void appendInt32(int32_t v)
+	{
+		append({ static_cast<char>(0x000000ff & v), static_cast<char>(0x0000ff & (v >> 8)),
+				 static_cast<char>(0x00ff & (v >> 16)), static_cast<char>(v >> 24) });
+	}
+	void writeUint16(size_t offset, uint16_t v)
+	{
+		write(offset, { static_cast<char>(0x00ff & v), static_cast<char>(v >> 8) });
+	}
+	void writeInt32(size_t offset, int32_t v)
+	{
+		write(offset, { static_cast<char>(0x000000ff & v), static_cast<char>(0x0000ff & (v >> 8)),
+						static_cast<char>(0x00ff & (v >> 16)), static_cast<char>(v >> 24) });
+	}
+	uint8_t readUint8(size_t offset) const { return static_cast<uint8_t>(buf_.at(offset)); }
+	uint16_t readUint16(size_t offset) const
+	{
+		std::vector<unsigned char> data = read(offset, 2);
+		return static_cast<uint16_t>(data[0] | (data[1] << 8));
+	}
+	int32_t readInt32(size_t offset) const
+	{
+		std::vector<unsigned char> data = read(offset, 4);
+		return static_cast<int32_t>(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
+	}
+
+private:
+	std::vector<char> buf_;
+
+	void append(std::vector<char> a) { std::copy(a.begin(), a.end(), std::back_inserter(buf_)); }
+	void write(size_t offset, std::vector<char> a)
+	{
+		std::copy(a.begin(), a.end(), buf_.begin() + static_cast<int>(offset));
+	}
+	std::vector<unsigned char> read(size_t offset, size_t size) const
+	{
+		std::vector<unsigned char> data;
+		std::copy_n(buf_.begin() + static_cast<int>(offset), size, std::back_inserter(data));
+		return data;
+	}
+};
+
+/// Append, overwrite and read records of uint16 + int32 + uint8
+template <class Container>
+void benchContainer(double (&time)[3])
+{
+	const size_t nRecords = 4000000;
+	const size_t recSize = 7;
+	Container ctr;
+
+	auto begin = Clock::now();
+	for (size_t i = 0; i < nRecords; ++i) {
+		ctr.appendUint16(static_cast<uint16_t>(i));
+		ctr.appendInt32(static_cast<int32_t>(i * 3));
+		ctr.appendUint8(static_cast<uint8_t>(i));
+	}
+	time[0] = elapsedNs(begin) / 1e6;
+
+	begin = Clock::now();
+	for (size_t i = 0; i < nRecords; ++i) {
+		ctr.writeUint16(i * recSize, static_cast<uint16_t>(i + 1));
+		ctr.writeInt32(i * recSize + 2, static_cast<int32_t>(i * 5));
+	}
+	time[1] = elapsedNs(begin) / 1e6;
+
+	volatile int64_t sink = 0;
+	begin = Clock::now();
+	for (size_t i = 0; i < nRecords; ++i) {
+		sink = sink + ctr.readUint16(i * recSize) + ctr.readInt32(i * recSize + 2)
+			   + ctr.readUint8(i * recSize + 6);
+	}
+	time[2] = elapsedNs(begin) / 1e6;
+}
+
+void benchContainers(std::ostream& os)
+{
+	double former[3], current[3];
+	benchContainer<FormerContainer>(former);
+	benchContainer<BinaryContainer>(current);
+	os << "binary container (4000000 records): append " << former[0] << " -> " << current[0]
+	   << " ms, write " << former[1] << " -> " << current[1]
+	   << " ms, read " << former[2] << " -> " << current[2] << " ms" << std::endl;
+}
+
+/// Load each module from memory and save it again
+void benchModuleIO(std::ostream& os, const std::vector<std::string>& paths)
+{
+	const int nRuns = 20;
+	std::vector<std::vector<char>> files;
+	for (const auto& path : paths) {
+		std::ifstream ifs(path, std::ios::binary);
+		if (!ifs) {
+			os << "module I/O: cannot open " << path << std::endl;
+			return;
+		}
+		files.emplace_back(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+	}
+
+	double load = 0., save = 0.;
+	for (int i = 0; i < nRuns; ++i) {
+		for (const auto& file : files) {
+			auto mod = std::make_shared<Module>();
+			auto instMan = std::make_shared<InstrumentsManager>(false);
+			auto begin = Clock::now();
+			ModuleIO::loadModule(BinaryContainer(file.data(), file.size()), mod, instMan);
+			load += elapsedNs(begin);
+
+			BinaryContainer ctr;
+			begin = Clock::now();
+			ModuleIO::saveModule(ctr, mod, instMan);
+			save += elapsedNs(begin);
+		}
+	}
+	os << "module I/O (" << files.size() << " modules x " << nRuns << "): load "
+	   << load / 1e6 << " ms, save " << save / 1e6 << " ms" << std::endl;
+}
+}
+
+void runBenchmark(std::ostream& os, const std::vector<std::string>& modulePaths)
+{
+	os << std::fixed << std::setprecision(2);
+	benchDotProduct(os);
+	benchMixDown(os);
+	benchResamplers(os);
+	benchNuked(os);
+	benchContainers(os);
+	if (!modulePaths.empty()) benchModuleIO(os, modulePaths);
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/// Headless renderer
+/// Usage: BambooTrackerCLI [options] <input.btm> <output.(wav|vgm|s98)>
+///        BambooTrackerCLI [options] -f <wav|vgm|s98> <input directory> <output directory>
+///        BambooTrackerCLI --benchmark [<input.btm>...]
+///        BambooTrackerCLI --check-timeline <input.btm>
+
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <exception>
+#include "batch_exporter.hpp"
+#include "benchmark.hpp"
+#include "timeline_check.hpp"
+#include "file_io.hpp"
+#include "chips/chip_misc.hpp"
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+void printUsage(const char* app)
+{
+	std::cerr << "Usage: " << app << " [options] <input.btm> <output.(wav|vgm|s98)>" << std::endl
+			  << "       " << app << " [options] -f <wav|vgm|s98> <input directory> <output directory>" << std::endl
+			  << "       " << app << " --benchmark [<input.btm>...]" << std::endl
+			  << "       " << app << " --check-timeline <input.btm>" << std::endl
+			  << "Options:" << std::endl
+			  << "  -s <num>      Song number (default: all songs)" << std::endl
+			  << "  -f <format>   Output format: wav, vgm or s98 (default: output file extension)" << std::endl
+			  << "  -r <rate>     Sample rate of WAV or resolution of S98 (default: 44100)" << std::endl
+			  << "  -l <num>      Loop count of WAV (default: 1)" << std::endl
+			  << "  -b <depth>    Sample format of WAV: 16, 24 or float (default: 16)" << std::endl
+			  << "  -t            Also write each channel of WAV to <output>-<track name>.wav" << std::endl
+			  << "  -e <emu>      Emulator: mame or nuked (default: mame)" << std::endl
+			  << "  -j <num>      Number of worker threads (default: number of cores)" << std::endl;
+}
+
+FileIO::FileType toFileType(std::string ext)
+{
+	for (auto& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	if (ext == "wav") return FileIO::FileType::WAV;
+	if (ext == "vgm") return FileIO::FileType::VGM;
+	if (ext == "s98") return FileIO::FileType::S98;
+	return FileIO::FileType::Unknown;
+}
+
+std::string toExtension(FileIO::FileType type)
+{
+	switch (type) {
+	case FileIO::FileType::WAV:	return "wav";
+	case FileIO::FileType::VGM:	return "vgm";
+	case FileIO::FileType::S98:	return "s98";
+	default:	return "";
+	}
+}
+
+bool isDirectory(const std::string& path)
+{
+#ifdef _WIN32
+	DWORD attr = GetFileAttributesA(path.c_str());
+	return (attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY));
+#else
+	struct stat st;
+	return (!stat(path.c_str(), &st) && S_ISDIR(st.st_mode));
+#endif
+}
+
+/// Return file names of modules in the directory
+std::vector<std::string> listModules(const std::string& dir)
+{
+	std::vector<std::string> names;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE h = FindFirstFileA((dir + "\\*.btm").c_str(), &data);
+	if (h != INVALID_HANDLE_VALUE) {
+		do {
+			names.push_back(data.cFileName);
+		} while (FindNextFileA(h, &data));
+		FindClose(h);
+	}
+#else
+	if (DIR* dp = opendir(dir.c_str())) {
+		while (dirent* ent = readdir(dp)) {
+			std::string name = ent->d_name;
+			if (FileIO::judgeFileTypeFromExtension(FileIO::getExtension(name)) == FileIO::FileType::Mod
+					&& name.find('.') != std::string::npos) {
+				names.push_back(name);
+			}
+		}
+		closedir(dp);
+	}
+#endif
+	return names;
+}
+}
+
+int main(int argc, char* argv[])
+{
+	BatchExporter::Settings settings;
+	settings.format = FileIO::FileType::Unknown;
+	int songNum = -1;
+	size_t nThreads = 0;
+	std::vector<std::string> paths;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "-h" || arg == "--help") {
+			printUsage(argv[0]);
+			return EXIT_SUCCESS;
+		}
+		else if (arg == "--benchmark") {
+			try {
+				runBenchmark(std::cout, std::vector<std::string>(argv + i + 1, argv + argc));
+			}
+			catch (std::exception& e) {
+				std::cerr << e.what() << std::endl;
+				return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+		}
+		else if (arg == "--check-timeline" && i + 1 < argc) {
+			try {
+				return checkTimeline(argv[i + 1], std::cout) ? EXIT_SUCCESS : EXIT_FAILURE;
+			}
+			catch (std::exception& e) {
+				std::cerr << e.what() << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if (arg == "-t") {
+			settings.stems = true;
+		}
+		else if (arg.size() == 2 && arg[0] == '-' && i + 1 < argc) {
+			std::string val = argv[++i];
+			switch (arg[1]) {
+			case 's':	songNum = std::atoi(val.c_str());	break;
+			case 'f':	settings.format = toFileType(val);	break;
+			case 'r':	settings.rate = std::atoi(val.c_str());	break;
+			case 'l':	settings.loopCount = std::atoi(val.c_str());	break;
+			case 'b':
+				if (val == "16") settings.sampleFormat = WavWriter::SampleFormat::Int16;
+				else if (val == "24") settings.sampleFormat = WavWriter::SampleFormat::Int24;
+				else if (val == "float") settings.sampleFormat = WavWriter::SampleFormat::Float32;
+				else {
+					printUsage(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'j':	nThreads = static_cast<size_t>(std::max(0, std::atoi(val.c_str())));	break;
+			case 'e':
+				if (val == "nuked") settings.emu = chip::Emu::Nuked;
+				else if (val == "mame") settings.emu = chip::Emu::Mame;
+				else {
+					printUsage(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			default:
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		}
+		else {
+			paths.push_back(arg);
+		}
+	}
+	if (paths.size() != 2 || settings.rate <= 0 || settings.loopCount < 0) {
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const std::string& inPath = paths[0];
+	const std::string& outPath = paths[1];
+	bool isDirMode = isDirectory(inPath);
+	if (settings.format == FileIO::FileType::Unknown && !isDirMode)
+		settings.format = toFileType(FileIO::getExtension(outPath));
+	if (settings.format == FileIO::FileType::Unknown) {
+		std::cerr << "Unsupported output format" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	BatchExporter exporter(settings);
+	bool hasFailed = false;
+	if (isDirMode) {
+		for (const std::string& name : listModules(inPath)) {
+			std::string base = name.substr(0, name.find_last_of('.'));
+			try {
+				exporter.addModule(inPath + "/" + name,
+								   outPath + "/" + base + "." + toExtension(settings.format), songNum);
+			}
+			catch (std::exception& e) {
+				std::cerr << "Failed: " << name << ": " << e.what() << std::endl;
+				hasFailed = true;
+			}
+		}
+	}
+	else {
+		try {
+			exporter.addModule(inPath, outPath, songNum);
+		}
+		catch (std::exception& e) {
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	size_t nJobs = exporter.getJobCount();
+	size_t nDone = 0;
+	exporter.run(nThreads, [&](const BatchExporter::Result& res) {
+		++nDone;
+		std::cout << "[" << nDone << "/" << nJobs << "] ";
+		if (res.succeeded) {
+			std::cout << res.outputPath << std::endl;
+		}
+		else {
+			std::cout << "Failed: " << res.inputPath << " #" << res.songNum << ": " << res.message << std::endl;
+			hasFailed = true;
+		}
+	});
+
+	return hasFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,737 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "timeline_check.hpp"
+#include <cstddef>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include "offline_renderer.hpp"
+#include "playback.hpp"
+#include "module.hpp"
+#include "instruments_manager.hpp"
+#include "instrument.hpp"
+#include "effect.hpp"
+#include "misc.hpp"
+#include "module_io.hpp"
+#include "binary_container.hpp"
+#include "wav_writer.hpp"
+#include "file_io_error.hpp"
+
+/// Copy of PlaybackManager::retrieveChannelStates before the song timeline was introduced.
+/// It scans the steps backward from the start position to the head of the song
+/// and applies the first state found for each parameter.
+void retrieveChannelStatesByLegacyScan(PlaybackManager& pb)
+{
+	size_t fmch = getFMChannelCount(pb.songStyle_.type);
+
+	std::vector<int> tonesCntFM(fmch), tonesCntSSG(3);
+	int tonesCntADPCM = 0;
+	std::vector<std::vector<int>> toneFM(fmch), toneSSG(3);
+	std::vector<int> toneADPCM = std::vector<int>(3, -1);
+	for (size_t i = 0; i < fmch; ++i) {
+		toneFM.at(i) = std::vector<int>(3, -1);
+	}
+	for (size_t i = 0; i < 3; ++i) {
+		toneSSG.at(i) = std::vector<int>(3, -1);
+	}
+	std::vector<bool> isSetInstFM(fmch, false), isSetVolFM(fmch, false), isSetArpFM(fmch, false);
+	std::vector<bool> isSetPrtFM(fmch, false), isSetVibFM(fmch, false), isSetTreFM(fmch, false);
+	std::vector<bool> isSetPanFM(fmch, false), isSetVolSldFM(fmch, false), isSetDtnFM(fmch, false);
+	std::vector<bool> isSetFBCtrlFM(fmch, false), isSetTLCtrlFM(fmch, false), isSetMLCtrlFM(fmch, false);
+	std::vector<bool> isSetARCtrlFM(fmch, false), isSetDRCtrlFM(fmch, false), isSetRRCtrlFM(fmch, false);
+	std::vector<bool> isSetBrightFM(fmch, false), isSetFiDtnFM(fmch, false);
+	std::vector<bool> isSetInstSSG(3, false), isSetVolSSG(3, false), isSetArpSSG(3, false), isSetPrtSSG(3, false);
+	std::vector<bool> isSetVibSSG(3, false), isSetTreSSG(3, false), isSetVolSldSSG(3, false), isSetDtnSSG(3, false);
+	std::vector<bool> isSetTNMixSSG(3, false), isSetFiDtnSSG(3, false);
+	std::vector<bool> isSetVolRhythm(6, false), isSetPanRhythm(6, false);
+	bool isSetInstADPCM(false), isSetVolADPCM(false), isSetArpADPCM(false), isSetPrtADPCM(false);
+	bool isSetVibADPCM(false), isSetTreADPCM(false), isSetPanADPCM(false), isSetVolSldADPCM(false);
+	bool isSetDtnADPCM(false), isSetFiDtnADPCM(false);
+	bool isSetMVolRhythm = false;
+	bool isSetNoisePitchSSG = false;
+	bool isSetHardEnvPeriodHighSSG = false;
+	bool isSetHardEnvPeriodLowSSG = false;
+	bool isSetAutoEnvSSG = false;
+	/// bit0: step
+	/// bit1: tempo
+	/// bit2: groove
+	uint8_t speedStates = 0;
+
+	int o = pb.playOrderNum_;
+	int s = pb.playStepNum_;
+	bool isPrevPos = false;
+	Song& song = pb.mod_.lock()->getSong(pb.curSongNum_);
+
+	while (true) {
+		for (auto it = pb.songStyle_.trackAttribs.rbegin(), e = pb.songStyle_.trackAttribs.rend(); it != e; ++it) {
+			Step& step = song.getTrack(it->number).getPatternFromOrderNumber(o).getStep(s);
+			int ch = it->channelInSource;
+			size_t uch = static_cast<size_t>(ch);
+
+			switch (it->source) {
+			case SoundSource::FM:
+			{
+				// Volume
+				int vol = step.getVolume();
+				if (!isSetVolFM[uch] && 0 <= vol && vol < 0x80) {
+					isSetVolFM[uch] = true;
+					if (isPrevPos)
+						pb.opnaCtrl_->setVolumeFM(ch, step.getVolume());
+				}
+				// Instrument
+				if (!isSetInstFM[uch] && step.getInstrumentNumber() != -1) {
+					if (auto inst = std::dynamic_pointer_cast<InstrumentFM>(
+								pb.instMan_.lock()->getInstrumentSharedPtr(step.getInstrumentNumber()))) {
+						isSetInstFM[uch] = true;
+						if (isPrevPos)
+							pb.opnaCtrl_->setInstrumentFM(ch, inst);
+					}
+				}
+				// Effects
+				for (int i = 3; i > -1; --i) {
+					Effect eff = Effect::makeEffectData(SoundSource::FM, step.getEffectID(i), step.getEffectValue(i));
+					switch (eff.type) {
+					case EffectType::Arpeggio:
+						if (!isSetArpFM[uch]) {
+							isSetArpFM[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setArpeggioEffectFM(ch, eff.value >> 4, eff.value & 0x0f);
+						}
+						break;
+					case EffectType::PortamentoUp:
+						if (!isSetPrtFM[uch]) {
+							isSetPrtFM[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setPortamentoEffectFM(ch, eff.value);
+						}
+						break;
+					case EffectType::PortamentoDown:
+						if (!isSetPrtFM[uch]) {
+							isSetPrtFM[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setPortamentoEffectFM(ch, -eff.value);
+						}
+						break;
+					case EffectType::TonePortamento:
+						if (!isSetPrtFM[uch]) {
+							isSetPrtFM[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setPortamentoEffectFM(ch, eff.value, true);
+						}
+						break;
+					case EffectType::Vibrato:
+						if (!isSetVibFM[uch]) {
+							isSetVibFM[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setVibratoEffectFM(ch, eff.value >> 4, eff.value & 0x0f);
+						}
+						break;
+					case EffectType::Tremolo:
+						if (!isSetTreFM[uch]) {
+							isSetTreFM[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setTremoloEffectFM(ch, eff.value >> 4, eff.value & 0x0f);
+						}
+						break;
+					case EffectType::Pan:
+						if (-1 < eff.value && eff.value < 4 && !isSetPanFM[uch]) {
+							isSetPanFM[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setPanFM(ch, eff.value);
+						}
+						break;
+					case EffectType::VolumeSlide:
+						if (!isSetVolSldFM[uch]) {
+							isSetVolSldFM[uch] = true;
+							if (isPrevPos) {
+								int hi = eff.value >> 4;
+								int low = eff.value & 0x0f;
+								if (hi && !low) pb.opnaCtrl_->setVolumeSlideFM(ch, hi, true);	// Slide up
+								else if (!hi) pb.opnaCtrl_->setVolumeSlideFM(ch, low, false);	// Slide down
+							}
+						}
+						break;
+					case EffectType::SpeedTempoChange:
+						if (!(speedStates & 0x4)) {
+							if (eff.value < 0x20) {				// Speed change
+								if (!(speedStates & 0x1)) {
+									speedStates |= 0x1;
+									if (isPrevPos) pb.effSpeedChange(eff.value);
+								}
+							}
+							else if (!(speedStates & 0x2)) {	// Tempo change
+								speedStates |= 0x2;
+								if (isPrevPos) pb.effTempoChange(eff.value);
+							}
+						}
+						break;
+					case EffectType::Groove:
+						if (eff.value < static_cast<int>(pb.mod_.lock()->getGrooveCount()) && !speedStates) {
+							speedStates |= 0x4;
+							if (isPrevPos) pb.effGrooveChange(eff.value);
+						}
+						break;
+					case EffectType::Detune:
+						if (!isSetDtnFM[uch]) {
+							isSetDtnFM[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setDetuneFM(ch, eff.value - 0x80);
+						}
+						break;
+					case EffectType::FineDetune:
+						if (!isSetFiDtnFM[uch]) {
+							isSetFiDtnFM[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setFineDetuneFM(ch, eff.value - 0x80);
+						}
+						break;
+					case EffectType::FBControl:
+						if (!isSetFBCtrlFM[uch]) {
+							isSetFBCtrlFM[uch] = true;
+							if (isPrevPos) {
+								if (-1 < eff.value && eff.value < 8) pb.opnaCtrl_->setFBControlFM(ch, eff.value);
+							}
+						}
+						break;
+					case EffectType::TLControl:
+						if (!isSetTLCtrlFM[uch]) {
+							isSetTLCtrlFM[uch] = true;
+							if (isPrevPos) {
+								int op = eff.value >> 8;
+								int val = eff.value & 0x00ff;
+								if (0 < op && op < 5 && -1 < val && val < 128)
+									pb.opnaCtrl_->setTLControlFM(ch, op - 1, val);
+							}
+						}
+						break;
+					case EffectType::MLControl:
+						if (!isSetMLCtrlFM[uch]) {
+							isSetMLCtrlFM[uch] = true;
+							if (isPrevPos) {
+								int op = eff.value >> 4;
+								int val = eff.value & 0x0f;
+								if (0 < op && op < 5 && -1 < val && val < 16)
+									pb.opnaCtrl_->setMLControlFM(ch, op - 1, val);
+							}
+						}
+						break;
+					case EffectType::ARControl:
+						if (!isSetARCtrlFM[uch]) {
+							isSetARCtrlFM[uch] = true;
+							if (isPrevPos) {
+								int op = eff.value >> 8;
+								int val = eff.value & 0x00ff;
+								if (0 < op && op < 5 && -1 < val && val < 32)
+									pb.opnaCtrl_->setARControlFM(ch, op - 1, val);
+							}
+						}
+						break;
+					case EffectType::DRControl:
+						if (!isSetDRCtrlFM[uch]) {
+							isSetDRCtrlFM[uch] = true;
+							if (isPrevPos) {
+								int op = eff.value >> 8;
+								int val = eff.value & 0x00ff;
+								if (0 < op && op < 5 && -1 < val && val < 32)
+									pb.opnaCtrl_->setDRControlFM(ch, op - 1, val);
+							}
+						}
+						break;
+					case EffectType::RRControl:
+						if (!isSetRRCtrlFM[uch]) {
+							isSetRRCtrlFM[uch] = true;
+							if (isPrevPos) {
+								int op = eff.value >> 4;
+								int val = eff.value & 0x0f;
+								if (0 < op && op < 5 && -1 < val && val < 16)
+									pb.opnaCtrl_->setRRControlFM(ch, op - 1, val);
+							}
+						}
+						break;
+					case EffectType::Brightness:
+						if (!isSetBrightFM[uch]) {
+							isSetBrightFM[uch] = true;
+							if (isPrevPos) {
+								if (0 < eff.value) pb.opnaCtrl_->setBrightnessFM(ch, eff.value - 0x80);
+							}
+						}
+						break;
+					default:
+						break;
+					}
+				}
+				// Tone
+				int t = step.getNoteNumber();
+				if (isPrevPos && t != -1 && t != -2) {
+					--tonesCntFM[uch];
+					for (auto it2 = toneFM[uch].rbegin();
+						 it2 != toneFM[uch].rend(); ++it2) {
+						if (*it2 == -1 || *it2 == tonesCntFM[uch]) {
+							if (t >= 0) {
+								*it2 = t;
+							}
+							else if (t < -2) {
+								*it2 = tonesCntFM[uch] - t + 2;
+							}
+							break;
+						}
+					}
+				}
+				break;
+			}
+			case SoundSource::SSG:
+			{
+				// Volume
+				int vol = step.getVolume();
+				if (!isSetVolSSG[uch] && 0 <= vol && vol < 0x10) {
+					isSetVolSSG[uch] = true;
+					if (isPrevPos)
+						pb.opnaCtrl_->setVolumeSSG(ch, vol);
+				}
+				// Instrument
+				if (!isSetInstSSG[uch] && step.getInstrumentNumber() != -1) {
+					if (auto inst = std::dynamic_pointer_cast<InstrumentSSG>(
+								pb.instMan_.lock()->getInstrumentSharedPtr(step.getInstrumentNumber()))) {
+						isSetInstSSG[uch] = true;
+						if (isPrevPos)
+							pb.opnaCtrl_->setInstrumentSSG(ch, inst);
+					}
+				}
+				// Effects
+				for (int i = 3; i > -1; --i) {
+					Effect eff = Effect::makeEffectData(SoundSource::SSG, step.getEffectID(i), step.getEffectValue(i));
+					switch (eff.type) {
+					case EffectType::Arpeggio:
+						if (!isSetArpSSG[uch]) {
+							isSetArpSSG[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setArpeggioEffectSSG(ch, eff.value >> 4, eff.value & 0x0f);
+						}
+						break;
+					case EffectType::PortamentoUp:
+						if (!isSetPrtSSG[uch]) {
+							isSetPrtSSG[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setPortamentoEffectSSG(ch, eff.value);
+						}
+						break;
+					case EffectType::PortamentoDown:
+						if (!isSetPrtSSG[uch]) {
+							isSetPrtSSG[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setPortamentoEffectSSG(ch, -eff.value);
+						}
+						break;
+					case EffectType::TonePortamento:
+						if (!isSetPrtSSG[uch]) {
+							isSetPrtSSG[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setPortamentoEffectSSG(ch, eff.value, true);
+						}
+						break;
+					case EffectType::Vibrato:
+						if (!isSetVibSSG[uch]) {
+							isSetVibSSG[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setVibratoEffectSSG(ch, eff.value >> 4, eff.value & 0x0f);
+						}
+						break;
+					case EffectType::Tremolo:
+						if (!isSetTreSSG[uch]) {
+							isSetTreSSG[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setTremoloEffectSSG(ch, eff.value >> 4, eff.value & 0x0f);
+						}
+						break;
+					case EffectType::VolumeSlide:
+						if (!isSetVolSldSSG[uch]) {
+							isSetVolSldSSG[uch] = true;
+							if (isPrevPos) {
+								int hi = eff.value >> 4;
+								int low = eff.value & 0x0f;
+								if (hi && !low) pb.opnaCtrl_->setVolumeSlideSSG(ch, hi, true);	// Slide up
+								else if (!hi) pb.opnaCtrl_->setVolumeSlideSSG(ch, low, false);	// Slide down
+							}
+						}
+						break;
+					case EffectType::SpeedTempoChange:
+						if (!(speedStates & 0x4)) {
+							if (eff.value < 0x20) {				// Speed change
+								if (!(speedStates & 0x1)) {
+									speedStates |= 0x1;
+									if (isPrevPos) pb.effSpeedChange(eff.value);
+								}
+							}
+							else if (!(speedStates & 0x2)) {	// Tempo change
+								speedStates |= 0x2;
+								if (isPrevPos) pb.effTempoChange(eff.value);
+							}
+						}
+						break;
+					case EffectType::Groove:
+						if (eff.value < static_cast<int>(pb.mod_.lock()->getGrooveCount()) && !speedStates) {
+							speedStates |= 0x4;
+							if (isPrevPos) pb.effGrooveChange(eff.value);
+						}
+						break;
+					case EffectType::Detune:
+						if (!isSetDtnSSG[uch]) {
+							isSetDtnSSG[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setDetuneSSG(ch, eff.value - 0x80);
+						}
+						break;
+					case EffectType::FineDetune:
+						if (!isSetFiDtnSSG[uch]) {
+							isSetFiDtnSSG[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setFineDetuneSSG(ch, eff.value - 0x80);
+						}
+						break;
+					case EffectType::ToneNoiseMix:
+						if (-1 < eff.value && eff.value < 4 && !isSetTNMixSSG[uch]) {
+							isSetTNMixSSG[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setToneNoiseMixSSG(ch, eff.value);
+						}
+						break;
+					case EffectType::NoisePitch:
+						if (-1 < eff.value && eff.value < 32 && !isSetNoisePitchSSG) {
+							isSetNoisePitchSSG = true;
+							if (isPrevPos) pb.opnaCtrl_->setNoisePitchSSG(ch, eff.value);
+						}
+						break;
+					case EffectType::HardEnvHighPeriod:
+						if (!isSetHardEnvPeriodHighSSG) {
+							isSetHardEnvPeriodHighSSG = true;
+							if (isPrevPos) pb.opnaCtrl_->setHardEnvelopePeriod(ch, true, eff.value);
+						}
+						break;
+					case EffectType::HardEnvLowPeriod:
+						if (!isSetHardEnvPeriodLowSSG) {
+							isSetHardEnvPeriodLowSSG = true;
+							if (isPrevPos) pb.opnaCtrl_->setHardEnvelopePeriod(ch, false, eff.value);
+						}
+						break;
+					case EffectType::AutoEnvelope:
+						if (!isSetAutoEnvSSG) {
+							isSetAutoEnvSSG = true;
+							if (isPrevPos) pb.opnaCtrl_->setAutoEnvelopeSSG(ch, (eff.value >> 4) - 8, eff.value & 0x0f);
+						}
+						break;
+					default:
+						break;
+					}
+				}
+				// Tone
+				int t = step.getNoteNumber();
+				if (isPrevPos && t != -1 && t != -2) {
+					--tonesCntSSG[uch];
+					for (auto it2 = toneSSG[uch].rbegin();
+						 it2 != toneSSG[uch].rend(); ++it2) {
+						if (*it2 == -1 || *it2 == tonesCntSSG[uch]) {
+							if (t >= 0) {
+								*it2 = t;
+							}
+							else if (t < -2) {
+								*it2 = tonesCntSSG[uch] - t + 2;
+							}
+							break;
+						}
+					}
+				}
+				break;
+			}
+			case SoundSource::RHYTHM:
+			{
+				// Volume
+				int vol = step.getVolume();
+				if (!isSetVolRhythm[uch] && 0 <= vol && vol < 0x20) {
+					isSetVolRhythm[uch] = true;
+					if (isPrevPos)
+						pb.opnaCtrl_->setVolumeRhythm(ch, vol);
+				}
+				// Effects
+				for (int i = 3; i > -1; --i) {
+					Effect eff = Effect::makeEffectData(SoundSource::RHYTHM, step.getEffectID(i), step.getEffectValue(i));
+					switch (eff.type) {
+					case EffectType::Pan:
+						if (-1 < eff.value && eff.value < 4 && !isSetPanRhythm[uch]) {
+							isSetPanRhythm[uch] = true;
+							if (isPrevPos) pb.opnaCtrl_->setPanRhythm(ch, eff.value);
+						}
+						break;
+					case EffectType::SpeedTempoChange:
+						if (!(speedStates & 0x4)) {
+							if (eff.value < 0x20) {				// Speed change
+								if (!(speedStates & 0x1)) {
+									speedStates |= 0x1;
+									if (isPrevPos) pb.effSpeedChange(eff.value);
+								}
+							}
+							else if (!(speedStates & 0x2)) {	// Tempo change
+								speedStates |= 0x2;
+								if (isPrevPos) pb.effTempoChange(eff.value);
+							}
+						}
+						break;
+					case EffectType::Groove:
+						if (eff.value < static_cast<int>(pb.mod_.lock()->getGrooveCount()) && !speedStates) {
+							speedStates |= 0x4;
+							if (isPrevPos) pb.effGrooveChange(eff.value);
+						}
+						break;
+					case EffectType::MasterVolume:
+						if (-1 < eff.value && eff.value < 64 && !isSetMVolRhythm) {
+							isSetMVolRhythm = true;
+							if (isPrevPos) pb.opnaCtrl_->setMasterVolumeRhythm(eff.value);
+						}
+						break;
+					default:
+						break;
+					}
+				}
+				break;
+			}
+			case SoundSource::ADPCM:
+			{
+				// Volume
+				int vol = step.getVolume();
+				if (!isSetVolADPCM && 0 <= vol && vol < 0x100) {
+					isSetVolADPCM = true;
+					if (isPrevPos)
+						pb.opnaCtrl_->setVolumeADPCM(step.getVolume());
+				}
+				// Instrument
+				if (!isSetInstADPCM && step.getInstrumentNumber() != -1) {
+					if (auto inst = std::dynamic_pointer_cast<InstrumentADPCM>(
+								pb.instMan_.lock()->getInstrumentSharedPtr(step.getInstrumentNumber()))) {
+						isSetInstADPCM = true;
+						if (isPrevPos)
+							pb.opnaCtrl_->setInstrumentADPCM(inst);
+					}
+				}
+				// Effects
+				for (int i = 3; i > -1; --i) {
+					Effect eff = Effect::makeEffectData(SoundSource::ADPCM, step.getEffectID(i), step.getEffectValue(i));
+					switch (eff.type) {
+					case EffectType::Arpeggio:
+						if (!isSetArpADPCM) {
+							isSetArpADPCM = true;
+							if (isPrevPos) pb.opnaCtrl_->setArpeggioEffectADPCM(eff.value >> 4, eff.value & 0x0f);
+						}
+						break;
+					case EffectType::PortamentoUp:
+						if (!isSetPrtADPCM) {
+							isSetPrtADPCM = true;
+							if (isPrevPos) pb.opnaCtrl_->setPortamentoEffectADPCM(eff.value);
+						}
+						break;
+					case EffectType::PortamentoDown:
+						if (!isSetPrtADPCM) {
+							isSetPrtADPCM = true;
+							if (isPrevPos) pb.opnaCtrl_->setPortamentoEffectADPCM(-eff.value);
+						}
+						break;
+					case EffectType::TonePortamento:
+						if (!isSetPrtADPCM) {
+							isSetPrtADPCM = true;
+							if (isPrevPos) pb.opnaCtrl_->setPortamentoEffectADPCM(eff.value, true);
+						}
+						break;
+					case EffectType::Vibrato:
+						if (!isSetVibADPCM) {
+							isSetVibADPCM = true;
+							if (isPrevPos) pb.opnaCtrl_->setVibratoEffectADPCM(eff.value >> 4, eff.value & 0x0f);
+						}
+						break;
+					case EffectType::Tremolo:
+						if (!isSetTreADPCM) {
+							isSetTreADPCM = true;
+							if (isPrevPos) pb.opnaCtrl_->setTremoloEffectADPCM(eff.value >> 4, eff.value & 0x0f);
+						}
+						break;
+					case EffectType::Pan:
+						if (-1 < eff.value && eff.value < 4 && !isSetPanADPCM) {
+							isSetPanADPCM = true;
+							if (isPrevPos) pb.opnaCtrl_->setPanADPCM(eff.value);
+						}
+						break;
+					case EffectType::VolumeSlide:
+						if (!isSetVolSldADPCM) {
+							isSetVolSldADPCM = true;
+							if (isPrevPos) {
+								int hi = eff.value >> 4;
+								int low = eff.value & 0x0f;
+								if (hi && !low) pb.opnaCtrl_->setVolumeSlideADPCM(hi, true);	// Slide up
+								else if (!hi) pb.opnaCtrl_->setVolumeSlideADPCM(low, false);	// Slide down
+							}
+						}
+						break;
+					case EffectType::SpeedTempoChange:
+						if (!(speedStates & 0x4)) {
+							if (eff.value < 0x20 && !(speedStates & 0x1)) {	// Speed change
+								speedStates |= 0x1;
+								if (isPrevPos) pb.effSpeedChange(eff.value);
+							}
+							else if (!(speedStates & 0x2)) {			// Tempo change
+								speedStates |= 0x2;
+								if (isPrevPos) pb.effTempoChange(eff.value);
+							}
+						}
+						break;
+					case EffectType::Groove:
+						if (eff.value < static_cast<int>(pb.mod_.lock()->getGrooveCount()) && !speedStates) {
+							speedStates |= 0x4;
+							if (isPrevPos) pb.effGrooveChange(eff.value);
+						}
+						break;
+					case EffectType::Detune:
+						if (!isSetDtnADPCM) {
+							isSetDtnADPCM = true;
+							if (isPrevPos) pb.opnaCtrl_->setDetuneADPCM(eff.value - 0x80);
+						}
+						break;
+					case EffectType::FineDetune:
+						if (!isSetFiDtnADPCM) {
+							isSetFiDtnADPCM = true;
+							if (isPrevPos) pb.opnaCtrl_->setFineDetuneADPCM(eff.value - 0x80);
+						}
+						break;
+					default:
+						break;
+					}
+				}
+				// Tone
+				int t = step.getNoteNumber();
+				if (isPrevPos && t != -1 && t != -2) {
+					--tonesCntADPCM;
+					for (auto it2 = toneADPCM.rbegin();
+						 it2 != toneADPCM.rend(); ++it2) {
+						if (*it2 == -1 || *it2 == tonesCntADPCM) {
+							if (t >= 0) {
+								*it2 = t;
+							}
+							else if (t < -2) {
+								*it2 = tonesCntADPCM - t + 2;
+							}
+							break;
+						}
+					}
+				}
+				break;
+			}
+			}
+		}
+
+		// Move position
+		isPrevPos = true;
+		if (--s < 0) {
+			if (--o < 0) break;
+			s = static_cast<int>(pb.getPatternSizeFromOrderNumber(pb.curSongNum_, o)) - 1;
+		}
+	}
+
+	// Echo & sequence reset
+	for (size_t ch = 0; ch < fmch; ++ch) {
+		for (size_t i = 0; i < 3; ++i) {
+			if (toneFM.at(ch).at(i) >= 0) {
+				std::pair<int, Note> octNote = noteNumberToOctaveAndNote(toneFM[ch][i]);
+				pb.opnaCtrl_->updateEchoBufferFM(static_cast<int>(ch), octNote.first, octNote.second, 0);
+			}
+		}
+		pb.opnaCtrl_->haltSequencesFM(static_cast<int>(ch));
+	}
+	for (size_t ch = 0; ch < 3; ++ch) {
+		for (size_t i = 0; i < 3; ++i) {
+			if (toneSSG.at(ch).at(i) >= 0) {
+				std::pair<int, Note> octNote = noteNumberToOctaveAndNote(toneSSG[ch][i]);
+				pb.opnaCtrl_->updateEchoBufferSSG(static_cast<int>(ch), octNote.first, octNote.second, 0);
+			}
+		}
+		pb.opnaCtrl_->haltSequencesSSG(static_cast<int>(ch));
+	}
+	for (size_t i = 0; i < 3; ++i) {
+		if (toneADPCM.at(i) >= 0) {
+			std::pair<int, Note> octNote = noteNumberToOctaveAndNote(toneADPCM[i]);
+			pb.opnaCtrl_->updateEchoBufferADPCM(octNote.first, octNote.second, 0);
+		}
+	}
+	pb.opnaCtrl_->haltSequencesADPCM();
+}
+
+namespace
+{
+enum class Retrieval
+{
+	Timeline, FullScan, Legacy
+};
+
+/// Render the steps of the order to WAV data
+std::vector<char> renderOrder(Module& mod, std::shared_ptr<InstrumentsManager> instMan,
+							  int songNum, int order, Retrieval retrieval)
+{
+	OfflineRenderer renderer(mod, instMan, songNum);
+	renderer.assignSampleADPCMRawSamples();
+	PlaybackManager::ChannelRetriever retriever;
+	if (retrieval == Retrieval::Legacy) retriever = retrieveChannelStatesByLegacyScan;
+	renderer.setStartOrder(order, retrieval == Retrieval::FullScan, retriever);
+
+	std::vector<char> buf;
+	size_t pos = 0;
+	WavWriter writer([&](const char* data, size_t size) {
+		if (buf.size() < pos + size) buf.resize(pos + size);
+		std::copy_n(data, size, buf.begin() + static_cast<std::ptrdiff_t>(pos));
+		pos += size;
+		return true;
+	}, [&pos](size_t p) {
+		pos = p;
+		return true;
+	});
+
+	// Stop at the head of the next order
+	size_t stepCnt = mod.getSong(songNum).getPatternSizeFromOrderNumber(order);
+	renderer.renderToWav(writer, 0, [&stepCnt] { return !stepCnt--; });
+	writer.finalize();
+	return buf;
+}
+}
+
+bool checkTimeline(const std::string& path, std::ostream& os)
+{
+	std::ifstream ifs(path, std::ios::binary);
+	if (!ifs) throw FileNotExistError(FileIO::FileType::Mod);
+	BinaryContainer data(std::vector<char>((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>()));
+
+	auto mod = std::make_shared<Module>();
+	auto instMan = std::make_shared<InstrumentsManager>(false);
+	ModuleIO::loadModule(data, mod, instMan);
+
+	bool isMatched = true;
+	size_t checkCnt = 0;
+	for (int s = 0; s < static_cast<int>(mod->getSongCount()); ++s) {
+		int orderCnt = static_cast<int>(mod->getSong(s).getOrderSize());
+		for (int o = 1; o < orderCnt; ++o) {
+			std::vector<char> legacy = renderOrder(*mod, instMan, s, o, Retrieval::Legacy);
+			if (renderOrder(*mod, instMan, s, o, Retrieval::Timeline) != legacy) {
+				os << "Mismatch: song " << s << ", order " << o << " (timeline)" << std::endl;
+				isMatched = false;
+			}
+			if (renderOrder(*mod, instMan, s, o, Retrieval::FullScan) != legacy) {
+				os << "Mismatch: song " << s << ", order " << o << " (full scan)" << std::endl;
+				isMatched = false;
+			}
+			++checkCnt;
+		}
+	}
+	os << checkCnt << " orders checked" << std::endl;
+
+	return isMatched;
+}
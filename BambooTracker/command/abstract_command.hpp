@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include "command_id.hpp"
 
 struct AbstractCommand
@@ -33,6 +34,9 @@ struct AbstractCommand
 	virtual void redo() = 0;
 	virtual void undo() = 0;
 	virtual CommandId getID() const = 0;
+	/// Approximate bytes used by the command to limit the history size.
+	/// The commands which keep large data override it.
+	virtual size_t getMemorySize() const { return sizeof(*this); }
 	virtual bool mergeWith(const AbstractCommand* other)
 	{
 		(void)other;
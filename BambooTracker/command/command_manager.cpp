@@ -26,38 +26,92 @@
 #include "command_manager.hpp"
 #include <utility>
 
-CommandManager::CommandManager() {}
+CommandManager::CommandManager()
+	: memSize_(0),
+	  budget_(DEF_MEMORY_BUDGET_),
+	  nEvicted_(0)
+{
+}
 
 void CommandManager::invoke(CommandIPtr command)
 {
 	command->redo();
 
-	redoStack_ = std::stack<CommandIPtr>();
-	if (undoStack_.empty() || !undoStack_.top()->mergeWith(command.get())) {
-		undoStack_.push(std::move(command));
+	while (!redoStack_.empty()) {
+		memSize_ -= redoStack_.top().size;
+		redoStack_.pop();
+	}
+	if (undoStack_.empty() || !undoStack_.back().command->mergeWith(command.get())) {
+		size_t size = command->getMemorySize();
+		memSize_ += size;
+		undoStack_.push_back({ std::move(command), size });
 	}
+	else {
+		// The merged command may grow
+		Entry& top = undoStack_.back();
+		memSize_ -= top.size;
+		top.size = top.command->getMemorySize();
+		memSize_ += top.size;
+	}
+
+	evict();
 }
 
 void CommandManager::undo()
 {
 	if (undoStack_.empty()) return;
-	CommandIPtr command = std::move(undoStack_.top());
-	command->undo();
-	undoStack_.pop();
-	redoStack_.push(std::move(command));
+	Entry entry = std::move(undoStack_.back());
+	entry.command->undo();
+	undoStack_.pop_back();
+	redoStack_.push(std::move(entry));
 }
 
 void CommandManager::redo()
 {
 	if (redoStack_.empty()) return;
-	CommandIPtr command = std::move(redoStack_.top());
-	command->redo();
+	Entry entry = std::move(redoStack_.top());
+	entry.command->redo();
 	redoStack_.pop();
-	undoStack_.push(std::move(command));
+	undoStack_.push_back(std::move(entry));
 }
 
 void CommandManager::clear()
 {
-	redoStack_ = std::stack<CommandIPtr>();
-	undoStack_ = std::stack<CommandIPtr>();
+	redoStack_ = std::stack<Entry>();
+	undoStack_.clear();
+	memSize_ = 0;
+	nEvicted_ = 0;
+}
+
+bool CommandManager::canUndo() const
+{
+	return !undoStack_.empty();
+}
+
+bool CommandManager::canRedo() const
+{
+	return !redoStack_.empty();
+}
+
+void CommandManager::setMemoryBudget(size_t bytes)
+{
+	budget_ = bytes;
+	evict();
+}
+
+CommandManager::Statistics CommandManager::getStatistics() const
+{
+	return { undoStack_.size(), redoStack_.size(), memSize_, budget_, nEvicted_ };
+}
+
+void CommandManager::evict()
+{
+	if (!budget_) return;
+
+	// Keep the latest command even if it exceeds the budget by itself
+	while (memSize_ > budget_ && undoStack_.size() > 1) {
+		memSize_ -= undoStack_.front().size;
+		undoStack_.pop_front();
+		++nEvicted_;
+	}
 }
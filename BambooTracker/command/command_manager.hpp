@@ -25,8 +25,10 @@
 
 #pragma once
 
+#include <deque>
 #include <stack>
 #include <memory>
+#include <cstddef>
 #include "abstract_command.hpp"
 
 class CommandManager
@@ -34,13 +36,42 @@ class CommandManager
 public:
 	using CommandIPtr = std::unique_ptr<AbstractCommand>;
 
+	struct Statistics
+	{
+		size_t undoCount, redoCount;
+		/// Bytes used by the commands in the history
+		size_t memorySize;
+		size_t memoryBudget;
+		/// The number of the oldest commands removed to keep the budget
+		size_t evictedCount;
+	};
+
 	CommandManager();
 	void invoke(CommandIPtr command);
 	void undo();
 	void redo();
 	void clear();
+	bool canUndo() const;
+	bool canRedo() const;
+
+	/// Set the upper limit of the bytes used by the history, 0 is unlimited.
+	/// The oldest commands are removed when the history exceeds it.
+	void setMemoryBudget(size_t bytes);
+	Statistics getStatistics() const;
 
 private:
-	std::stack<CommandIPtr> undoStack_;
-	std::stack<CommandIPtr> redoStack_;
+	struct Entry
+	{
+		CommandIPtr command;
+		size_t size;
+	};
+
+	/// The back is the latest command
+	std::deque<Entry> undoStack_;
+	std::stack<Entry> redoStack_;
+	size_t memSize_, budget_, nEvicted_;
+
+	static constexpr size_t DEF_MEMORY_BUDGET_ = 64 * 1024 * 1024;
+
+	void evict();
 };
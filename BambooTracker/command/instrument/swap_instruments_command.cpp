@@ -70,4 +70,5 @@ void SwapInstrumentsCommand::swapInstrumentsInPatterns()
 			}
 		}
 	}
+	song.invalidateTimeline();
 }
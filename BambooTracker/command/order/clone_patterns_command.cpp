@@ -46,6 +46,7 @@ ClonePatternsCommand::ClonePatternsCommand(std::weak_ptr<Module> mod, int songNu
 void ClonePatternsCommand::redo()
 {
 	auto& sng = mod_.lock()->getSong(song_);
+	sng.invalidateTimeline(bOrder_);
 	for (int o = bOrder_; o <= eOrder_; ++o) {
 		for (int t = bTrack_; t <= eTrack_; ++t) {
 			auto& track = sng.getTrack(t);
@@ -57,6 +58,7 @@ void ClonePatternsCommand::redo()
 void ClonePatternsCommand::undo()
 {
 	auto& sng = mod_.lock()->getSong(song_);
+	sng.invalidateTimeline(bOrder_);
 	for (int o = bOrder_; o <= eOrder_; ++o) {
 		for (int t = bTrack_; t <= eTrack_; ++t) {
 			auto& track = sng.getTrack(t);
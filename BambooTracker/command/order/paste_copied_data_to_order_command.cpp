@@ -62,6 +62,8 @@ CommandId PasteCopiedDataToOrderCommand::getID() const
 void PasteCopiedDataToOrderCommand::setCells(std::vector<std::vector<std::string>>& cells)
 {
 	auto& sng = mod_.lock()->getSong(song_);
+	sng.invalidateTimeline(order_);
+	sng.invalidateAnalysis();
 
 	for (size_t i = 0; i < cells.size(); ++i) {
 		for (size_t j = 0; j < cells.at(i).size(); ++j) {
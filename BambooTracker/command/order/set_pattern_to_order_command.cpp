@@ -39,12 +39,18 @@ SetPatternToOrderCommand::SetPatternToOrderCommand(std::weak_ptr<Module> mod, in
 
 void SetPatternToOrderCommand::redo()
 {
-	mod_.lock()->getSong(song_).getTrack(track_).registerPatternToOrder(order_, pattern_);
+	auto& sng = mod_.lock()->getSong(song_);
+	sng.invalidateTimeline(order_);
+	sng.invalidateAnalysis();
+	sng.getTrack(track_).registerPatternToOrder(order_, pattern_);
 }
 
 void SetPatternToOrderCommand::undo()
 {
-	mod_.lock()->getSong(song_).getTrack(track_).registerPatternToOrder(order_, prevPattern_);
+	auto& sng = mod_.lock()->getSong(song_);
+	sng.invalidateTimeline(order_);
+	sng.invalidateAnalysis();
+	sng.getTrack(track_).registerPatternToOrder(order_, prevPattern_);
 	isSecond_ = true;	// Forced complete
 }
 
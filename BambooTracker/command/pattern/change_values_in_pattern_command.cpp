@@ -25,6 +25,7 @@
 
 #include "change_values_in_pattern_command.hpp"
 #include "misc.hpp"
+#include "pattern_command_utils.hpp"
 
 ChangeValuesInPatternCommand::ChangeValuesInPatternCommand(std::weak_ptr<Module> mod, int songNum, int beginTrack,
 														   int beginColumn, int beginOrder, int beginStep,
@@ -70,6 +71,9 @@ ChangeValuesInPatternCommand::ChangeValuesInPatternCommand(std::weak_ptr<Module>
 
 void ChangeValuesInPatternCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(bCol_, calculateColumnSize(bTrack_, bCol_, eTrack_, eCol_)))
+		mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& sng = mod_.lock()->getSong(song_);
 	auto it = prevVals_.begin();
 	for (int step = bStep_; step <= eStep_; ++step, ++it) {
@@ -113,6 +117,9 @@ void ChangeValuesInPatternCommand::redo()
 
 void ChangeValuesInPatternCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(bCol_, calculateColumnSize(bTrack_, bCol_, eTrack_, eCol_)))
+		mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& sng = mod_.lock()->getSong(song_);
 	auto it = prevVals_.begin();
 	for (int step = bStep_; step <= eStep_; ++step, ++it) {
@@ -45,12 +45,16 @@ DeletePreviousStepCommand::DeletePreviousStepCommand(std::weak_ptr<Module> mod,
 
 void DeletePreviousStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	mod_.lock()->getSong(song_).invalidateAnalysis();
 	mod_.lock()->getSong(song_).getTrack(track_)
 			.getPatternFromOrderNumber(order_).deletePreviousStep(step_);
 }
 
 void DeletePreviousStepCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& pt =  mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_);
 	pt.insertStep(step_ - 1);	// Insert previous step
 	auto& st = pt.getStep(step_ - 1);
@@ -40,18 +40,20 @@ EraseCellsInPatternCommand::EraseCellsInPatternCommand(std::weak_ptr<Module> mod
 	auto& song = mod.lock()->getSong(songNum);
 	size_t h = static_cast<size_t>(endStep - beginStep + 1);
 	size_t w = calculateColumnSize(beginTrack, beginColumn, endTrack, endColumn);
-	prevCells_ = getPreviousCells(song, w, h, beginTrack, beginColumn, beginOrder, beginStep);
+	prevCells_ = PatternCellBlock(song, w, h, beginTrack, beginColumn, beginOrder, beginStep);
 }
 
 void EraseCellsInPatternCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(bCol_, prevCells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = bStep_;
-	for (size_t i = 0; i < prevCells_.size(); ++i) {
+	for (size_t i = 0; i < prevCells_.getHeight(); ++i) {
 		int t = bTrack_;
 		int c = bCol_;
-		for (size_t j = 0; j < prevCells_.at(i).size(); ++j) {
+		for (size_t j = 0; j < prevCells_.getWidth(); ++j) {
 			Step& st = sng.getTrack(t).getPatternFromOrderNumber(order_).getStep(s);
 			switch (c) {
 			case 0:		st.setNoteNumber(-1);		break;
@@ -77,10 +79,17 @@ void EraseCellsInPatternCommand::redo()
 
 void EraseCellsInPatternCommand::undo()
 {
-	restorePattern(mod_.lock()->getSong(song_), prevCells_, bTrack_, bCol_, order_, bStep_);
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(bCol_, prevCells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
+	prevCells_.restore(mod_.lock()->getSong(song_), bTrack_, order_, bStep_);
 }
 
 CommandId EraseCellsInPatternCommand::getID() const
 {
 	return CommandId::EraseCellsInPattern;
 }
+
+size_t EraseCellsInPatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + prevCells_.getMemorySize();
+}
@@ -24,6 +24,7 @@
  */
 
 #include "erase_effect_in_step_command.hpp"
+#include "pattern_command_utils.hpp"
 
 EraseEffectInStepCommand::EraseEffectInStepCommand(std::weak_ptr<Module> mod, int songNum, int trackNum, int orderNum, int stepNum, int n)
 	: mod_(mod),
@@ -40,6 +41,8 @@ EraseEffectInStepCommand::EraseEffectInStepCommand(std::weak_ptr<Module> mod, in
 
 void EraseEffectInStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (isSongStructureEffect(Effect::encodeID(prevEffID_))) mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& st = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
 	st.setEffectID(n_, "--");
 	st.setEffectValue(n_, -1);
@@ -47,6 +50,8 @@ void EraseEffectInStepCommand::redo()
 
 void EraseEffectInStepCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (isSongStructureEffect(Effect::encodeID(prevEffID_))) mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& st = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
 	st.setEffectID(n_, prevEffID_);
 	st.setEffectValue(n_, prevEffVal_);
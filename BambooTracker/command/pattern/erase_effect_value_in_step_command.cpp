@@ -24,6 +24,7 @@
  */
 
 #include "erase_effect_value_in_step_command.hpp"
+#include "pattern_command_utils.hpp"
 
 EraseEffectValueInStepCommand::EraseEffectValueInStepCommand(std::weak_ptr<Module> mod, int songNum, int trackNum, int orderNum, int stepNum, int n)
 	: mod_(mod),
@@ -39,14 +40,18 @@ EraseEffectValueInStepCommand::EraseEffectValueInStepCommand(std::weak_ptr<Modul
 
 void EraseEffectValueInStepCommand::redo()
 {
-	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
-			.getStep(step_).setEffectValue(n_, -1);
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	Step& step = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
+	if (isSongStructureEffect(step.getEffectIDCode(n_))) mod_.lock()->getSong(song_).invalidateAnalysis();
+	step.setEffectValue(n_, -1);
 }
 
 void EraseEffectValueInStepCommand::undo()
 {
-	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
-			.getStep(step_).setEffectValue(n_, prevVal_);
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	Step& step = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
+	if (isSongStructureEffect(step.getEffectIDCode(n_))) mod_.lock()->getSong(song_).invalidateAnalysis();
+	step.setEffectValue(n_, prevVal_);
 }
 
 CommandId EraseEffectValueInStepCommand::getID() const
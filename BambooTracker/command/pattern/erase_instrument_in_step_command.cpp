@@ -38,12 +38,14 @@ EraseInstrumentInStepCommand::EraseInstrumentInStepCommand(std::weak_ptr<Module>
 
 void EraseInstrumentInStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
 			.getStep(step_).setInstrumentNumber(-1);
 }
 
 void EraseInstrumentInStepCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
 			.getStep(step_).setInstrumentNumber(prevInst_);
 }
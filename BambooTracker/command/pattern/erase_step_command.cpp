@@ -44,6 +44,8 @@ EraseStepCommand::EraseStepCommand(std::weak_ptr<Module> mod, int songNum, int t
 
 void EraseStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& st = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
 	st.setNoteNumber(-1);
 	st.setInstrumentNumber(-1);
@@ -56,6 +58,8 @@ void EraseStepCommand::redo()
 
 void EraseStepCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& st = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
 	st.setNoteNumber(prevNote_);
 	st.setInstrumentNumber(prevInst_);
@@ -38,12 +38,14 @@ EraseVolumeInStepCommand::EraseVolumeInStepCommand(std::weak_ptr<Module> mod, in
 
 void EraseVolumeInStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
 			.getStep(step_).setVolume(-1);
 }
 
 void EraseVolumeInStepCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
 			.getStep(step_).setVolume(prevVol_);
 }
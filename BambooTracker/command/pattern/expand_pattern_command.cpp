@@ -40,87 +40,25 @@ ExpandPatternCommand::ExpandPatternCommand(std::weak_ptr<Module> mod,
 	auto& song = mod.lock()->getSong(songNum);
 	size_t h = static_cast<size_t>(endStep - beginStep + 1);
 	size_t w = calculateColumnSize(beginTrack, beginColumn, endTrack, endColumn);
-	prevCells_ = getPreviousCells(song, w, h, beginTrack, beginColumn, beginOrder, beginStep);
+	prevCells_ = PatternCellBlock(song, w, h, beginTrack, beginColumn, beginOrder, beginStep);
 }
 
 void ExpandPatternCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(bCol_, prevCells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& sng = mod_.lock()->getSong(song_);
 
+	std::vector<uint16_t> cells = prevCells_.unpack();
+	size_t w = prevCells_.getWidth();
 	int s = bStep_;
-	for (size_t i = 0; i < prevCells_.size(); ++i) {
+	for (size_t i = 0; i < prevCells_.getHeight(); ++i) {
 		int t = bTrack_;
 		int c = bCol_;
-		for (size_t j = 0; j < prevCells_.at(i).size(); ++j) {
+		for (size_t j = 0; j < w; ++j) {
 			Step& st = sng.getTrack(t).getPatternFromOrderNumber(order_).getStep(s);
-			switch (c) {
-			case 0:
-			{
-				int n = (i % 2) ? -1 : std::stoi(prevCells_.at(i / 2).at(j));
-				st.setNoteNumber(n);
-				break;
-			}
-			case 1:
-			{
-				int n = (i % 2) ? -1 : std::stoi(prevCells_.at(i / 2).at(j));
-				st.setInstrumentNumber(n);
-				break;
-			}
-			case 2:
-			{
-				int v = (i % 2) ? -1 : std::stoi(prevCells_.at(i / 2).at(j));
-				st.setVolume(v);
-				break;
-			}
-			case 3:
-			{
-				std::string id = (i % 2) ? "--" : prevCells_.at(i / 2).at(j);
-				st.setEffectID(0, id);
-				break;
-			}
-			case 4:
-			{
-				int v = (i % 2) ? -1 : std::stoi(prevCells_.at(i / 2).at(j));
-				st.setEffectValue(0, v);
-				break;
-			}
-			case 5:
-			{
-				std::string id = (i % 2) ? "--" : prevCells_.at(i / 2).at(j);
-				st.setEffectID(1, id);
-				break;
-			}
-			case 6:
-			{
-				int v = (i % 2) ? -1 : std::stoi(prevCells_.at(i / 2).at(j));
-				st.setEffectValue(1, v);
-				break;
-			}
-			case 7:
-			{
-				std::string id = (i % 2) ? "--" : prevCells_.at(i / 2).at(j);
-				st.setEffectID(2, id);
-				break;
-			}
-			case 8:
-			{
-				int v = (i % 2) ? -1 : std::stoi(prevCells_.at(i / 2).at(j));
-				st.setEffectValue(2, v);
-				break;
-			}
-			case 9:
-			{
-				std::string id = (i % 2) ? "--" : prevCells_.at(i / 2).at(j);
-				st.setEffectID(3, id);
-				break;
-			}
-			case 10:
-			{
-				int v = (i % 2) ? -1 : std::stoi(prevCells_.at(i / 2).at(j));
-				st.setEffectValue(3, v);
-				break;
-			}
-			}
+			uint16_t cell = (i % 2) ? PatternCellBlock::getEmptyCell(c) : cells[(i / 2) * w + j];
+			PatternCellBlock::setCell(st, c, cell);
 
 			t += (++c / 11);
 			c %= 11;
@@ -132,10 +70,17 @@ void ExpandPatternCommand::redo()
 
 void ExpandPatternCommand::undo()
 {
-	restorePattern(mod_.lock()->getSong(song_), prevCells_, bTrack_, bCol_, order_, bStep_);
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(bCol_, prevCells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
+	prevCells_.restore(mod_.lock()->getSong(song_), bTrack_, order_, bStep_);
 }
 
 CommandId ExpandPatternCommand::getID() const
 {
 	return CommandId::ExpandPattern;
 }
+
+size_t ExpandPatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + prevCells_.getMemorySize();
+}
@@ -36,11 +36,15 @@ InsertStepCommand::InsertStepCommand(std::weak_ptr<Module> mod, int songNum, int
 
 void InsertStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	mod_.lock()->getSong(song_).invalidateAnalysis();
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).insertStep(step_);
 }
 
 void InsertStepCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	mod_.lock()->getSong(song_).invalidateAnalysis();
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).deletePreviousStep(step_ + 1);
 }
 
@@ -41,20 +41,22 @@ InterpolatePatternCommand::InterpolatePatternCommand(std::weak_ptr<Module> mod,
 	auto& song = mod.lock()->getSong(songNum);
 	size_t h = static_cast<size_t>(endStep - beginStep + 1);
 	size_t w = calculateColumnSize(beginTrack, beginColumn, endTrack, endColumn);
-	prevCells_ = getPreviousCells(song, w, h, beginTrack, beginColumn, beginOrder, beginStep);
+	prevCells_ = PatternCellBlock(song, w, h, beginTrack, beginColumn, beginOrder, beginStep);
 }
 
 void InterpolatePatternCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(bCol_, prevCells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& sng = mod_.lock()->getSong(song_);
-	int div = static_cast<int>(prevCells_.size()) - 1;
+	int div = static_cast<int>(prevCells_.getHeight()) - 1;
 	if (!div) div = 1;
 
 	int t = bTrack_;
 	int c = bCol_;
-	for (size_t i = 0; i < prevCells_.front().size(); ++i) {
+	for (size_t i = 0; i < prevCells_.getWidth(); ++i) {
 		int s = bStep_;
-		for (size_t j = 0; j < prevCells_.size(); ++j) {
+		for (size_t j = 0; j < prevCells_.getHeight(); ++j) {
 			switch (c) {
 			case 0:
 			{
@@ -171,10 +173,17 @@ void InterpolatePatternCommand::redo()
 
 void InterpolatePatternCommand::undo()
 {
-	restorePattern(mod_.lock()->getSong(song_), prevCells_, bTrack_, bCol_, order_, bStep_);
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(bCol_, prevCells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
+	prevCells_.restore(mod_.lock()->getSong(song_), bTrack_, order_, bStep_);
 }
 
 CommandId InterpolatePatternCommand::getID() const
 {
 	return CommandId::InterpolatePattern;
 }
+
+size_t InterpolatePatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + prevCells_.getMemorySize();
+}
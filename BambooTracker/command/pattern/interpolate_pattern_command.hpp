@@ -30,6 +30,7 @@
 #include <vector>
 #include <string>
 #include "module.hpp"
+#include "pattern_cell_block.hpp"
 
 class InterpolatePatternCommand : public AbstractCommand
 {
@@ -40,12 +41,13 @@ public:
 	void redo() override;
 	void undo() override;
 	CommandId getID() const override;
+	size_t getMemorySize() const override;
 
 private:
 	std::weak_ptr<Module> mod_;
 	int song_, bTrack_, bCol_, order_, bStep_;
 	int eStep_;
-	std::vector<std::vector<std::string>> prevCells_;
+	PatternCellBlock prevCells_;
 
 	inline int interp(int a, int b, size_t t, int div) { return a + (b - a) * static_cast<int>(t) / div; }
 };
@@ -27,21 +27,21 @@
 
 #include "abstract_command.hpp"
 #include <memory>
-#include <vector>
-#include <string>
 #include "module.hpp"
+#include "pattern_cell_block.hpp"
 
 class PasteCopiedDataToPatternCommand : public AbstractCommand
 {
 public:
 	PasteCopiedDataToPatternCommand(std::weak_ptr<Module> mod, int songNum, int beginTrack, int beginColmn,
-									int beginOrder, int beginStep, std::vector<std::vector<std::string>> cells);
+									int beginOrder, int beginStep, PatternCellBlock cells);
 	void redo() override;
 	void undo() override;
 	CommandId getID() const override;
+	size_t getMemorySize() const override;
 
 private:
 	std::weak_ptr<Module> mod_;
 	int song_, track_, col_, order_, step_;
-	std::vector<std::vector<std::string>> cells_, prevCells_;
+	PatternCellBlock cells_, prevCells_;
 };
@@ -24,40 +24,53 @@
  */
 
 #include "paste_insert_copied_data_to_pattern_command.hpp"
-#include <algorithm>
+#include <utility>
 #include "pattern_command_utils.hpp"
 
 PasteInsertCopiedDataToPatternCommand::PasteInsertCopiedDataToPatternCommand(
 		std::weak_ptr<Module> mod, int songNum, int beginTrack, int beginColumn,
-		int beginOrder, int beginStep, std::vector<std::vector<std::string>> cells)
+		int beginOrder, int beginStep, PatternCellBlock cells)
 	: mod_(mod),
 	  song_(songNum),
 	  track_(beginTrack),
 	  col_(beginColumn),
 	  order_(beginOrder),
 	  step_(beginStep),
-	  cells_(cells)
+	  cells_(std::move(cells))
 {
 	auto& song = mod.lock()->getSong(songNum);
 	size_t newStepSize = song.getTrack(track_).getPatternFromOrderNumber(order_).getSize() - step_;
-	prevCells_ = getPreviousCells(song, cells.front().size(), newStepSize,
+	prevCells_ = PatternCellBlock(song, cells_.getWidth(), newStepSize,
 								  beginTrack, beginColumn, beginOrder, beginStep);
-	if (cells.size() < newStepSize) {
-		std::copy(prevCells_.begin(), prevCells_.end() - cells.size(), std::back_inserter(cells_));
+	if (cells_.getHeight() < newStepSize) {
+		// Shift the previous cells after the pasted cells
+		std::vector<uint16_t> tmp = cells_.unpack();
+		std::vector<uint16_t> prev = prevCells_.unpack();
+		tmp.insert(tmp.end(), prev.begin(), prev.end() - static_cast<int>(tmp.size()));
+		cells_ = PatternCellBlock(tmp, cells_.getWidth(), beginColumn);
 	}
 }
 
 void PasteInsertCopiedDataToPatternCommand::redo()
 {
-	restorePattern(mod_.lock()->getSong(song_), cells_, track_, col_, order_, step_);
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(col_, cells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
+	cells_.restore(mod_.lock()->getSong(song_), track_, order_, step_);
 }
 
 void PasteInsertCopiedDataToPatternCommand::undo()
 {
-	restorePattern(mod_.lock()->getSong(song_), prevCells_, track_, col_, order_, step_);
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(col_, cells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
+	prevCells_.restore(mod_.lock()->getSong(song_), track_, order_, step_);
 }
 
 CommandId PasteInsertCopiedDataToPatternCommand::getID() const
 {
 	return CommandId::PasteInsertCopiedDataToPattern;
 }
+
+size_t PasteInsertCopiedDataToPatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + cells_.getMemorySize() + prevCells_.getMemorySize();
+}
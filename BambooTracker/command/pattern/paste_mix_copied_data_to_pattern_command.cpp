@@ -24,99 +24,43 @@
  */
 
 #include "paste_mix_copied_data_to_pattern_command.hpp"
+#include <utility>
 #include "pattern_command_utils.hpp"
 
 PasteMixCopiedDataToPatternCommand::PasteMixCopiedDataToPatternCommand(std::weak_ptr<Module> mod, int songNum,
 																	   int beginTrack, int beginColumn,
 																	   int beginOrder, int beginStep,
-																	   std::vector<std::vector<std::string>> cells)
+																	   PatternCellBlock cells)
 	: mod_(mod),
 	  song_(songNum),
 	  track_(beginTrack),
 	  col_(beginColumn),
 	  order_(beginOrder),
 	  step_(beginStep),
-	  cells_(cells)
+	  cells_(std::move(cells))
 {
 	auto& song = mod.lock()->getSong(songNum);
-	prevCells_ = getPreviousCells(song, cells.front().size(), cells.size(),
+	prevCells_ = PatternCellBlock(song, cells_.getWidth(), cells_.getHeight(),
 								  beginTrack, beginColumn, beginOrder, beginStep);
 }
 
 void PasteMixCopiedDataToPatternCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(col_, cells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& sng = mod_.lock()->getSong(song_);
 
+	std::vector<uint16_t> cells = cells_.unpack();
+	auto it = cells.cbegin();
 	int s = step_;
-	for (const auto& row : cells_) {
+	for (size_t i = 0; i < cells_.getHeight(); ++i) {
 		int t = track_;
 		int c = col_;
-		for (const std::string& cell : row) {
-			auto& step = sng.getTrack(t).getPatternFromOrderNumber(order_).getStep(s);
-			switch (c) {
-			case 0:
-			{
-				int n = std::stoi(cell);
-				if (n != -1 && step.getNoteNumber() == -1) step.setNoteNumber(n);
-				break;
-			}
-			case 1:
-			{
-				int n = std::stoi(cell);
-				if (n != -1 && step.getInstrumentNumber() == -1) step.setInstrumentNumber(n);
-				break;
-			}
-			case 2:
-			{
-				int vol = std::stoi(cell);
-				if (vol != -1 && step.getVolume() == -1) step.setVolume(vol);
-				break;
-			}
-			case 3:
-			{
-				if (cell != "--" && step.getEffectID(0) == "--") step.setEffectID(0, cell);
-				break;
-			}
-			case 4:
-			{
-				int val = std::stoi(cell);
-				if (val != -1 && step.getEffectValue(0) == -1) step.setEffectValue(0, val);
-				break;
-			}
-			case 5:
-			{
-				if (cell != "--" && step.getEffectID(1) == "--") step.setEffectID(1, cell);
-				break;
-			}
-			case 6:
-			{
-				int val = std::stoi(cell);
-				if (val != -1 && step.getEffectValue(1) == -1) step.setEffectValue(1, val);
-				break;
-			}
-			case 7:
-			{
-				if (cell!= "--" && step.getEffectID(2) == "--") step.setEffectID(2, cell);
-				break;
-			}
-			case 8:
-			{
-				int val = std::stoi(cell);
-				if (val != -1 && step.getEffectValue(2) == -1) step.setEffectValue(2, val);
-				break;
-			}
-			case 9:
-			{
-				if (cell != "--" && step.getEffectID(3) == "--") step.setEffectID(3, cell);
-				break;
-			}
-			case 10:
-			{
-				int val = std::stoi(cell);
-				if (val != -1 && step.getEffectValue(3) == -1) step.setEffectValue(3, val);
-				break;
-			}
-			}
+		for (size_t j = 0; j < cells_.getWidth(); ++j, ++it) {
+			Step& st = sng.getTrack(t).getPatternFromOrderNumber(order_).getStep(s);
+			uint16_t empty = PatternCellBlock::getEmptyCell(c);
+			if (*it != empty && PatternCellBlock::getCell(st, c) == empty)
+				PatternCellBlock::setCell(st, c, *it);
 
 			++c;
 			t += (c / 11);
@@ -129,10 +73,17 @@ void PasteMixCopiedDataToPatternCommand::redo()
 
 void PasteMixCopiedDataToPatternCommand::undo()
 {
-	restorePattern(mod_.lock()->getSong(song_), prevCells_, track_, col_, order_, step_);
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(col_, cells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
+	prevCells_.restore(mod_.lock()->getSong(song_), track_, order_, step_);
 }
 
 CommandId PasteMixCopiedDataToPatternCommand::getID() const
 {
 	return CommandId::PasteMixCopiedDataToPattern;
 }
+
+size_t PasteMixCopiedDataToPatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + cells_.getMemorySize() + prevCells_.getMemorySize();
+}
@@ -24,98 +24,40 @@
  */
 
 #include "paste_overwrite_copied_data_to_pattern_command.hpp"
+#include <utility>
 #include "pattern_command_utils.hpp"
 
 PasteOverwriteCopiedDataToPatternCommand::PasteOverwriteCopiedDataToPatternCommand(
 		std::weak_ptr<Module> mod, int songNum, int beginTrack, int beginColumn,
-		int beginOrder, int beginStep, std::vector<std::vector<std::string>> cells)
+		int beginOrder, int beginStep, PatternCellBlock cells)
 	: mod_(mod),
 	  song_(songNum),
 	  track_(beginTrack),
 	  col_(beginColumn),
 	  order_(beginOrder),
 	  step_(beginStep),
-	  cells_(cells)
+	  cells_(std::move(cells))
 {
 	auto& song = mod.lock()->getSong(songNum);
-	prevCells_ = getPreviousCells(song, cells.front().size(), cells.size(),
+	prevCells_ = PatternCellBlock(song, cells_.getWidth(), cells_.getHeight(),
 								  beginTrack, beginColumn, beginOrder, beginStep);
 }
 
 void PasteOverwriteCopiedDataToPatternCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(col_, cells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
 	auto& sng = mod_.lock()->getSong(song_);
 
+	std::vector<uint16_t> cells = cells_.unpack();
+	auto it = cells.cbegin();
 	int s = step_;
-	for (const auto& row : cells_) {
+	for (size_t i = 0; i < cells_.getHeight(); ++i) {
 		int t = track_;
 		int c = col_;
-		for (const std::string& cell : row) {
+		for (size_t j = 0; j < cells_.getWidth(); ++j, ++it) {
 			Step& st = sng.getTrack(t).getPatternFromOrderNumber(order_).getStep(s);
-			switch (c) {
-			case 0:
-			{
-				int n = std::stoi(cell);
-				if (n != -1) st.setNoteNumber(n);
-				break;
-			}
-			case 1:
-			{
-				int n = std::stoi(cell);
-				if (n != -1) st.setInstrumentNumber(n);
-				break;
-			}
-			case 2:
-			{
-				int vol = std::stoi(cell);
-				if (vol != -1) st.setVolume(vol);
-				break;
-			}
-			case 3:
-			{
-				if (cell != "--") st.setEffectID(0, cell);
-				break;
-			}
-			case 4:
-			{
-				int val = std::stoi(cell);
-				if (val != -1) st.setEffectValue(0, val);
-				break;
-			}
-			case 5:
-			{
-				if (cell != "--") st.setEffectID(1, cell);
-				break;
-			}
-			case 6:
-			{
-				int val = std::stoi(cell);
-				if (val != -1) st.setEffectValue(1, val);
-				break;
-			}
-			case 7:
-			{
-				if (cell != "--") st.setEffectID(2, cell);
-				break;
-			}
-			case 8:
-			{
-				int val = std::stoi(cell);
-				if (val != -1) st.setEffectValue(2, val);
-				break;
-			}
-			case 9:
-			{
-				if (cell != "--") st.setEffectID(3, cell);
-				break;
-			}
-			case 10:
-			{
-				int val = std::stoi(cell);
-				if (val != -1) st.setEffectValue(3, val);
-				break;
-			}
-			}
+			if (*it != PatternCellBlock::getEmptyCell(c)) PatternCellBlock::setCell(st, c, *it);
 
 			t += (++c / 11);
 			c %= 11;
@@ -127,10 +69,17 @@ void PasteOverwriteCopiedDataToPatternCommand::redo()
 
 void PasteOverwriteCopiedDataToPatternCommand::undo()
 {
-	restorePattern(mod_.lock()->getSong(song_), prevCells_, track_, col_, order_, step_);
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	if (includeEffectColumns(col_, cells_.getWidth())) mod_.lock()->getSong(song_).invalidateAnalysis();
+	prevCells_.restore(mod_.lock()->getSong(song_), track_, order_, step_);
 }
 
 CommandId PasteOverwriteCopiedDataToPatternCommand::getID() const
 {
 	return CommandId::PasteOverwriteCopiedDataToPattern;
 }
+
+size_t PasteOverwriteCopiedDataToPatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + cells_.getMemorySize() + prevCells_.getMemorySize();
+}
@@ -27,22 +27,22 @@
 
 #include "abstract_command.hpp"
 #include <memory>
-#include <vector>
-#include <string>
 #include "module.hpp"
+#include "pattern_cell_block.hpp"
 
 class PasteOverwriteCopiedDataToPatternCommand : public AbstractCommand
 {
 public:
 	PasteOverwriteCopiedDataToPatternCommand(std::weak_ptr<Module> mod, int songNum, int beginTrack, int beginColumn,
 											 int beginOrder, int beginStep,
-											 std::vector<std::vector<std::string>> cells);
+											 PatternCellBlock cells);
 	void redo() override;
 	void undo() override;
 	CommandId getID() const override;
+	size_t getMemorySize() const override;
 
 private:
 	std::weak_ptr<Module> mod_;
 	int song_, track_, col_, order_, step_;
-	std::vector<std::vector<std::string>> cells_, prevCells_;
+	PatternCellBlock cells_, prevCells_;
 };
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pattern_cell_block.hpp"
+#include "song.hpp"
+#include "effect.hpp"
+
+PatternCellBlock::PatternCellBlock()
+	: width_(0),
+	  height_(0),
+	  beginColumn_(0),
+	  isRunLength_(false)
+{
+}
+
+PatternCellBlock::PatternCellBlock(const std::vector<uint16_t>& cells, size_t width, int beginColumn)
+	: width_(width),
+	  height_(width ? cells.size() / width : 0),
+	  beginColumn_(beginColumn),
+	  isRunLength_(false)
+{
+	pack(cells);
+}
+
+PatternCellBlock::PatternCellBlock(Song& song, size_t width, size_t height, int beginTrack,
+								   int beginColumn, int beginOrder, int beginStep)
+	: width_(width),
+	  height_(height),
+	  beginColumn_(beginColumn),
+	  isRunLength_(false)
+{
+	std::vector<uint16_t> tmp;
+	tmp.reserve(width * height);
+	int s = beginStep;
+	for (size_t i = 0; i < height; ++i) {
+		int t = beginTrack;
+		int c = beginColumn;
+		for (size_t j = 0; j < width; ++j) {
+			tmp.push_back(getCell(song.getTrack(t).getPatternFromOrderNumber(beginOrder).getStep(s), c));
+
+			t += (++c / 11);
+			c %= 11;
+		}
+		++s;
+	}
+	pack(tmp);
+}
+
+size_t PatternCellBlock::getWidth() const
+{
+	return width_;
+}
+
+size_t PatternCellBlock::getHeight() const
+{
+	return height_;
+}
+
+int PatternCellBlock::getBeginColumn() const
+{
+	return beginColumn_;
+}
+
+std::vector<uint16_t> PatternCellBlock::unpack() const
+{
+	if (!isRunLength_) return data_;
+
+	std::vector<uint16_t> cells(width_ * height_);
+	size_t n = 0;
+	for (size_t i = 0; i < data_.size(); i += 2) {
+		for (uint16_t k = 0; k < data_[i]; ++k, ++n) {
+			// Runs are stored in column-major order
+			cells[(n % height_) * width_ + n / height_] = data_[i + 1];
+		}
+	}
+	return cells;
+}
+
+void PatternCellBlock::restore(Song& song, int beginTrack, int beginOrder, int beginStep) const
+{
+	std::vector<uint16_t> cells = unpack();
+	auto it = cells.cbegin();
+	int s = beginStep;
+	for (size_t i = 0; i < height_; ++i) {
+		int t = beginTrack;
+		int c = beginColumn_;
+		for (size_t j = 0; j < width_; ++j) {
+			setCell(song.getTrack(t).getPatternFromOrderNumber(beginOrder).getStep(s), c, *it++);
+
+			t += (++c / 11);
+			c %= 11;
+		}
+		++s;
+	}
+}
+
+size_t PatternCellBlock::getMemorySize() const
+{
+	return data_.capacity() * sizeof(uint16_t);
+}
+
+uint16_t PatternCellBlock::getCell(const Step& step, int column)
+{
+	switch (column) {
+	case 0:		return static_cast<uint16_t>(step.getNoteNumber());
+	case 1:		return static_cast<uint16_t>(step.getInstrumentNumber());
+	case 2:		return static_cast<uint16_t>(step.getVolume());
+	case 3:		return step.getEffectIDCode(0);
+	case 4:		return static_cast<uint16_t>(step.getEffectValue(0));
+	case 5:		return step.getEffectIDCode(1);
+	case 6:		return static_cast<uint16_t>(step.getEffectValue(1));
+	case 7:		return step.getEffectIDCode(2);
+	case 8:		return static_cast<uint16_t>(step.getEffectValue(2));
+	case 9:		return step.getEffectIDCode(3);
+	case 10:	return static_cast<uint16_t>(step.getEffectValue(3));
+	default:	return 0;
+	}
+}
+
+void PatternCellBlock::setCell(Step& step, int column, uint16_t cell)
+{
+	int v = static_cast<int16_t>(cell);
+	switch (column) {
+	case 0:		step.setNoteNumber(v);			break;
+	case 1:		step.setInstrumentNumber(v);	break;
+	case 2:		step.setVolume(v);				break;
+	case 3:		step.setEffectIDCode(0, cell);	break;
+	case 4:		step.setEffectValue(0, v);		break;
+	case 5:		step.setEffectIDCode(1, cell);	break;
+	case 6:		step.setEffectValue(1, v);		break;
+	case 7:		step.setEffectIDCode(2, cell);	break;
+	case 8:		step.setEffectValue(2, v);		break;
+	case 9:		step.setEffectIDCode(3, cell);	break;
+	case 10:	step.setEffectValue(3, v);		break;
+	default:	break;
+	}
+}
+
+uint16_t PatternCellBlock::getEmptyCell(int column)
+{
+	switch (column) {
+	case 3:
+	case 5:
+	case 7:
+	case 9:
+		return Effect::NO_ID;
+	default:
+		return static_cast<uint16_t>(-1);
+	}
+}
+
+void PatternCellBlock::pack(const std::vector<uint16_t>& cells)
+{
+	// Empty cells continue down each column, so find runs in column-major order
+	std::vector<uint16_t> cm;
+	cm.reserve(cells.size());
+	for (size_t j = 0; j < width_; ++j) {
+		for (size_t i = 0; i < height_; ++i) {
+			cm.push_back(cells[i * width_ + j]);
+		}
+	}
+
+	std::vector<uint16_t> runs;
+	for (size_t i = 0; i < cm.size() && runs.size() < cm.size();) {
+		size_t j = i + 1;
+		while (j < cm.size() && cm[j] == cm[i] && j - i < 0xffff) ++j;
+		runs.push_back(static_cast<uint16_t>(j - i));
+		runs.push_back(cm[i]);
+		i = j;
+	}
+
+	isRunLength_ = (runs.size() < cells.size());
+	data_ = isRunLength_ ? runs : cells;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class Song;
+class Step;
+
+/// Rectangular block of pattern cells kept by the commands for undo and redo,
+/// and passed from the clipboard to the paste commands.
+/// Each cell is packed in 16 bits: effect IDs as EffectIDCode, and the other columns as signed values.
+/// Runs of the same value down the columns are stored as pairs of the length and the value
+/// when it is smaller.
+class PatternCellBlock
+{
+public:
+	PatternCellBlock();
+	/// Pack the cells given in row-major order
+	PatternCellBlock(const std::vector<uint16_t>& cells, size_t width, int beginColumn);
+	/// Capture the current cells in the pattern
+	PatternCellBlock(Song& song, size_t width, size_t height, int beginTrack,
+					 int beginColumn, int beginOrder, int beginStep);
+
+	size_t getWidth() const;
+	size_t getHeight() const;
+	int getBeginColumn() const;
+
+	/// Unpack the cells in row-major order
+	std::vector<uint16_t> unpack() const;
+	/// Write all cells back to the pattern
+	void restore(Song& song, int beginTrack, int beginOrder, int beginStep) const;
+
+	/// Heap bytes used by the block
+	size_t getMemorySize() const;
+
+	static uint16_t getCell(const Step& step, int column);
+	static void setCell(Step& step, int column, uint16_t cell);
+	/// The value of an empty cell in the column
+	static uint16_t getEmptyCell(int column);
+
+private:
+	size_t width_, height_;
+	int beginColumn_;
+	bool isRunLength_;
+	std::vector<uint16_t> data_;
+
+	void pack(const std::vector<uint16_t>& cells);
+};
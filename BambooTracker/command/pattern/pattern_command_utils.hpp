@@ -25,15 +25,13 @@
 
 #pragma once
 
-#include <vector>
-#include <string>
-
-class Song;
+#include <cstddef>
+#include "effect.hpp"
 
 size_t calculateColumnSize(int beginTrack, int beginColumn, int endTrack, int endColumn);
 
-std::vector<std::vector<std::string>> getPreviousCells(Song& song, size_t w, size_t h, int beginTrack,
-													   int beginColumn, int beginOrder, int beginStep);
+/// Check whether the columns include effects
+bool includeEffectColumns(int beginColumn, size_t width);
 
-void restorePattern(Song& song, const std::vector<std::vector<std::string>>& cells, int beginTrack,
-					int beginColumn, int beginOrder, int beginStep);
+/// Check whether the effect changes the song structure or speed analyzed by SongLengthCalculator
+bool isSongStructureEffect(EffectIDCode code);
@@ -51,6 +51,7 @@ ReplaceInstrumentInPatternCommand::ReplaceInstrumentInPatternCommand(std::weak_p
 
 void ReplaceInstrumentInPatternCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	auto& sng = mod_.lock()->getSong(song_);
 
 	for (int step = bStep_; step <= eStep_; ++step) {
@@ -64,6 +65,7 @@ void ReplaceInstrumentInPatternCommand::redo()
 
 void ReplaceInstrumentInPatternCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	auto& sng = mod_.lock()->getSong(song_);
 
 	size_t i = 0;
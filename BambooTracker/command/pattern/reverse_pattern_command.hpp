@@ -30,6 +30,7 @@
 #include <vector>
 #include <string>
 #include "module.hpp"
+#include "pattern_cell_block.hpp"
 
 class ReversePatternCommand : public AbstractCommand
 {
@@ -40,9 +41,10 @@ public:
 	void redo() override;
 	void undo() override;
 	CommandId getID() const override;
+	size_t getMemorySize() const override;
 
 private:
 	std::weak_ptr<Module> mod_;
 	int song_, bTrack_, bCol_, order_, bStep_;
-	std::vector<std::vector<std::string>> prevCells_;
+	PatternCellBlock prevCells_;
 };
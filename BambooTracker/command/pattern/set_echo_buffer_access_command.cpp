@@ -39,12 +39,14 @@ SetEchoBufferAccessCommand::SetEchoBufferAccessCommand(std::weak_ptr<Module> mod
 
 void SetEchoBufferAccessCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
 			.getStep(step_).setNoteNumber(-buf_ - 3);
 }
 
 void SetEchoBufferAccessCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
 			.getStep(step_).setNoteNumber(prevNote_);
 }
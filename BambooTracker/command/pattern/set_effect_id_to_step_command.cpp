@@ -24,6 +24,7 @@
  */
 
 #include "set_effect_id_to_step_command.hpp"
+#include "pattern_command_utils.hpp"
 
 SetEffectIDToStepCommand::SetEffectIDToStepCommand(std::weak_ptr<Module> mod, int songNum, int trackNum, int orderNum, int stepNum, int n, std::string id, bool fillValue00, bool secondEntry)
 	: mod_(mod),
@@ -43,15 +44,21 @@ SetEffectIDToStepCommand::SetEffectIDToStepCommand(std::weak_ptr<Module> mod, in
 
 void SetEffectIDToStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	std::string str = isSecond_ ? effID_ : ("0" + effID_);
 	Step& step = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
+	if (isSongStructureEffect(step.getEffectIDCode(n_)) || isSongStructureEffect(Effect::encodeID(str)))
+		mod_.lock()->getSong(song_).invalidateAnalysis();
 	step.setEffectID(n_, str);
 	if (filledValue00_) step.setEffectValue(n_, 0);
 }
 
 void SetEffectIDToStepCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	Step& step = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
+	if (isSongStructureEffect(step.getEffectIDCode(n_)) || isSongStructureEffect(Effect::encodeID(prevEffID_)))
+		mod_.lock()->getSong(song_).invalidateAnalysis();
 	step.setEffectID(n_, prevEffID_);
 	if (filledValue00_) step.setEffectValue(n_, -1);
 
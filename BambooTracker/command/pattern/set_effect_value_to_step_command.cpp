@@ -24,6 +24,7 @@
  */
 
 #include "set_effect_value_to_step_command.hpp"
+#include "pattern_command_utils.hpp"
 
 SetEffectValueToStepCommand::SetEffectValueToStepCommand(std::weak_ptr<Module> mod, int songNum, int trackNum,
 														 int orderNum, int stepNum, int n, int value,
@@ -44,6 +45,7 @@ SetEffectValueToStepCommand::SetEffectValueToStepCommand(std::weak_ptr<Module> m
 
 void SetEffectValueToStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	int value;
 	switch (ctrl_) {
 	default:
@@ -57,14 +59,17 @@ void SetEffectValueToStepCommand::redo()
 		value = (val_ > 0) ? (0xff - val_ + 1) : val_;
 		break;
 	}
-	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
-			.getStep(step_).setEffectValue(n_, value);
+	Step& step = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
+	if (isSongStructureEffect(step.getEffectIDCode(n_))) mod_.lock()->getSong(song_).invalidateAnalysis();
+	step.setEffectValue(n_, value);
 }
 
 void SetEffectValueToStepCommand::undo()
 {
-	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
-			.getStep(step_).setEffectValue(n_, prevVal_);
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
+	Step& step = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
+	if (isSongStructureEffect(step.getEffectIDCode(n_))) mod_.lock()->getSong(song_).invalidateAnalysis();
+	step.setEffectValue(n_, prevVal_);
 	isSecond_ = true;	// Forced complete
 }
 
@@ -40,12 +40,14 @@ SetInstrumentToStepCommand::SetInstrumentToStepCommand(std::weak_ptr<Module> mod
 
 void SetInstrumentToStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
 			.getStep(step_).setInstrumentNumber(inst_);
 }
 
 void SetInstrumentToStepCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
 			.getStep(step_).setInstrumentNumber(prevInst_);
 	isSecond_ = true;	// Forced complete
@@ -44,6 +44,7 @@ SetKeyOffToStepCommand::SetKeyOffToStepCommand(std::weak_ptr<Module> mod, int so
 
 void SetKeyOffToStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	auto& st = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
 	st.setNoteNumber(-2);
 	st.setInstrumentNumber(-1);
@@ -56,6 +57,7 @@ void SetKeyOffToStepCommand::redo()
 
 void SetKeyOffToStepCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	auto& st = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
 	st.setNoteNumber(prevNote_);
 	st.setInstrumentNumber(prevInst_);
@@ -47,6 +47,7 @@ SetKeyOnToStepCommand::SetKeyOnToStepCommand(std::weak_ptr<Module> mod, int song
 
 void SetKeyOnToStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	auto& st = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
 	st.setNoteNumber(note_);
 	if (!instMask_) st.setInstrumentNumber(inst_);
@@ -55,6 +56,7 @@ void SetKeyOnToStepCommand::redo()
 
 void SetKeyOnToStepCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	auto& st = mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_).getStep(step_);
 	st.setNoteNumber(prevNote_);
 	if (!instMask_) st.setInstrumentNumber(prevInst_);
@@ -42,6 +42,7 @@ SetVolumeToStepCommand::SetVolumeToStepCommand(std::weak_ptr<Module> mod, int so
 
 void SetVolumeToStepCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	int volume = (isFMReserved_ && vol_ < 0x80) ? (0x7f - vol_) : vol_;
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
 			.getStep(step_).setVolume(volume);
@@ -49,6 +50,7 @@ void SetVolumeToStepCommand::redo()
 
 void SetVolumeToStepCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	mod_.lock()->getSong(song_).getTrack(track_).getPatternFromOrderNumber(order_)
 			.getStep(step_).setVolume(prevVol_);
 	isSecond_ = true;	// Forced complete
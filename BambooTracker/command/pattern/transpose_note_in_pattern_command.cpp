@@ -52,6 +52,7 @@ TransposeNoteInPatternCommand::TransposeNoteInPatternCommand(std::weak_ptr<Modul
 
 void TransposeNoteInPatternCommand::redo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	auto& sng = mod_.lock()->getSong(song_);
 
 	for (int step = bStep_; step <= eStep_; ++step) {
@@ -67,6 +68,7 @@ void TransposeNoteInPatternCommand::redo()
 
 void TransposeNoteInPatternCommand::undo()
 {
+	mod_.lock()->getSong(song_).invalidateTimelineByPatterns(order_);
 	auto& sng = mod_.lock()->getSong(song_);
 
 	size_t i = 0;
@@ -26,20 +26,21 @@
 #include "erase_instrument_in_step_qt_command.hpp"
 #include "command_id.hpp"
 
-EraseInstrumentInStepQtCommand::EraseInstrumentInStepQtCommand(PatternEditorPanel* panel, QUndoCommand* parent)
+EraseInstrumentInStepQtCommand::EraseInstrumentInStepQtCommand(PatternEditorPanel* panel, PatternPosition pos, QUndoCommand* parent)
 	: QUndoCommand(parent),
-	  panel_(panel)
+	  panel_(panel),
+	  pos_(pos)
 {
 }
 
 void EraseInstrumentInStepQtCommand::redo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 void EraseInstrumentInStepQtCommand::undo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 int EraseInstrumentInStepQtCommand::id() const
@@ -26,20 +26,21 @@
 #include "erase_volume_in_step_qt_command.hpp"
 #include "command_id.hpp"
 
-EraseVolumeInStepQtCommand::EraseVolumeInStepQtCommand(PatternEditorPanel* panel, QUndoCommand* parent)
+EraseVolumeInStepQtCommand::EraseVolumeInStepQtCommand(PatternEditorPanel* panel, PatternPosition pos, QUndoCommand* parent)
 	: QUndoCommand(parent),
-	  panel_(panel)
+	  panel_(panel),
+	  pos_(pos)
 {
 }
 
 void EraseVolumeInStepQtCommand::redo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 void EraseVolumeInStepQtCommand::undo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 int EraseVolumeInStepQtCommand::id() const
@@ -32,13 +32,14 @@
 class EraseVolumeInStepQtCommand : public QUndoCommand
 {
 public:
-	EraseVolumeInStepQtCommand(PatternEditorPanel* panel, QUndoCommand* parent = nullptr);
+	EraseVolumeInStepQtCommand(PatternEditorPanel* panel, PatternPosition pos, QUndoCommand* parent = nullptr);
 	void redo() Q_DECL_OVERRIDE;
 	void undo() Q_DECL_OVERRIDE;
 	int id() const Q_DECL_OVERRIDE;
 
 private:
 	PatternEditorPanel* panel_;
+	PatternPosition pos_;
 };
 
 #endif // ERASE_VOLUME_IN_STEP_QT_COMMAND_HPP
@@ -26,20 +26,21 @@
 #include "set_echo_buffer_access_qt_command.hpp"
 #include "command_id.hpp"
 
-SetEchoBufferAccessQtCommand::SetEchoBufferAccessQtCommand(PatternEditorPanel* panel, QUndoCommand* parent)
+SetEchoBufferAccessQtCommand::SetEchoBufferAccessQtCommand(PatternEditorPanel* panel, PatternPosition pos, QUndoCommand* parent)
 	: QUndoCommand(parent),
-	  panel_(panel)
+	  panel_(panel),
+	  pos_(pos)
 {
 }
 
 void SetEchoBufferAccessQtCommand::redo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 void SetEchoBufferAccessQtCommand::undo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 int SetEchoBufferAccessQtCommand::id() const
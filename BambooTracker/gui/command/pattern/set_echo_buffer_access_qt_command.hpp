@@ -33,13 +33,14 @@
 class SetEchoBufferAccessQtCommand : public QUndoCommand
 {
 public:
-	SetEchoBufferAccessQtCommand(PatternEditorPanel* panel, QUndoCommand* parent = nullptr);
+	SetEchoBufferAccessQtCommand(PatternEditorPanel* panel, PatternPosition pos, QUndoCommand* parent = nullptr);
 	void redo() Q_DECL_OVERRIDE;
 	void undo() Q_DECL_OVERRIDE;
 	int id() const Q_DECL_OVERRIDE;
 
 private:
 	PatternEditorPanel* panel_;
+	PatternPosition pos_;
 };
 
 #endif // SET_ECHO_BUFFER_ACCESS_QT_COMMAND_HPP
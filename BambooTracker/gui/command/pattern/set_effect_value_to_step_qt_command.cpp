@@ -36,12 +36,12 @@ SetEffectValueToStepQtCommand::SetEffectValueToStepQtCommand(PatternEditorPanel*
 
 void SetEffectValueToStepQtCommand::redo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 void SetEffectValueToStepQtCommand::undo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 	panel_->resetEntryCount();
 }
 
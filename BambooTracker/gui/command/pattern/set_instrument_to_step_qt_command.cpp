@@ -36,12 +36,12 @@ SetInstrumentToStepQtCommand::SetInstrumentToStepQtCommand(PatternEditorPanel* p
 
 void SetInstrumentToStepQtCommand::redo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 void SetInstrumentToStepQtCommand::undo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 	panel_->resetEntryCount();
 }
 
@@ -26,20 +26,21 @@
 #include "set_key_off_to_step_qt_command.hpp"
 #include "command_id.hpp"
 
-SetKeyOffToStepQtCommand::SetKeyOffToStepQtCommand(PatternEditorPanel* panel, QUndoCommand* parent)
+SetKeyOffToStepQtCommand::SetKeyOffToStepQtCommand(PatternEditorPanel* panel, PatternPosition pos, QUndoCommand* parent)
 	: QUndoCommand(parent),
-	  panel_(panel)
+	  panel_(panel),
+	  pos_(pos)
 {
 }
 
 void SetKeyOffToStepQtCommand::redo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 void SetKeyOffToStepQtCommand::undo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 int SetKeyOffToStepQtCommand::id() const
@@ -32,13 +32,14 @@
 class SetKeyOffToStepQtCommand : public QUndoCommand
 {
 public:
-	SetKeyOffToStepQtCommand(PatternEditorPanel* panel, QUndoCommand* parent = nullptr);
+	SetKeyOffToStepQtCommand(PatternEditorPanel* panel, PatternPosition pos, QUndoCommand* parent = nullptr);
 	void redo() Q_DECL_OVERRIDE;
 	void undo() Q_DECL_OVERRIDE;
 	int id() const Q_DECL_OVERRIDE;
 
 private:
 	PatternEditorPanel* panel_;
+	PatternPosition pos_;
 };
 
 #endif // SET_KEY_OFF_TO_STEP_QT_COMMAND_HPP
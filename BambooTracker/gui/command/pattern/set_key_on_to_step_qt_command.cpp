@@ -26,20 +26,21 @@
 #include "set_key_on_to_step_qt_command.hpp"
 #include "command_id.hpp"
 
-SetKeyOnToStepQtCommand::SetKeyOnToStepQtCommand(PatternEditorPanel* panel, QUndoCommand* parent)
+SetKeyOnToStepQtCommand::SetKeyOnToStepQtCommand(PatternEditorPanel* panel, PatternPosition pos, QUndoCommand* parent)
 	: QUndoCommand(parent),
-	  panel_(panel)
+	  panel_(panel),
+	  pos_(pos)
 {
 }
 
 void SetKeyOnToStepQtCommand::redo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 void SetKeyOnToStepQtCommand::undo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 int SetKeyOnToStepQtCommand::id() const
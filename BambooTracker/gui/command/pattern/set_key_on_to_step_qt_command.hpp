@@ -32,13 +32,14 @@
 class SetKeyOnToStepQtCommand : public QUndoCommand
 {
 public:
-	SetKeyOnToStepQtCommand(PatternEditorPanel* panel, QUndoCommand* parent = nullptr);
+	SetKeyOnToStepQtCommand(PatternEditorPanel* panel, PatternPosition pos, QUndoCommand* parent = nullptr);
 	void redo() Q_DECL_OVERRIDE;
 	void undo() Q_DECL_OVERRIDE;
 	int id() const Q_DECL_OVERRIDE;
 
 private:
 	PatternEditorPanel* panel_;
+	PatternPosition pos_;
 };
 
 #endif // SET_KEY_ON_TO_STEP_QT_COMMAND_HPP
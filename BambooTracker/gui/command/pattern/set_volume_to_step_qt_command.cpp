@@ -36,12 +36,12 @@ SetVolumeToStepQtCommand::SetVolumeToStepQtCommand(PatternEditorPanel* panel, Pa
 
 void SetVolumeToStepQtCommand::redo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 }
 
 void SetVolumeToStepQtCommand::undo()
 {
-	panel_->redrawByPatternChanged();
+	panel_->redrawByCellChanged(pos_);
 	panel_->resetEntryCount();
 }
 
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "glyph_atlas.hpp"
+#include <QFontMetrics>
+#include <QString>
+#include <QPaintDevice>
+#include <QtMath>
+#include <algorithm>
+
+namespace
+{
+inline int charAdvance(const QFontMetrics& metrics, QChar c)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+	return metrics.horizontalAdvance(c);
+#else
+	return metrics.width(c);
+#endif
+}
+
+inline qreal devicePixelRatio(const QPaintDevice* device)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+	return device->devicePixelRatioF();
+#else
+	return device->devicePixelRatio();
+#endif
+}
+}
+
+GlyphAtlas::GlyphAtlas()
+	: ascent_(0),
+	  height_(0),
+	  pad_(0),
+	  advance_{},
+	  cellX_{},
+	  stripWidth_(0),
+	  stripRatio_(1.)
+{
+}
+
+void GlyphAtlas::setFont(const QFont& font)
+{
+	font_ = font;
+	QFontMetrics metrics(font_);
+	ascent_ = metrics.ascent();
+	height_ = metrics.height();
+	pad_ = metrics.averageCharWidth() / 2 + 1;	// Room for glyphs overhanging their advance
+
+	int x = 0;
+	for (int i = 0; i < CHAR_CNT_; ++i) {
+		QChar c(FIRST_CHAR_ + i);
+		advance_[i] = charAdvance(metrics, c);
+		cellX_[i] = x;
+		x += advance_[i] + pad_ * 2;
+	}
+	stripWidth_ = x;
+
+	clear();
+}
+
+void GlyphAtlas::clear()
+{
+	strips_.clear();
+}
+
+const QPixmap& GlyphAtlas::getStrip(const QColor& color, qreal ratio)
+{
+	if (ratio != stripRatio_) {	// Moved to a screen with another scale
+		strips_.clear();
+		stripRatio_ = ratio;
+	}
+
+	auto it = strips_.find(color.rgba());
+	if (it != strips_.end()) return it->second;
+
+	// Render in device pixels so that the blitted glyphs stay sharp on high-DPI screens
+	QPixmap strip(qCeil(stripWidth_ * ratio), qCeil(height_ * ratio));
+	strip.setDevicePixelRatio(ratio);
+	strip.fill(Qt::transparent);
+	QPainter painter(&strip);
+	painter.setFont(font_);
+	painter.setPen(color);
+	for (int i = 0; i < CHAR_CNT_; ++i) {
+		painter.drawText(cellX_[i] + pad_, ascent_, QString(QChar(FIRST_CHAR_ + i)));
+	}
+	painter.end();
+
+	return strips_.emplace(color.rgba(), std::move(strip)).first->second;
+}
+
+void GlyphAtlas::drawText(QPainter& painter, int x, int baseY, const QColor& color, const char* text)
+{
+	const qreal ratio = devicePixelRatio(painter.device());
+	const QPixmap& strip = getStrip(color, ratio);
+	int top = baseY - ascent_;
+	for (const char* p = text; *p; ++p) {
+		if (*p < FIRST_CHAR_ || LAST_CHAR_ < *p) {
+			painter.setPen(color);
+			painter.drawText(x, baseY, QString(QChar(*p)));
+			x += charAdvance(QFontMetrics(font_), QChar(*p));
+			continue;
+		}
+		int i = *p - FIRST_CHAR_;
+		int w = advance_[i] + pad_ * 2;
+		painter.drawPixmap(QRectF(x - pad_, top, w, height_), strip,
+						   QRectF(cellX_[i] * ratio, 0, w * ratio, height_ * ratio));
+		x += advance_[i];
+	}
+}
+
+void GlyphAtlas::drawNumber(QPainter& painter, int x, int baseY, const QColor& color, int value, int width, int base)
+{
+	static const char DIGITS[] = "0123456789ABCDEF";
+	char buf[17];
+	char* digits = buf;
+	unsigned int mag = static_cast<unsigned int>(value);
+	if (value < 0) {	// Sign precedes the padded digits
+		*digits++ = '-';
+		mag = 0u - mag;
+	}
+	const unsigned int ubase = static_cast<unsigned int>(std::max(2, std::min(base, 16)));
+	int n = std::max(1, std::min(width, 15));
+	digits[n] = '\0';
+	for (int i = n - 1; i >= 0; --i) {
+		digits[i] = DIGITS[mag % ubase];
+		mag /= ubase;
+	}
+	drawText(painter, x, baseY, color, buf);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GLYPH_ATLAS_HPP
+#define GLYPH_ATLAS_HPP
+
+#include <QFont>
+#include <QColor>
+#include <QPixmap>
+#include <QPainter>
+#include <unordered_map>
+
+/// Pre-rendered printable ASCII characters of a font, one strip per colour.
+/// Text is blitted from the strip instead of being laid out by QPainter::drawText.
+class GlyphAtlas
+{
+public:
+	GlyphAtlas();
+
+	/// Set the font and clear the cached strips
+	void setFont(const QFont& font);
+	/// Clear the cached strips (e.g. palette changed)
+	void clear();
+
+	/// Draw [text] with its baseline at [baseY].
+	/// Characters out of the atlas fall back to QPainter::drawText.
+	void drawText(QPainter& painter, int x, int baseY, const QColor& color, const char* text);
+	/// Draw [value] zero-padded to [width] digits in upper case, preceded by '-' if negative
+	void drawNumber(QPainter& painter, int x, int baseY, const QColor& color, int value, int width, int base = 16);
+
+private:
+	static constexpr char FIRST_CHAR_ = 0x20;
+	static constexpr char LAST_CHAR_ = 0x7e;
+	static constexpr int CHAR_CNT_ = LAST_CHAR_ - FIRST_CHAR_ + 1;
+
+	QFont font_;
+	int ascent_, height_, pad_;
+	int advance_[CHAR_CNT_];
+	int cellX_[CHAR_CNT_];
+	int stripWidth_;
+	qreal stripRatio_;	// Device pixel ratio of the cached strips
+	std::unordered_map<QRgb, QPixmap> strips_;
+
+	const QPixmap& getStrip(const QColor& color, qreal ratio);
+};
+
+#endif // GLYPH_ATLAS_HPP
@@ -29,8 +29,8 @@
 #include <numeric>
 #include <QRegularExpression>
 #include <QRegularExpressionMatch>
-#include <QApplication>
-#include <QClipboard>
+#include "effect.hpp"
+#include "gui/pattern_editor/pattern_clipboard.hpp"
 
 GrooveSettingsDialog::GrooveSettingsDialog(QWidget *parent) :
 	QDialog(parent),
@@ -253,8 +253,12 @@ void GrooveSettingsDialog::on_padPushButton_clicked()
 void GrooveSettingsDialog::on_copyPushButton_clicked()
 {
 	auto& seq = seqs_[static_cast<size_t>(ui->grooveListWidget->currentRow())];
-	auto text = QString("PATTERN_COPY:3,2,%1,").arg(seq.size());
-	for (auto v : seq) text += QString("0F,%1,").arg(v);
+	PatternClipboardCells cells = { 3, 2, {} };
+	cells.cells.reserve(seq.size() * 2);
+	for (auto v : seq) {
+		cells.cells.push_back(toEffectIDCode('0', 'F'));
+		cells.cells.push_back(static_cast<uint16_t>(v));
+	}
 
-	QApplication::clipboard()->setText(text);
+	setPatternCellsToClipboard(cells, false);
 }
@@ -31,8 +31,11 @@
 #include <algorithm>
 #include <QString>
 #include <QKeySequence>
+#include <QFile>
+#include <QByteArray>
 #include "song.hpp"
 #include "misc.hpp"
+#include "binary_container.hpp"
 
 inline QString getTrackName(SongType songType, SoundSource src, int chInSrc)
 {
@@ -145,4 +148,17 @@ inline std::vector<int> adaptVisibleTrackList(const std::vector<int> list,
 	return tracks;
 }
 
+/// Wrap the opened file by memory mapping, or read it into the buffer if mapping fails.
+/// The container is valid while the file is open and the buffer is alive.
+inline BinaryContainer mapFileToContainer(QFile& fp, QByteArray& buf)
+{
+	qint64 size = fp.size();
+	if (size > 0) {
+		if (uchar* p = fp.map(0, size))
+			return BinaryContainer(reinterpret_cast<const char*>(p), static_cast<size_t>(size));
+	}
+	buf = fp.readAll();
+	return BinaryContainer(buf.constData(), static_cast<size_t>(buf.size()));
+}
+
 #endif // GUI_UTIL_HPP
@@ -29,6 +29,7 @@
 #include <limits>
 #include <vector>
 #include <algorithm>
+#include <utility>
 #include <QMimeData>
 #include <QFile>
 #include <QIODevice>
@@ -44,6 +45,8 @@
 #include <QWheelEvent>
 #include <QHoverEvent>
 #include "chips/codec/ymb_codec.hpp"
+#include "io/wav_reader.hpp"
+#include "io/adpcm_sample_importer.hpp"
 #include "gui/event_guard.hpp"
 #include "gui/instrument_editor/sample_length_dialog.hpp"
 #include "gui/instrument_editor/grid_settings_dialog.hpp"
@@ -316,17 +319,21 @@ void ADPCMSampleEditor::setInstrumentSampleParameters(int sampNum, bool repeatab
 
 void ADPCMSampleEditor::importSampleFrom(const QString file)
 {
-	std::unique_ptr<WavContainer> wav;
-	try {
-		QFile fp(file);
-		if (!fp.open(QIODevice::ReadOnly)) {
-			FileIOErrorMessageBox::openError(file, true, FileIO::FileType::WAV, this);
-			return;
-		}
-		QByteArray array = fp.readAll();
-		fp.close();
+	QFile fp(file);
+	if (!fp.open(QIODevice::ReadOnly)) {
+		FileIOErrorMessageBox::openError(file, true, FileIO::FileType::WAV, this);
+		return;
+	}
 
-		wav = std::make_unique<WavContainer>(BinaryContainer(std::vector<char>(array.begin(), array.end())));
+	std::vector<uint8_t> adpcm;
+	uint32_t rate = 0;
+	try {
+		WavReader reader([&fp](char* data, size_t size) {
+			return static_cast<size_t>(std::max<qint64>(fp.read(data, static_cast<qint64>(size)), 0));
+		}, static_cast<size_t>(fp.size()));
+		// Resample only when the rate is out of the range supported by ADPCM
+		rate = clamp<uint32_t>(reader.getSampleRate(), 2000, 55466);
+		adpcm = ADPCMSampleImporter::importWav(reader, rate, bt_.lock()->getADPCMLimit());
 	}
 	catch (FileIOError& e) {
 		FileIOErrorMessageBox(file, true, e, this).exec();
@@ -337,34 +344,12 @@ void ADPCMSampleEditor::importSampleFrom(const QString file)
 		return;
 	}
 
-	if (wav->getSampleRate() < 2000 || 55466 < wav->getSampleRate()) {
-		FileIOErrorMessageBox(file, true, FileIO::FileType::WAV,
-							  tr("Supported sample rate is 2kHz-55.5kHz, but the rate of selected sample is %1.")
-							  .arg(wav->getSampleRate()), this).exec();
-		return;
-	}
-
-	if (wav->getChannelCount() != 1) {
-		FileIOErrorMessageBox(file, true, FileIO::FileType::WAV,
-							  tr("The selected sample is not mono channel."), this).exec();
-		return;
-	}
-
-	BinaryContainer bc = wav->getSample();
-	size_t rawSize = bc.size() / 2;
-	std::vector<int16_t> raw(rawSize);
-	for (size_t i = 0; i < rawSize; ++i) {
-		raw[i] = bc.readInt16(i * 2);
-	}
-	std::vector<uint8_t> adpcm((raw.size() + 1) / 2);
-	codec::ymb_encode(raw.data(), adpcm.data(), static_cast<long>(raw.size()));
-
 	const int ROOT_KEY = 60;	//C5
 
-	bt_.lock()->storeSampleADPCMRawSample(ui->sampleNumSpinBox->value(), adpcm);
+	bt_.lock()->storeSampleADPCMRawSample(ui->sampleNumSpinBox->value(), std::move(adpcm));
 	ui->rootKeyComboBox->setCurrentIndex(ROOT_KEY % 12);
 	ui->rootKeySpinBox->setValue(ROOT_KEY / 12);
-	ui->rootRateSpinBox->setValue(calcADPCMDeltaN(wav->getSampleRate()));
+	ui->rootRateSpinBox->setValue(calcADPCMDeltaN(rate));
 
 	emit modified();
 	emit sampleAssignRequested();
@@ -607,7 +592,7 @@ void ADPCMSampleEditor::on_action_Import_triggered()
 {
 	QString dir = QString::fromStdString(config_.lock()->getWorkingDirectory());
 	QString file = QFileDialog::getOpenFileName(this, tr("Import sample"),
-												(dir.isEmpty() ? "./" : dir), tr("WAV signed 16-bit PCM (*.wav)"));
+												(dir.isEmpty() ? "./" : dir), tr("WAV file (*.wav)"));
 	if (file.isNull()) return;
 
 	importSampleFrom(file);
@@ -39,6 +39,7 @@
 #include <QFileInfo>
 #include <QMimeData>
 #include <QProgressDialog>
+#include <QEventLoop>
 #include <QRect>
 #include <QDesktopWidget>
 #include <QMetaMethod>
@@ -85,6 +86,7 @@
 #include "gui/track_visibility_memory_handler.hpp"
 #include "gui/file_io_error_message_box.hpp"
 #include "gui/gui_util.hpp"
+#include "gui/pattern_editor/pattern_clipboard.hpp"
 
 MainWindow::MainWindow(std::weak_ptr<Configuration> config, QString filePath, QWidget *parent) :
 	QMainWindow(parent),
@@ -127,6 +129,8 @@ MainWindow::MainWindow(std::weak_ptr<Configuration> config, QString filePath, QW
 	nextSongSc_(nullptr),
 	jamVolUpSc_(nullptr),
 	jamVolDownSc_(nullptr),
+	midiJamRoute_(MIDI_JAM_BY_GUI_),
+	midiJamVolumeSet_(true),
 	bankJamMidiCtrl_(false)
 {
 	ui->setupUi(this);
@@ -180,7 +184,8 @@ MainWindow::MainWindow(std::weak_ptr<Configuration> config, QString filePath, QW
 	QObject::connect(comStack_.get(), &QUndoStack::indexChanged,
 					 this, [&](int idx) {
 		setWindowModified(idx || isModifiedForNotCommand_);
-		ui->actionUndo->setEnabled(comStack_->canUndo());
+		// The oldest commands may be removed from the core history to keep its memory budget
+		ui->actionUndo->setEnabled(comStack_->canUndo() && bt_->canUndo());
 		ui->actionRedo->setEnabled(comStack_->canRedo());
 	});
 
@@ -642,7 +647,7 @@ MainWindow::MainWindow(std::weak_ptr<Configuration> config, QString filePath, QW
 
 	/* MIDI */
 	setMidiConfiguration();
-	midiKeyEventMethod_ = metaObject()->indexOfSlot("midiKeyEvent(uchar,uchar,uchar)");
+	midiKeyEventMethod_ = metaObject()->indexOfSlot("midiKeyEvent(uchar,uchar,uchar,bool)");
 	Q_ASSERT(midiKeyEventMethod_ != -1);
 	midiProgramEventMethod_ = metaObject()->indexOfSlot("midiProgramEvent(uchar,uchar)");
 	Q_ASSERT(midiProgramEventMethod_ != -1);
@@ -650,11 +655,17 @@ MainWindow::MainWindow(std::weak_ptr<Configuration> config, QString filePath, QW
 
 	/* Audio stream */
 	stream_ = std::make_shared<AudioStreamRtAudio>();
-	stream_->setTickUpdateCallback(+[](void* cbPtr) -> int {
+	stream_->setTickUpdateCallback(+[](size_t offset, void* cbPtr) -> int {
 		auto bt = reinterpret_cast<BambooTracker*>(cbPtr);
-		return bt->streamCountUp();
+		return bt->streamCountUp(offset);
 	}, bt_.get());
-	stream_->setGenerateCallback(+[](int16_t* container, size_t nSamples, void* cbPtr) {
+	stream_->setEventUpdateCallback(+[](size_t offset, size_t nSamples,
+									 std::chrono::steady_clock::time_point begin,
+									 std::chrono::steady_clock::time_point end, void* cbPtr) {
+		auto bt = reinterpret_cast<BambooTracker*>(cbPtr);
+		bt->streamMidiJamEvents(offset, nSamples, begin, end);
+	}, bt_.get());
+	stream_->setGenerateCallback(+[](float* container, size_t nSamples, void* cbPtr) {
 		auto bt = reinterpret_cast<BambooTracker*>(cbPtr);
 		bt->getStreamSamples(container, nSamples);
 	}, bt_.get());
@@ -733,42 +744,38 @@ MainWindow::MainWindow(std::weak_ptr<Configuration> config, QString filePath, QW
 	else {
 		timer_ = std::make_unique<Timer>();
 		timer_->setInterval(1000000 / bt_->getModuleTickFrequency());
-		tickEventMethod_ = metaObject()->indexOfSlot("onNewTickSignaledRealChip()");
+		tickEventMethod_ = metaObject()->indexOfSlot("onNewTickSignaled(int)");
 		Q_ASSERT(tickEventMethod_ != -1);
 		timer_->setFunction([&]{
+			// Process the tick on the timer thread and notify only the result to the GUI
+			int state = bt_->streamCountUpOnRealChip();
 			QMetaMethod method = this->metaObject()->method(this->tickEventMethod_);
-			method.invoke(this, Qt::QueuedConnection);
+			method.invoke(this, Qt::QueuedConnection, Q_ARG(int, state));
 		});
 
 		setRealChipInterface(intf);
 
 		timer_->start();
 	}
+	updateMidiJamRoute();
+	QObject::connect(qApp, &QApplication::focusChanged, this, [&] { updateMidiJamRoute(); });
 
 	/* Load module */
-	if (filePath.isEmpty()) {
-		loadModule();
-		setInitialSelectedInstrument();
-		assignADPCMSamples();
-		if (!timer_) stream_->start();
-	}
-	else {
-		openModule(filePath);	// If use emulation, stream stars
-	}
+	loadModule();
+	setInitialSelectedInstrument();
+	assignADPCMSamples();
+	if (!timer_) stream_->start();
 
 	/* Track visibility */
-	SongType memSongType;
-	std::vector<int> visTracks;
-	if (config.lock()->getRestoreTrackVisibility()
-			&& TrackVisibilityMemoryHandler::loadTrackVisibilityMemory(memSongType, visTracks)) {
-		SongType songType = bt_->getSongStyle(bt_->getCurrentSongNumber()).type;
-		visTracks = adaptVisibleTrackList(visTracks, songType, songType);
-	}
-	else {
-		visTracks.resize(bt_->getSongStyle(0).trackAttribs.size());
-		std::iota(visTracks.begin(), visTracks.end(), 0);
+	restoreTrackVisibility();
+
+	// Open the module after the window is shown, not from a nested event loop in the constructor
+	if (!filePath.isEmpty()) {
+		QTimer::singleShot(0, this, [this, filePath] {
+			openModule(filePath);
+			restoreTrackVisibility();
+		});
 	}
-	setTrackVisibility(visTracks);
 }
 
 MainWindow::~MainWindow()
@@ -1231,6 +1238,22 @@ void MainWindow::setTrackVisibility(const std::vector<int>& visTracks)
 	}
 }
 
+void MainWindow::restoreTrackVisibility()
+{
+	SongType memSongType;
+	std::vector<int> visTracks;
+	if (config_.lock()->getRestoreTrackVisibility()
+			&& TrackVisibilityMemoryHandler::loadTrackVisibilityMemory(memSongType, visTracks)) {
+		SongType songType = bt_->getSongStyle(bt_->getCurrentSongNumber()).type;
+		visTracks = adaptVisibleTrackList(visTracks, songType, songType);
+	}
+	else {
+		visTracks.resize(bt_->getSongStyle(0).trackAttribs.size());
+		std::iota(visTracks.begin(), visTracks.end(), 0);
+	}
+	setTrackVisibility(visTracks);
+}
+
 void MainWindow::updateInstrumentListColors()
 {
 	ui->instrumentList->setStyleSheet(
@@ -1270,9 +1293,22 @@ void MainWindow::midiThreadReceivedEvent(double delay, const uint8_t *msg, size_
 		uint8_t status = msg[0];
 		uint8_t key = msg[1];
 		uint8_t velocity = msg[2];
+
+		// Play the key by the audio stream directly, the GUI is only notified
+		bool isJammed = false;
+		int route = self->midiJamRoute_.load();
+		if (route != MIDI_JAM_BY_GUI_) {
+			bool release = ((status & 0xf0) == 0x80) || velocity == 0;
+			bool isForced = (route != MIDI_JAM_CURRENT_TRACK_);
+			isJammed = self->bt_->queueMidiJamKeyEvent(
+						   static_cast<int>(key) - 12, !release, isForced,
+						   isForced ? static_cast<SoundSource>(route) : SoundSource::FM,
+						   self->midiJamVolumeSet_.load());
+		}
+
 		QMetaMethod method = self->metaObject()->method(self->midiKeyEventMethod_);
 		method.invoke(self, Qt::QueuedConnection,
-					  Q_ARG(uchar, status), Q_ARG(uchar, key), Q_ARG(uchar, velocity));
+					  Q_ARG(uchar, status), Q_ARG(uchar, key), Q_ARG(uchar, velocity), Q_ARG(bool, isJammed));
 	}
 	// Program change
 	else if (len == 2 && (msg[0] & 0xf0) == 0xc0) {
@@ -1284,13 +1320,29 @@ void MainWindow::midiThreadReceivedEvent(double delay, const uint8_t *msg, size_
 	}
 }
 
-void MainWindow::midiKeyEvent(uchar status, uchar key, uchar velocity)
+void MainWindow::updateMidiJamRoute()
+{
+	// Real chips are not driven by the audio stream
+	if (timer_ || importBankDiag_) {
+		midiJamRoute_.store(MIDI_JAM_BY_GUI_);
+	}
+	else {
+		int n = instForms_->checkActivatedFormNumber();
+		midiJamRoute_.store((n == -1) ? MIDI_JAM_CURRENT_TRACK_
+									  : static_cast<int>(instForms_->getFormInstrumentSoundSource(n)));
+	}
+	midiJamVolumeSet_.store(!config_.lock()->getFixJammingVolume());
+}
+
+void MainWindow::midiKeyEvent(uchar status, uchar key, uchar velocity, bool isJammed)
 {
 	bool release = ((status & 0xf0) == 0x80) || velocity == 0;
 	int k = static_cast<int>(key) - 12;
 
 	octave_->setValue(k / 12);
 
+	if (isJammed || bt_->isLoadingModule()) return;
+
 	if (importBankDiag_) {
 		if (bankJamMidiCtrl_.load()) return;
 		importBankDiag_->onJamKeyOffByMidi(k);
@@ -1712,12 +1764,10 @@ void MainWindow::funcLoadInstrument(QString file)
 			FileIOErrorMessageBox::openError(file, true, FileIO::FileType::Inst, this);
 			return;
 		}
-		QByteArray array = fp.readAll();
-		fp.close();
-
-		BinaryContainer contaner;
-		contaner.appendVector(std::vector<char>(array.begin(), array.end()));
+		QByteArray array;
+		BinaryContainer contaner = mapFileToContainer(fp, array);
 		bt_->loadInstrument(contaner, file.toStdString(), n);
+		fp.close();
 
 		auto inst = bt_->getInstrument(n);
 		comStack_->push(new AddInstrumentQtCommand(
@@ -1809,13 +1859,11 @@ void MainWindow::funcImportInstrumentsFromBank(QString file)
 			FileIOErrorMessageBox::openError(file, true, FileIO::FileType::Bank, this);
 			return;
 		}
-		QByteArray array = fp.readAll();
-		fp.close();
-
-		BinaryContainer container;
-		container.appendVector(std::vector<char>(array.begin(), array.end()));
+		QByteArray array;
+		BinaryContainer container = mapFileToContainer(fp, array);
 
 		bank.reset(BankIO::loadBank(container, file.toStdString()));
+		fp.close();
 		config_.lock()->setWorkingDirectory(QFileInfo(file).dir().path().toStdString());
 	}
 	catch (FileIOError& e) {
@@ -1884,15 +1932,18 @@ void MainWindow::funcImportInstrumentsFromBank(QString file)
 					 this, [&](int key) { if (jamInst) bt_->jamKeyOffForced(key, jamInst->getSoundSource()); },
 	Qt::DirectConnection);
 	importBankDiag_->addActions({ &octUpSc_, &octDownSc_ });
+	updateMidiJamRoute();
 
 	if (importBankDiag_->exec() != QDialog::Accepted) {
 		assignADPCMSamples();	// Restore
 		importBankDiag_.reset();
+		updateMidiJamRoute();
 		return;
 	}
 
 	QVector<size_t> selection = importBankDiag_->currentInstrumentSelection();
 	importBankDiag_.reset();
+	updateMidiJamRoute();
 	if (selection.empty()) return;
 
 	try {
@@ -1992,6 +2043,7 @@ void MainWindow::swapInstruments(int row1, int row2)
 /********** Undo-Redo **********/
 void MainWindow::undo()
 {
+	if (!bt_->canUndo()) return;
 	bt_->undo();
 	comStack_->undo();
 }
@@ -2090,54 +2142,71 @@ void MainWindow::loadModule()
 
 void MainWindow::openModule(QString file)
 {
-	try {
-		freezeViews();
-		if (timer_) timer_->stop();
-		else stream_->stop();
+	if (bt_->isLoadingModule()) return;
 
-		BinaryContainer container;
-		QFile fp(file);
-		if (fp.open(QIODevice::ReadOnly)) {
-
-			QByteArray array = fp.readAll();
-			fp.close();
-
-			container.appendVector(std::vector<char>(array.begin(), array.end()));
-			bt_->loadModule(container);
-			bt_->setModulePath(file.toStdString());
+	QFile fp(file);
+	if (!fp.open(QIODevice::ReadOnly)) {
+		FileIOErrorMessageBox::openError(file, true, FileIO::FileType::Mod, this);
+		return;
+	}
 
-			loadModule();
+	// Load on the worker thread while the window is repainted and the stream keeps running
+	stopPlaySong();
+	freezeViews();
+	QByteArray array;
+	bt_->startLoadingModule(mapFileToContainer(fp, array));
 
-			config_.lock()->setWorkingDirectory(QFileInfo(file).dir().path().toStdString());
-			changeFileHistory(file);
+	QProgressDialog progress(tr("Loading %1").arg(QFileInfo(file).fileName()), QString(), 0, 100, this);
+	progress.setWindowFlags(progress.windowFlags()
+							& ~Qt::WindowContextHelpButtonHint
+							& ~Qt::WindowCloseButtonHint);
+	progress.setMinimumDuration(500);
+	progress.setValue(0);
+	QEventLoop loop;
+	QTimer poller;
+	QObject::connect(&poller, &QTimer::timeout, &loop, [&] {
+		if (bt_->isLoadingModule()) progress.setValue(bt_->getModuleLoadingProgress());
+		else loop.quit();
+	});
+	poller.start(20);
+	loop.exec(QEventLoop::ExcludeUserInputEvents);
+	poller.stop();
+	progress.reset();
 
-			goto AFTER_LOADING;	// Skip error handling section
-		}
-		else {
-			FileIOErrorMessageBox::openError(file, true, FileIO::FileType::Mod, this);
-		}
+	// Swap the module and rebuild the views without the stream
+	if (timer_) timer_->stop();
+	else stream_->stop();
+	try {
+		bt_->finishLoadingModule();
 	}
 	catch (std::exception& e) {
+		// The current module is kept
+		unfreezeViews();
+		if (timer_) timer_->start();
+		else stream_->start();
+		instForms_->onInstrumentADPCMSampleMemoryUpdated();
 		if (auto ef = dynamic_cast<FileIOError*>(&e)) {
 			FileIOErrorMessageBox(file, true, *ef, this).exec();
 		}
 		else {
 			FileIOErrorMessageBox(file, true, FileIO::FileType::Mod, QString(e.what()), this).exec();
 		}
+		return;
 	}
+	fp.close();
+	bt_->setModulePath(file.toStdString());
 
-	// Init module as a plain when something is wrong
-	freezeViews();
-	bt_->makeNewModule();
 	loadModule();
 
-AFTER_LOADING:	// Post process of module loading
+	config_.lock()->setWorkingDirectory(QFileInfo(file).dir().path().toStdString());
+	changeFileHistory(file);
+
 	isModifiedForNotCommand_ = false;
 	setWindowModified(false);
 	if (timer_) timer_->start();
 	else stream_->start();
 	setInitialSelectedInstrument();
-	assignADPCMSamples();
+	instForms_->onInstrumentADPCMSampleMemoryUpdated();	// Samples have been stored by the loader
 }
 
 void MainWindow::loadSong()
@@ -2278,6 +2347,7 @@ void MainWindow::changeConfiguration()
 	RealChipInterface intf = config_.lock()->getRealChipInterface();
 	if (intf == RealChipInterface::NONE) {
 		timer_.reset();
+		statusIntr_->setToolTip("");
 		bt_->useSCCI(nullptr);
 		bt_->useC86CTL(nullptr);
 		QString streamErr;
@@ -2299,11 +2369,13 @@ void MainWindow::changeConfiguration()
 		else {
 			timer_ = std::make_unique<Timer>();
 			timer_->setInterval(1000000 / bt_->getModuleTickFrequency());
-			tickEventMethod_ = metaObject()->indexOfSlot("onNewTickSignaledRealChip()");
+			tickEventMethod_ = metaObject()->indexOfSlot("onNewTickSignaled(int)");
 			Q_ASSERT(tickEventMethod_ != -1);
 			timer_->setFunction([&]{
+				// Process the tick on the timer thread and notify only the result to the GUI
+				int state = bt_->streamCountUpOnRealChip();
 				QMetaMethod method = this->metaObject()->method(this->tickEventMethod_);
-				method.invoke(this, Qt::QueuedConnection);
+				method.invoke(this, Qt::QueuedConnection, Q_ARG(int, state));
 			});
 		}
 
@@ -2313,6 +2385,7 @@ void MainWindow::changeConfiguration()
 	}
 
 	setMidiConfiguration();
+	updateMidiJamRoute();
 	updateFonts();
 	ui->orderList->setHorizontalScrollMode(config_.lock()->getMoveCursorByHorizontalScroll());
 	ui->patternEditor->setHorizontalScrollMode(config_.lock()->getMoveCursorByHorizontalScroll());
@@ -2627,7 +2700,7 @@ void MainWindow::updateMenuByPattern()
 	}
 	else {
 		// Edit
-		bool enabled = QApplication::clipboard()->text().startsWith("PATTERN_");
+		bool enabled = hasPatternCellsInClipboard();
 		ui->actionPaste->setEnabled(enabled);
 		ui->actionMix->setEnabled(enabled);
 		ui->actionOverwrite->setEnabled(enabled);
@@ -3291,30 +3364,76 @@ void MainWindow::on_actionWAV_triggered()
 
 	bt_->stopPlaySong();
 	lockWidgets(false);
-	stream_->stop();
 
 	try {
-		WavContainer container(0, static_cast<uint32_t>(diag.getSampleRate()));
 		auto bar = [&progress]() -> bool {
 				   QApplication::processEvents();
 				   progress.setValue(progress.value() + 1);
 				   return progress.wasCanceled();
 	};
 
-		bool res = bt_->exportToWav(container, diag.getLoopCount(), bar);
-		if (res) {
-			QFile fp(path);
-			if (!fp.open(QIODevice::WriteOnly)) {
-				FileIOErrorMessageBox::openError(path, false, FileIO::FileType::WAV, this);
+		if (diag.isStemExportEnabled()) {
+			// The master is written to the selected file, each channel to "<base name>-<track name>.wav"
+			std::unique_ptr<StemExporter> exporter = bt_->createStemExporter();
+			QFileInfo info(path);
+			std::vector<std::unique_ptr<QFile>> files;
+			std::vector<std::unique_ptr<WavWriter>> writers;
+			std::vector<WavWriter*> writerPtrs;
+			for (const auto& stem : exporter->getStems()) {
+				QString stemPath = stem.isMaster ? path
+												 : QString("%1/%2-%3.wav").arg(info.dir().path(), info.completeBaseName(),
+																			   QString::fromStdString(stem.name));
+				auto fp = std::make_unique<QFile>(stemPath);
+				if (!fp->open(QIODevice::WriteOnly)) {
+					for (auto& f : files) f->remove();
+					FileIOErrorMessageBox::openError(stemPath, false, FileIO::FileType::WAV, this);
+					return;
+				}
+				QFile* fpp = fp.get();
+				writers.push_back(std::make_unique<WavWriter>([fpp](const char* data, size_t size) {
+					return fpp->write(data, static_cast<qint64>(size)) == static_cast<qint64>(size);
+				}, [fpp](size_t pos) {
+					return fpp->seek(static_cast<qint64>(pos));
+				}, static_cast<uint32_t>(diag.getSampleRate()), diag.getSampleFormat()));
+				writerPtrs.push_back(writers.back().get());
+				files.push_back(std::move(fp));
 			}
-			else {
-				BinaryContainer bc = container.createWavBinary();
-				fp.write(bc.getPointer(), bc.size());
-				fp.close();
+
+			bool res = exporter->render(writerPtrs, diag.getLoopCount(), bar);
+			for (auto& f : files) {
+				f->close();
+				if (!res) f->remove();
+			}
+			if (res) {
 				bar();
 
-				config_.lock()->setWorkingDirectory(QFileInfo(path).dir().path().toStdString());
+				config_.lock()->setWorkingDirectory(info.dir().path().toStdString());
 			}
+			return;
+		}
+
+		QFile fp(path);
+		if (!fp.open(QIODevice::WriteOnly)) {
+			FileIOErrorMessageBox::openError(path, false, FileIO::FileType::WAV, this);
+			return;
+		}
+
+		// Samples are written to the file while rendering
+		WavWriter writer([&fp](const char* data, size_t size) {
+			return fp.write(data, static_cast<qint64>(size)) == static_cast<qint64>(size);
+		}, [&fp](size_t pos) {
+			return fp.seek(static_cast<qint64>(pos));
+		}, static_cast<uint32_t>(diag.getSampleRate()), diag.getSampleFormat());
+
+		bool res = bt_->exportToWav(writer, diag.getLoopCount(), bar);
+		fp.close();
+		if (res) {
+			bar();
+
+			config_.lock()->setWorkingDirectory(QFileInfo(path).dir().path().toStdString());
+		}
+		else {
+			fp.remove();
 		}
 	}
 	catch (FileIOError& e) {
@@ -3323,8 +3442,6 @@ void MainWindow::on_actionWAV_triggered()
 	catch (std::exception& e) {
 		FileIOErrorMessageBox(path, false, FileIO::FileType::WAV, QString(e.what()), this).exec();
 	}
-
-	stream_->start();
 }
 
 void MainWindow::on_actionVGM_triggered()
@@ -3351,7 +3468,6 @@ void MainWindow::on_actionVGM_triggered()
 
 	bt_->stopPlaySong();
 	lockWidgets(false);
-	stream_->stop();
 
 	try {
 		BinaryContainer container;
@@ -3382,8 +3498,6 @@ void MainWindow::on_actionVGM_triggered()
 	catch (std::exception& e) {
 		FileIOErrorMessageBox(path, false, FileIO::FileType::VGM, QString(e.what()), this).exec();
 	}
-
-	stream_->start();
 }
 
 void MainWindow::on_actionS98_triggered()
@@ -3410,7 +3524,6 @@ void MainWindow::on_actionS98_triggered()
 
 	bt_->stopPlaySong();
 	lockWidgets(false);
-	stream_->stop();
 
 	try {
 		BinaryContainer container;
@@ -3442,8 +3555,6 @@ void MainWindow::on_actionS98_triggered()
 	catch (std::exception& e) {
 		FileIOErrorMessageBox(path, false, FileIO::FileType::S98, QString(e.what()), this).exec();
 	}
-
-	stream_->start();
 }
 
 void MainWindow::on_actionMix_triggered()
@@ -3456,11 +3567,6 @@ void MainWindow::on_actionOverwrite_triggered()
 	if (isEditedPattern_) ui->patternEditor->onPasteOverwritePressed();
 }
 
-void MainWindow::onNewTickSignaledRealChip()
-{
-	onNewTickSignaled(bt_->streamCountUp());
-}
-
 void MainWindow::onNewTickSignaled(int state)
 {
 	if (!state) {	// New step
@@ -3520,6 +3626,13 @@ void MainWindow::updateVisuals()
 	bt_->getOutputHistory(wave);
 
 	ui->waveVisual->setStereoSamples(wave, OPNAController::OUTPUT_HISTORY_SIZE);
+
+	if (timer_) {
+		Timer::Statistics stats = timer_->getStatistics();
+		statusIntr_->setToolTip(tr("Tick latency: mean %1us, max %2us, jitter %3us\nSkipped ticks: %4")
+								.arg(stats.meanLatency, 0, 'f', 1).arg(stats.maxLatency, 0, 'f', 1)
+								.arg(stats.jitter, 0, 'f', 1).arg(stats.skippedTicks));
+	}
 }
 
 void MainWindow::on_action_Effect_List_triggered()
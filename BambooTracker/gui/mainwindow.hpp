@@ -96,7 +96,8 @@ protected:
 private:
 	static void midiThreadReceivedEvent(double delay, const uint8_t *msg, size_t len, void *userData);
 private slots:
-	void midiKeyEvent(uchar status, uchar key, uchar velocity);
+	/// [isJammed]: the key is already played by the audio stream
+	void midiKeyEvent(uchar status, uchar key, uchar velocity, bool isJammed);
 	void midiProgramEvent(uchar status, uchar program);
 
 private:
@@ -216,12 +217,22 @@ private:
 	std::unique_ptr<BookmarkManagerForm> bmManForm_;
 	std::unique_ptr<CommentEditDialog> commentDiag_;
 
+	// MIDI jam
+	/// Jam target of MIDI key events, read by the MIDI input thread
+	/// MIDI_JAM_BY_GUI_: jam in the GUI thread, MIDI_JAM_CURRENT_TRACK_: current track, others: SoundSource
+	std::atomic_int midiJamRoute_;
+	std::atomic_bool midiJamVolumeSet_;
+	static constexpr int MIDI_JAM_BY_GUI_ = -2;
+	static constexpr int MIDI_JAM_CURRENT_TRACK_ = -1;
+	void updateMidiJamRoute();
+
 	// Bank import
 	std::atomic_bool bankJamMidiCtrl_;
 	std::unique_ptr<InstrumentSelectionDialog> importBankDiag_;
 
 	// Track visibility
 	void setTrackVisibility(const std::vector<int>& visTracks);
+	void restoreTrackVisibility();
 
 	// Meta methods
 	int tickEventMethod_;
@@ -339,7 +350,6 @@ private slots:
 	void on_actionS98_triggered();
 	void on_actionMix_triggered();
 	void on_actionOverwrite_triggered();
-	void onNewTickSignaledRealChip();
 	void onNewTickSignaled(int state);
 	void on_actionClear_triggered();
 	void on_keyRepeatCheckBox_stateChanged(int arg1);
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pattern_clipboard.hpp"
+#include <cstring>
+#include <string>
+#include <exception>
+#include <QApplication>
+#include <QClipboard>
+#include <QMimeData>
+#include <QByteArray>
+#include <QString>
+#include "effect.hpp"
+
+namespace
+{
+const QString MIME_TYPE = "application/x-bambootracker-pattern-cells";
+
+struct BinaryHeader
+{
+	int32_t startColumn;
+	uint32_t width, height;
+};
+
+inline bool isEffectIDColumn(int column)
+{
+	switch (column) {
+	case 3:
+	case 5:
+	case 7:
+	case 9:
+		return true;
+	default:
+		return false;
+	}
+}
+
+inline bool isValidSize(int startColumn, size_t width, size_t height)
+{
+	return (0 <= startColumn && startColumn < 11 && width && height);
+}
+
+QString encodeText(const PatternClipboardCells& cells, bool isCut)
+{
+	QString str = QString("PATTERN_%1:%2,%3,%4,").arg(QString(isCut ? "CUT" : "COPY"))
+				  .arg(cells.startColumn).arg(cells.width).arg(cells.getHeight());
+	str.reserve(str.size() + static_cast<int>(cells.cells.size()) * 4);
+	for (size_t i = 0; i < cells.cells.size(); ++i) {
+		if (i) str += ',';
+		uint16_t cell = cells.cells[i];
+		if (isEffectIDColumn((cells.startColumn + static_cast<int>(i % cells.width)) % 11))
+			str += QString::fromStdString(Effect::decodeID(cell));
+		else
+			str += QString::number(static_cast<int16_t>(cell));
+	}
+	return str;
+}
+
+bool decodeText(const QString& text, PatternClipboardCells& cells)
+{
+	std::string str = text.toStdString();
+	size_t pos;
+	if (str.compare(0, 13, "PATTERN_COPY:") == 0) pos = 13;
+	else if (str.compare(0, 12, "PATTERN_CUT:") == 0) pos = 12;
+	else return false;
+
+	auto next = [&str, &pos](std::string& field) {
+		if (pos >= str.size()) return false;
+		size_t end = str.find(',', pos);
+		if (end == std::string::npos) end = str.size();
+		field = str.substr(pos, end - pos);
+		pos = end + 1;
+		return true;
+	};
+
+	try {
+		std::string field;
+		int hd[3];
+		for (int& v : hd) {
+			if (!next(field)) return false;
+			v = std::stoi(field);
+		}
+		if (hd[1] <= 0 || hd[2] <= 0 || !isValidSize(hd[0], static_cast<size_t>(hd[1]), static_cast<size_t>(hd[2])))
+			return false;
+		cells.startColumn = hd[0];
+		cells.width = static_cast<size_t>(hd[1]);
+		size_t n = cells.width * static_cast<size_t>(hd[2]);
+		cells.cells.clear();
+		cells.cells.reserve(n);
+		for (size_t i = 0; i < n; ++i) {
+			if (!next(field)) return false;
+			if (isEffectIDColumn((cells.startColumn + static_cast<int>(i % cells.width)) % 11))
+				cells.cells.push_back(Effect::encodeID(field));
+			else
+				cells.cells.push_back(static_cast<uint16_t>(std::stoi(field)));
+		}
+	}
+	catch (std::exception&) {
+		return false;
+	}
+	return true;
+}
+}
+
+void setPatternCellsToClipboard(const PatternClipboardCells& cells, bool isCut)
+{
+	BinaryHeader hd = {
+		cells.startColumn, static_cast<uint32_t>(cells.width), static_cast<uint32_t>(cells.getHeight())
+	};
+	size_t cellsSize = cells.cells.size() * sizeof(uint16_t);
+	QByteArray data(static_cast<int>(sizeof(BinaryHeader) + cellsSize), Qt::Uninitialized);
+	std::memcpy(data.data(), &hd, sizeof(BinaryHeader));
+	std::memcpy(data.data() + sizeof(BinaryHeader), cells.cells.data(), cellsSize);
+
+	auto mime = new QMimeData;
+	mime->setData(MIME_TYPE, data);
+	mime->setText(encodeText(cells, isCut));
+	QApplication::clipboard()->setMimeData(mime);
+}
+
+bool hasPatternCellsInClipboard()
+{
+	const QMimeData* mime = QApplication::clipboard()->mimeData();
+	return (mime && (mime->hasFormat(MIME_TYPE) || mime->text().startsWith("PATTERN_")));
+}
+
+bool getPatternCellsFromClipboard(PatternClipboardCells& cells)
+{
+	const QMimeData* mime = QApplication::clipboard()->mimeData();
+	if (!mime) return false;
+
+	if (mime->hasFormat(MIME_TYPE)) {
+		// The cells are copied as they are without parsing
+		QByteArray data = mime->data(MIME_TYPE);
+		size_t size = static_cast<size_t>(data.size());
+		BinaryHeader hd;
+		if (size >= sizeof(BinaryHeader)) {
+			std::memcpy(&hd, data.constData(), sizeof(BinaryHeader));
+			size_t n = static_cast<size_t>(hd.width) * hd.height;
+			if (isValidSize(hd.startColumn, hd.width, hd.height)
+					&& size == sizeof(BinaryHeader) + n * sizeof(uint16_t)) {
+				cells.startColumn = hd.startColumn;
+				cells.width = hd.width;
+				cells.cells.resize(n);
+				std::memcpy(cells.cells.data(), data.constData() + sizeof(BinaryHeader), n * sizeof(uint16_t));
+				return true;
+			}
+		}
+	}
+
+	return decodeText(mime->text(), cells);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PATTERN_CLIPBOARD_HPP
+#define PATTERN_CLIPBOARD_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/// Pattern cells exchanged through the clipboard.
+/// The cells are in row-major order and packed in the same form as PatternCellBlock.
+struct PatternClipboardCells
+{
+	int startColumn;
+	size_t width;
+	std::vector<uint16_t> cells;
+
+	size_t getHeight() const { return width ? cells.size() / width : 0; }
+};
+
+/// Put the cells in both the binary format for copying in the application
+/// and the text format for other applications
+void setPatternCellsToClipboard(const PatternClipboardCells& cells, bool isCut);
+bool hasPatternCellsInClipboard();
+/// Read the binary format if it is available, otherwise parse the text format
+bool getPatternCellsFromClipboard(PatternClipboardCells& cells);
+
+#endif // PATTERN_CLIPBOARD_HPP
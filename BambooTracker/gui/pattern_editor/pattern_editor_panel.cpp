@@ -36,13 +36,12 @@
 #include <QFontInfo>
 #include <QPoint>
 #include <QApplication>
-#include <QClipboard>
 #include <QMenu>
 #include <QAction>
-#include <QRegularExpression>
-#include <QRegularExpressionMatch>
 #include <QMetaMethod>
 #include <QIcon>
+#include <QElapsedTimer>
+#include <QDebug>
 #include "gui/event_guard.hpp"
 #include "gui/command/pattern/pattern_commands_qt.hpp"
 #include "midi/midi.hpp"
@@ -107,6 +106,7 @@ PatternEditorPanel::PatternEditorPanel(QWidget *parent)
 	  viewedRowOffset_(0),
 	  viewedCenterY_(0),
 	  viewedCenterBaseY_(0),
+	  playPos_{ -1, -1, -1, -1 },
 	  backChanged_(false),
 	  textChanged_(false),
 	  foreChanged_(false),
@@ -115,6 +115,11 @@ PatternEditorPanel::PatternEditorPanel(QWidget *parent)
 	  followModeChanged_(false),
 	  hasFocussedBefore_(false),
 	  stepDownCount_(0),
+	  isFrameTimeReported_(qEnvironmentVariableIsSet("BT_PATTERN_REDRAW_STATS")),
+	  isFullRedrawForced_(qgetenv("BT_PATTERN_REDRAW_STATS") == "full"),
+	  frameTimeSum_(0),
+	  frameTimeMax_(0),
+	  frameCnt_(0),
 	  repaintable_(true),
 	  repaintingCnt_(0),
 	  isInitedFirstMod_(false),
@@ -222,7 +227,7 @@ PatternEditorPanel::PatternEditorPanel(QWidget *parent)
 	QObject::connect(&keyOffSc_, &QShortcut::activated, this, [&] {
 		if (!bt_->isJamMode() && curPos_.colInTrack == 0) {
 			bt_->setStepKeyOff(curSongNum_, visTracks_.at(curPos_.trackVisIdx), curPos_.order, curPos_.step);
-			comStack_.lock()->push(new SetKeyOffToStepQtCommand(this));
+			comStack_.lock()->push(new SetKeyOffToStepQtCommand(this, curPos_));
 			if (!bt_->isPlaySong() || !bt_->isFollowPlay()) moveCursorToDown(editableStepCnt_);
 		}
 	});
@@ -231,7 +236,7 @@ PatternEditorPanel::PatternEditorPanel(QWidget *parent)
 			int n = bt_->getCurrentOctave();
 			if (n > 3) n = 3;
 			bt_->setEchoBufferAccess(curSongNum_, visTracks_.at(curPos_.trackVisIdx), curPos_.order, curPos_.step, n);
-			comStack_.lock()->push(new SetEchoBufferAccessQtCommand(this));
+			comStack_.lock()->push(new SetEchoBufferAccessQtCommand(this, curPos_));
 			if (!bt_->isPlaySong() || !bt_->isFollowPlay()) moveCursorToDown(editableStepCnt_);
 		}
 	});
@@ -275,6 +280,8 @@ void PatternEditorPanel::funcResize()
 
 void PatternEditorPanel::updateSizes()
 {
+	stepGlyphs_.setFont(stepFont_);
+
 	QFontMetrics metrics(stepFont_);
 #if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
 	stepFontWidth_ = metrics.horizontalAdvance('0');
@@ -370,6 +377,7 @@ void PatternEditorPanel::setConfiguration(std::shared_ptr<Configuration> config)
 void PatternEditorPanel::setColorPallete(std::shared_ptr<ColorPalette> palette)
 {
 	palette_ = palette;
+	stepGlyphs_.clear();
 }
 
 void PatternEditorPanel::waitPaintFinish()
@@ -480,11 +488,31 @@ void PatternEditorPanel::redrawByHoverChanged()
 
 void PatternEditorPanel::redrawByMaskChanged()
 {
-	foreChanged_ = true;
+	invalidateViewedRows();
 	headerChanged_ = true;
 	repaint();
 }
 
+void PatternEditorPanel::redrawByCellChanged(const PatternPosition& pos)
+{
+	invalidateRow(pos.order, pos.step);
+
+	// The rows of the other orders may show the same pattern,
+	// unless the order is cut before the step by a jump or break in another track
+	if (0 <= pos.trackVisIdx && pos.trackVisIdx < static_cast<int>(visTracks_.size())
+			&& pos.order < static_cast<int>(bt_->getOrderSize(curSongNum_))) {
+		size_t track = static_cast<size_t>(visTracks_[static_cast<size_t>(pos.trackVisIdx)]);
+		int ptn = bt_->getOrderData(curSongNum_, pos.order).at(track).patten;
+		for (int order = std::max(0, viewedFirstPos_.order); order <= viewedLastPos_.order; ++order) {
+			if (order != pos.order && bt_->getOrderData(curSongNum_, order).at(track).patten == ptn
+					&& pos.step < static_cast<int>(bt_->getPatternSizeFromOrderNumber(curSongNum_, order)))
+				invalidateRow(order, pos.step);
+		}
+	}
+
+	repaint();
+}
+
 void PatternEditorPanel::redrawPatterns()
 {
 	backChanged_ = true;
@@ -518,40 +546,32 @@ void PatternEditorPanel::drawPattern(const QRect &rect)
 			foreChanged_ = true;
 		}
 
-		if (backChanged_ || textChanged_ || foreChanged_ || headerChanged_ || focusChanged_ || stepDownCount_ || followModeChanged_) {
-
-			int maxWidth = std::min(rect.width(), tracksWidthFromLeftToEnd_);
-			completePixmap_.fill(palette_->ptnBackColor);
-
-			if (!focusChanged_) {
-				if (stepDownCount_ && !followModeChanged_) {
-					quickDrawRows(maxWidth);
-				}
-				else {
-					backPixmap_.fill(Qt::transparent);
-					if (textChanged_) textPixmap_.fill(Qt::transparent);
-					if (foreChanged_) forePixmap_.fill(Qt::transparent);
-					drawRows(maxWidth);
-				}
-				drawBorders(maxWidth);
-
-				if (headerChanged_) {
-					// headerPixmap_->fill(Qt::transparent);
-					drawHeaders(maxWidth);
+		bool isFullRedraw = (backChanged_ || textChanged_ || foreChanged_ || stepDownCount_ || followModeChanged_);
+		if (isFullRedraw || !dirtyRows_.empty() || headerChanged_ || focusChanged_) {
+			QElapsedTimer frameTimer;
+			if (isFrameTimeReported_) {
+				if (isFullRedrawForced_) {
+					headerChanged_ = true;
+					backChanged_ = true;
+					textChanged_ = true;
+					foreChanged_ = true;
+					followModeChanged_ = true;	// Not scroll
+					isFullRedraw = true;
 				}
+				frameTimer.start();
 			}
 
-			{
-				QPainter mergePainter(&completePixmap_);
-				QRect rowsRect(0, viewedRowOffset_, maxWidth, viewedRegionHeight_);
-				QRect inViewRect(0, headerHeight_, maxWidth, viewedRegionHeight_);
-				mergePainter.drawPixmap(inViewRect, backPixmap_, rowsRect);
-				mergePainter.drawPixmap(inViewRect, textPixmap_, rowsRect);
-				mergePainter.drawPixmap(inViewRect, forePixmap_, rowsRect);
-				mergePainter.drawPixmap(headerPixmap_.rect(), headerPixmap_);
+			int maxWidth = std::min(rect.width(), tracksWidthFromLeftToEnd_);
+			if (!isFullRedraw) {
+				redrawDirtyRows(maxWidth);
 			}
-
-			if (!hasFocus()) drawShadow();
+			else if (stepDownCount_ && !followModeChanged_ && !focusChanged_ && !headerChanged_) {
+				scrollRows(maxWidth);
+			}
+			else {
+				redrawAllRows(maxWidth);
+			}
+			dirtyRows_.clear();
 
 			backChanged_ = false;
 			textChanged_ = false;
@@ -560,6 +580,8 @@ void PatternEditorPanel::drawPattern(const QRect &rect)
 			focusChanged_ = false;
 			followModeChanged_ = false;
 			stepDownCount_ = 0;
+
+			if (isFrameTimeReported_) updateFrameTime(frameTimer.nsecsElapsed() / 1000);
 		}
 
 		--repaintingCnt_;	// Used module data until this line
@@ -570,6 +592,100 @@ void PatternEditorPanel::drawPattern(const QRect &rect)
 	completePainter.drawPixmap(rect, completePixmap_);
 }
 
+void PatternEditorPanel::updateFrameTime(qint64 us)
+{
+	frameTimeSum_ += us;
+	frameTimeMax_ = std::max(frameTimeMax_, us);
+	if (++frameCnt_ == FRAME_TIME_REPORT_CNT_) {
+		qDebug() << "Pattern editor redraw" << completePixmap_.size()
+				 << (isFullRedrawForced_ ? "(full): avg" : ": avg") << (frameTimeSum_ / frameCnt_)
+				 << "us, max" << frameTimeMax_ << "us";
+		frameTimeSum_ = 0;
+		frameTimeMax_ = 0;
+		frameCnt_ = 0;
+	}
+}
+
+void PatternEditorPanel::redrawAllRows(int maxWidth)
+{
+	completePixmap_.fill(palette_->ptnBackColor);
+
+	if (stepDownCount_ && !followModeChanged_) {
+		quickDrawRows(maxWidth);
+	}
+	else {
+		backPixmap_.fill(Qt::transparent);
+		if (textChanged_) textPixmap_.fill(Qt::transparent);
+		if (foreChanged_) forePixmap_.fill(Qt::transparent);
+		drawRows(maxWidth);
+	}
+	drawBorders(maxWidth);
+
+	if (headerChanged_) {
+		// headerPixmap_->fill(Qt::transparent);
+		drawHeaders(maxWidth);
+	}
+
+	{
+		QPainter mergePainter(&completePixmap_);
+		QRect rowsRect(0, viewedRowOffset_, maxWidth, viewedRegionHeight_);
+		QRect inViewRect(0, headerHeight_, maxWidth, viewedRegionHeight_);
+		mergePainter.drawPixmap(inViewRect, backPixmap_, rowsRect);
+		mergePainter.drawPixmap(inViewRect, textPixmap_, rowsRect);
+		mergePainter.drawPixmap(inViewRect, forePixmap_, rowsRect);
+		mergePainter.drawPixmap(headerPixmap_.rect(), headerPixmap_);
+	}
+
+	if (!hasFocus()) drawShadow();
+}
+
+void PatternEditorPanel::scrollRows(int maxWidth)
+{
+	int shift = stepFontHeight_ * stepDownCount_;
+	int prevY = viewedCenterY_ - shift;
+	bool isForeRepainted = quickDrawRows(maxWidth);
+	drawBorders(maxWidth);
+
+	// Move the merged rows up and merge only the rows redrawn by quickDrawRows
+	if (!isForeRepainted)
+		completePixmap_.scroll(0, -shift, QRect(0, headerHeight_, completePixmap_.width(), viewedRegionHeight_));
+	QPainter mergePainter(&completePixmap_);
+	if (isForeRepainted) {
+		mergeRows(mergePainter, QRect(0, viewedRowOffset_, maxWidth, viewedRegionHeight_));
+	}
+	else {
+		mergeRows(mergePainter, QRect(0, prevY, maxWidth, stepFontHeight_));
+		mergeRows(mergePainter, QRect(0, viewedCenterY_, maxWidth, stepFontHeight_));
+		int newY = viewedRowOffset_ + viewedRegionHeight_ - shift;
+		mergeRows(mergePainter, QRect(0, newY, maxWidth, viewedRowsHeight_ - newY));
+	}
+}
+
+void PatternEditorPanel::mergeRows(QPainter& mergePainter, const QRect& rowsRect)
+{
+	QRect rect = rowsRect.intersected(QRect(0, viewedRowOffset_, completePixmap_.width(), viewedRegionHeight_));
+	if (rect.isEmpty()) return;
+
+	QRect inViewRect = rect.translated(0, headerHeight_ - viewedRowOffset_);
+	mergePainter.setCompositionMode(QPainter::CompositionMode_Source);
+	mergePainter.fillRect(inViewRect, palette_->ptnBackColor);
+	mergePainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+	mergePainter.drawPixmap(inViewRect, backPixmap_, rect);
+	mergePainter.drawPixmap(inViewRect, textPixmap_, rect);
+	mergePainter.drawPixmap(inViewRect, forePixmap_, rect);
+	if (!hasFocus()) mergePainter.fillRect(inViewRect, palette_->ptnUnfocusedShadowColor);
+}
+
+void PatternEditorPanel::mergeHeader(QPainter& mergePainter)
+{
+	QRect rect(0, 0, completePixmap_.width(), headerHeight_);
+	mergePainter.setCompositionMode(QPainter::CompositionMode_Source);
+	mergePainter.fillRect(rect, palette_->ptnBackColor);
+	mergePainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+	mergePainter.drawPixmap(headerPixmap_.rect(), headerPixmap_);
+	if (!hasFocus()) mergePainter.fillRect(rect, palette_->ptnUnfocusedShadowColor);
+}
+
 void PatternEditorPanel::drawRows(int maxWidth)
 {
 	QPainter forePainter(&forePixmap_);
@@ -578,35 +694,11 @@ void PatternEditorPanel::drawRows(int maxWidth)
 	textPainter.setFont(stepFont_);
 
 	/* Current row */
-	// Fill row
-	backPainter.fillRect(0, viewedCenterY_, maxWidth, stepFontHeight_,
-						 bt_->isJamMode() ? palette_->ptnCurStepColor : palette_->ptnCurEditStepColor);
-	// Step number
-	if (markerPos_.isEqualRows(curPos_))
-		backPainter.fillRect(0, viewedCenterY_, stepNumWidth_, stepFontHeight_, palette_->ptnMarkerColor);	// Paint marker
-	if (hovPos_.trackVisIdx == -2 && hovPos_.isEqualRows(curPos_))
-		backPainter.fillRect(0, viewedCenterY_, stepNumWidth_, stepFontHeight_, palette_->ptnHovCellColor);	// Paint hover
-	if (textChanged_) {
-		if (curPos_.step % hl2Cnt_) {
-			textPainter.setPen(!(curPos_.step % hl2Cnt_) ? palette_->ptnHl1StepNumColor
-														 : !(curPos_.step % hl1Cnt_) ? palette_->ptnHl1StepNumColor
-																					 : palette_->ptnDefStepNumColor);
-		}
-		else {
-			textPainter.setPen(palette_->ptnHl2StepNumColor);
-		}
-		textPainter.drawText(1, viewedCenterBaseY_, QString("%1").arg(curPos_.step, stepNumWidthCnt_, stepNumBase_, QChar('0')).toUpper());
-	}
-	// Step data
-	for (int x = stepNumWidth_, trackVisIdx = leftTrackVisIdx_; x < maxWidth; ++trackVisIdx) {
-		x += drawStep(forePainter, textPainter, backPainter, trackVisIdx, curPos_.order, curPos_.step, x, viewedCenterBaseY_, viewedCenterY_);
-	}
+	drawRow(forePainter, textPainter, backPainter, maxWidth, curPos_.order, curPos_.step, viewedCenterBaseY_, viewedCenterY_);
 	viewedCenterPos_ = curPos_;
 
 	int stepNum, odrNum;
 	int rowY, baseY;
-	int playOdrNum = bt_->getPlayingOrderNumber();
-	int playStepNum = bt_->getPlayingStepNumber();
 
 	/* Previous rows */
 	viewedFirstPos_ = curPos_;
@@ -627,37 +719,7 @@ void PatternEditorPanel::drawRows(int maxWidth)
 			}
 		}
 
-		QColor rowColor;
-		if (!config_->getFollowMode() && odrNum == playOdrNum && stepNum == playStepNum) {
-			rowColor = palette_->ptnPlayStepColor;
-		}
-		else {
-			rowColor = !(stepNum % hl2Cnt_) ? palette_->ptnHl2StepColor
-											: !(stepNum % hl1Cnt_) ? palette_->ptnHl1StepColor
-																   : palette_->ptnDefStepColor;
-		}
-
-		// Fill row
-		backPainter.fillRect(0, rowY, maxWidth, stepFontHeight_, rowColor);
-		// Step number
-		if (markerPos_.isEqualRows(odrNum, stepNum))
-			backPainter.fillRect(0, rowY, stepNumWidth_, stepFontHeight_, palette_->ptnMarkerColor);	// Paint marker
-		if (hovPos_.trackVisIdx == -2 && hovPos_.isEqualRows(odrNum, stepNum))
-			backPainter.fillRect(0, rowY, stepNumWidth_, stepFontHeight_, palette_->ptnHovCellColor);	// Paint hover
-		if (textChanged_) {
-			textPainter.setPen(!(stepNum % hl2Cnt_) ? palette_->ptnHl2StepNumColor
-													: !(stepNum % hl1Cnt_) ? palette_->ptnHl1StepNumColor
-																		   : palette_->ptnDefStepNumColor);
-			textPainter.drawText(1, baseY, QString("%1").arg(stepNum, stepNumWidthCnt_, stepNumBase_, QChar('0')).toUpper());
-		}
-		// Step data
-		for (int x = stepNumWidth_, trackVisIdx = leftTrackVisIdx_; x < maxWidth; ++trackVisIdx) {
-			x += drawStep(forePainter, textPainter, backPainter, trackVisIdx, odrNum, stepNum, x, baseY, rowY);
-		}
-		if (foreChanged_) {
-			if (odrNum != curPos_.order)	// Mask
-				forePainter.fillRect(0, rowY, maxWidth, stepFontHeight_, palette_->ptnMaskColor);
-		}
+		drawRow(forePainter, textPainter, backPainter, maxWidth, odrNum, stepNum, baseY, rowY);
 		viewedFirstPos_.setRows(odrNum, stepNum);
 	}
 
@@ -683,42 +745,128 @@ void PatternEditorPanel::drawRows(int maxWidth)
 			}
 		}
 
-		QColor rowColor;
-		if (!config_->getFollowMode() && odrNum == playOdrNum && stepNum == playStepNum) {
-			rowColor = palette_->ptnPlayStepColor;
+		drawRow(forePainter, textPainter, backPainter, maxWidth, odrNum, stepNum, baseY, rowY);
+		viewedLastPos_.setRows(odrNum, stepNum);
+	}
+}
+
+void PatternEditorPanel::drawRow(QPainter& forePainter, QPainter& textPainter, QPainter& backPainter, int maxWidth, int orderNum, int stepNum, int baseY, int rowY)
+{
+	QColor rowColor;
+	if (curPos_.isEqualRows(orderNum, stepNum)) {
+		rowColor = bt_->isJamMode() ? palette_->ptnCurStepColor : palette_->ptnCurEditStepColor;
+	}
+	else if (!config_->getFollowMode() && orderNum == bt_->getPlayingOrderNumber()
+			 && stepNum == bt_->getPlayingStepNumber()) {
+		rowColor = palette_->ptnPlayStepColor;
+	}
+	else {
+		rowColor = !(stepNum % hl2Cnt_) ? palette_->ptnHl2StepColor
+										: !(stepNum % hl1Cnt_) ? palette_->ptnHl1StepColor
+															   : palette_->ptnDefStepColor;
+	}
+
+	// Fill row
+	backPainter.fillRect(0, rowY, maxWidth, stepFontHeight_, rowColor);
+	// Step number
+	if (markerPos_.isEqualRows(orderNum, stepNum))
+		backPainter.fillRect(0, rowY, stepNumWidth_, stepFontHeight_, palette_->ptnMarkerColor);	// Paint marker
+	if (hovPos_.trackVisIdx == -2 && hovPos_.isEqualRows(orderNum, stepNum))
+		backPainter.fillRect(0, rowY, stepNumWidth_, stepFontHeight_, palette_->ptnHovCellColor);	// Paint hover
+	if (textChanged_) {
+		QColor numColor;
+		if (curPos_.isEqualRows(orderNum, stepNum)) {
+			if (stepNum % hl2Cnt_) {
+				numColor = !(stepNum % hl2Cnt_) ? palette_->ptnHl1StepNumColor
+												: !(stepNum % hl1Cnt_) ? palette_->ptnHl1StepNumColor
+																	   : palette_->ptnDefStepNumColor;
+			}
+			else {
+				numColor = palette_->ptnHl2StepNumColor;
+			}
 		}
 		else {
-			rowColor = !(stepNum % hl2Cnt_) ? palette_->ptnHl2StepColor
-											: !(stepNum % hl1Cnt_) ? palette_->ptnHl1StepColor
-																   : palette_->ptnDefStepColor;
-		}
-
-		// Fill row
-		backPainter.fillRect(0, rowY, maxWidth, stepFontHeight_, rowColor);
-		// Step number
-		if (markerPos_.isEqualRows(odrNum, stepNum))
-			backPainter.fillRect(0, rowY, stepNumWidth_, stepFontHeight_, palette_->ptnMarkerColor);	// Paint marker
-		if (hovPos_.trackVisIdx == -2 && hovPos_.isEqualRows(odrNum, stepNum))
-			backPainter.fillRect(0, rowY, stepNumWidth_, stepFontHeight_, palette_->ptnHovCellColor);	// Paint hover
-		if (textChanged_) {
-			textPainter.setPen(!(stepNum % hl2Cnt_) ? palette_->ptnHl2StepNumColor
-													: !(stepNum % hl1Cnt_) ? palette_->ptnHl1StepNumColor
-																		   : palette_->ptnDefStepNumColor);
-			textPainter.drawText(1, baseY, QString("%1").arg(stepNum, stepNumWidthCnt_, stepNumBase_, QChar('0')).toUpper());
-		}
-		// Step data
-		for (int x = stepNumWidth_, trackVisIdx = leftTrackVisIdx_; x < maxWidth; ++trackVisIdx) {
-			x += drawStep(forePainter, textPainter, backPainter, trackVisIdx, odrNum, stepNum, x, baseY, rowY);
+			numColor = !(stepNum % hl2Cnt_) ? palette_->ptnHl2StepNumColor
+											: !(stepNum % hl1Cnt_) ? palette_->ptnHl1StepNumColor
+																   : palette_->ptnDefStepNumColor;
 		}
-		if (foreChanged_) {
-			if (odrNum != curPos_.order)	// Mask
-				forePainter.fillRect(0, rowY, maxWidth, stepFontHeight_, palette_->ptnMaskColor);
+		stepGlyphs_.drawNumber(textPainter, 1, baseY, numColor, stepNum, stepNumWidthCnt_, stepNumBase_);
+	}
+	// Step data
+	for (int x = stepNumWidth_, trackVisIdx = leftTrackVisIdx_; x < maxWidth; ++trackVisIdx) {
+		x += drawStep(forePainter, textPainter, backPainter, trackVisIdx, orderNum, stepNum, x, baseY, rowY);
+	}
+	if (foreChanged_) {
+		if (orderNum != curPos_.order)	// Mask
+			forePainter.fillRect(0, rowY, maxWidth, stepFontHeight_, palette_->ptnMaskColor);
+	}
+}
+
+void PatternEditorPanel::redrawDirtyRows(int maxWidth)
+{
+	std::vector<int> rowYs;
+	{
+		QPainter forePainter(&forePixmap_);
+		QPainter textPainter(&textPixmap_);
+		QPainter backPainter(&backPixmap_);
+		textPainter.setFont(stepFont_);
+
+		// Redraw all layers of the invalidated rows
+		textChanged_ = true;
+		foreChanged_ = true;
+
+		int baseOffset = viewedCenterBaseY_ - viewedCenterY_;
+		for (const PatternPosition& pos : dirtyRows_) {
+			if (pos.compareRows(viewedFirstPos_) < 0 || pos.compareRows(viewedLastPos_) > 0) continue;	// Out of view
+
+			int rowY = viewedCenterY_ + stepFontHeight_ * calculateStepDistance(
+						   viewedCenterPos_.order, viewedCenterPos_.step, pos.order, pos.step);
+			QRect rowRect(0, rowY, maxWidth, stepFontHeight_);
+			for (QPainter* painter : { &forePainter, &textPainter, &backPainter }) {	// Clear row
+				painter->setCompositionMode(QPainter::CompositionMode_Source);
+				painter->fillRect(rowRect, Qt::transparent);
+				painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
+			}
+			drawRow(forePainter, textPainter, backPainter, maxWidth, pos.order, pos.step, rowY + baseOffset, rowY);
+			rowYs.push_back(rowY);
 		}
-		viewedLastPos_.setRows(odrNum, stepNum);
+
+		textChanged_ = false;
+		foreChanged_ = false;
+	}
+
+	for (const int rowY : rowYs) drawBorders(maxWidth, rowY, stepFontHeight_);
+
+	if (headerChanged_) drawHeaders(maxWidth);
+
+	QPainter mergePainter(&completePixmap_);
+	if (focusChanged_) {
+		// Only the shadow is changed in the rows out of dirtyRows_
+		mergeRows(mergePainter, QRect(0, viewedRowOffset_, completePixmap_.width(), viewedRegionHeight_));
+	}
+	else {
+		// Merge only the changed rows
+		for (const int rowY : rowYs) mergeRows(mergePainter, QRect(0, rowY, maxWidth, stepFontHeight_));
+	}
+	if (headerChanged_ || focusChanged_) mergeHeader(mergePainter);
+}
+
+void PatternEditorPanel::invalidateRow(int order, int step)
+{
+	if (order < 0 || step < 0) return;
+	dirtyRows_.push_back({ -1, -1, order, step });
+}
+
+void PatternEditorPanel::invalidateViewedRows()
+{
+	for (PatternPosition pos = viewedFirstPos_;
+		 pos.order != -1 && pos.compareRows(viewedLastPos_) <= 0;
+		 pos = calculatePositionFrom(pos.order, pos.step, 1)) {
+		invalidateRow(pos.order, pos.step);
 	}
 }
 
-void PatternEditorPanel::quickDrawRows(int maxWidth)
+bool PatternEditorPanel::quickDrawRows(int maxWidth)
 {
 	int halfRowsCnt = viewedRowCnt_ >> 1;
 	bool repaintForeAll = (curPos_.step - stepDownCount_ < 0);
@@ -758,48 +906,11 @@ void PatternEditorPanel::quickDrawRows(int maxWidth)
 	/* Redraw previous cursor step */
 	{
 		int baseY = viewedCenterBaseY_ - shift;
-		QColor rowColor = !(viewedCenterPos_.step % hl2Cnt_) ? palette_->ptnHl2StepColor
-															 : !(viewedCenterPos_.step % hl1Cnt_) ? palette_->ptnHl1StepColor
-																								  : palette_->ptnDefStepColor;
-		// Fill row
-		backPainter.fillRect(0, prevY, maxWidth, stepFontHeight_, rowColor);
-		// Step number
-		if (markerPos_.isEqualRows(viewedCenterPos_))
-			backPainter.fillRect(0, prevY, stepNumWidth_, stepFontHeight_, palette_->ptnMarkerColor);	// Paint marker
-		if (hovPos_.trackVisIdx == -2 && hovPos_.isEqualRows(viewedCenterPos_))
-			backPainter.fillRect(0, prevY, stepNumWidth_, stepFontHeight_, palette_->ptnHovCellColor);	// Paint hover
-		textPainter.setPen(!(viewedCenterPos_.step % hl2Cnt_) ? palette_->ptnHl2StepNumColor
-															  : !(viewedCenterPos_.step % hl1Cnt_) ? palette_->ptnHl1StepNumColor
-																								   : palette_->ptnDefStepNumColor);
-		textPainter.drawText(1, baseY, QString("%1").arg(viewedCenterPos_.step, stepNumWidthCnt_, stepNumBase_, QChar('0')).toUpper());
-		// Step data
-		for (int x = stepNumWidth_, trackVisIdx = leftTrackVisIdx_; x < maxWidth; ++trackVisIdx) {
-			x += drawStep(forePainter, textPainter, backPainter, trackVisIdx, viewedCenterPos_.order, viewedCenterPos_.step, x, baseY, prevY);
-		}
+		drawRow(forePainter, textPainter, backPainter, maxWidth, viewedCenterPos_.order, viewedCenterPos_.step, baseY, prevY);
 	}
 
 	/* Redraw current cursor step */
-	// Fill row
-	backPainter.fillRect(0, viewedCenterY_, maxWidth, stepFontHeight_,
-						 bt_->isJamMode() ? palette_->ptnCurStepColor : palette_->ptnCurEditStepColor);
-	// Step number
-	if (markerPos_.isEqualRows(curPos_))
-		backPainter.fillRect(0, viewedCenterY_, stepNumWidth_, stepFontHeight_, palette_->ptnMarkerColor);	// Paint marker
-	if (hovPos_.trackVisIdx == -2 && hovPos_.isEqualRows(curPos_))
-		backPainter.fillRect(0, viewedCenterY_, stepNumWidth_, stepFontHeight_, palette_->ptnHovCellColor);	// Paint hover
-	if (curPos_.step % hl2Cnt_) {
-		textPainter.setPen(!(curPos_.step % hl2Cnt_) ? palette_->ptnHl1StepNumColor
-													 : !(curPos_.step % hl1Cnt_) ? palette_->ptnHl1StepNumColor
-																				 : palette_->ptnDefStepNumColor);
-	}
-	else {
-		textPainter.setPen(palette_->ptnHl2StepNumColor);
-	}
-	textPainter.drawText(1, viewedCenterBaseY_, QString("%1").arg(curPos_.step, stepNumWidthCnt_, stepNumBase_, QChar('0')).toUpper());
-	// Step data
-	for (int x = stepNumWidth_, trackVisIdx = leftTrackVisIdx_; x < maxWidth; ++trackVisIdx) {
-		x += drawStep(forePainter, textPainter, backPainter, trackVisIdx, curPos_.order, curPos_.step, x, viewedCenterBaseY_, viewedCenterY_);
-	}
+	drawRow(forePainter, textPainter, backPainter, maxWidth, curPos_.order, curPos_.step, viewedCenterBaseY_, viewedCenterY_);
 	viewedCenterPos_ = curPos_;
 
 	/* Draw new step at last if necessary */
@@ -827,26 +938,7 @@ void PatternEditorPanel::quickDrawRows(int maxWidth)
 					bpos = tmpBpos;
 				}
 
-				QColor rowColor = !(bpos.step % hl2Cnt_) ? palette_->ptnHl2StepColor
-														 : !(bpos.step % hl1Cnt_) ? palette_->ptnHl1StepColor
-																				  : palette_->ptnDefStepColor;
-				// Fill row
-				backPainter.fillRect(0, lastY, maxWidth, stepFontHeight_, rowColor);
-				// Step number
-				if (markerPos_.isEqualRows(bpos))
-					backPainter.fillRect(0, lastY, stepNumWidth_, stepFontHeight_, palette_->ptnMarkerColor);	// Paint marker
-				if (hovPos_.trackVisIdx == -2 && hovPos_.isEqualRows(bpos))
-					backPainter.fillRect(0, lastY, stepNumWidth_, stepFontHeight_, palette_->ptnHovCellColor);	// Paint hover
-				textPainter.setPen(!(bpos.step % hl2Cnt_) ? palette_->ptnHl2StepNumColor
-														  : !(bpos.step % hl1Cnt_) ? palette_->ptnHl1StepNumColor
-																				   : palette_->ptnDefStepNumColor);
-				textPainter.drawText(1, baseY, QString("%1").arg(bpos.step, stepNumWidthCnt_, stepNumBase_, QChar('0')).toUpper());
-				// Step data
-				for (int x = stepNumWidth_, trackVisIdx = leftTrackVisIdx_; x < maxWidth; ++trackVisIdx) {
-					x += drawStep(forePainter, textPainter, backPainter, trackVisIdx, bpos.order, bpos.step, x, baseY, lastY);
-				}
-				if (bpos.order != curPos_.order)	// Mask
-					forePainter.fillRect(0, lastY, maxWidth, stepFontHeight_, palette_->ptnMaskColor);
+				drawRow(forePainter, textPainter, backPainter, maxWidth, bpos.order, bpos.step, baseY, lastY);
 
 				baseY += stepFontHeight_;
 				lastY += stepFontHeight_;
@@ -870,6 +962,8 @@ void PatternEditorPanel::quickDrawRows(int maxWidth)
 			x += w;
 		}
 	}
+
+	return repaintForeAll;
 }
 
 int PatternEditorPanel::drawStep(QPainter &forePainter, QPainter &textPainter, QPainter& backPainter, int trackVisIdx, int orderNum, int stepNum, int x, int baseY, int rowY)
@@ -895,48 +989,32 @@ int PatternEditorPanel::drawStep(QPainter &forePainter, QPainter &textPainter, Q
 		int noteNum = bt_->getStepNoteNumber(curSongNum_, trackNum, orderNum, stepNum);
 		switch (noteNum) {
 		case -1:	// None
-			textPainter.setPen(textColor);
-			textPainter.drawText(offset, baseY, "---");
+			stepGlyphs_.drawText(textPainter, offset, baseY, textColor, "---");
 			break;
 		case -2:	// Key off
 			textPainter.fillRect(offset, rowY + stepFontHeight_ * 2 / 5,
 								 toneNameWidth_, stepFontHeight_ / 5, palette_->ptnNoteColor);
 			break;
 		case -3:	// Echo 0
-			textPainter.setPen(palette_->ptnNoteColor);
-			textPainter.drawText(offset + stepFontWidth_ / 2, baseY, "^0");
+			stepGlyphs_.drawText(textPainter, offset + stepFontWidth_ / 2, baseY, palette_->ptnNoteColor, "^0");
 			break;
 		case -4:	// Echo 1
-			textPainter.setPen(palette_->ptnNoteColor);
-			textPainter.drawText(offset + stepFontWidth_ / 2, baseY, "^1");
+			stepGlyphs_.drawText(textPainter, offset + stepFontWidth_ / 2, baseY, palette_->ptnNoteColor, "^1");
 			break;
 		case -5:	// Echo 2
-			textPainter.setPen(palette_->ptnNoteColor);
-			textPainter.drawText(offset + stepFontWidth_ / 2, baseY, "^2");
+			stepGlyphs_.drawText(textPainter, offset + stepFontWidth_ / 2, baseY, palette_->ptnNoteColor, "^2");
 			break;
 		case -6:	// Echo 3
-			textPainter.setPen(palette_->ptnNoteColor);
-			textPainter.drawText(offset + stepFontWidth_ / 2, baseY, "^3");
+			stepGlyphs_.drawText(textPainter, offset + stepFontWidth_ / 2, baseY, palette_->ptnNoteColor, "^3");
 			break;
 		default:	// Convert tone name
 		{
-			QString toneStr;
-			switch (noteNum % 12) {
-			case 0:		toneStr = "C-";	break;
-			case 1:		toneStr = "C#";	break;
-			case 2:		toneStr = "D-";	break;
-			case 3:		toneStr = "D#";	break;
-			case 4:		toneStr = "E-";	break;
-			case 5:		toneStr = "F-";	break;
-			case 6:		toneStr = "F#";	break;
-			case 7:		toneStr = "G-";	break;
-			case 8:		toneStr = "G#";	break;
-			case 9:		toneStr = "A-";	break;
-			case 10:	toneStr = "A#";	break;
-			case 11:	toneStr = "B-";	break;
-			}
-			textPainter.setPen(palette_->ptnNoteColor);
-			textPainter.drawText(offset, baseY, toneStr + QString::number(noteNum / 12));
+			static const char TONE_NAMES[12][3] = {
+				"C-", "C#", "D-", "D#", "E-", "F-", "F#", "G-", "G#", "A-", "A#", "B-"
+			};
+			const char* tone = TONE_NAMES[noteNum % 12];
+			char toneStr[] = { tone[0], tone[1], static_cast<char>('0' + noteNum / 12), '\0' };
+			stepGlyphs_.drawText(textPainter, offset, baseY, palette_->ptnNoteColor, toneStr);
 			break;
 		}
 		}
@@ -955,15 +1033,14 @@ int PatternEditorPanel::drawStep(QPainter &forePainter, QPainter &textPainter, Q
 	if (textChanged_) {
 		int instNum = bt_->getStepInstrument(curSongNum_, trackNum, orderNum, stepNum);
 		if (instNum == -1) {
-			textPainter.setPen(textColor);
-			textPainter.drawText(offset, baseY, "--");
+			stepGlyphs_.drawText(textPainter, offset, baseY, textColor, "--");
 		}
 		else {
 			std::unique_ptr<AbstractInstrument> inst = bt_->getInstrument(instNum);
-			textPainter.setPen((inst != nullptr && src == inst->getSoundSource())
-							   ? palette_->ptnInstColor
-							   : palette_->ptnErrorColor);
-			textPainter.drawText(offset, baseY, QString("%1").arg(instNum, 2, 16, QChar('0')).toUpper());
+			const QColor& instColor = (inst != nullptr && src == inst->getSoundSource())
+									  ? palette_->ptnInstColor
+									  : palette_->ptnErrorColor;
+			stepGlyphs_.drawNumber(textPainter, offset, baseY, instColor, instNum, 2);
 		}
 	}
 	offset += instWidth_ +  widthSpaceDbl_;
@@ -980,8 +1057,7 @@ int PatternEditorPanel::drawStep(QPainter &forePainter, QPainter &textPainter, Q
 	if (textChanged_) {
 		int vol = bt_->getStepVolume(curSongNum_, trackNum, orderNum, stepNum);
 		if (vol == -1) {
-			textPainter.setPen(textColor);
-			textPainter.drawText(offset, baseY, "--");
+			stepGlyphs_.drawText(textPainter, offset, baseY, textColor, "--");
 		}
 		else {
 			int volLim = 0;	// Dummy set
@@ -991,11 +1067,11 @@ int PatternEditorPanel::drawStep(QPainter &forePainter, QPainter &textPainter, Q
 			case SoundSource::RHYTHM:		volLim = 0x20;	break;
 			case SoundSource::ADPCM:	volLim = 0x100;	break;
 			}
-			textPainter.setPen((vol < volLim) ? palette_->ptnVolColor : palette_->ptnErrorColor);
+			const QColor& volColor = (vol < volLim) ? palette_->ptnVolColor : palette_->ptnErrorColor;
 			if (src == SoundSource::FM && vol < volLim && config_->getReverseFMVolumeOrder()) {
 				vol = volLim - vol - 1;
 			}
-			textPainter.drawText(offset, baseY, QString("%1").arg(vol, 2, 16, QChar('0')).toUpper());
+			stepGlyphs_.drawNumber(textPainter, offset, baseY, volColor, vol, 2);
 		}
 	}
 	offset += volWidth_ +  widthSpaceDbl_;
@@ -1012,18 +1088,10 @@ int PatternEditorPanel::drawStep(QPainter &forePainter, QPainter &textPainter, Q
 				&& isSelectedCell(trackVisIdx, pos.colInTrack, orderNum, stepNum))	// Paint selected
 			backPainter.fillRect(offset - widthSpace_, rowY, effIDWidth_ + widthSpace_, stepFontHeight_, palette_->ptnSelCellColor);
 		std::string effId;
-		QString effStr;
 		if (textChanged_) {
 			effId = bt_->getStepEffectID(curSongNum_, trackNum, orderNum, stepNum, i);
-			effStr = QString::fromStdString(effId);
-			if (effStr == "--") {
-				textPainter.setPen(textColor);
-				textPainter.drawText(offset, baseY, effStr);
-			}
-			else {
-				textPainter.setPen(palette_->ptnEffColor);
-				textPainter.drawText(offset, baseY, effStr);
-			}
+			stepGlyphs_.drawText(textPainter, offset, baseY,
+								 (effId == "--") ? textColor : palette_->ptnEffColor, effId.c_str());
 		}
 		offset += effIDWidth_;
 		++pos.colInTrack;
@@ -1039,11 +1107,9 @@ int PatternEditorPanel::drawStep(QPainter &forePainter, QPainter &textPainter, Q
 		if (textChanged_) {
 			int effVal = bt_->getStepEffectValue(curSongNum_, trackNum, orderNum, stepNum, i);
 			if (effVal == -1) {
-				textPainter.setPen(textColor);
-				textPainter.drawText(offset, baseY, "--");
+				stepGlyphs_.drawText(textPainter, offset, baseY, textColor, "--");
 			}
 			else {
-				textPainter.setPen(palette_->ptnEffColor);
 				switch (Effect::toEffectType(src, effId)) {
 				case EffectType::VolumeDelay:
 					if (src == SoundSource::FM && config_->getReverseFMVolumeOrder() && effVal < 0x80)
@@ -1056,7 +1122,7 @@ int PatternEditorPanel::drawStep(QPainter &forePainter, QPainter &textPainter, Q
 				default:
 					break;
 				}
-				textPainter.drawText(offset, baseY, QString("%1").arg(effVal, 2, 16, QChar('0')).toUpper());
+				stepGlyphs_.drawNumber(textPainter, offset, baseY, palette_->ptnEffColor, effVal, 2);
 			}
 		}
 		offset += effValWidth_ + widthSpaceDbl_;
@@ -1102,16 +1168,17 @@ void PatternEditorPanel::drawHeaders(int maxWidth)
 	}
 }
 
-void PatternEditorPanel::drawBorders(int maxWidth)
+void PatternEditorPanel::drawBorders(int maxWidth, int top, int height)
 {
 	QPainter painter(&backPixmap_);
 	painter.setPen(palette_->ptnBorderColor);
-	painter.drawLine(stepNumWidth_, 0, stepNumWidth_, backPixmap_.height());
+	int bottom = (height < 0) ? backPixmap_.height() : (top + height - 1);
+	painter.drawLine(stepNumWidth_, top, stepNumWidth_, bottom);
 	size_t trackVisIdx = static_cast<size_t>(leftTrackVisIdx_);
 	for (int x = stepNumWidth_; trackVisIdx < rightEffn_.size(); ) {
 		x += (baseTrackWidth_ + effWidth_ * rightEffn_.at(trackVisIdx));
 		if (x > maxWidth) break;
-		painter.drawLine(x, 0, x, backPixmap_.height());
+		painter.drawLine(x, top, x, bottom);
 		++trackVisIdx;
 	}
 }
@@ -1451,8 +1518,10 @@ int PatternEditorPanel::getFullColmunSize() const
 
 void PatternEditorPanel::updatePositionByStepUpdate(bool isFirstUpdate, bool forceJump, bool trackChanged)
 {
-	if (!forceJump && !config_->getFollowMode()) {	// Repaint only background
-		backChanged_ = true;
+	if (!forceJump && !config_->getFollowMode()) {	// Repaint only the previous and new playing rows
+		invalidateRow(playPos_.order, playPos_.step);
+		playPos_.setRows(bt_->getPlayingOrderNumber(), bt_->getPlayingStepNumber());
+		invalidateRow(playPos_.order, playPos_.step);
 		repaint();
 		return;
 	}
@@ -1564,7 +1633,7 @@ void PatternEditorPanel::setStepKeyOn(Note note, int octave)
 	if (octave < 8) {
 		bt_->setStepNote(curSongNum_, visTracks_.at(curPos_.trackVisIdx), curPos_.order, curPos_.step, octave, note,
 						 config_->getInstrumentMask(), config_->getVolumeMask());
-		comStack_.lock()->push(new SetKeyOnToStepQtCommand(this));
+		comStack_.lock()->push(new SetKeyOnToStepQtCommand(this, curPos_));
 		if (!bt_->isPlaySong() || !bt_->isFollowPlay()) moveCursorToDown(editableStepCnt_);
 	}
 }
@@ -1774,77 +1843,17 @@ void PatternEditorPanel::copySelectedCells()
 {
 	if (selLeftAbovePos_.order == -1) return;
 
-	int r = visTracks_.at(selRightBelowPos_.trackVisIdx) * 11 + selRightBelowPos_.colInTrack;
-	int l = visTracks_.at(selLeftAbovePos_.trackVisIdx) * 11 + selLeftAbovePos_.colInTrack;
-	int w = 1 + r - l;	// Real selected region width
-	int h = 1 + calculateStepDistance(selLeftAbovePos_.order, selLeftAbovePos_.step,
-									  selRightBelowPos_.order, selRightBelowPos_.step);
-	QString str = QString("PATTERN_COPY:%1,%2,%3,")
-				  .arg(QString::number(selLeftAbovePos_.colInTrack),
-					   QString::number(w),
-					   QString::number(h));
-	// NOTE: After this line, PatternPosition.trackVisIdx indecates a real track number.
-	PatternPosition pos = {
-		selLeftAbovePos_.trackVisIdx, selLeftAbovePos_.colInTrack,
-		selLeftAbovePos_.order, selLeftAbovePos_.step
-	};
-	while (true) {
-		int trackIdx = visTracks_.at(pos.trackVisIdx);
-		switch (pos.colInTrack) {
-		case 0:
-			str += QString::number(bt_->getStepNoteNumber(curSongNum_, trackIdx, pos.order, pos.step));
-			break;
-		case 1:
-			str += QString::number(bt_->getStepInstrument(curSongNum_, trackIdx, pos.order, pos.step));
-			break;
-		case 2:
-			str += QString::number(bt_->getStepVolume(curSongNum_, trackIdx, pos.order, pos.step));
-			break;
-		case 3:
-			str += QString::fromStdString(bt_->getStepEffectID(curSongNum_, trackIdx, pos.order, pos.step, 0));
-			break;
-		case 4:
-			str += QString::number(bt_->getStepEffectValue(curSongNum_, trackIdx, pos.order, pos.step, 0));
-			break;
-		case 5:
-			str += QString::fromStdString(bt_->getStepEffectID(curSongNum_, trackIdx, pos.order, pos.step, 1));
-			break;
-		case 6:
-			str += QString::number(bt_->getStepEffectValue(curSongNum_, trackIdx, pos.order, pos.step, 1));
-			break;
-		case 7:
-			str += QString::fromStdString(bt_->getStepEffectID(curSongNum_, trackIdx, pos.order, pos.step, 2));
-			break;
-		case 8:
-			str += QString::number(bt_->getStepEffectValue(curSongNum_, trackIdx, pos.order, pos.step, 2));
-			break;
-		case 9:
-			str += QString::fromStdString(bt_->getStepEffectID(curSongNum_, trackIdx, pos.order, pos.step, 3));
-			break;
-		case 10:
-			str += QString::number(bt_->getStepEffectValue(curSongNum_, trackIdx, pos.order, pos.step, 3));
-			break;
-		}
-
-		if (pos.isEqualCols(selRightBelowPos_)) {
-			if (pos.isEqualRows(selRightBelowPos_)) {
-				break;
-			}
-			else {
-				pos.setCols(selLeftAbovePos_.trackVisIdx, selLeftAbovePos_.colInTrack);
-				++pos.step;
-			}
-		}
-		else {
-			++pos.colInTrack;
-			pos.trackVisIdx += (pos.colInTrack / 11);
-			pos.colInTrack %= 11;
-		}
-
-		str += ",";
-	}
+	setPatternCellsToClipboard(getSelectedCells(), false);
+}
 
-	QApplication::clipboard()->setText(str);
+PatternClipboardCells PatternEditorPanel::getSelectedCells() const
+{
+	PatternCellBlock block = bt_->getPatternCells(
+								 curSongNum_, visTracks_.at(selLeftAbovePos_.trackVisIdx), selLeftAbovePos_.colInTrack,
+								 selLeftAbovePos_.order, selLeftAbovePos_.step,
+								 visTracks_.at(selRightBelowPos_.trackVisIdx), selRightBelowPos_.colInTrack,
+								 selRightBelowPos_.step);
+	return { selLeftAbovePos_.colInTrack, block.getWidth(), block.unpack() };
 }
 
 void PatternEditorPanel::eraseSelectedCells()
@@ -1857,12 +1866,9 @@ void PatternEditorPanel::eraseSelectedCells()
 
 void PatternEditorPanel::pasteCopiedCells(const PatternPosition& cursorPos)
 {
-	int sCol = 0;
-	PatternCells cells = decodeCells(QApplication::clipboard()->text(), sCol);
-	PatternPosition pos = getPasteLeftAbovePosition(sCol, cursorPos, cells.front().size());
-	if (config_->getPasteMode() == Configuration::FILL && selLeftAbovePos_.order != -1) {
-		cells = compandPasteCells(pos, cells);
-	}
+	PatternPosition pos;
+	PatternCellBlock cells;
+	if (!getPasteCells(cursorPos, pos, cells)) return;
 
 	bt_->pastePatternCells(
 				curSongNum_, visTracks_.at(pos.trackVisIdx), pos.colInTrack, pos.order, pos.step, std::move(cells));
@@ -1871,12 +1877,9 @@ void PatternEditorPanel::pasteCopiedCells(const PatternPosition& cursorPos)
 
 void PatternEditorPanel::pasteMixCopiedCells(const PatternPosition& cursorPos)
 {
-	int sCol = 0;
-	PatternCells cells = decodeCells(QApplication::clipboard()->text(), sCol);
-	PatternPosition pos = getPasteLeftAbovePosition(sCol, cursorPos, cells.front().size());
-	if (config_->getPasteMode() == Configuration::FILL && selLeftAbovePos_.order != -1) {
-		cells = compandPasteCells(pos, cells);
-	}
+	PatternPosition pos;
+	PatternCellBlock cells;
+	if (!getPasteCells(cursorPos, pos, cells)) return;
 
 	bt_->pasteMixPatternCells(
 				curSongNum_, visTracks_.at(pos.trackVisIdx), pos.colInTrack, pos.order, pos.step, std::move(cells));
@@ -1885,12 +1888,9 @@ void PatternEditorPanel::pasteMixCopiedCells(const PatternPosition& cursorPos)
 
 void PatternEditorPanel::pasteOverwriteCopiedCells(const PatternPosition& cursorPos)
 {
-	int sCol = 0;
-	PatternCells cells = decodeCells(QApplication::clipboard()->text(), sCol);
-	PatternPosition pos = getPasteLeftAbovePosition(sCol, cursorPos, cells.front().size());
-	if (config_->getPasteMode() == Configuration::FILL && selLeftAbovePos_.order != -1) {
-		cells = compandPasteCells(pos, cells);
-	}
+	PatternPosition pos;
+	PatternCellBlock cells;
+	if (!getPasteCells(cursorPos, pos, cells)) return;
 
 	bt_->pasteOverwritePatternCells(
 				curSongNum_, visTracks_.at(pos.trackVisIdx), pos.colInTrack, pos.order, pos.step, std::move(cells));
@@ -1899,47 +1899,26 @@ void PatternEditorPanel::pasteOverwriteCopiedCells(const PatternPosition& cursor
 
 void PatternEditorPanel::pasteInsertCopiedCells(const PatternPosition& cursorPos)
 {
-	int sCol = 0;
-	PatternCells cells = decodeCells(QApplication::clipboard()->text(), sCol);
-	PatternPosition pos = getPasteLeftAbovePosition(sCol, cursorPos, cells.front().size());
-	if (config_->getPasteMode() == Configuration::FILL && selLeftAbovePos_.order != -1) {
-		cells = compandPasteCells(pos, cells);
-	}
+	PatternPosition pos;
+	PatternCellBlock cells;
+	if (!getPasteCells(cursorPos, pos, cells)) return;
 
 	bt_->pasteInsertPatternCells(
 				curSongNum_, visTracks_.at(pos.trackVisIdx), pos.colInTrack, pos.order, pos.step, std::move(cells));
 	comStack_.lock()->push(new PasteInsertCopiedDataToPatternQtCommand(this));
 }
 
-PatternEditorPanel::PatternCells PatternEditorPanel::decodeCells(QString str, int& startCol)
+bool PatternEditorPanel::getPasteCells(const PatternPosition& cursorPos, PatternPosition& pos, PatternCellBlock& cells)
 {
-	str.remove(QRegularExpression("PATTERN_(COPY|CUT):"));
-	QString hdRe = "^([0-9]+),([0-9]+),([0-9]+),";
-	QRegularExpression re(hdRe);
-	QRegularExpressionMatch match = re.match(str);
-	startCol = match.captured(1).toInt();
-	int w = match.captured(2).toInt();
-	size_t h = match.captured(3).toUInt();
-	str.remove(re);
+	PatternClipboardCells clip;
+	if (!getPatternCellsFromClipboard(clip)) return false;
 
-	std::vector<std::vector<std::string>> cells;
-	re = QRegularExpression("^([^,]+),");
-	for (size_t i = 0; i < h; ++i) {
-		cells.emplace_back();
-		for (int j = 0; j < w; ++j) {
-			match = re.match(str);
-			if (match.hasMatch()) {
-				cells.at(i).push_back(match.captured(1).toStdString());
-				str.remove(re);
-			}
-			else {
-				cells.at(i).push_back(str.toStdString());
-				break;
-			}
-		}
+	pos = getPasteLeftAbovePosition(clip.startColumn, cursorPos, clip.width);
+	if (config_->getPasteMode() == Configuration::FILL && selLeftAbovePos_.order != -1) {
+		compandPasteCells(pos, clip);
 	}
-
-	return cells;
+	cells = PatternCellBlock(clip.cells, clip.width, pos.colInTrack);
+	return true;
 }
 
 PatternPosition PatternEditorPanel::getPasteLeftAbovePosition(
@@ -1967,52 +1946,40 @@ void PatternEditorPanel::cutSelectedCells()
 {
 	if (selLeftAbovePos_.order == -1) return;
 
-	copySelectedCells();
+	setPatternCellsToClipboard(getSelectedCells(), true);
 	eraseSelectedCells();
-	QString str = QApplication::clipboard()->text();
-	str.replace("COPY", "CUT");
-	QApplication::clipboard()->setText(str);
 }
 
-PatternEditorPanel::PatternCells PatternEditorPanel::compandPasteCells(const PatternPosition& laPos, const PatternCells& cells)
+void PatternEditorPanel::compandPasteCells(const PatternPosition& laPos, PatternClipboardCells& cells)
 {
-	PatternCells newCells;
-	int ow = cells.front().size();
-	int oh = cells.size();
+	int ow = static_cast<int>(cells.width);
+	size_t oh = cells.getHeight();
 	int l = laPos.trackVisIdx * 11 + laPos.colInTrack;
 	int r = selRightBelowPos_.trackVisIdx * 11 + selRightBelowPos_.colInTrack;
 	int w = r - l + 1;	// Real selected region width
 	size_t h = static_cast<size_t>(calculateStepDistance(laPos.order, laPos.step,
 														 selRightBelowPos_.order, selRightBelowPos_.step) + 1);
 	int bw = ((ow - 1) / 11 + 1) * 11;
-	size_t padSize = bw - ow;
-	std::vector<std::string> pad(padSize);
+	int padSize = bw - ow;
+	std::vector<uint16_t> pad(static_cast<size_t>(padSize));
 	int lc = (laPos.colInTrack + ow) % 11;
-	for (size_t i = 0; i < padSize; ++i) {
-		switch (lc) {
-		case 3:
-		case 5:
-		case 7:
-		case 9:
-			pad[i] = "--";
-			break;
-		default:
-			pad[i] = "-1";
-			break;
-		}
+	for (uint16_t& cell : pad) {
+		cell = PatternCellBlock::getEmptyCell(lc);
 		lc = (lc + 1) % 11;
 	}
+	std::vector<uint16_t> newCells(static_cast<size_t>(w) * h);
 	for (size_t i = 0; i < h; ++i) {
-		newCells.emplace_back(w);
-		auto&& rowBeginIt = newCells.back().begin();
+		auto rowBeginIt = newCells.begin() + static_cast<int>(i) * w;
+		auto srcIt = cells.cells.cbegin() + static_cast<int>(i % oh) * ow;
 		for (int dw = w, p = 0; dw > 0; dw -= bw, p += bw) {
 			int ws = std::min(ow, dw);
-			std::copy_n(cells.at(i % oh).begin(), ws, rowBeginIt + p);
-			std::copy_n(pad.begin(), std::min(dw - ws, static_cast<int>(padSize)), rowBeginIt + p + ws);
+			std::copy_n(srcIt, ws, rowBeginIt + p);
+			std::copy_n(pad.cbegin(), std::min(dw - ws, padSize), rowBeginIt + p + ws);
 		}
 	}
 
-	return newCells;
+	cells.width = static_cast<size_t>(w);
+	cells.cells = std::move(newCells);
 }
 
 void PatternEditorPanel::transposeNote(const PatternPosition& startPos, const PatternPosition& endPos, int seminote)
@@ -2115,6 +2082,7 @@ void PatternEditorPanel::showPatternContextMenu(const PatternPosition& pos, cons
 	QAction* undo = menu.addAction(tr("&Undo"));
 	undo->setIcon(QIcon(":/icon/undo"));
 	QObject::connect(undo, &QAction::triggered, this, [&]() {
+		if (!bt_->canUndo()) return;	// The oldest commands may have been dropped from the history
 		bt_->undo();
 		comStack_.lock()->undo();
 	});
@@ -2269,8 +2237,7 @@ void PatternEditorPanel::showPatternContextMenu(const PatternPosition& pos, cons
 		cinVal->setEnabled(false);
 	}
 	else {
-		QString clipText = QApplication::clipboard()->text();
-		if (!clipText.startsWith("PATTERN_COPY") && !clipText.startsWith("PATTERN_CUT")) {
+		if (!hasPatternCellsInClipboard()) {
 			paste->setEnabled(false);
 			pasteMix->setEnabled(false);
 			pasteOver->setEnabled(false);
@@ -2296,7 +2263,7 @@ void PatternEditorPanel::showPatternContextMenu(const PatternPosition& pos, cons
 			cinVal->setEnabled(false);
 		}
 	}
-	if (!comStack_.lock()->canUndo()) {
+	if (!comStack_.lock()->canUndo() || !bt_->canUndo()) {
 		undo->setEnabled(false);
 	}
 	if (!comStack_.lock()->canRedo()) {
@@ -2470,11 +2437,11 @@ void PatternEditorPanel::onDeletePressed()
 			break;
 		case 1:
 			bt_->eraseStepInstrument(curSongNum_, visTracks_.at(curPos_.trackVisIdx), curPos_.order, curPos_.step);
-			comStack_.lock()->push(new EraseInstrumentInStepQtCommand(this));
+			comStack_.lock()->push(new EraseInstrumentInStepQtCommand(this, curPos_));
 			break;
 		case 2:
 			bt_->eraseStepVolume(curSongNum_, visTracks_.at(curPos_.trackVisIdx), curPos_.order, curPos_.step);
-			comStack_.lock()->push(new EraseVolumeInStepQtCommand(this));
+			comStack_.lock()->push(new EraseVolumeInStepQtCommand(this, curPos_));
 			break;
 		case 3:
 		case 5:
@@ -3176,7 +3143,16 @@ bool PatternEditorPanel::mouseHoverd(QHoverEvent *event)
 		}
 	}
 
-	if (hovPos_ != oldPos) redrawByHoverChanged();
+	if (hovPos_ != oldPos) {
+		if (oldPos.order != -2 && hovPos_.order != -2) {	// Only the hovered rows are changed
+			invalidateRow(oldPos.order, oldPos.step);
+			invalidateRow(hovPos_.order, hovPos_.step);
+			repaint();
+		}
+		else {
+			redrawByHoverChanged();
+		}
+	}
 
 	return true;
 }
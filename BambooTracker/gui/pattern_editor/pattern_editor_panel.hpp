@@ -48,7 +48,9 @@
 #include "configuration.hpp"
 #include "song.hpp"
 #include "gui/pattern_editor/pattern_position.hpp"
+#include "gui/pattern_editor/pattern_clipboard.hpp"
 #include "gui/color_palette.hpp"
+#include "gui/glyph_atlas.hpp"
 #include "misc.hpp"
 
 class PatternEditorPanel : public QWidget
@@ -77,6 +79,7 @@ public:
 	void redrawByFocusChanged();
 	void redrawByHoverChanged();
 	void redrawByMaskChanged();
+	void redrawByCellChanged(const PatternPosition& pos);
 	void redrawPatterns();
 	void redrawAll();
 
@@ -176,6 +179,7 @@ private:
 	std::shared_ptr<ColorPalette> palette_;
 
 	QFont stepFont_, headerFont_;
+	GlyphAtlas stepGlyphs_;
 	int stepFontWidth_, stepFontHeight_, stepFontAscent_, stepFontLeading_;
 	int headerFontAscent_;
 
@@ -221,11 +225,21 @@ private:
 	int viewedRegionHeight_;
 	int viewedRowsHeight_, viewedRowOffset_, viewedCenterY_, viewedCenterBaseY_;
 	PatternPosition viewedFirstPos_, viewedCenterPos_, viewedLastPos_;
+	PatternPosition playPos_;
+	/// Rows to be redrawn without a full redraw
+	std::vector<PatternPosition> dirtyRows_;
 
 	bool backChanged_, textChanged_, foreChanged_, headerChanged_, focusChanged_, followModeChanged_;
 	bool hasFocussedBefore_;
 	int stepDownCount_;
 
+	// Redraw time statistics in microseconds, reported every FRAME_TIME_REPORT_CNT_ frames
+	// when BT_PATTERN_REDRAW_STATS is set. "full" redraws all rows in every frame to compare.
+	bool isFrameTimeReported_, isFullRedrawForced_;
+	qint64 frameTimeSum_, frameTimeMax_;
+	int frameCnt_;
+	static constexpr int FRAME_TIME_REPORT_CNT_ = 120;
+
 	std::atomic_bool repaintable_;	// Recurrensive repaint guard
 	std::atomic_int repaintingCnt_;
 	std::atomic_bool isInitedFirstMod_;
@@ -243,13 +257,26 @@ private:
 	void updateSizes();
 	void initDisplay();
 	void drawPattern(const QRect& rect);
+	void updateFrameTime(qint64 us);
+	void redrawAllRows(int maxWidth);
+	/// Redraw only the rows in dirtyRows_ and the header if needed
+	void redrawDirtyRows(int maxWidth);
+	/// Scroll the pixmaps by stepDownCount_ rows and redraw only the new rows
+	void scrollRows(int maxWidth);
+	void mergeRows(QPainter& mergePainter, const QRect& rowsRect);
+	void mergeHeader(QPainter& mergePainter);
+	void invalidateRow(int order, int step);
+	void invalidateViewedRows();
 	void drawRows(int maxWidth);
-	void quickDrawRows(int maxWidth);
+	/// Return:
+	///		true if the foreground is repainted entirely
+	bool quickDrawRows(int maxWidth);
+	void drawRow(QPainter& forePainter, QPainter& textPainter, QPainter& backPainter, int maxWidth, int orderNum, int stepNum, int baseY, int rowY);
 	/// Return:
 	///		track width
 	int drawStep(QPainter& forePainter, QPainter& textPainter, QPainter& backPainter, int trackVisIdx, int orderNum, int stepNum, int x, int baseY, int rowY);
 	void drawHeaders(int maxWidth);
-	void drawBorders(int maxWidth);
+	void drawBorders(int maxWidth, int top = 0, int height = -1);
 	void drawShadow();
 
 	// NOTE: Calculated by visible tracks
@@ -300,11 +327,12 @@ private:
 	void pasteMixCopiedCells(const PatternPosition& cursorPos);
 	void pasteOverwriteCopiedCells(const PatternPosition& cursorPos);
 	void pasteInsertCopiedCells(const PatternPosition& cursorPos);
-	using PatternCells = std::vector<std::vector<std::string>>;
-	PatternCells decodeCells(QString str, int& startCol);
+	PatternClipboardCells getSelectedCells() const;
+	/// Read the cells in the clipboard and decide the position to paste them
+	bool getPasteCells(const PatternPosition& cursorPos, PatternPosition& pos, PatternCellBlock& cells);
 	PatternPosition getPasteLeftAbovePosition(
 			int pasteCol, const PatternPosition& cursorPos, size_t cellW) const;
-	PatternCells compandPasteCells(const PatternPosition& laPos, const PatternCells& cells);
+	void compandPasteCells(const PatternPosition& laPos, PatternClipboardCells& cells);
 
 	void transposeNote(const PatternPosition& startPos, const PatternPosition& endPos, int seminote);
 	void changeValuesInPattern(const PatternPosition& startPos, const PatternPosition& endPos, int value);
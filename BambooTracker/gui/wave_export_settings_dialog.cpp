@@ -37,6 +37,10 @@ WaveExportSettingsDialog::WaveExportSettingsDialog(QWidget *parent) :
 	ui->sampleRateComboBox->addItem("44100Hz", 44100);
 	ui->sampleRateComboBox->addItem("48000Hz", 48000);
 	ui->sampleRateComboBox->addItem("55466Hz", 55466);
+
+	ui->sampleFormatComboBox->addItem(tr("16-bit"), static_cast<int>(WavWriter::SampleFormat::Int16));
+	ui->sampleFormatComboBox->addItem(tr("24-bit"), static_cast<int>(WavWriter::SampleFormat::Int24));
+	ui->sampleFormatComboBox->addItem(tr("32-bit float"), static_cast<int>(WavWriter::SampleFormat::Float32));
 }
 
 WaveExportSettingsDialog::~WaveExportSettingsDialog()
@@ -53,3 +57,13 @@ int WaveExportSettingsDialog::getLoopCount() const
 {
 	return ui->loopSpinBox->value();
 }
+
+WavWriter::SampleFormat WaveExportSettingsDialog::getSampleFormat() const
+{
+	return static_cast<WavWriter::SampleFormat>(ui->sampleFormatComboBox->currentData().toInt());
+}
+
+bool WaveExportSettingsDialog::isStemExportEnabled() const
+{
+	return ui->stemsCheckBox->isChecked();
+}
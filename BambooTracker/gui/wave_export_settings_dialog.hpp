@@ -27,6 +27,7 @@
 #define WAVE_EXPORT_SETTINGS_DIALOG_HPP
 
 #include <QDialog>
+#include "wav_writer.hpp"
 
 namespace Ui {
 	class WaveExportSettingsDialog;
@@ -42,6 +43,8 @@ public:
 
 	int getSampleRate() const;
 	int getLoopCount() const;
+	WavWriter::SampleFormat getSampleFormat() const;
+	bool isStemExportEnabled() const;
 
 private:
 	Ui::WaveExportSettingsDialog *ui;
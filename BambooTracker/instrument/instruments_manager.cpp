@@ -906,6 +906,11 @@ void InstrumentsManager::setPropertyFindMode(bool unedited)
 	regardingUnedited_ = unedited;
 }
 
+bool InstrumentsManager::getPropertyFindMode() const
+{
+	return regardingUnedited_;
+}
+
 //----- FM methods -----
 void InstrumentsManager::setInstrumentFMEnvelope(int instNum, int envNum)
 {
@@ -75,6 +75,7 @@ public:
 	std::vector<std::vector<int>> checkDuplicateInstruments() const;
 
 	void setPropertyFindMode(bool unedited);
+	bool getPropertyFindMode() const;
 
 private:
 	std::array<std::shared_ptr<AbstractInstrument>, 128> insts_;
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "adpcm_sample_importer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "resampler.hpp"
+#include "chip_misc.hpp"
+#include "codec/ymb_codec.hpp"
+
+namespace
+{
+inline int32_t toInt16Range(float v)
+{
+	return static_cast<int32_t>(std::lrint(std::min(std::max(v * 32768.f, -32768.f), 32767.f)));
+}
+
+/// Feed PCM blocks to the ADPCM encoder keeping its state
+class ADPCMEncoder
+{
+public:
+	explicit ADPCMEncoder(std::vector<uint8_t>& dest) : dest_(dest), pos_(0), history_(0), stepSize_(127) {}
+
+	/// [nSamples] must be even except for the last block
+	void encode(std::vector<int16_t>& pcm, size_t nSamples)
+	{
+		codec::ymb_encode_block(pcm.data(), dest_.data() + pos_, static_cast<long>(nSamples), &history_, &stepSize_);
+		pos_ += nSamples / 2;
+	}
+
+private:
+	std::vector<uint8_t>& dest_;
+	size_t pos_;
+	int16_t history_, stepSize_;
+};
+}
+
+constexpr size_t ADPCMSampleImporter::BLOCK_SIZE_;
+
+std::vector<uint8_t> ADPCMSampleImporter::importWav(WavReader& reader, uint32_t rate, size_t maxSize)
+{
+	const uint32_t srcRate = reader.getSampleRate();
+	if (!rate) rate = srcRate;
+	const size_t nSrc = reader.getSampleCount();
+	const uint64_t nDest64 = (static_cast<uint64_t>(nSrc) * rate + srcRate - 1) / srcRate;
+	if ((nDest64 + 1) / 2 > maxSize) throw std::length_error("Sample is larger than the ADPCM memory");
+	const size_t nDest = static_cast<size_t>(nDest64);
+
+	std::vector<uint8_t> adpcm((nDest + 1) / 2);
+	ADPCMEncoder encoder(adpcm);
+	std::vector<int16_t> pcm(BLOCK_SIZE_);
+
+	if (rate == srcRate) {
+		std::vector<float> in(BLOCK_SIZE_);
+		size_t n;
+		while ((n = reader.readMonoSamples(in.data(), BLOCK_SIZE_))) {
+			std::transform(in.begin(), in.begin() + static_cast<int>(n), pcm.begin(),
+						   [](float v) { return static_cast<int16_t>(toInt16Range(v)); });
+			encoder.encode(pcm, n);
+		}
+		return adpcm;
+	}
+
+	// Source frames in a block are fixed so that the internal buffers of the resampler do not overflow
+	chip::SincResampler resampler;
+	resampler.init(static_cast<int>(srcRate), static_cast<int>(rate), 0);
+	const size_t nOutBlock = std::max<size_t>(
+								 std::min<size_t>(static_cast<uint64_t>(BLOCK_SIZE_) * rate / srcRate, BLOCK_SIZE_) & ~size_t(1), 2);
+	std::vector<float> in(chip::SMPL_BUF_SIZE_);
+	std::vector<sample> src(chip::SMPL_BUF_SIZE_);
+	sample* srcs[2] = { src.data(), nullptr };
+	resampler.setMonaural(true);
+	for (size_t rest = nDest; rest; ) {
+		size_t n = std::min(rest, nOutBlock);
+		size_t nIn = resampler.calculateInternalSampleSize(n);
+		size_t nRead = reader.readMonoSamples(in.data(), nIn);
+		std::transform(in.begin(), in.begin() + static_cast<int>(nRead), src.begin(), toInt16Range);
+		std::fill(src.begin() + static_cast<int>(nRead), src.begin() + static_cast<int>(nIn), 0);	// Flush the filter at the end
+
+		sample** out = resampler.interpolate(srcs, n, nIn);
+		std::transform(out[chip::LEFT], out[chip::LEFT] + n, pcm.begin(), [](sample v) {
+			return static_cast<int16_t>(std::min(std::max(v, -32768), 32767));
+		});
+		encoder.encode(pcm, n);
+		rest -= n;
+	}
+	return adpcm;
+}
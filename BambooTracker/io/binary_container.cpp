@@ -27,32 +27,47 @@
 #include <algorithm>
 #include <iterator>
 #include <utility>
+#include <stdexcept>
 
 BinaryContainer::BinaryContainer(size_t defCapacity)
-	: isLE_(true)
+	: extBuf_(nullptr),
+	  extSize_(0),
+	  isLE_(true)
 {
 	if (defCapacity) reserve(defCapacity);
 }
 
 BinaryContainer::BinaryContainer(std::vector<char> buf)
-	: buf_(buf),
+	: buf_(std::move(buf)),
+	  extBuf_(nullptr),
+	  extSize_(0),
+	  isLE_(true)
+{
+}
+
+BinaryContainer::BinaryContainer(const char* data, size_t size)
+	: extBuf_(data),
+	  extSize_(size),
 	  isLE_(true)
 {
 }
 
 size_t BinaryContainer::size() const
 {
-	return buf_.size();
+	return extBuf_ ? extSize_ : buf_.size();
 }
 
 void BinaryContainer::clear()
 {
+	extBuf_ = nullptr;
+	extSize_ = 0;
 	buf_.clear();
 	buf_.shrink_to_fit();
 }
 
 void BinaryContainer::reserve(size_t capacity)
 {
+	detach();
 	buf_.reserve(capacity);
 }
 
@@ -68,223 +83,262 @@ bool BinaryContainer::isLittleEndian() const
 
 void BinaryContainer::appendInt8(const int8_t v)
 {
+	detach();
 	buf_.push_back(static_cast<char>(v));
 }
 
 void BinaryContainer::appendUint8(const uint8_t v)
 {
+	detach();
 	buf_.push_back(static_cast<char>(v));
 }
 
 void BinaryContainer::appendInt16(const int16_t v)
 {
-	append({
-			   static_cast<char>(0x00ff & v),
-			   static_cast<char>(v >> 8),
-		   });
+	const char a[] = {
+		static_cast<char>(0x00ff & v),
+		static_cast<char>(v >> 8),
+	};
+	append(a, sizeof(a));
 }
 
 void BinaryContainer::appendUint16(const uint16_t v)
 {
-	append({
-			   static_cast<char>(0x00ff & v),
-			   static_cast<char>(v >> 8),
-		   });
+	const char a[] = {
+		static_cast<char>(0x00ff & v),
+		static_cast<char>(v >> 8),
+	};
+	append(a, sizeof(a));
 }
 
 void BinaryContainer::appendInt32(const int32_t v)
 {
-	append({
-			   static_cast<char>(0x000000ff & v),
-			   static_cast<char>(0x0000ff & (v >> 8)),
-			   static_cast<char>(0x00ff & (v >> 16)),
-			   static_cast<char>(v >> 24),
-		   });
+	const char a[] = {
+		static_cast<char>(0x000000ff & v),
+		static_cast<char>(0x0000ff & (v >> 8)),
+		static_cast<char>(0x00ff & (v >> 16)),
+		static_cast<char>(v >> 24),
+	};
+	append(a, sizeof(a));
 }
 
 void BinaryContainer::appendUint32(const uint32_t v)
 {
-	append({
-			   static_cast<char>(0x000000ff & v),
-			   static_cast<char>(0x0000ff & (v >> 8)),
-			   static_cast<char>(0x00ff & (v >> 16)),
-			   static_cast<char>(v >> 24),
-		   });
+	const char a[] = {
+		static_cast<char>(0x000000ff & v),
+		static_cast<char>(0x0000ff & (v >> 8)),
+		static_cast<char>(0x00ff & (v >> 16)),
+		static_cast<char>(v >> 24),
+	};
+	append(a, sizeof(a));
 }
 
 void BinaryContainer::appendChar(const char c)
 {
+	detach();
 	buf_.push_back(c);
 }
 
-void BinaryContainer::appendString(const std::string str)
+void BinaryContainer::appendString(const std::string& str)
 {
-	std::copy(str.begin(), str.end(), std::back_inserter(buf_));
+	detach();
+	buf_.insert(buf_.end(), str.begin(), str.end());
 }
 
 void BinaryContainer::appendArray(const uint8_t* array, size_t size)
 {
-	std::copy(array, array + size, std::back_inserter(buf_));
+	detach();
+	const char* p = reinterpret_cast<const char*>(array);
+	buf_.insert(buf_.end(), p, p + size);
 }
 
 void BinaryContainer::appendVector(const std::vector<uint8_t>& vec)
 {
-	std::copy(vec.begin(), vec.end(), std::back_inserter(buf_));
+	appendArray(vec.data(), vec.size());
 }
 
 void BinaryContainer::appendVector(const std::vector<char>& vec)
 {
-	std::copy(vec.begin(), vec.end(), std::back_inserter(buf_));
+	detach();
+	buf_.insert(buf_.end(), vec.begin(), vec.end());
 }
 
 void BinaryContainer::appendBinaryContainer(const BinaryContainer& bc)
 {
+	detach();
 	const char* bcp = bc.getPointer();
-	std::copy(bcp, bcp + bc.size(), std::back_inserter(buf_));
+	buf_.insert(buf_.end(), bcp, bcp + bc.size());
 }
 
 void BinaryContainer::writeInt8(size_t offset, const int8_t v)
 {
+	detach();
 	buf_.at(offset) = static_cast<char>(v);
 }
 
 void BinaryContainer::writeUint8(size_t offset, const uint8_t v)
 {
+	detach();
 	buf_.at(offset) = static_cast<char>(v);
 }
 
 void BinaryContainer::writeInt16(size_t offset, const int16_t v)
 {
-	write(offset, {
-			  static_cast<char>(0x00ff & v),
-			  static_cast<char>(v >> 8),
-		  });
+	const char a[] = {
+		static_cast<char>(0x00ff & v),
+		static_cast<char>(v >> 8),
+	};
+	write(offset, a, sizeof(a));
 }
 
 void BinaryContainer::writeUint16(size_t offset, const uint16_t v)
 {
-	write(offset, {
-			  static_cast<char>(0x00ff & v),
-			  static_cast<char>(v >> 8),
-		  });
+	const char a[] = {
+		static_cast<char>(0x00ff & v),
+		static_cast<char>(v >> 8),
+	};
+	write(offset, a, sizeof(a));
 }
 
 void BinaryContainer::writeInt32(size_t offset, const int32_t v)
 {
-	write(offset, {
-			  static_cast<char>(0x000000ff & v),
-			  static_cast<char>(0x0000ff & (v >> 8)),
-			  static_cast<char>(0x00ff & (v >> 16)),
-			  static_cast<char>(v >> 24),
-		  });
+	const char a[] = {
+		static_cast<char>(0x000000ff & v),
+		static_cast<char>(0x0000ff & (v >> 8)),
+		static_cast<char>(0x00ff & (v >> 16)),
+		static_cast<char>(v >> 24),
+	};
+	write(offset, a, sizeof(a));
 }
 
 void BinaryContainer::writeUint32(size_t offset, const uint32_t v)
 {
-	write(offset, {
-			  static_cast<char>(0x000000ff & v),
-			  static_cast<char>(0x0000ff & (v >> 8)),
-			  static_cast<char>(0x00ff & (v >> 16)),
-			  static_cast<char>(v >> 24),
-		  });
+	const char a[] = {
+		static_cast<char>(0x000000ff & v),
+		static_cast<char>(0x0000ff & (v >> 8)),
+		static_cast<char>(0x00ff & (v >> 16)),
+		static_cast<char>(v >> 24),
+	};
+	write(offset, a, sizeof(a));
 }
 
 void BinaryContainer::writeChar(size_t offset, const char c)
 {
+	detach();
 	buf_.at(offset) = c;
 }
 
-void BinaryContainer::writeString(size_t offset, const std::string str)
+void BinaryContainer::writeString(size_t offset, const std::string& str)
 {
+	detach();
+	checkRange(offset, str.size());
 	std::copy(str.begin(), str.end(), buf_.begin() + static_cast<int>(offset));
 }
 
 int8_t BinaryContainer::readInt8(size_t offset) const
 {
-	return static_cast<int8_t>(buf_.at(offset));
+	checkRange(offset, 1);
+	return static_cast<int8_t>(data()[offset]);
 }
 
 uint8_t BinaryContainer::readUint8(size_t offset) const
 {
-	return static_cast<uint8_t>(buf_.at(offset));
+	checkRange(offset, 1);
+	return static_cast<uint8_t>(data()[offset]);
 }
 
 int16_t BinaryContainer::readInt16(size_t offset) const
 {
-	std::vector<unsigned char> data = read(offset, 2);
-	return static_cast<int16_t>(data[0] | (data[1] << 8));
+	return static_cast<int16_t>(read(offset, 2));
 }
 
 uint16_t BinaryContainer::readUint16(size_t offset) const
 {
-	std::vector<unsigned char> data = read(offset, 2);
-	return static_cast<uint16_t>(data[0] | (data[1] << 8));
+	return static_cast<uint16_t>(read(offset, 2));
 }
 
 int32_t BinaryContainer::readInt32(size_t offset) const
 {
-	std::vector<unsigned char> data = read(offset, 4);
-	return static_cast<int32_t>(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
+	return static_cast<int32_t>(read(offset, 4));
 }
 
 uint32_t BinaryContainer::readUint32(size_t offset) const
 {
-	std::vector<unsigned char> data = read(offset, 4);
-	return static_cast<uint32_t>(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
+	return read(offset, 4);
 }
 
 char BinaryContainer::readChar(size_t offset) const
 {
-	return buf_.at(offset);
+	checkRange(offset, 1);
+	return data()[offset];
 }
 
 std::string BinaryContainer::readString(size_t offset, size_t length) const
 {
-	return std::string(buf_.begin() + static_cast<int>(offset), buf_.begin() + static_cast<int>(offset + length));
+	checkRange(offset, length);
+	return std::string(data() + offset, length);
 }
 
 BinaryContainer BinaryContainer::getSubcontainer(size_t offset, size_t length) const
 {
-	std::vector<char> tmp;
-	std::copy_n(buf_.begin() + static_cast<int>(offset), length, std::back_inserter(tmp));
-	return BinaryContainer(std::move(tmp));
+	checkRange(offset, length);
+	const char* p = data() + offset;
+	return BinaryContainer(std::vector<char>(p, p + length));
 }
 
 const char* BinaryContainer::getPointer() const
 {
-	return &buf_[0];
+	return data();
 }
 
 std::vector<uint8_t> BinaryContainer::toVector() const
 {
-	std::vector<uint8_t> vec;
-	std::transform(buf_.begin(), buf_.end(), std::back_inserter(vec),
-				   [](const char v) { return static_cast<uint8_t>(v); });
-	return vec;
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(data());
+	return std::vector<uint8_t>(p, p + size());
 }
 
-void BinaryContainer::append(std::vector<char> a)
+void BinaryContainer::copyExternalData()
 {
-	if (isLE_)
-		std::copy(a.begin(), a.end(), std::back_inserter(buf_));
-	else
-		std::reverse_copy(a.begin(), a.end(), std::back_inserter(buf_));
+	buf_.assign(extBuf_, extBuf_ + extSize_);
+	extBuf_ = nullptr;
+	extSize_ = 0;
 }
 
-void BinaryContainer::write(size_t offset, std::vector<char> a)
+void BinaryContainer::checkRange(size_t offset, size_t size) const
 {
+	if (this->size() < size || this->size() - size < offset)
+		throw std::out_of_range("Out of range of binary container");
+}
+
+void BinaryContainer::append(const char* a, size_t size)
+{
+	detach();
 	if (isLE_)
-		std::copy(a.begin(), a.end(), buf_.begin() + static_cast<int>(offset));
+		buf_.insert(buf_.end(), a, a + size);
 	else
-		std::reverse_copy(a.begin(), a.end(), buf_.begin() + static_cast<int>(offset));
+		buf_.insert(buf_.end(), std::reverse_iterator<const char*>(a + size), std::reverse_iterator<const char*>(a));
 }
 
-std::vector<unsigned char> BinaryContainer::read(size_t offset, size_t size) const
+void BinaryContainer::write(size_t offset, const char* a, size_t size)
 {
-	std::vector<unsigned char> data;
+	detach();
+	checkRange(offset, size);
 	if (isLE_)
-		std::copy(buf_.begin() + static_cast<int>(offset), buf_.begin() + static_cast<int>(offset + size), std::back_inserter(data));
+		std::copy(a, a + size, buf_.begin() + static_cast<int>(offset));
 	else
-		std::reverse_copy(buf_.begin() + static_cast<int>(offset), buf_.begin() + static_cast<int>(offset + size), std::back_inserter(data));
-	return data;
+		std::reverse_copy(a, a + size, buf_.begin() + static_cast<int>(offset));
+}
+
+uint32_t BinaryContainer::read(size_t offset, size_t size) const
+{
+	checkRange(offset, size);
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(data()) + offset;
+	uint32_t v = 0;
+	if (isLE_) {
+		for (size_t i = size; i > 0; --i) v = (v << 8) | p[i - 1];
+	}
+	else {
+		for (size_t i = 0; i < size; ++i) v = (v << 8) | p[i];
+	}
+	return v;
 }
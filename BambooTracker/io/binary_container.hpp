@@ -27,6 +27,7 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 #include <string>
 
 class BinaryContainer
@@ -34,6 +35,9 @@ class BinaryContainer
 public:
 	explicit BinaryContainer(size_t defCapacity = 0);
 	explicit BinaryContainer(std::vector<char> buf);
+	/// Wrap external data such as a memory-mapped file without copying it.
+	/// The data must outlive the container, and it is copied on the first modification.
+	BinaryContainer(const char* data, size_t size);
 	size_t size() const;
 	void clear();
 	void reserve(size_t capacity);
@@ -48,7 +52,7 @@ public:
 	void appendInt32(const int32_t v);
 	void appendUint32(const uint32_t v);
 	void appendChar(const char c);
-	void appendString(const std::string str);
+	void appendString(const std::string& str);
 	void appendArray(const uint8_t* array, size_t size);
 	void appendVector(const std::vector<uint8_t>& vec);
 	void appendVector(const std::vector<char>& vec);
@@ -61,7 +65,7 @@ public:
 	void writeInt32(size_t offset, const int32_t v);
 	void writeUint32(size_t offset, const uint32_t v);
 	void writeChar(size_t offset, const char c);
-	void writeString(size_t offset, const std::string str);
+	void writeString(size_t offset, const std::string& str);
 
 	int8_t readInt8(size_t offset) const;
 	uint8_t readUint8(size_t offset) const;
@@ -72,6 +76,7 @@ public:
 	char readChar(size_t offset) const;
 	std::string readString(size_t offset, size_t length) const;
 
+	/// Return the copy of the range, which is valid after this container is released
 	BinaryContainer getSubcontainer(size_t offset, size_t length) const;
 
 	const char* getPointer() const;
@@ -79,9 +84,25 @@ public:
 
 private:
 	std::vector<char> buf_;
+	/// Wrapped external data, nullptr if the container owns its data in buf_
+	const char* extBuf_;
+	size_t extSize_;
 	bool isLE_;
 
-	void append(std::vector<char> a);
-	void write(size_t offset, std::vector<char> a);
-	std::vector<unsigned char> read(size_t offset, size_t size) const;
+	inline const char* data() const
+	{
+		return extBuf_ ? extBuf_ : buf_.data();
+	}
+
+	inline void detach()
+	{
+		if (extBuf_) copyExternalData();
+	}
+
+	void copyExternalData();
+	void checkRange(size_t offset, size_t size) const;
+	/// Values are passed in little endian order and stored in the container's endian
+	void append(const char* a, size_t size);
+	void write(size_t offset, const char* a, size_t size);
+	uint32_t read(size_t offset, size_t size) const;
 };
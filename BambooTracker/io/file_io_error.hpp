@@ -45,6 +45,7 @@ public:
 
 class FileNotExistError : public FileIOError
 {
+public:
 	FileNotExistError(const FileIO::FileType type)
 		: FileIOError("File not exist error", type) {}
 };
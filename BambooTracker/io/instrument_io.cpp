@@ -1899,7 +1899,7 @@ AbstractInstrument* InstrumentIO::loadBTIFile(const BinaryContainer& ctr,
 							csr += 4;
 						}
 						else {
-							subdata = ctr.readUint16(csr);
+							subdata = ctr.readInt16(csr);
 							csr += 2;
 							if (subdata != -1)
 								subdata = PitchConverter::getPitchSSGSquare(subdata);
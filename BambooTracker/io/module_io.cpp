@@ -968,7 +968,7 @@ void ModuleIO::saveModule(BinaryContainer& ctr, const std::weak_ptr<Module> mod,
 }
 
 void ModuleIO::loadModule(const BinaryContainer& ctr, std::weak_ptr<Module> mod,
-						  std::weak_ptr<InstrumentsManager> instMan)
+						  std::weak_ptr<InstrumentsManager> instMan, SectionCallback callback)
 {
 	size_t globCsr = 0;
 	if (ctr.readString(globCsr, 16) != "BambooTrackerMod")
@@ -983,18 +983,31 @@ void ModuleIO::loadModule(const BinaryContainer& ctr, std::weak_ptr<Module> mod,
 	globCsr += 4;
 
 	while (globCsr < eof) {
-		if (ctr.readString(globCsr, 8) == "MODULE  ")
+		Section section;
+		if (ctr.readString(globCsr, 8) == "MODULE  ") {
 			globCsr = loadModuleSectionInModule(mod, ctr, globCsr + 8, fileVersion);
-		else if (ctr.readString(globCsr, 8) == "INSTRMNT")
+			section = Section::Module;
+		}
+		else if (ctr.readString(globCsr, 8) == "INSTRMNT") {
 			globCsr = loadInstrumentSectionInModule(instMan, ctr, globCsr + 8, fileVersion);
-		else if (ctr.readString(globCsr, 8) == "INSTPROP")
+			section = Section::Instrument;
+		}
+		else if (ctr.readString(globCsr, 8) == "INSTPROP") {
 			globCsr = loadInstrumentPropertySectionInModule(instMan, ctr, globCsr + 8, fileVersion);
-		else if (ctr.readString(globCsr, 8) == "GROOVE  ")
+			section = Section::InstrumentProperty;
+		}
+		else if (ctr.readString(globCsr, 8) == "GROOVE  ") {
 			globCsr = loadGrooveSectionInModule(mod, ctr, globCsr + 8, fileVersion);
-		else if (ctr.readString(globCsr, 8) == "SONG    ")
+			section = Section::Groove;
+		}
+		else if (ctr.readString(globCsr, 8) == "SONG    ") {
 			globCsr = loadSongSectionInModule(mod, ctr, globCsr + 8, fileVersion);
-		else
+			section = Section::Song;
+		}
+		else {
 			throw FileCorruptionError(FileIO::FileType::Mod, globCsr);
+		}
+		if (callback) callback(section, globCsr);
 	}
 }
 
@@ -1797,7 +1810,7 @@ size_t ModuleIO::loadInstrumentPropertySectionInModule(std::weak_ptr<Instruments
 						csr += 4;
 					}
 					else {
-						subdata = ctr.readUint16(csr);
+						subdata = ctr.readInt16(csr);
 						csr += 2;
 						if (subdata != -1)
 							subdata = PitchConverter::getPitchSSGSquare(subdata);
@@ -26,6 +26,7 @@
 #pragma once
 
 #include <memory>
+#include <functional>
 #include "module.hpp"
 #include "instruments_manager.hpp"
 #include "binary_container.hpp"
@@ -33,10 +34,17 @@
 class ModuleIO
 {
 public:
+	enum class Section
+	{
+		Module, Instrument, InstrumentProperty, Groove, Song
+	};
+	/// Called after each section is loaded with the section and the position of the next section
+	using SectionCallback = std::function<void(Section, size_t)>;
+
 	static void saveModule(BinaryContainer& ctr, const std::weak_ptr<Module> mod,
 						   const std::weak_ptr<InstrumentsManager> instMan);
 	static void loadModule(const BinaryContainer& ctr, std::weak_ptr<Module> mod,
-						   std::weak_ptr<InstrumentsManager> instMan);
+						   std::weak_ptr<InstrumentsManager> instMan, SectionCallback callback = nullptr);
 
 private:
 	ModuleIO();
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "wav_reader.hpp"
+#include <algorithm>
+#include <cstring>
+#include "file_io_error.hpp"
+
+namespace
+{
+inline uint16_t getUint16(const char* p)
+{
+	return static_cast<uint16_t>(static_cast<uint8_t>(p[0]) | (static_cast<uint8_t>(p[1]) << 8));
+}
+
+inline uint32_t getUint24(const char* p)
+{
+	return static_cast<uint32_t>(static_cast<uint8_t>(p[0]) | (static_cast<uint8_t>(p[1]) << 8)
+								 | (static_cast<uint8_t>(p[2]) << 16));
+}
+
+inline uint32_t getUint32(const char* p)
+{
+	return getUint24(p) | (static_cast<uint32_t>(static_cast<uint8_t>(p[3])) << 24);
+}
+
+inline uint64_t getUint64(const char* p)
+{
+	return getUint32(p) | (static_cast<uint64_t>(getUint32(p + 4)) << 32);
+}
+
+inline float getFloat32(const char* p)
+{
+	uint32_t bits = getUint32(p);
+	float v;
+	std::memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+inline double getFloat64(const char* p)
+{
+	uint64_t bits = getUint64(p);
+	double v;
+	std::memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+}
+
+constexpr size_t WavReader::DEFAULT_BLOCK_SIZE;
+
+WavReader::WavReader(ReadFunction read, size_t fileSize, size_t blockSize)
+	: read_(read),
+	  rate_(0),
+	  format_(SampleFormat::Int16),
+	  nCh_(0),
+	  byteSize_(0),
+	  nSamples_(0),
+	  nRead_(0),
+	  fileSize_(fileSize),
+	  filePos_(0),
+	  block_(std::max<size_t>(blockSize, 64)),
+	  blockPos_(0),
+	  blockEnd_(0)
+{
+	readHeader();
+
+	// Keep whole frames in a block
+	size_t frameSize = static_cast<size_t>(byteSize_) * nCh_;
+	block_.resize(std::max<size_t>(block_.size() / frameSize, 1) * frameSize);
+}
+
+uint32_t WavReader::getSampleRate() const
+{
+	return rate_;
+}
+
+WavReader::SampleFormat WavReader::getSampleFormat() const
+{
+	return format_;
+}
+
+uint16_t WavReader::getChannelCount() const
+{
+	return nCh_;
+}
+
+size_t WavReader::getSampleCount() const
+{
+	return nSamples_;
+}
+
+void WavReader::readHeader()
+{
+	char riff[12];
+	readBytes(riff, 12);
+	if (std::memcmp(riff, "RIFF", 4) || std::memcmp(riff + 8, "WAVE", 4))
+		throw FileCorruptionError(FileIO::FileType::WAV, 0);
+
+	bool hasFmt = false;
+	while (true) {
+		char chunk[8];
+		readBytes(chunk, 8);
+		const size_t pos = filePos_;
+		const uint32_t size = getUint32(chunk + 4);
+
+		if (!std::memcmp(chunk, "fmt ", 4)) {
+			if (size < 16 || (fileSize_ && size > fileSize_ - std::min(pos, fileSize_)))
+				throw FileCorruptionError(FileIO::FileType::WAV, pos);
+			std::vector<char> fmt(size);
+			readBytes(fmt.data(), size);
+			uint16_t tag = getUint16(&fmt[0]);
+			nCh_ = getUint16(&fmt[2]);
+			rate_ = getUint32(&fmt[4]);
+			uint16_t blockAlign = getUint16(&fmt[12]);
+			uint16_t bits = getUint16(&fmt[14]);
+			if (tag == 0xfffe && size >= 26) tag = getUint16(&fmt[24]);	// Extensible, use the sub format
+			if (!nCh_ || !rate_ || bits % 8 || blockAlign != nCh_ * bits / 8)
+				throw FileCorruptionError(FileIO::FileType::WAV, pos);
+
+			if (tag == 1) {	// Linear PCM
+				switch (bits) {
+				case 8:		format_ = SampleFormat::UInt8;	break;
+				case 16:	format_ = SampleFormat::Int16;	break;
+				case 24:	format_ = SampleFormat::Int24;	break;
+				case 32:	format_ = SampleFormat::Int32;	break;
+				default:	throw FileUnsupportedError(FileIO::FileType::WAV);
+				}
+			}
+			else if (tag == 3) {	// IEEE float
+				switch (bits) {
+				case 32:	format_ = SampleFormat::Float32;	break;
+				case 64:	format_ = SampleFormat::Float64;	break;
+				default:	throw FileUnsupportedError(FileIO::FileType::WAV);
+				}
+			}
+			else {
+				throw FileUnsupportedError(FileIO::FileType::WAV);
+			}
+			byteSize_ = bits / 8;
+			hasFmt = true;
+		}
+		else if (!std::memcmp(chunk, "data", 4)) {
+			if (!hasFmt) throw FileCorruptionError(FileIO::FileType::WAV, pos);
+			size_t dataSize = fileSize_ ? std::min<size_t>(size, fileSize_ - std::min(pos, fileSize_)) : size;
+			nSamples_ = dataSize / (static_cast<size_t>(byteSize_) * nCh_);
+			return;
+		}
+		else {
+			skipBytes(size);
+		}
+
+		if (size & 1) skipBytes(1);	// Chunks are aligned to 2 bytes
+	}
+}
+
+void WavReader::readBytes(char* data, size_t size)
+{
+	if (read_(data, size) != size) throw FileCorruptionError(FileIO::FileType::WAV, filePos_);
+	filePos_ += size;
+}
+
+void WavReader::skipBytes(size_t size)
+{
+	while (size) {
+		size_t n = std::min(size, block_.size());
+		readBytes(block_.data(), n);
+		size -= n;
+	}
+}
+
+bool WavReader::fillBlock()
+{
+	// Move the rest of a partially read frame to the front
+	size_t rest = blockEnd_ - blockPos_;
+	std::copy(block_.begin() + static_cast<int>(blockPos_), block_.begin() + static_cast<int>(blockEnd_), block_.begin());
+	size_t n = read_(&block_[rest], block_.size() - rest);
+	filePos_ += n;
+	blockPos_ = 0;
+	blockEnd_ = rest + n;
+	return n > 0;
+}
+
+size_t WavReader::readMonoSamples(float* samples, size_t nSamples)
+{
+	const size_t frameSize = static_cast<size_t>(byteSize_) * nCh_;
+	size_t nDone = 0;
+	while (nDone < nSamples && nRead_ < nSamples_) {
+		size_t nAvail = (blockEnd_ - blockPos_) / frameSize;
+		if (!nAvail) {
+			if (fillBlock()) continue;
+			else break;	// The data is shorter than declared
+		}
+
+		size_t n = std::min(std::min(nAvail, nSamples - nDone), nSamples_ - nRead_);
+		const char* src = &block_[blockPos_];
+		float* dest = samples + nDone;
+		switch (format_) {
+		case SampleFormat::UInt8:
+			downmix(src, dest, n, [](const char* p) { return (static_cast<uint8_t>(*p) - 128) / 128.f; });
+			break;
+		case SampleFormat::Int16:
+			downmix(src, dest, n, [](const char* p) { return static_cast<int16_t>(getUint16(p)) / 32768.f; });
+			break;
+		case SampleFormat::Int24:
+			downmix(src, dest, n, [](const char* p) {
+				return (static_cast<int32_t>(getUint24(p) ^ 0x800000) - 0x800000) / 8388608.f;
+			});
+			break;
+		case SampleFormat::Int32:
+			downmix(src, dest, n, [](const char* p) { return static_cast<int32_t>(getUint32(p)) / 2147483648.f; });
+			break;
+		case SampleFormat::Float32:
+			downmix(src, dest, n, [](const char* p) { return getFloat32(p); });
+			break;
+		case SampleFormat::Float64:
+			downmix(src, dest, n, [](const char* p) { return static_cast<float>(getFloat64(p)); });
+			break;
+		}
+		blockPos_ += n * frameSize;
+		nDone += n;
+		nRead_ += n;
+	}
+	return nDone;
+}
+
+template <typename Decoder>
+void WavReader::downmix(const char* src, float* dest, size_t nSamples, Decoder dec) const
+{
+	if (nCh_ == 1) {
+		for (size_t i = 0; i < nSamples; ++i, src += byteSize_) dest[i] = dec(src);
+	}
+	else {
+		const float gain = 1.f / nCh_;
+		for (size_t i = 0; i < nSamples; ++i) {
+			float sum = 0.f;
+			for (uint16_t ch = 0; ch < nCh_; ++ch, src += byteSize_) sum += dec(src);
+			dest[i] = sum * gain;
+		}
+	}
+}
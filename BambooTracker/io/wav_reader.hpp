@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <functional>
+
+/// Read a WAV file block by block.
+/// Linear PCM of 8, 16, 24 and 32 bits and IEEE float of 32 and 64 bits are supported
+/// in any channel count. Only the current block is held in memory.
+class WavReader
+{
+public:
+	enum class SampleFormat
+	{
+		UInt8,
+		Int16,
+		Int24,
+		Int32,
+		Float32,
+		Float64
+	};
+
+	/// Return the number of read bytes, it is less than [size] at the end of the input
+	using ReadFunction = std::function<size_t(char* data, size_t size)>;
+
+	/// Read chunks up to the beginning of the sample data.
+	/// Throw FileCorruptionError or FileUnsupportedError if the header is invalid.
+	/// [fileSize] 0 if unknown. Otherwise the data chunk is cut at the end of the file.
+	explicit WavReader(ReadFunction read, size_t fileSize = 0, size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+	uint32_t getSampleRate() const;
+	SampleFormat getSampleFormat() const;
+	uint16_t getChannelCount() const;
+	/// The number of frames declared in the data chunk, up to the end of the file
+	size_t getSampleCount() const;
+
+	/// Read frames averaged down to mono, 1.0 is the full scale.
+	/// Return the number of read frames, it is less than [nSamples] only at the end of the data.
+	size_t readMonoSamples(float* samples, size_t nSamples);
+
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 0x10000;
+
+private:
+	ReadFunction read_;
+	uint32_t rate_;
+	SampleFormat format_;
+	uint16_t nCh_, byteSize_;
+	size_t nSamples_, nRead_;
+	size_t fileSize_, filePos_;
+	std::vector<char> block_;
+	size_t blockPos_, blockEnd_;
+
+	void readHeader();
+	void readBytes(char* data, size_t size);
+	void skipBytes(size_t size);
+	bool fillBlock();
+	template <typename Decoder>
+	void downmix(const char* src, float* dest, size_t nSamples, Decoder dec) const;
+};
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "wav_writer.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+inline void setUint16(char* p, uint16_t v)
+{
+	p[0] = static_cast<char>(v & 0xff);
+	p[1] = static_cast<char>(v >> 8);
+}
+
+inline void setUint24(char* p, uint32_t v)
+{
+	p[0] = static_cast<char>(v & 0xff);
+	p[1] = static_cast<char>((v >> 8) & 0xff);
+	p[2] = static_cast<char>((v >> 16) & 0xff);
+}
+
+inline void setUint32(char* p, uint32_t v)
+{
+	p[0] = static_cast<char>(v & 0xff);
+	p[1] = static_cast<char>((v >> 8) & 0xff);
+	p[2] = static_cast<char>((v >> 16) & 0xff);
+	p[3] = static_cast<char>(v >> 24);
+}
+
+inline void setFloat32(char* p, float v)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &v, sizeof(bits));
+	setUint32(p, bits);
+}
+
+inline int32_t toInt(float v, float scale)
+{
+	return static_cast<int32_t>(std::lrint(std::min(std::max(v * scale, -scale), scale - 1.f)));
+}
+
+constexpr size_t MAX_HEADER_SIZE = 58;
+}
+
+constexpr size_t WavWriter::DEFAULT_BLOCK_SIZE;
+
+WavWriter::WavWriter(WriteFunction write, SeekFunction seek, uint32_t rate, SampleFormat format,
+					 uint16_t nCh, size_t blockSize)
+	: write_(write),
+	  seek_(seek),
+	  rate_(rate),
+	  format_(format),
+	  nCh_(nCh),
+	  byteSize_(format == SampleFormat::Int16 ? 2 : format == SampleFormat::Int24 ? 3 : 4),
+	  block_(std::max<size_t>(blockSize, 4)),
+	  blockPos_(0),
+	  dataSize_(0),
+	  finalized_(false)
+{
+	writeHeader(0);	// Sizes are patched later
+}
+
+uint32_t WavWriter::getSampleRate() const
+{
+	return rate_;
+}
+
+WavWriter::SampleFormat WavWriter::getSampleFormat() const
+{
+	return format_;
+}
+
+uint16_t WavWriter::getChannelCount() const
+{
+	return nCh_;
+}
+
+size_t WavWriter::getSampleCount() const
+{
+	return static_cast<size_t>((dataSize_ + blockPos_) / (byteSize_ * nCh_));
+}
+
+void WavWriter::writeSamples(const int16_t* samples, size_t nSamples)
+{
+	switch (format_) {
+	case SampleFormat::Int16:
+		appendSamples(samples, nSamples, [](char* p, int16_t s) { setUint16(p, static_cast<uint16_t>(s)); });
+		break;
+	case SampleFormat::Int24:
+		appendSamples(samples, nSamples, [](char* p, int16_t s) { setUint24(p, static_cast<uint32_t>(s * 256)); });
+		break;
+	case SampleFormat::Float32:
+		appendSamples(samples, nSamples, [](char* p, int16_t s) { setFloat32(p, s / 32768.f); });
+		break;
+	}
+}
+
+void WavWriter::writeSamples(const float* samples, size_t nSamples)
+{
+	switch (format_) {
+	case SampleFormat::Int16:
+		appendSamples(samples, nSamples, [](char* p, float s) {
+			setUint16(p, static_cast<uint16_t>(toInt(s, 32768.f)));
+		});
+		break;
+	case SampleFormat::Int24:
+		appendSamples(samples, nSamples, [](char* p, float s) {
+			setUint24(p, static_cast<uint32_t>(toInt(s, 8388608.f)));
+		});
+		break;
+	case SampleFormat::Float32:
+		appendSamples(samples, nSamples, [](char* p, float s) { setFloat32(p, s); });
+		break;
+	}
+}
+
+template <typename T, typename Converter>
+void WavWriter::appendSamples(const T* samples, size_t nSamples, Converter conv)
+{
+	size_t n = nSamples * nCh_;
+	while (n) {
+		size_t count = std::min(n, (block_.size() - blockPos_) / byteSize_);
+		if (!count) {
+			flushBlock();
+			continue;
+		}
+		char* p = &block_[blockPos_];
+		for (size_t i = 0; i < count; ++i, p += byteSize_) conv(p, samples[i]);
+		samples += count;
+		blockPos_ += count * byteSize_;
+		n -= count;
+	}
+}
+
+void WavWriter::finalize()
+{
+	if (finalized_) return;
+	finalized_ = true;
+
+	flushBlock();
+	if (!seek_(0)) throw std::runtime_error("Failed to seek WAV output");
+	writeHeader(static_cast<uint32_t>(dataSize_));
+}
+
+void WavWriter::writeHeader(uint32_t dataSize)
+{
+	char header[MAX_HEADER_SIZE];
+	const bool isFloat = (format_ == SampleFormat::Float32);
+	const uint32_t fmtSize = isFloat ? 18 : 16;
+	const uint16_t blockAlign = byteSize_ * nCh_;
+
+	// RIFF header
+	std::copy_n("RIFF", 4, header);
+	std::copy_n("WAVE", 4, header + 8);
+	size_t p = 12;
+
+	// fmt chunk
+	std::copy_n("fmt ", 4, header + p);
+	setUint32(header + p + 4, fmtSize);
+	setUint16(header + p + 8, isFloat ? 3 : 1);	// IEEE float or linear PCM
+	setUint16(header + p + 10, nCh_);
+	setUint32(header + p + 12, rate_);
+	setUint32(header + p + 16, blockAlign * rate_);
+	setUint16(header + p + 20, blockAlign);
+	setUint16(header + p + 22, byteSize_ * 8);
+	if (isFloat) setUint16(header + p + 24, 0);	// No extension
+	p += 8 + fmtSize;
+
+	// fact chunk (required for non-PCM formats)
+	if (isFloat) {
+		std::copy_n("fact", 4, header + p);
+		setUint32(header + p + 4, 4);
+		setUint32(header + p + 8, dataSize / blockAlign);
+		p += 12;
+	}
+
+	// Data chunk
+	std::copy_n("data", 4, header + p);
+	setUint32(header + p + 4, dataSize);
+	p += 8;
+
+	setUint32(header + 4, static_cast<uint32_t>(p - 8 + dataSize));
+
+	if (!write_(header, p)) throw std::runtime_error("Failed to write WAV header");
+}
+
+void WavWriter::flushBlock()
+{
+	if (!blockPos_) return;
+	// Fail before writing past the limit of the RIFF sizes
+	if (dataSize_ + blockPos_ > std::numeric_limits<uint32_t>::max() - MAX_HEADER_SIZE)
+		throw std::runtime_error("WAV data exceeds 4GiB");
+	if (!write_(block_.data(), blockPos_)) throw std::runtime_error("Failed to write WAV data");
+	dataSize_ += blockPos_;
+	blockPos_ = 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <functional>
+
+/// Write a WAV file block by block.
+/// Only the current block is held in memory. The RIFF and data chunk sizes
+/// are patched by finalize(), so the output must be seekable.
+class WavWriter
+{
+public:
+	enum class SampleFormat
+	{
+		Int16,
+		Int24,
+		Float32
+	};
+
+	/// Return false if failed
+	using WriteFunction = std::function<bool(const char* data, size_t size)>;
+	using SeekFunction = std::function<bool(size_t pos)>;
+
+	WavWriter(WriteFunction write, SeekFunction seek, uint32_t rate = 44100,
+			  SampleFormat format = SampleFormat::Int16, uint16_t nCh = 2,
+			  size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+	uint32_t getSampleRate() const;
+	SampleFormat getSampleFormat() const;
+	uint16_t getChannelCount() const;
+	size_t getSampleCount() const;
+
+	/// Append interleaved samples. [nSamples] is the number of frames.
+	void writeSamples(const int16_t* samples, size_t nSamples);
+	/// Append interleaved samples, 1.0 is the full scale. [nSamples] is the number of frames.
+	void writeSamples(const float* samples, size_t nSamples);
+	/// Flush the rest of the block and patch chunk sizes in the header.
+	void finalize();
+
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 0x10000;
+
+private:
+	WriteFunction write_;
+	SeekFunction seek_;
+	uint32_t rate_;
+	SampleFormat format_;
+	uint16_t nCh_, byteSize_;
+	std::vector<char> block_;
+	size_t blockPos_;
+	uint64_t dataSize_;
+	bool finalized_;
+
+	void writeHeader(uint32_t dataSize);
+	void flushBlock();
+	template <typename T, typename Converter>
+	void appendSamples(const T* samples, size_t nSamples, Converter conv);
+};
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include "spsc_queue.hpp"
+#include "track.hpp"
+#include "misc.hpp"
+
+class AbstractInstrument;
+
+/// Channel and parameters played by a jam key.
+/// It is resolved from the current track and instrument on the thread that owns them.
+struct JamTarget
+{
+	TrackAttribute attrib;
+	SongType songType;
+	std::shared_ptr<AbstractInstrument> inst;
+	int volume;	// -1: keep the channel volume
+	bool isFMVolumeReversed;
+};
+
+struct JamEvent
+{
+	std::chrono::steady_clock::time_point time;	// Arrival time
+	int keyNum;
+	bool isKeyOn;
+	JamTarget target;
+};
+
+/// Queued by the MIDI input thread, played by the audio stream
+using JamEventQueue = SPSCQueue<JamEvent>;
@@ -25,279 +25,104 @@
 
 #include "effect.hpp"
 
-EffectType Effect::toEffectType(SoundSource src, std::string id)
+constexpr EffectIDCode Effect::NO_ID;
+
+namespace
 {
-	if (id == "00") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::Arpeggio;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "01") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::PortamentoUp;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "02") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::PortamentoDown;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "03") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::TonePortamento;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "04") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::Vibrato;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "07") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::Tremolo;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "08") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::RHYTHM:
-		case SoundSource::ADPCM:
-			return EffectType::Pan;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "0A") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::VolumeSlide;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "0B") {
-		return EffectType::PositionJump;
-	}
-	else if (id == "0C") {
-		return EffectType::SongEnd;
-	}
-	else if (id == "0D") {
-		return EffectType::PatternBreak;
-	}
-	else if (id == "0F") {
-		return EffectType::SpeedTempoChange;
-	}
-	else if (id == "0G") {
-		return EffectType::NoteDelay;
-	}
-	else if (id == "0H") {
-		switch (src) {
-		case SoundSource::SSG:
-			return EffectType::AutoEnvelope;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "0I") {
-		switch (src) {
-		case SoundSource::SSG:
-			return EffectType::HardEnvHighPeriod;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "0J") {
-		switch (src) {
-		case SoundSource::SSG:
-			return EffectType::HardEnvLowPeriod;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "0O") {
-		return EffectType::Groove;
-	}
-	else if (id == "0P") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::Detune;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "0Q") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::NoteSlideUp;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "0R") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::NoteSlideDown;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "0S") {
-		return EffectType::NoteCut;
-	}
-	else if (id == "0T") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::TransposeDelay;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "0V") {
-		switch (src) {
-		case SoundSource::SSG:
-			return EffectType::ToneNoiseMix;
-		case SoundSource::RHYTHM:
-			return EffectType::MasterVolume;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "0W") {
-		switch (src) {
-		case SoundSource::SSG:
-			return EffectType::NoisePitch;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "0X") {
-		return EffectType::RegisterAddress0;
-	}
-	else if (id == "0Y") {
-		return EffectType::RegisterAddress1;
-	}
-	else if (id == "0Z") {
-		return EffectType::RegisterValue;
-	}
-	else if (id == "B0") {
-		switch (src) {
-		case SoundSource::FM:
-			return EffectType::Brightness;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "FB") {
-		switch (src) {
-		case SoundSource::FM:
-			return EffectType::FBControl;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "FP") {
-		switch (src) {
-		case SoundSource::FM:
-		case SoundSource::SSG:
-		case SoundSource::ADPCM:
-			return EffectType::FineDetune;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "ML") {
-		switch (src) {
-		case SoundSource::FM:
-			return EffectType::MLControl;
-		default:
-			return EffectType::NoEffect;
-		}
-	}
-	else if (id == "RR") {
-		switch (src) {
-		case SoundSource::FM:
-			return EffectType::RRControl;
-		default:
-			return EffectType::NoEffect;
-		}
+constexpr int SRC_FM = static_cast<int>(SoundSource::FM);
+constexpr int SRC_SSG = static_cast<int>(SoundSource::SSG);
+constexpr int SRC_RHYTHM = static_cast<int>(SoundSource::RHYTHM);
+constexpr int SRC_ADPCM = static_cast<int>(SoundSource::ADPCM);
+constexpr int SRC_TONE = SRC_FM | SRC_SSG | SRC_ADPCM;
+constexpr int SRC_ALL = SRC_TONE | SRC_RHYTHM;
+
+inline EffectType typeInSources(SoundSource src, int sources, EffectType type)
+{
+	return (static_cast<int>(src) & sources) ? type : EffectType::NoEffect;
+}
+}
+
+EffectIDCode Effect::encodeID(const std::string& id)
+{
+	switch (id.size()) {
+	case 0:		return toEffectIDCode('\0', '\0');
+	case 1:		return toEffectIDCode(id[0], '\0');
+	default:	return toEffectIDCode(id[0], id[1]);
 	}
-	else {
-		switch (id.front()) {
-		case 'A':
-			switch (src) {
-			case SoundSource::FM:
-				return EffectType::ARControl;
-			default:
-				return EffectType::NoEffect;
-			}
-		case 'D':
-			switch (src) {
-			case SoundSource::FM:
-				return EffectType::DRControl;
-			default:
-				return EffectType::NoEffect;
-			}
-		case 'M':
-			return EffectType::VolumeDelay;
-		case 'T':
-			switch (src) {
-			case SoundSource::FM:
-				return EffectType::TLControl;
-			default:
-				return EffectType::NoEffect;
-			}
-		default:
-			return EffectType::NoEffect;
+}
+
+std::string Effect::decodeID(EffectIDCode code)
+{
+	const char id[] = { static_cast<char>(code >> 8), static_cast<char>(code & 0xff), '\0' };
+	return id;
+}
+
+EffectType Effect::toEffectType(SoundSource src, std::string id)
+{
+	return toEffectType(src, encodeID(id));
+}
+
+EffectType Effect::toEffectType(SoundSource src, EffectIDCode code)
+{
+	switch (code) {
+	case toEffectIDCode('0', '0'):	return typeInSources(src, SRC_TONE, EffectType::Arpeggio);
+	case toEffectIDCode('0', '1'):	return typeInSources(src, SRC_TONE, EffectType::PortamentoUp);
+	case toEffectIDCode('0', '2'):	return typeInSources(src, SRC_TONE, EffectType::PortamentoDown);
+	case toEffectIDCode('0', '3'):	return typeInSources(src, SRC_TONE, EffectType::TonePortamento);
+	case toEffectIDCode('0', '4'):	return typeInSources(src, SRC_TONE, EffectType::Vibrato);
+	case toEffectIDCode('0', '7'):	return typeInSources(src, SRC_TONE, EffectType::Tremolo);
+	case toEffectIDCode('0', '8'):	return typeInSources(src, SRC_FM | SRC_RHYTHM | SRC_ADPCM, EffectType::Pan);
+	case toEffectIDCode('0', 'A'):	return typeInSources(src, SRC_TONE, EffectType::VolumeSlide);
+	case toEffectIDCode('0', 'B'):	return EffectType::PositionJump;
+	case toEffectIDCode('0', 'C'):	return EffectType::SongEnd;
+	case toEffectIDCode('0', 'D'):	return EffectType::PatternBreak;
+	case toEffectIDCode('0', 'F'):	return EffectType::SpeedTempoChange;
+	case toEffectIDCode('0', 'G'):	return EffectType::NoteDelay;
+	case toEffectIDCode('0', 'H'):	return typeInSources(src, SRC_SSG, EffectType::AutoEnvelope);
+	case toEffectIDCode('0', 'I'):	return typeInSources(src, SRC_SSG, EffectType::HardEnvHighPeriod);
+	case toEffectIDCode('0', 'J'):	return typeInSources(src, SRC_SSG, EffectType::HardEnvLowPeriod);
+	case toEffectIDCode('0', 'O'):	return EffectType::Groove;
+	case toEffectIDCode('0', 'P'):	return typeInSources(src, SRC_TONE, EffectType::Detune);
+	case toEffectIDCode('0', 'Q'):	return typeInSources(src, SRC_TONE, EffectType::NoteSlideUp);
+	case toEffectIDCode('0', 'R'):	return typeInSources(src, SRC_TONE, EffectType::NoteSlideDown);
+	case toEffectIDCode('0', 'S'):	return EffectType::NoteCut;
+	case toEffectIDCode('0', 'T'):	return typeInSources(src, SRC_TONE, EffectType::TransposeDelay);
+	case toEffectIDCode('0', 'V'):
+		switch (src) {
+		case SoundSource::SSG:		return EffectType::ToneNoiseMix;
+		case SoundSource::RHYTHM:	return EffectType::MasterVolume;
+		default:					return EffectType::NoEffect;
+		}
+	case toEffectIDCode('0', 'W'):	return typeInSources(src, SRC_SSG, EffectType::NoisePitch);
+	case toEffectIDCode('0', 'X'):	return EffectType::RegisterAddress0;
+	case toEffectIDCode('0', 'Y'):	return EffectType::RegisterAddress1;
+	case toEffectIDCode('0', 'Z'):	return EffectType::RegisterValue;
+	case toEffectIDCode('B', '0'):	return typeInSources(src, SRC_FM, EffectType::Brightness);
+	case toEffectIDCode('F', 'B'):	return typeInSources(src, SRC_FM, EffectType::FBControl);
+	case toEffectIDCode('F', 'P'):	return typeInSources(src, SRC_TONE, EffectType::FineDetune);
+	case toEffectIDCode('M', 'L'):	return typeInSources(src, SRC_FM, EffectType::MLControl);
+	case toEffectIDCode('R', 'R'):	return typeInSources(src, SRC_FM, EffectType::RRControl);
+	default:
+		switch (code >> 8) {
+		case 'A':	return typeInSources(src, SRC_FM, EffectType::ARControl);
+		case 'D':	return typeInSources(src, SRC_FM, EffectType::DRControl);
+		case 'M':	return typeInSources(src, SRC_ALL, EffectType::VolumeDelay);
+		case 'T':	return typeInSources(src, SRC_FM, EffectType::TLControl);
+		default:	return EffectType::NoEffect;
 		}
 	}
 }
 
 Effect Effect::makeEffectData(SoundSource src, std::string id, int value)
 {
-	if (value == -1) return { EffectType::NoEffect, -1 };
+	return makeEffectData(src, encodeID(id), value);
+}
 
-	EffectType type = Effect::toEffectType(src, id);
+Effect Effect::makeEffectData(SoundSource src, EffectIDCode code, int value)
+{
+	if (value == -1) return { EffectType::NoEffect, -1 };
 
+	EffectType type = Effect::toEffectType(src, code);
 	int v;
 	switch (type) {
 	case EffectType::NoEffect:
@@ -307,7 +132,7 @@ Effect Effect::makeEffectData(SoundSource src, std::string id, int value)
 	case EffectType::TLControl:
 	case EffectType::ARControl:
 	case EffectType::DRControl:
-		v = (ctohex(id[1]) << 8) | value;
+		v = (ctohex(static_cast<char>(code & 0xff)) << 8) | value;
 		break;
 	default:
 		v = value;
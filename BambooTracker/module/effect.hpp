@@ -26,6 +26,7 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 #include "misc.hpp"
 
 enum class EffectType
@@ -38,11 +39,29 @@ enum class EffectType
 	RegisterAddress0, RegisterAddress1, RegisterValue, Brightness, FineDetune
 };
 
+/// Effect ID characters packed into 16 bits, the first character in the upper byte.
+/// Pattern steps hold effect IDs in this form so that playback can decode them
+/// without string comparisons or allocations.
+using EffectIDCode = uint16_t;
+
+constexpr EffectIDCode toEffectIDCode(char c1, char c2)
+{
+	return static_cast<EffectIDCode>((static_cast<uint8_t>(c1) << 8) | static_cast<uint8_t>(c2));
+}
+
 struct Effect
 {
 	EffectType type;
 	int value;
 
+	/// Code of the empty effect ID "--"
+	static constexpr EffectIDCode NO_ID = toEffectIDCode('-', '-');
+
+	static EffectIDCode encodeID(const std::string& id);
+	static std::string decodeID(EffectIDCode code);
+
 	static EffectType toEffectType(SoundSource src, std::string id);
+	static EffectType toEffectType(SoundSource src, EffectIDCode code);
 	static Effect makeEffectData(SoundSource src, std::string id, int value);
+	static Effect makeEffectData(SoundSource src, EffectIDCode code, int value);
 };
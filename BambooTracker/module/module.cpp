@@ -98,6 +98,7 @@ std::string Module::getComment() const
 void Module::setTickFrequency(unsigned int freq)
 {
 	tickFreq_ = freq;
+	for (auto& song : songs_) song.invalidateLengthAnalysis();
 }
 
 unsigned int Module::getTickFrequency() const
@@ -208,16 +209,19 @@ Song& Module::getSong(int num)
 void Module::addGroove()
 {
 	grooves_.emplace_back();
+	for (auto& song : songs_) song.invalidateLengthAnalysis();
 }
 
 void Module::removeGroove(int num)
 {
 	grooves_.erase(grooves_.begin() + num);
+	for (auto& song : songs_) song.invalidateLengthAnalysis();
 }
 
 void Module::setGroove(int num, std::vector<int> seq)
 {
 	grooves_.at(static_cast<size_t>(num)).setSequrnce(seq);
+	for (auto& song : songs_) song.invalidateLengthAnalysis();
 }
 
 void Module::setGrooves(std::vector<std::vector<int>> seqs)
@@ -226,6 +230,7 @@ void Module::setGrooves(std::vector<std::vector<int>> seqs)
 	for (auto& seq : seqs) {
 		grooves_.emplace_back(seq);
 	}
+	for (auto& song : songs_) song.invalidateLengthAnalysis();
 }
 
 Groove& Module::getGroove(int num)
@@ -94,6 +94,7 @@ std::string Song::getTitle() const
 void Song::setTempo(int tempo)
 {
 	tempo_ = tempo;
+	invalidateLengthAnalysis();
 }
 
 int Song::getTempo() const
@@ -104,6 +105,7 @@ int Song::getTempo() const
 void Song::setGroove(int groove)
 {
 	groove_ = groove;
+	invalidateLengthAnalysis();
 }
 
 int Song::getGroove() const
@@ -114,6 +116,7 @@ int Song::getGroove() const
 void Song::toggleTempoOrGroove(bool isUsedTempo)
 {
 	isUsedTempo_ = isUsedTempo;
+	invalidateLengthAnalysis();
 }
 
 bool Song::isUsedTempo() const
@@ -124,6 +127,7 @@ bool Song::isUsedTempo() const
 void Song::setSpeed(int speed)
 {
 	speed_ = speed;
+	invalidateLengthAnalysis();
 }
 
 int Song::getSpeed() const
@@ -134,6 +138,8 @@ int Song::getSpeed() const
 void Song::setDefaultPatternSize(size_t size)
 {
 	defPtnSize_ = size;
+	timeline_.invalidate();
+	invalidateAnalysis();
 	for (auto& t : tracks_) {
 		t.changeDefaultPatternSize(size);
 	}
@@ -180,6 +186,8 @@ Track& Song::getTrack(int num)
 void Song::changeType(SongType type)
 {
 	if (std::exchange(type_, type) == type_) return;
+	timeline_.invalidate();
+	invalidateAnalysis();
 
 	switch (type_) {
 	case SongType::Standard:	// Previous type: FM3chExpanded
@@ -230,6 +238,8 @@ void Song::insertOrderBelow(int order)
 	for (auto& track : tracks_) {
 		track.insertOrderBelow(order);
 	}
+	timeline_.invalidate(order + 1);
+	invalidateAnalysis();
 }
 
 void Song::deleteOrder(int order)
@@ -237,6 +247,8 @@ void Song::deleteOrder(int order)
 	for (auto& track : tracks_) {
 		track.deleteOrder(order);
 	}
+	timeline_.invalidate(order);
+	invalidateAnalysis();
 }
 
 void Song::swapOrder(int a, int b)
@@ -244,6 +256,8 @@ void Song::swapOrder(int a, int b)
 	for (auto& track : tracks_) {
 		track.swapOrder(a, b);
 	}
+	timeline_.invalidate(std::min(a, b));
+	invalidateAnalysis();
 }
 
 std::unordered_set<int> Song::getRegisteredInstruments() const
@@ -265,6 +279,7 @@ void Song::clearUnusedPatterns()
 void Song::replaceDuplicateInstrumentsInPatterns(std::unordered_map<int, int> map)
 {
 	for (auto& track : tracks_) track.replaceDuplicateInstrumentsInPatterns(map);
+	timeline_.invalidate();
 }
 
 int Song::addBookmark(std::string name, int order, int step)
@@ -369,6 +384,7 @@ size_t Song::getBookmarkSize() const
 void Song::transpose(int seminotes, std::vector<int> excludeInsts)
 {
 	for (auto& track : tracks_) track.transpose(seminotes, excludeInsts);
+	timeline_.invalidate();
 }
 
 void Song::swapTracks(int track1, int track2)
@@ -388,6 +404,49 @@ void Song::swapTracks(int track1, int track2)
 	it2->setAttribute(attrib1.number, attrib1.source, attrib1.channelInSource);
 
 	std::iter_swap(it1, it2);
+	timeline_.invalidate();
+	invalidateAnalysis();
+}
+
+const TimelineState& Song::getStatesBeforeOrder(int order)
+{
+	return timeline_.getStatesBeforeOrder(*this, order);
+}
+
+void Song::invalidateTimeline(int order)
+{
+	timeline_.invalidate(order);
+}
+
+void Song::invalidateTimelineByPatterns(int order)
+{
+	// Patterns may be shared with the orders before
+	int first = order;
+	for (auto& track : tracks_) {
+		int ptn = track.getOrderData(order).patten;
+		for (int o = 0; o < first; ++o) {
+			if (track.getOrderData(o).patten == ptn) {
+				first = o;
+				break;
+			}
+		}
+	}
+	timeline_.invalidate(first);
+}
+
+SongAnalysis& Song::getAnalysis()
+{
+	return analysis_;
+}
+
+void Song::invalidateAnalysis()
+{
+	analysis_ = SongAnalysis();
+}
+
+void Song::invalidateLengthAnalysis()
+{
+	analysis_.hasLength = false;
 }
 
 Bookmark::Bookmark(std::string argname, int argorder, int argstep)
@@ -30,11 +30,23 @@
 #include <string>
 #include <unordered_map>
 #include "track.hpp"
+#include "song_timeline.hpp"
 #include "misc.hpp"
 
 struct SongStyle;
 struct Bookmark;
 
+struct SongAnalysis
+{
+	bool hasStructure = false;
+	/// Position played after the last step, -1 if the song ends without loop
+	int endOrder = 0, endStep = 0;
+	size_t nIntroStep = 0, nLoopStep = 0;
+
+	bool hasLength = false;
+	double lengthBySecond = 0.;
+};
+
 class Song
 {
 public:
@@ -90,6 +102,20 @@ public:
 	void transpose(int seminotes, std::vector<int> excludeInsts);
 	void swapTracks(int track1, int track2);
 
+	/// Return the playback states set by the steps before the order
+	const TimelineState& getStatesBeforeOrder(int order);
+	/// Call when the steps or the patterns in the order are changed
+	void invalidateTimeline(int order = 0);
+	/// Call when the steps in the patterns used in the order are changed
+	void invalidateTimelineByPatterns(int order);
+
+	/// Results of SongLengthCalculator, kept until the song structure or speed is changed
+	SongAnalysis& getAnalysis();
+	/// Call when the effects changing the order or the step size may be changed
+	void invalidateAnalysis();
+	/// Call when the effects and settings changing speed may be changed
+	void invalidateLengthAnalysis();
+
 private:
 	int num_;
 	SongType type_;
@@ -103,6 +129,9 @@ private:
 	std::vector<Track> tracks_;
 	std::vector<Bookmark> bms_;
 
+	SongTimeline timeline_;
+	SongAnalysis analysis_;
+
 	std::vector<Bookmark> getSortedBookmarkList() const;
 };
 
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "song_timeline.hpp"
+#include <algorithm>
+#include "song.hpp"
+#include "track.hpp"
+#include "effect.hpp"
+
+/********** TimelineState **********/
+constexpr size_t TimelineState::GLOBAL_SLOT;
+constexpr size_t TimelineState::MAX_TONE_CNT;
+constexpr size_t TimelineState::SLOT_CNT;
+
+size_t TimelineState::toSlot(SoundSource src, int ch)
+{
+	size_t uch = static_cast<size_t>(ch);
+	switch (src) {
+	case SoundSource::FM:		return uch;
+	case SoundSource::SSG:		return 9 + uch;
+	case SoundSource::RHYTHM:	return 12 + uch;
+	case SoundSource::ADPCM:	return 18;
+	default:					return GLOBAL_SLOT;
+	}
+}
+
+uint64_t TimelineState::makeKey(int order, int step, int track)
+{
+	// The lowest 3 bits are used to order the states in a step
+	return (static_cast<uint64_t>(order) << 32) | (static_cast<uint64_t>(step) << 16)
+			| (static_cast<uint64_t>(track) << 8);
+}
+
+void TimelineState::scanStep(Step& step, const TrackAttribute& attrib, uint64_t key, bool isHeld)
+{
+	const SoundSource src = attrib.source;
+	const size_t slot = toSlot(src, attrib.channelInSource);
+	const Flag flag = isHeld ? Flag::Held : Flag::Set;
+
+	// Volume
+	int volLim = 0;
+	switch (src) {
+	case SoundSource::FM:		volLim = 0x80;	break;
+	case SoundSource::SSG:		volLim = 0x10;	break;
+	case SoundSource::RHYTHM:	volLim = 0x20;	break;
+	case SoundSource::ADPCM:	volLim = 0x100;	break;
+	}
+	int vol = step.getVolume();
+	if (0 <= vol && vol < volLim) setValue(slot, Volume, { flag, vol, 0, key | 5 });
+
+	// Instrument
+	int inst = step.getInstrumentNumber();
+	if (src != SoundSource::RHYTHM && inst != -1) addInstrument(slot, { flag, inst, 0, key | 4 });
+
+	// Effects
+	for (int i = 3; i > -1; --i) {
+		Effect eff = Effect::makeEffectData(src, step.getEffectIDCode(i), step.getEffectValue(i));
+		Value val{ flag, eff.value, 0, key | static_cast<uint64_t>(i) };
+		switch (eff.type) {
+		case EffectType::Arpeggio:
+			if (src != SoundSource::RHYTHM) setValue(slot, Arpeggio, val);
+			break;
+		case EffectType::PortamentoUp:
+		case EffectType::PortamentoDown:
+		case EffectType::TonePortamento:
+			if (src != SoundSource::RHYTHM) {
+				val.sub = (eff.type == EffectType::PortamentoUp) ? 0
+																 : (eff.type == EffectType::PortamentoDown) ? 1 : 2;
+				setValue(slot, Portamento, val);
+			}
+			break;
+		case EffectType::Vibrato:
+			if (src != SoundSource::RHYTHM) setValue(slot, Vibrato, val);
+			break;
+		case EffectType::Tremolo:
+			if (src != SoundSource::RHYTHM) setValue(slot, Tremolo, val);
+			break;
+		case EffectType::Pan:
+			if (src != SoundSource::SSG && -1 < eff.value && eff.value < 4) setValue(slot, Pan, val);
+			break;
+		case EffectType::VolumeSlide:
+			if (src != SoundSource::RHYTHM) setValue(slot, VolumeSlide, val);
+			break;
+		case EffectType::SpeedTempoChange:
+			if (eff.value >= 0x20)
+				addTempoEvent({ TempoEventType::Tempo, eff.value, isHeld });
+			else if (src == SoundSource::ADPCM)
+				addTempoEvent({ TempoEventType::SpeedOrTempo, eff.value, isHeld });
+			else
+				addTempoEvent({ TempoEventType::Speed, eff.value, isHeld });
+			break;
+		case EffectType::Groove:
+			addTempoEvent({ TempoEventType::Groove, eff.value, isHeld });
+			break;
+		case EffectType::Detune:
+			if (src != SoundSource::RHYTHM) setValue(slot, Detune, val);
+			break;
+		case EffectType::FineDetune:
+			if (src != SoundSource::RHYTHM) setValue(slot, FineDetune, val);
+			break;
+		case EffectType::FBControl:
+			if (src == SoundSource::FM) setValue(slot, FBControl, val);
+			break;
+		case EffectType::TLControl:
+			if (src == SoundSource::FM) setValue(slot, TLControl, val);
+			break;
+		case EffectType::MLControl:
+			if (src == SoundSource::FM) setValue(slot, MLControl, val);
+			break;
+		case EffectType::ARControl:
+			if (src == SoundSource::FM) setValue(slot, ARControl, val);
+			break;
+		case EffectType::DRControl:
+			if (src == SoundSource::FM) setValue(slot, DRControl, val);
+			break;
+		case EffectType::RRControl:
+			if (src == SoundSource::FM) setValue(slot, RRControl, val);
+			break;
+		case EffectType::Brightness:
+			if (src == SoundSource::FM) setValue(slot, Brightness, val);
+			break;
+		case EffectType::ToneNoiseMix:
+			if (src == SoundSource::SSG && -1 < eff.value && eff.value < 4) setValue(slot, ToneNoiseMix, val);
+			break;
+		case EffectType::NoisePitch:
+			if (src == SoundSource::SSG && -1 < eff.value && eff.value < 32) {
+				val.sub = attrib.channelInSource;
+				setValue(GLOBAL_SLOT, NoisePitch, val);
+			}
+			break;
+		case EffectType::HardEnvHighPeriod:
+			if (src == SoundSource::SSG) {
+				val.sub = attrib.channelInSource;
+				setValue(GLOBAL_SLOT, HardEnvHighPeriod, val);
+			}
+			break;
+		case EffectType::HardEnvLowPeriod:
+			if (src == SoundSource::SSG) {
+				val.sub = attrib.channelInSource;
+				setValue(GLOBAL_SLOT, HardEnvLowPeriod, val);
+			}
+			break;
+		case EffectType::AutoEnvelope:
+			if (src == SoundSource::SSG) {
+				val.sub = attrib.channelInSource;
+				setValue(GLOBAL_SLOT, AutoEnvelope, val);
+			}
+			break;
+		case EffectType::MasterVolume:
+			if (src == SoundSource::RHYTHM && -1 < eff.value && eff.value < 64)
+				setValue(GLOBAL_SLOT, MasterVolume, val);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Tone
+	// The step at the start position is not used as a previous tone
+	int t = step.getNoteNumber();
+	if (!isHeld && src != SoundSource::RHYTHM && t != -1 && t != -2 && tones_[slot].size() < MAX_TONE_CNT)
+		tones_[slot].push_back(t);
+}
+
+void TimelineState::append(const TimelineState& earlier)
+{
+	for (size_t i = 0; i < values_.size(); ++i) {
+		if (values_[i].flag == Flag::Unset) values_[i] = earlier.values_[i];
+	}
+	for (size_t slot = 0; slot < SLOT_CNT; ++slot) {
+		for (const Value& inst : earlier.insts_[slot]) addInstrument(slot, inst);
+		std::vector<int>& tones = tones_[slot];
+		for (auto it = earlier.tones_[slot].begin(); it != earlier.tones_[slot].end() && tones.size() < MAX_TONE_CNT; ++it)
+			tones.push_back(*it);
+	}
+	for (const TempoEvent& event : earlier.tempoEvents_) addTempoEvent(event);
+}
+
+const TimelineState::Value& TimelineState::getValue(size_t slot, Param param) const
+{
+	return values_[slot * PARAM_CNT + param];
+}
+
+const std::vector<TimelineState::Value>& TimelineState::getInstrumentCandidates(size_t slot) const
+{
+	return insts_[slot];
+}
+
+const std::vector<int>& TimelineState::getTones(size_t slot) const
+{
+	return tones_[slot];
+}
+
+const std::vector<TimelineState::TempoEvent>& TimelineState::getTempoEvents() const
+{
+	return tempoEvents_;
+}
+
+void TimelineState::setValue(size_t slot, Param param, const Value& value)
+{
+	Value& dst = values_[slot * PARAM_CNT + param];
+	if (dst.flag == Flag::Unset) dst = value;
+}
+
+void TimelineState::addInstrument(size_t slot, const Value& value)
+{
+	// Only the first appearance of each instrument affects the choice
+	std::vector<Value>& insts = insts_[slot];
+	if (std::none_of(insts.begin(), insts.end(), [&](const Value& v) { return v.value == value.value; }))
+		insts.push_back(value);
+}
+
+void TimelineState::addTempoEvent(const TempoEvent& event)
+{
+	// Drop the events which are never used regardless of the events found before them:
+	// speed and tempo after the first one, speed in ADPCM after the second one,
+	// and groove after the first one of the same number
+	size_t limit = (event.type == TempoEventType::SpeedOrTempo) ? 2 : 1;
+	size_t cnt = static_cast<size_t>(std::count_if(
+										 tempoEvents_.begin(), tempoEvents_.end(), [&](const TempoEvent& e) {
+		return (e.type == event.type && (event.type != TempoEventType::Groove || e.value == event.value));
+	}));
+	if (cnt < limit) tempoEvents_.push_back(event);
+}
+
+/********** SongTimeline **********/
+SongTimeline::SongTimeline()
+	: checkpoints_(1),
+	  validCnt_(1)
+{
+}
+
+const TimelineState& SongTimeline::getStatesBeforeOrder(Song& song, int order)
+{
+	size_t target = static_cast<size_t>(order);
+	if (target < validCnt_) return checkpoints_[target];
+
+	if (checkpoints_.size() <= target) checkpoints_.resize(target + 1);
+	std::vector<TrackAttribute> attribs = song.getTrackAttributes();
+	for (size_t n = validCnt_; n <= target; ++n) {
+		// Scan the previous order backward and add the states before it
+		int prev = static_cast<int>(n) - 1;
+		TimelineState& state = checkpoints_[n];
+		state = TimelineState();
+		for (int s = static_cast<int>(song.getPatternSizeFromOrderNumber(prev)) - 1; s > -1; --s) {
+			for (auto it = attribs.rbegin(), e = attribs.rend(); it != e; ++it) {
+				Step& step = song.getTrack(it->number).getPatternFromOrderNumber(prev).getStep(s);
+				state.scanStep(step, *it, TimelineState::makeKey(prev, s, it->number), false);
+			}
+		}
+		state.append(checkpoints_[n - 1]);
+	}
+	validCnt_ = target + 1;
+
+	return checkpoints_[target];
+}
+
+void SongTimeline::invalidate(int order)
+{
+	// The checkpoint before the order is still valid
+	validCnt_ = std::min(validCnt_, static_cast<size_t>(std::max(order, 0)) + 1);
+	checkpoints_.resize(validCnt_);
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+#include "step.hpp"
+#include "misc.hpp"
+
+struct TrackAttribute;
+class Song;
+
+/// Playback states set by the steps of a range of a song, used to restore channels when playback
+/// starts from the middle of the song.
+/// Steps are scanned backward from the end of the range, so each state holds the value set last.
+class TimelineState
+{
+public:
+	enum Param : size_t
+	{
+		Volume, Instrument, Arpeggio, Portamento, Vibrato, Tremolo, Pan, VolumeSlide, Detune, FineDetune,
+		FBControl, TLControl, MLControl, ARControl, DRControl, RRControl, Brightness, ToneNoiseMix,
+		NoisePitch, HardEnvHighPeriod, HardEnvLowPeriod, AutoEnvelope, MasterVolume, PARAM_CNT
+	};
+
+	enum class Flag : uint8_t
+	{
+		Unset,
+		/// Set by the step at the start position, which is executed by playback itself
+		Held,
+		Set
+	};
+
+	struct Value
+	{
+		Flag flag = Flag::Unset;
+		int value = 0;
+		/// Portamento: 0 = up, 1 = down, 2 = tone portamento
+		/// SSG global states: channel in source
+		int sub = 0;
+		/// Position of the step in the song, see makeKey
+		uint64_t key = 0;
+	};
+
+	enum class TempoEventType : uint8_t
+	{
+		Speed, Tempo, Groove,
+		/// Speed change in ADPCM track, which is treated as tempo change once speed is set
+		SpeedOrTempo
+	};
+
+	struct TempoEvent
+	{
+		TempoEventType type;
+		int value;
+		bool isHeld;
+	};
+
+	/// Slot of the channel in the state. Global states are held in GLOBAL_SLOT
+	static size_t toSlot(SoundSource src, int ch);
+	static constexpr size_t GLOBAL_SLOT = 19;
+	static constexpr size_t MAX_TONE_CNT = 3;
+
+	/// Make the key to order the states by the position set in the song
+	static uint64_t makeKey(int order, int step, int track);
+
+	/// Scan the step as the one before the steps scanned until now
+	void scanStep(Step& step, const TrackAttribute& attrib, uint64_t key, bool isHeld);
+	/// Add the states of the range before the range scanned until now
+	void append(const TimelineState& earlier);
+
+	const Value& getValue(size_t slot, Param param) const;
+	/// Instruments in the order found. The first valid one of them is used
+	const std::vector<Value>& getInstrumentCandidates(size_t slot) const;
+	/// Note numbers and echo buffer accesses in the order found
+	const std::vector<int>& getTones(size_t slot) const;
+	/// Speed, tempo and groove changes in the order found, except ones never used
+	const std::vector<TempoEvent>& getTempoEvents() const;
+
+private:
+	static constexpr size_t SLOT_CNT = 20;
+
+	std::array<Value, SLOT_CNT * PARAM_CNT> values_;
+	std::array<std::vector<Value>, SLOT_CNT> insts_;
+	std::array<std::vector<int>, SLOT_CNT> tones_;
+	std::vector<TempoEvent> tempoEvents_;
+
+	void setValue(size_t slot, Param param, const Value& value);
+	void addInstrument(size_t slot, const Value& value);
+	void addTempoEvent(const TempoEvent& event);
+};
+
+/// Checkpoints of playback states at the head of each order.
+/// They are built on demand and rebuilt from the order invalidated by edits.
+class SongTimeline
+{
+public:
+	SongTimeline();
+
+	/// Return the states set by the steps before the order
+	const TimelineState& getStatesBeforeOrder(Song& song, int order);
+	/// Drop the checkpoints affected by the change in the order
+	void invalidate(int order = 0);
+
+private:
+	/// checkpoints_[n]: states before order n
+	std::vector<TimelineState> checkpoints_;
+	size_t validCnt_;
+};
@@ -25,14 +25,19 @@
 
 #include "step.hpp"
 
+constexpr uint8_t Step::INST_NONE_;
+constexpr uint8_t Step::VOL_NONE_;
+constexpr uint8_t Step::ALL_NONE_;
+
 Step::Step()
 	: noteNum_(-1),
-	  instNum_(-1),
-	  vol_(-1)
+	  instNum_(0),
+	  vol_(0),
+	  noneFlags_(ALL_NONE_)
 {
 	for (size_t i = 0; i < 4; ++i) {
-		effID_[i] = "--";
-		effVal_[i] = -1;
+		effID_[i] = Effect::NO_ID;
+		effVal_[i] = 0;
 	}
 }
 
@@ -43,53 +48,64 @@ int Step::getNoteNumber() const
 
 void Step::setNoteNumber(int num)
 {
-	noteNum_ = num;
+	noteNum_ = static_cast<int8_t>(num);
 }
 
 int Step::getInstrumentNumber() const
 {
-	return instNum_;
+	return getField(instNum_, INST_NONE_);
 }
 
 void Step::setInstrumentNumber(int num)
 {
-	instNum_ = num;
+	setField(instNum_, INST_NONE_, num);
 }
 
 int Step::getVolume() const
 {
-	return vol_;
+	return getField(vol_, VOL_NONE_);
 }
 
 void Step::setVolume(int volume)
 {
-	vol_ = volume;
+	setField(vol_, VOL_NONE_, volume);
 }
 
 std::string Step::getEffectID(int n) const
 {
-	return effID_[n];
+	return Effect::decodeID(effID_[n]);
 }
 
 void Step::setEffectID(int n, std::string str)
 {
-	effID_[n] = str;
+	effID_[n] = Effect::encodeID(str);
+}
+
+EffectIDCode Step::getEffectIDCode(int n) const
+{
+	return effID_[n];
+}
+
+void Step::setEffectIDCode(int n, EffectIDCode code)
+{
+	effID_[n] = code;
 }
 
 int Step::getEffectValue(int n) const
 {
-	return effVal_[n];
+	return getField(effVal_[n], static_cast<uint8_t>(1 << n));
 }
 
 void Step::setEffectValue(int n, int v)
 {
-	effVal_[n] = v;
+	setField(effVal_[n], static_cast<uint8_t>(1 << n), v);
 }
 
 int Step::checkEffectID(std::string str) const
 {
+	const EffectIDCode code = Effect::encodeID(str);
 	for (int i = 0; i < 4; ++i) {
-		if (effID_[i] == str && effVal_[i] != -1) return i;
+		if (effID_[i] == code && !(noneFlags_ & (1 << i))) return i;
 	}
 	return -1;
 }
@@ -97,11 +113,26 @@ int Step::checkEffectID(std::string str) const
 bool Step::existCommand() const
 {
 	if (noteNum_ != -1) return true;
-	if (instNum_ != -1) return true;
-	if (vol_ != -1) return true;
+	if (noneFlags_ != ALL_NONE_) return true;
 	for (int i = 0; i < 4; ++i) {
-		if (effID_[i] != "--") return true;
-		if (effVal_[i] != -1) return true;
+		if (effID_[i] != Effect::NO_ID) return true;
 	}
 	return false;
 }
+
+int Step::getField(uint8_t val, uint8_t noneFlag) const
+{
+	return (noneFlags_ & noneFlag) ? -1 : val;
+}
+
+void Step::setField(uint8_t& field, uint8_t noneFlag, int val)
+{
+	if (val < 0) {
+		noneFlags_ |= noneFlag;
+		field = 0;
+	}
+	else {
+		noneFlags_ &= ~noneFlag;
+		field = static_cast<uint8_t>(val);
+	}
+}
@@ -26,6 +26,8 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
+#include "effect.hpp"
 
 class Step
 {
@@ -43,6 +45,9 @@ public:
 
 	std::string getEffectID(int n) const;
 	void setEffectID(int n, std::string str);
+	/// Packed effect ID used by playback instead of the string form
+	EffectIDCode getEffectIDCode(int n) const;
+	void setEffectIDCode(int n, EffectIDCode code);
 
 	int getEffectValue(int n) const;
 	void setEffectValue(int n, int v);
@@ -53,6 +58,15 @@ public:
 	bool existCommand() const;
 
 private:
+	// Steps are stored in compact 16-byte cells since every track allocates
+	// all of its patterns. The accessors translate to the int values with -1 as none.
+
+	/// effID_
+	///		packed effect ID, Effect::NO_ID: none
+	EffectIDCode effID_[4];
+	/// effVal_
+	///		effect value, ignored when the bit of the effect is set in noneFlags_
+	uint8_t effVal_[4];
 	/// noteNum_
 	///		0<=: note number (key on)
 	///		 -1: none
@@ -61,18 +75,23 @@ private:
 	///		 -4: echo 2 notes before
 	///		 -5: echo 3 notes before
 	///		 -6: echo 4 notes before
-	int noteNum_;
+	int8_t noteNum_;
 	/// instNum_
-	///		0<=: instrument number
-	///		 -1: none
-	int instNum_;
+	///		instrument number, ignored when INST_NONE_ is set in noneFlags_
+	uint8_t instNum_;
 	/// vol_
-	///		0<=: volume level
-	///		 -1: none
-	int vol_;
-	std::string effID_[4];
-	/// effVal_
-	///		0<=: effect value
-	///		 -1: none
-	int effVal_[4];
+	///		volume level, ignored when VOL_NONE_ is set in noneFlags_
+	uint8_t vol_;
+	/// noneFlags_
+	///		bit 0-3: effect value 0-3 is none
+	///		bit 4: instrument is none
+	///		bit 5: volume is none
+	uint8_t noneFlags_;
+
+	static constexpr uint8_t INST_NONE_ = 0x10;
+	static constexpr uint8_t VOL_NONE_ = 0x20;
+	static constexpr uint8_t ALL_NONE_ = 0x3f;
+
+	int getField(uint8_t val, uint8_t noneFlag) const;
+	void setField(uint8_t& field, uint8_t noneFlag, int val);
 };
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "offline_renderer.hpp"
+#include <algorithm>
+#include "chips/chip_misc.hpp"
+#include "export_handler.hpp"
+#include "song_length_calculator.hpp"
+
+const uint32_t OfflineRenderer::CHIP_CLOCK = 3993600 * 2;
+
+OfflineRenderer::OfflineRenderer(const Module& mod, std::shared_ptr<InstrumentsManager> instMan,
+								 int songNum, chip::Emu emu, int duration)
+	: mod_(std::make_shared<Module>(mod)),
+	  instMan_(instMan),
+	  tickCounter_(std::make_shared<TickCounter>()),
+	  songNum_(songNum),
+	  startOrder_(0),
+	  storeOnlyUsedSamples_(true)
+{
+	opnaCtrl_ = std::make_shared<OPNAController>(emu, CHIP_CLOCK, 44100, duration);
+
+	Song& song = mod_->getSong(songNum_);
+	SongStyle style = song.getStyle();
+	opnaCtrl_->setMode(style.type);
+	tickCounter_->setInterruptRate(mod_->getTickFrequency());
+
+	playback_ = std::make_unique<PlaybackManager>(opnaCtrl_, instMan_, tickCounter_, mod_, false);
+	playback_->setSong(mod_, songNum_);
+
+	muteState_ = {
+		{ SoundSource::FM, std::vector<bool>(static_cast<size_t>(getFMChannelCount(style.type)), false) },
+		{ SoundSource::SSG, std::vector<bool>(3, false) },
+		{ SoundSource::RHYTHM, std::vector<bool>(6, false) },
+		{ SoundSource::ADPCM, std::vector<bool>(1, false) },
+	};
+}
+
+/********** Mixer **********/
+void OfflineRenderer::setMuteState(SoundSource src, int chInSrc, bool isMute)
+{
+	muteState_.at(src).at(static_cast<size_t>(chInSrc)) = isMute;
+}
+
+void OfflineRenderer::setMasterVolume(int percentage)
+{
+	opnaCtrl_->setMasterVolume(percentage);
+}
+
+void OfflineRenderer::setMasterVolumeFM(double dB)
+{
+	opnaCtrl_->setMasterVolumeFM(dB);
+}
+
+void OfflineRenderer::setMasterVolumeSSG(double dB)
+{
+	opnaCtrl_->setMasterVolumeSSG(dB);
+}
+
+/********** ADPCM **********/
+void OfflineRenderer::setStoreOnlyUsedSamples(bool enabled)
+{
+	storeOnlyUsedSamples_ = enabled;
+}
+
+void OfflineRenderer::assignSampleADPCMRawSamples()
+{
+	opnaCtrl_->clearSamplesADPCM();
+	for (auto sampNum : getSampleADPCMIndices()) {
+		std::vector<size_t> addresses
+				= opnaCtrl_->storeSampleADPCM(instMan_->getSampleADPCMRawSample(sampNum));
+		instMan_->setSampleADPCMStartAddress(sampNum, addresses[0]);
+		instMan_->setSampleADPCMStopAddress(sampNum, addresses[1]);
+	}
+}
+
+std::vector<int> OfflineRenderer::getSampleADPCMIndices() const
+{
+	return storeOnlyUsedSamples_ ? instMan_->getSampleADPCMValidIndices()
+								 : instMan_->getSampleADPCMEntriedIndices();
+}
+
+void OfflineRenderer::restoreSampleADPCMRawSamples()
+{
+	opnaCtrl_->clearSamplesADPCM();
+	for (auto sampNum : getSampleADPCMIndices()) {
+		opnaCtrl_->storeSampleADPCM(instMan_->getSampleADPCMRawSample(sampNum),
+									instMan_->getSampleADPCMStartAddress(sampNum));
+	}
+}
+
+std::vector<uint8_t> OfflineRenderer::createSampleADPCMROM() const
+{
+	std::vector<uint8_t> rom;
+	for (auto sampNum : instMan_->getSampleADPCMValidIndices()) {
+		std::vector<uint8_t> sample = instMan_->getSampleADPCMRawSample(sampNum);
+		size_t start = instMan_->getSampleADPCMStartAddress(sampNum) << 5;
+		size_t stop = (instMan_->getSampleADPCMStopAddress(sampNum) + 1) << 5;
+		if (rom.size() < stop) rom.resize(stop);
+		std::copy_n(sample.begin(), std::min(sample.size(), stop - start),
+					rom.begin() + static_cast<int>(start));
+	}
+	return rom;
+}
+
+/********** Play song **********/
+void OfflineRenderer::setStartOrder(int order, bool isFullScan, PlaybackManager::ChannelRetriever retriever)
+{
+	startOrder_ = order;
+	playback_->setChannelRetrieving(order > 0);
+	playback_->setChannelRetrievingByFullScan(isFullScan);
+	playback_->setChannelRetriever(retriever);
+}
+
+void OfflineRenderer::startPlay()
+{
+	if (startOrder_ > 0) playback_->startPlaySong(startOrder_);
+	else playback_->startPlayFromStart();
+
+	for (auto& pair : muteState_) {
+		for (size_t i = 0; i < pair.second.size(); ++i) {
+			opnaCtrl_->setMuteState(pair.first, static_cast<int>(i), pair.second[i]);
+		}
+	}
+}
+
+void OfflineRenderer::stopPlay()
+{
+	opnaCtrl_->setExportContainer();
+	playback_->stopPlaySong();
+}
+
+/********** Render **********/
+bool OfflineRenderer::renderToWav(WavWriter& writer, int loopCnt, std::function<bool()> bar)
+{
+	opnaCtrl_->setRate(static_cast<int>(writer.getSampleRate()));
+	size_t sampCnt = static_cast<size_t>(opnaCtrl_->getRate() * opnaCtrl_->getDuration() / 1000);
+	size_t intrCnt = static_cast<size_t>(opnaCtrl_->getRate()) / mod_->getTickFrequency();
+	size_t intrCntRest = 0;
+	// 16-bit output is mixed in fixed point, others on the float bus
+	const bool isInt16 = (writer.getSampleFormat() == WavWriter::SampleFormat::Int16);
+	std::vector<int16_t> dumbuf(isInt16 ? (sampCnt << 1) : 0);
+	std::vector<float> floatBuf(isInt16 ? 0 : (sampCnt << 1));
+
+	int endOrder = 0;
+	int endStep = 0;
+	size_t dummy = 0;
+	SongLengthCalculator(*mod_, songNum_).checkNextPositionOfLastStepAndStepSize(endOrder, endStep, dummy, dummy);
+	bool endFlag = false;
+	restoreSampleADPCMRawSamples();
+	startPlay();
+
+	while (true) {
+		size_t sampCntRest = sampCnt;
+		while (sampCntRest) {
+			if (!intrCntRest) {	// Interruption
+				intrCntRest = intrCnt;    // Set counts to next interruption
+
+				if (!playback_->streamCountUp()) {
+					if (bar()) {	// Update lambda function
+						stopPlay();
+						return false;
+					}
+
+					int playOrder = playback_->getPlayingOrderNumber();
+					int playStep = playback_->getPlayingStepNumber();
+					if ((playOrder == -1 && playStep == -1)
+							|| (playOrder == endOrder && playStep == endStep && !(loopCnt--))){
+						endFlag = true;
+						break;
+					}
+				}
+			}
+
+			size_t count = std::min(intrCntRest, sampCntRest);
+			sampCntRest -= count;
+			intrCntRest -= count;
+
+			if (isInt16) {
+				opnaCtrl_->getStreamSamples(&dumbuf[0], count);
+				writer.writeSamples(&dumbuf[0], count);
+			}
+			else {
+				opnaCtrl_->getStreamSamples(&floatBuf[0], count);
+				writer.writeSamples(&floatBuf[0], count);
+			}
+		}
+
+		if (endFlag) break;
+	}
+
+	stopPlay();
+
+	writer.finalize();
+
+	return true;
+}
+
+bool OfflineRenderer::renderToVgm(BinaryContainer& container, int target, bool gd3TagEnabled,
+								  GD3Tag tag, std::function<bool()> bar)
+{
+	opnaCtrl_->setRate(44100);
+	double dblIntrCnt = 44100.0 / static_cast<double>(mod_->getTickFrequency());
+	size_t intrCnt = static_cast<size_t>(dblIntrCnt);
+	double intrCntDiff = dblIntrCnt - intrCnt;
+	double intrCntRest = 0;
+	std::vector<int16_t> dumbuf((intrCnt + 1) << 1);
+
+	int loopOrder = 0;
+	int loopStep = 0;
+	size_t dummy = 0;
+	SongLengthCalculator(*mod_, songNum_).checkNextPositionOfLastStepAndStepSize(loopOrder, loopStep, dummy, dummy);
+	bool loopFlag = (loopOrder != -1);
+	int endCnt = (loopOrder == -1) ? 0 : 1;
+	uint32_t loopPoint = 0;
+	uint32_t loopPointSamples = 0;
+
+	std::shared_ptr<chip::VgmExportContainer> exCntr
+			= std::make_shared<chip::VgmExportContainer>(target, mod_->getTickFrequency());
+
+	// Set ADPCM
+	restoreSampleADPCMRawSamples();
+	exCntr->setDataBlock(createSampleADPCMROM());
+
+	opnaCtrl_->setExportContainer(exCntr);
+	startPlay();
+	opnaCtrl_->flushRegisterWrites();	// Record initial register states before the loop point
+	exCntr->forceMoveLoopPoint();
+
+	while (true) {
+		if (!playback_->streamCountUp()) {
+			if (bar()) {	// Update lambda function
+				stopPlay();
+				return false;
+			}
+
+			int playOrder = playback_->getPlayingOrderNumber();
+			int playStep = playback_->getPlayingStepNumber();
+			if (playOrder == loopOrder && playStep == loopStep && !(endCnt--)) break;
+
+			if (loopFlag && loopOrder == playOrder && loopStep == playStep) {
+				loopPoint = exCntr->setLoopPoint();
+				loopPointSamples = exCntr->getSampleLength();
+			}
+		}
+
+		intrCntRest += intrCntDiff;
+		size_t extraIntrCnt = static_cast<size_t>(intrCntRest);
+		intrCntRest -= extraIntrCnt;
+		opnaCtrl_->getStreamSamples(&dumbuf[0], intrCnt + extraIntrCnt);
+	}
+
+	stopPlay();
+
+	ExportHandler::writeVgm(container, target, exCntr->getData(), CHIP_CLOCK, mod_->getTickFrequency(),
+							loopFlag, loopPoint, exCntr->getSampleLength() - loopPointSamples,
+							exCntr->getSampleLength(), gd3TagEnabled, tag);
+	return true;
+}
+
+bool OfflineRenderer::renderToS98(BinaryContainer& container, int target, bool tagEnabled,
+								  S98Tag tag, int rate, std::function<bool()> bar)
+{
+	opnaCtrl_->setRate(rate);
+	double dblIntrCnt = static_cast<double>(rate) / static_cast<double>(mod_->getTickFrequency());
+	size_t intrCnt = static_cast<size_t>(dblIntrCnt);
+	double intrCntDiff = dblIntrCnt - intrCnt;
+	double intrCntRest = 0;
+	std::vector<int16_t> dumbuf((intrCnt + 1) << 1);
+
+	int loopOrder = 0;
+	int loopStep = 0;
+	size_t dummy = 0;
+	SongLengthCalculator(*mod_, songNum_).checkNextPositionOfLastStepAndStepSize(loopOrder, loopStep, dummy, dummy);
+	bool loopFlag = (loopOrder != -1);
+	int endCnt = (loopOrder == -1) ? 0 : 1;
+	uint32_t loopPoint = 0;
+	std::shared_ptr<chip::S98ExportContainer> exCntr = std::make_shared<chip::S98ExportContainer>(target);
+	opnaCtrl_->setExportContainer(exCntr);
+	startPlay();
+	restoreSampleADPCMRawSamples();	// Record DRAM writes
+	opnaCtrl_->flushRegisterWrites();	// Record initial register states before the loop point
+	exCntr->forceMoveLoopPoint();
+
+	while (true) {
+		exCntr->getData();	// Set wait counts
+		if (!playback_->streamCountUp()) {
+			if (bar()) {	// Update lambda function
+				stopPlay();
+				return false;
+			}
+
+			int playOrder = playback_->getPlayingOrderNumber();
+			int playStep = playback_->getPlayingStepNumber();
+			if (playOrder == loopOrder && playStep == loopStep && !(endCnt--)) break;
+
+			if (loopFlag && loopOrder == playOrder && loopStep == playStep) {
+				loopPoint = exCntr->setLoopPoint();
+			}
+		}
+
+		intrCntRest += intrCntDiff;
+		size_t extraIntrCnt = static_cast<size_t>(intrCntRest);
+		intrCntRest -= extraIntrCnt;
+		opnaCtrl_->getStreamSamples(&dumbuf[0], intrCnt + extraIntrCnt);
+	}
+
+	stopPlay();
+
+	ExportHandler::writeS98(container, target, exCntr->getData(), CHIP_CLOCK, static_cast<uint32_t>(rate),
+							loopFlag, loopPoint, tagEnabled, tag);
+	return true;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include "opna_controller.hpp"
+#include "instruments_manager.hpp"
+#include "tick_counter.hpp"
+#include "module.hpp"
+#include "playback.hpp"
+#include "gd3_tag.hpp"
+#include "s98_tag.hpp"
+#include "binary_container.hpp"
+#include "wav_writer.hpp"
+#include "enum_hash.hpp"
+#include "misc.hpp"
+
+/// Render a song with its own chip and playback routine.
+/// It works on a copy of the module, so the interactive session is never touched.
+/// The instruments manager is only read. ADPCM samples are uploaded to the addresses
+/// already assigned in it (see assignSampleADPCMRawSamples for an unshared manager).
+class OfflineRenderer
+{
+public:
+	OfflineRenderer(const Module& mod, std::shared_ptr<InstrumentsManager> instMan, int songNum,
+					chip::Emu emu = chip::Emu::Mame, int duration = 40);
+
+	// Mixer
+	void setMuteState(SoundSource src, int chInSrc, bool isMute);
+	void setMasterVolume(int percentage);
+	void setMasterVolumeFM(double dB);
+	void setMasterVolumeSSG(double dB);
+
+	// ADPCM
+	void setStoreOnlyUsedSamples(bool enabled);
+	/// Assign sample addresses in the instruments manager.
+	/// NOTE: Use only when the instruments manager is not shared with other sessions
+	void assignSampleADPCMRawSamples();
+
+	// Render
+	/// Start rendering from the order with the channel states retrieved.
+	/// [isFullScan] Retrieve the states by scanning the song from the head instead of the song timeline
+	/// [retriever] Retrieve the states with it instead of the song timeline if it is set
+	void setStartOrder(int order, bool isFullScan = false,
+					   PlaybackManager::ChannelRetriever retriever = nullptr);
+	bool renderToWav(WavWriter& writer, int loopCnt, std::function<bool()> bar);
+	bool renderToVgm(BinaryContainer& container, int target, bool gd3TagEnabled,
+					 GD3Tag tag, std::function<bool()> bar);
+	bool renderToS98(BinaryContainer& container, int target, bool tagEnabled, S98Tag tag,
+					 int rate, std::function<bool()> bar);
+
+	static const uint32_t CHIP_CLOCK;
+
+private:
+	std::shared_ptr<Module> mod_;
+	std::shared_ptr<InstrumentsManager> instMan_;
+	std::shared_ptr<OPNAController> opnaCtrl_;
+	std::shared_ptr<TickCounter> tickCounter_;
+	std::unique_ptr<PlaybackManager> playback_;
+
+	int songNum_;
+	int startOrder_;
+	std::unordered_map<SoundSource, std::vector<bool>> muteState_;
+	bool storeOnlyUsedSamples_;
+
+	void startPlay();
+	void stopPlay();
+	std::vector<int> getSampleADPCMIndices() const;
+	void restoreSampleADPCMRawSamples();
+	std::vector<uint8_t> createSampleADPCMROM() const;
+};
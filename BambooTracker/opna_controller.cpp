@@ -24,6 +24,7 @@
  */
 
 #include "opna_controller.hpp"
+#include <algorithm>
 #include <stdexcept>
 #include <limits>
 #include "pitch_converter.hpp"
@@ -72,8 +73,8 @@ OPNAController::OPNAController(chip::Emu emu, int clock, int rate, int duration)
 	  storePointADPCM_(0)
 {
 	opna_ = std::make_unique<chip::OPNA>(emu, clock, rate, duration, dramSize_,
-										 std::make_unique<chip::LinearResampler>(),
-										 std::make_unique<chip::LinearResampler>());
+										 std::make_unique<chip::SincResampler>(),
+										 std::make_unique<chip::SincResampler>());
 
 	for (int ch = 0; ch < 6; ++ch) {
 		fmOpEnables_[ch] = 0xf;
@@ -157,6 +158,16 @@ void OPNAController::updateRegisterStates()
 	}
 }
 
+void OPNAController::flushRegisterWrites()
+{
+	opna_->flushRegisterWrites();
+}
+
+void OPNAController::setRegisterWriteOffset(size_t offset)
+{
+	opna_->setRegisterWriteOffset(offset);
+}
+
 /********** Real chip interface **********/
 void OPNAController::useSCCI(scci::SoundInterfaceManager* manager)
 {
@@ -187,6 +198,14 @@ void OPNAController::getStreamSamples(int16_t* container, size_t nSamples)
 	fillOutputHistory(&container[2 * (nSamples - nHistory)], nHistory);
 }
 
+void OPNAController::getStreamSamples(float* container, size_t nSamples)
+{
+	opna_->mix(container, nSamples);
+
+	size_t nHistory = std::min<size_t>(nSamples, OUTPUT_HISTORY_SIZE);
+	fillOutputHistory(&container[2 * (nSamples - nHistory)], nHistory);
+}
+
 void OPNAController::getOutputHistory(int16_t* container)
 {
 	std::lock_guard<std::mutex> lock(outputHistoryReadyMutex_);
@@ -217,6 +236,15 @@ void OPNAController::fillOutputHistory(const int16_t* outputs, size_t nSamples)
 		transferReadyHistory();
 }
 
+void OPNAController::fillOutputHistory(const float* outputs, size_t nSamples)
+{
+	int16_t history[2 * OUTPUT_HISTORY_SIZE];
+	std::transform(outputs, &outputs[2 * nSamples], history, [](float s) {
+		return static_cast<int16_t>(chip::clamp(s * 32768.f, -32768.f, 32767.f));
+	});
+	fillOutputHistory(history, nSamples);
+}
+
 void OPNAController::transferReadyHistory()
 {
 	const int16_t* src = outputHistory_.get();
@@ -3461,10 +3489,8 @@ std::vector<size_t> OPNAController::storeSampleADPCM(std::vector<uint8_t> sample
 		opna_->setRegister(0x105, (stopAddress >> 8) & 0xff);
 		storePointADPCM_ = stopAddress + 1;
 
-		size_t size = sample.size();
-		for (size_t i = 0; i < size; ++i) {
-			opna_->setRegister(0x108, sample[i]);
-		}
+		size_t size = std::min(sample.size(), (stopAddress - startAddress + 1) << 5);
+		opna_->writeDRAM(startAddress << 5, sample.data(), size);
 
 		addrs = { startAddress, stopAddress };
 	}
@@ -3475,6 +3501,12 @@ std::vector<size_t> OPNAController::storeSampleADPCM(std::vector<uint8_t> sample
 	return addrs;
 }
 
+std::vector<size_t> OPNAController::storeSampleADPCM(std::vector<uint8_t> sample, size_t startAddress)
+{
+	storePointADPCM_ = startAddress;
+	return storeSampleADPCM(std::move(sample));
+}
+
 /********** Set volume **********/
 void OPNAController::setVolumeADPCM(int volume)
 {
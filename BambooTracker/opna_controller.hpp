@@ -76,6 +76,8 @@ public:
 
 	// Update register states after tick process
 	void updateRegisterStates();
+	void flushRegisterWrites();
+	void setRegisterWriteOffset(size_t offset);
 
 	// Real chip interface
 	void useSCCI(scci::SoundInterfaceManager* manager);
@@ -85,6 +87,7 @@ public:
 
 	// Stream samples
 	void getStreamSamples(int16_t* container, size_t nSamples);
+	void getStreamSamples(float* container, size_t nSamples);
 	void getOutputHistory(int16_t* history);
 
 	static constexpr int OUTPUT_HISTORY_SIZE = 1024;
@@ -121,6 +124,7 @@ private:
 	void initChip();
 
 	void fillOutputHistory(const int16_t* outputs, size_t nSamples);
+	void fillOutputHistory(const float* outputs, size_t nSamples);
 	void transferReadyHistory();
 
 	void checkRealToneByArpeggio(int seqPos, const std::unique_ptr<SequenceIteratorInterface>& arpIt,
@@ -486,6 +490,9 @@ public:
 	void clearSamplesADPCM();
 	/// return: [0]: start address, [1]: stop address
 	std::vector<size_t> storeSampleADPCM(std::vector<uint8_t> sample);
+	/// Store sample from the given start address (by 32 bytes)
+	/// return: [0]: start address, [1]: stop address
+	std::vector<size_t> storeSampleADPCM(std::vector<uint8_t> sample, size_t startAddress);
 
 	// Set volume
 	void setVolumeADPCM(int volume);
@@ -41,7 +41,8 @@ PlaybackManager::PlaybackManager(std::shared_ptr<OPNAController> opnaCtrl,
 	  playStepNum_(-1),
 	  playState_(0),
 	  isFindNextStep_(false),
-	  isRetrieveChannel_(isRetrieveChannel)
+	  isRetrieveChannel_(isRetrieveChannel),
+	  isRetrieveByFullScan_(false)
 {
 	songStyle_ = mod.lock()->getSong(curSongNum_).getStyle();
 
@@ -100,6 +101,11 @@ void PlaybackManager::setSong(std::weak_ptr<Module> mod, int songNum)
 	volDlyValueADPCM_ = -1;
 }
 
+void PlaybackManager::setInstrumentsManager(std::weak_ptr<InstrumentsManager> instMan)
+{
+	instMan_ = instMan;
+}
+
 /********** Play song **********/
 void PlaybackManager::startPlaySong(int order)
 {
@@ -362,7 +368,7 @@ void PlaybackManager::stepProcess()
 		}
 		bool isDelay = false;
 		for (int i = 0; i < 4; ++i) {
-			Effect&& eff = Effect::makeEffectData(attrib.source, step.getEffectID(i), step.getEffectValue(i));
+			Effect&& eff = Effect::makeEffectData(attrib.source, step.getEffectIDCode(i), step.getEffectValue(i));
 			isDelay |= (this->*storeEffectToMap)(attrib.channelInSource, std::move(eff));
 		}
 		isNoteDelay_[attrib.source].at(uch) = isDelay;
@@ -1320,7 +1326,7 @@ void PlaybackManager::tickProcess(int rest)
 			auto& step = song.getTrack(attrib.number)
 						 .getPatternFromOrderNumber(nextReadOrder_).getStep(nextReadStep_);
 			for (int i = 0; i < 4; ++i) {
-				auto&& eff = Effect::makeEffectData(attrib.source, step.getEffectID(i), step.getEffectValue(i));
+				auto&& eff = Effect::makeEffectData(attrib.source, step.getEffectIDCode(i), step.getEffectValue(i));
 				if (eff.type == EffectType::NoteDelay && eff.value > 0) {	// Note delay check
 					opnaCtrl_->tickEvent(attrib.source, ch);
 					return;
@@ -1370,7 +1376,7 @@ void PlaybackManager::envelopeResetEffectFM(Step& step, int ch)
 			&& opnaCtrl_->enableFMEnvelopeReset(ch)) {	// Key on or echo buffer access
 		for (int i = 0; i < 4; ++i) {
 			auto&& eff = Effect::makeEffectData(	// "SoundSource::FM" is dummy
-													SoundSource::FM, step.getEffectID(i), step.getEffectValue(i));
+													SoundSource::FM, step.getEffectIDCode(i), step.getEffectValue(i));
 			if (eff.type == EffectType::TonePortamento) {
 				if (eff.value) opnaCtrl_->tickEvent(SoundSource::FM, ch);
 				else opnaCtrl_->resetFMChannelEnvelope(ch);
@@ -1551,622 +1557,374 @@ void PlaybackManager::setChannelRetrieving(bool enabled)
 	isRetrieveChannel_ = enabled;
 }
 
-void PlaybackManager::retrieveChannelStates()
+void PlaybackManager::setChannelRetrievingByFullScan(bool enabled)
 {
-	size_t fmch = getFMChannelCount(songStyle_.type);
+	isRetrieveByFullScan_ = enabled;
+}
 
-	std::vector<int> tonesCntFM(fmch), tonesCntSSG(3);
-	int tonesCntADPCM = 0;
-	std::vector<std::vector<int>> toneFM(fmch), toneSSG(3);
-	std::vector<int> toneADPCM = std::vector<int>(3, -1);
-	for (size_t i = 0; i < fmch; ++i) {
-		toneFM.at(i) = std::vector<int>(3, -1);
-	}
-	for (size_t i = 0; i < 3; ++i) {
-		toneSSG.at(i) = std::vector<int>(3, -1);
-	}
-	std::vector<bool> isSetInstFM(fmch, false), isSetVolFM(fmch, false), isSetArpFM(fmch, false);
-	std::vector<bool> isSetPrtFM(fmch, false), isSetVibFM(fmch, false), isSetTreFM(fmch, false);
-	std::vector<bool> isSetPanFM(fmch, false), isSetVolSldFM(fmch, false), isSetDtnFM(fmch, false);
-	std::vector<bool> isSetFBCtrlFM(fmch, false), isSetTLCtrlFM(fmch, false), isSetMLCtrlFM(fmch, false);
-	std::vector<bool> isSetARCtrlFM(fmch, false), isSetDRCtrlFM(fmch, false), isSetRRCtrlFM(fmch, false);
-	std::vector<bool> isSetBrightFM(fmch, false), isSetFiDtnFM(fmch, false);
-	std::vector<bool> isSetInstSSG(3, false), isSetVolSSG(3, false), isSetArpSSG(3, false), isSetPrtSSG(3, false);
-	std::vector<bool> isSetVibSSG(3, false), isSetTreSSG(3, false), isSetVolSldSSG(3, false), isSetDtnSSG(3, false);
-	std::vector<bool> isSetTNMixSSG(3, false), isSetFiDtnSSG(3, false);
-	std::vector<bool> isSetVolRhythm(6, false), isSetPanRhythm(6, false);
-	bool isSetInstADPCM(false), isSetVolADPCM(false), isSetArpADPCM(false), isSetPrtADPCM(false);
-	bool isSetVibADPCM(false), isSetTreADPCM(false), isSetPanADPCM(false), isSetVolSldADPCM(false);
-	bool isSetDtnADPCM(false), isSetFiDtnADPCM(false);
-	bool isSetMVolRhythm = false;
-	bool isSetNoisePitchSSG = false;
-	bool isSetHardEnvPeriodHighSSG = false;
-	bool isSetHardEnvPeriodLowSSG = false;
-	bool isSetAutoEnvSSG = false;
-	/// bit0: step
-	/// bit1: tempo
-	/// bit2: groove
-	uint8_t speedStates = 0;
+void PlaybackManager::setChannelRetriever(ChannelRetriever retriever)
+{
+	retriever_ = retriever;
+}
+
+void PlaybackManager::retrieveChannelStates()
+{
+	if (retriever_) {
+		retriever_(*this);
+		return;
+	}
 
-	int o = playOrderNum_;
-	int s = playStepNum_;
-	bool isPrevPos = false;
 	Song& song = mod_.lock()->getSong(curSongNum_);
 
-	while (true) {
-		for (auto it = songStyle_.trackAttribs.rbegin(), e = songStyle_.trackAttribs.rend(); it != e; ++it) {
-			Step& step = song.getTrack(it->number).getPatternFromOrderNumber(o).getStep(s);
-			int ch = it->channelInSource;
-			size_t uch = static_cast<size_t>(ch);
+	// Scan the steps in the current order, and add the states before it from the song timeline
+	TimelineState state;
+	int firstOrder = isRetrieveByFullScan_ ? 0 : playOrderNum_;
+	for (int o = playOrderNum_; o >= firstOrder; --o) {
+		int lastStep = (o == playOrderNum_) ? playStepNum_
+											: static_cast<int>(song.getPatternSizeFromOrderNumber(o)) - 1;
+		for (int s = lastStep; s > -1; --s) {
+			for (auto it = songStyle_.trackAttribs.rbegin(), e = songStyle_.trackAttribs.rend(); it != e; ++it) {
+				Step& step = song.getTrack(it->number).getPatternFromOrderNumber(o).getStep(s);
+				// The step at the start position is executed by playback itself
+				state.scanStep(step, *it, TimelineState::makeKey(o, s, it->number),
+							   o == playOrderNum_ && s == playStepNum_);
+			}
+		}
+	}
+	if (!isRetrieveByFullScan_) state.append(song.getStatesBeforeOrder(playOrderNum_));
+
+	applyTimelineState(state);
+}
+
+void PlaybackManager::applyTimelineState(const TimelineState& state)
+{
+	using Param = TimelineState::Param;
+	using Flag = TimelineState::Flag;
+
+	struct Change
+	{
+		uint64_t key;
+		TrackAttribute attrib;
+		Param param;
+		const TimelineState::Value* value;
+	};
+
+	// Apply the states in the same order as they are found in a backward scan
+	std::vector<Change> changes;
+	TrackAttribute global{ -1, SoundSource::SSG, 0 };
+	for (const TrackAttribute& attrib : songStyle_.trackAttribs) {
+		size_t slot = TimelineState::toSlot(attrib.source, attrib.channelInSource);
+		for (size_t p = 0; p < TimelineState::PARAM_CNT; ++p) {
+			const TimelineState::Value& value = state.getValue(slot, static_cast<Param>(p));
+			if (value.flag == Flag::Set) changes.push_back({ value.key, attrib, static_cast<Param>(p), &value });
+		}
 
-			switch (it->source) {
-			case SoundSource::FM:
+		// Choose the first valid instrument
+		for (const TimelineState::Value& value : state.getInstrumentCandidates(slot)) {
+			auto inst = instMan_.lock()->getInstrumentSharedPtr(value.value);
+			bool isValid = false;
+			switch (attrib.source) {
+			case SoundSource::FM:		isValid = !!std::dynamic_pointer_cast<InstrumentFM>(inst);		break;
+			case SoundSource::SSG:		isValid = !!std::dynamic_pointer_cast<InstrumentSSG>(inst);		break;
+			case SoundSource::ADPCM:	isValid = !!std::dynamic_pointer_cast<InstrumentADPCM>(inst);	break;
+			default:	break;
+			}
+			if (isValid) {
+				if (value.flag == Flag::Set) changes.push_back({ value.key, attrib, Param::Instrument, &value });
+				break;
+			}
+		}
+	}
+	for (size_t p = 0; p < TimelineState::PARAM_CNT; ++p) {
+		const TimelineState::Value& value = state.getValue(TimelineState::GLOBAL_SLOT, static_cast<Param>(p));
+		if (value.flag == Flag::Set) changes.push_back({ value.key, global, static_cast<Param>(p), &value });
+	}
+	std::sort(changes.begin(), changes.end(), [](const Change& a, const Change& b) { return a.key > b.key; });
+
+	for (const Change& change : changes) {
+		int ch = change.attrib.channelInSource;
+		int v = change.value->value;
+		int sub = change.value->sub;
+		switch (change.attrib.source) {
+		case SoundSource::FM:
+			switch (change.param) {
+			case Param::Volume:
+				opnaCtrl_->setVolumeFM(ch, v);
+				break;
+			case Param::Instrument:
+				opnaCtrl_->setInstrumentFM(
+							ch, std::dynamic_pointer_cast<InstrumentFM>(instMan_.lock()->getInstrumentSharedPtr(v)));
+				break;
+			case Param::Arpeggio:
+				opnaCtrl_->setArpeggioEffectFM(ch, v >> 4, v & 0x0f);
+				break;
+			case Param::Portamento:
+				if (sub == 2) opnaCtrl_->setPortamentoEffectFM(ch, v, true);
+				else opnaCtrl_->setPortamentoEffectFM(ch, sub ? -v : v);
+				break;
+			case Param::Vibrato:
+				opnaCtrl_->setVibratoEffectFM(ch, v >> 4, v & 0x0f);
+				break;
+			case Param::Tremolo:
+				opnaCtrl_->setTremoloEffectFM(ch, v >> 4, v & 0x0f);
+				break;
+			case Param::Pan:
+				opnaCtrl_->setPanFM(ch, v);
+				break;
+			case Param::VolumeSlide:
 			{
-				// Volume
-				int vol = step.getVolume();
-				if (!isSetVolFM[uch] && 0 <= vol && vol < 0x80) {
-					isSetVolFM[uch] = true;
-					if (isPrevPos)
-						opnaCtrl_->setVolumeFM(ch, step.getVolume());
-				}
-				// Instrument
-				if (!isSetInstFM[uch] && step.getInstrumentNumber() != -1) {
-					if (auto inst = std::dynamic_pointer_cast<InstrumentFM>(
-								instMan_.lock()->getInstrumentSharedPtr(step.getInstrumentNumber()))) {
-						isSetInstFM[uch] = true;
-						if (isPrevPos)
-							opnaCtrl_->setInstrumentFM(ch, inst);
-					}
-				}
-				// Effects
-				for (int i = 3; i > -1; --i) {
-					Effect eff = Effect::makeEffectData(SoundSource::FM, step.getEffectID(i), step.getEffectValue(i));
-					switch (eff.type) {
-					case EffectType::Arpeggio:
-						if (!isSetArpFM[uch]) {
-							isSetArpFM[uch] = true;
-							if (isPrevPos) opnaCtrl_->setArpeggioEffectFM(ch, eff.value >> 4, eff.value & 0x0f);
-						}
-						break;
-					case EffectType::PortamentoUp:
-						if (!isSetPrtFM[uch]) {
-							isSetPrtFM[uch] = true;
-							if (isPrevPos) opnaCtrl_->setPortamentoEffectFM(ch, eff.value);
-						}
-						break;
-					case EffectType::PortamentoDown:
-						if (!isSetPrtFM[uch]) {
-							isSetPrtFM[uch] = true;
-							if (isPrevPos) opnaCtrl_->setPortamentoEffectFM(ch, -eff.value);
-						}
-						break;
-					case EffectType::TonePortamento:
-						if (!isSetPrtFM[uch]) {
-							isSetPrtFM[uch] = true;
-							if (isPrevPos) opnaCtrl_->setPortamentoEffectFM(ch, eff.value, true);
-						}
-						break;
-					case EffectType::Vibrato:
-						if (!isSetVibFM[uch]) {
-							isSetVibFM[uch] = true;
-							if (isPrevPos) opnaCtrl_->setVibratoEffectFM(ch, eff.value >> 4, eff.value & 0x0f);
-						}
-						break;
-					case EffectType::Tremolo:
-						if (!isSetTreFM[uch]) {
-							isSetTreFM[uch] = true;
-							if (isPrevPos) opnaCtrl_->setTremoloEffectFM(ch, eff.value >> 4, eff.value & 0x0f);
-						}
-						break;
-					case EffectType::Pan:
-						if (-1 < eff.value && eff.value < 4 && !isSetPanFM[uch]) {
-							isSetPanFM[uch] = true;
-							if (isPrevPos) opnaCtrl_->setPanFM(ch, eff.value);
-						}
-						break;
-					case EffectType::VolumeSlide:
-						if (!isSetVolSldFM[uch]) {
-							isSetVolSldFM[uch] = true;
-							if (isPrevPos) {
-								int hi = eff.value >> 4;
-								int low = eff.value & 0x0f;
-								if (hi && !low) opnaCtrl_->setVolumeSlideFM(ch, hi, true);	// Slide up
-								else if (!hi) opnaCtrl_->setVolumeSlideFM(ch, low, false);	// Slide down
-							}
-						}
-						break;
-					case EffectType::SpeedTempoChange:
-						if (!(speedStates & 0x4)) {
-							if (eff.value < 0x20) {				// Speed change
-								if (!(speedStates & 0x1)) {
-									speedStates |= 0x1;
-									if (isPrevPos) effSpeedChange(eff.value);
-								}
-							}
-							else if (!(speedStates & 0x2)) {	// Tempo change
-								speedStates |= 0x2;
-								if (isPrevPos) effTempoChange(eff.value);
-							}
-						}
-						break;
-					case EffectType::Groove:
-						if (eff.value < static_cast<int>(mod_.lock()->getGrooveCount()) && !speedStates) {
-							speedStates |= 0x4;
-							if (isPrevPos) effGrooveChange(eff.value);
-						}
-						break;
-					case EffectType::Detune:
-						if (!isSetDtnFM[uch]) {
-							isSetDtnFM[uch] = true;
-							if (isPrevPos) opnaCtrl_->setDetuneFM(ch, eff.value - 0x80);
-						}
-						break;
-					case EffectType::FineDetune:
-						if (!isSetFiDtnFM[uch]) {
-							isSetFiDtnFM[uch] = true;
-							if (isPrevPos) opnaCtrl_->setFineDetuneFM(ch, eff.value - 0x80);
-						}
-						break;
-					case EffectType::FBControl:
-						if (!isSetFBCtrlFM[uch]) {
-							isSetFBCtrlFM[uch] = true;
-							if (isPrevPos) {
-								if (-1 < eff.value && eff.value < 8) opnaCtrl_->setFBControlFM(ch, eff.value);
-							}
-						}
-						break;
-					case EffectType::TLControl:
-						if (!isSetTLCtrlFM[uch]) {
-							isSetTLCtrlFM[uch] = true;
-							if (isPrevPos) {
-								int op = eff.value >> 8;
-								int val = eff.value & 0x00ff;
-								if (0 < op && op < 5 && -1 < val && val < 128)
-									opnaCtrl_->setTLControlFM(ch, op - 1, val);
-							}
-						}
-						break;
-					case EffectType::MLControl:
-						if (!isSetMLCtrlFM[uch]) {
-							isSetMLCtrlFM[uch] = true;
-							if (isPrevPos) {
-								int op = eff.value >> 4;
-								int val = eff.value & 0x0f;
-								if (0 < op && op < 5 && -1 < val && val < 16)
-									opnaCtrl_->setMLControlFM(ch, op - 1, val);
-							}
-						}
-						break;
-					case EffectType::ARControl:
-						if (!isSetARCtrlFM[uch]) {
-							isSetARCtrlFM[uch] = true;
-							if (isPrevPos) {
-								int op = eff.value >> 8;
-								int val = eff.value & 0x00ff;
-								if (0 < op && op < 5 && -1 < val && val < 32)
-									opnaCtrl_->setARControlFM(ch, op - 1, val);
-							}
-						}
-						break;
-					case EffectType::DRControl:
-						if (!isSetDRCtrlFM[uch]) {
-							isSetDRCtrlFM[uch] = true;
-							if (isPrevPos) {
-								int op = eff.value >> 8;
-								int val = eff.value & 0x00ff;
-								if (0 < op && op < 5 && -1 < val && val < 32)
-									opnaCtrl_->setDRControlFM(ch, op - 1, val);
-							}
-						}
-						break;
-					case EffectType::RRControl:
-						if (!isSetRRCtrlFM[uch]) {
-							isSetRRCtrlFM[uch] = true;
-							if (isPrevPos) {
-								int op = eff.value >> 4;
-								int val = eff.value & 0x0f;
-								if (0 < op && op < 5 && -1 < val && val < 16)
-									opnaCtrl_->setRRControlFM(ch, op - 1, val);
-							}
-						}
-						break;
-					case EffectType::Brightness:
-						if (!isSetBrightFM[uch]) {
-							isSetBrightFM[uch] = true;
-							if (isPrevPos) {
-								if (0 < eff.value) opnaCtrl_->setBrightnessFM(ch, eff.value - 0x80);
-							}
-						}
-						break;
-					default:
-						break;
-					}
-				}
-				// Tone
-				int t = step.getNoteNumber();
-				if (isPrevPos && t != -1 && t != -2) {
-					--tonesCntFM[uch];
-					for (auto it2 = toneFM[uch].rbegin();
-						 it2 != toneFM[uch].rend(); ++it2) {
-						if (*it2 == -1 || *it2 == tonesCntFM[uch]) {
-							if (t >= 0) {
-								*it2 = t;
-							}
-							else if (t < -2) {
-								*it2 = tonesCntFM[uch] - t + 2;
-							}
-							break;
-						}
-					}
-				}
+				int hi = v >> 4;
+				int low = v & 0x0f;
+				if (hi && !low) opnaCtrl_->setVolumeSlideFM(ch, hi, true);	// Slide up
+				else if (!hi) opnaCtrl_->setVolumeSlideFM(ch, low, false);	// Slide down
 				break;
 			}
-			case SoundSource::SSG:
+			case Param::Detune:
+				opnaCtrl_->setDetuneFM(ch, v - 0x80);
+				break;
+			case Param::FineDetune:
+				opnaCtrl_->setFineDetuneFM(ch, v - 0x80);
+				break;
+			case Param::FBControl:
+				if (-1 < v && v < 8) opnaCtrl_->setFBControlFM(ch, v);
+				break;
+			case Param::TLControl:
 			{
-				// Volume
-				int vol = step.getVolume();
-				if (!isSetVolSSG[uch] && 0 <= vol && vol < 0x10) {
-					isSetVolSSG[uch] = true;
-					if (isPrevPos)
-						opnaCtrl_->setVolumeSSG(ch, vol);
-				}
-				// Instrument
-				if (!isSetInstSSG[uch] && step.getInstrumentNumber() != -1) {
-					if (auto inst = std::dynamic_pointer_cast<InstrumentSSG>(
-								instMan_.lock()->getInstrumentSharedPtr(step.getInstrumentNumber()))) {
-						isSetInstSSG[uch] = true;
-						if (isPrevPos)
-							opnaCtrl_->setInstrumentSSG(ch, inst);
-					}
-				}
-				// Effects
-				for (int i = 3; i > -1; --i) {
-					Effect eff = Effect::makeEffectData(SoundSource::SSG, step.getEffectID(i), step.getEffectValue(i));
-					switch (eff.type) {
-					case EffectType::Arpeggio:
-						if (!isSetArpSSG[uch]) {
-							isSetArpSSG[uch] = true;
-							if (isPrevPos) opnaCtrl_->setArpeggioEffectSSG(ch, eff.value >> 4, eff.value & 0x0f);
-						}
-						break;
-					case EffectType::PortamentoUp:
-						if (!isSetPrtSSG[uch]) {
-							isSetPrtSSG[uch] = true;
-							if (isPrevPos) opnaCtrl_->setPortamentoEffectSSG(ch, eff.value);
-						}
-						break;
-					case EffectType::PortamentoDown:
-						if (!isSetPrtSSG[uch]) {
-							isSetPrtSSG[uch] = true;
-							if (isPrevPos) opnaCtrl_->setPortamentoEffectSSG(ch, -eff.value);
-						}
-						break;
-					case EffectType::TonePortamento:
-						if (!isSetPrtSSG[uch]) {
-							isSetPrtSSG[uch] = true;
-							if (isPrevPos) opnaCtrl_->setPortamentoEffectSSG(ch, eff.value, true);
-						}
-						break;
-					case EffectType::Vibrato:
-						if (!isSetVibSSG[uch]) {
-							isSetVibSSG[uch] = true;
-							if (isPrevPos) opnaCtrl_->setVibratoEffectSSG(ch, eff.value >> 4, eff.value & 0x0f);
-						}
-						break;
-					case EffectType::Tremolo:
-						if (!isSetTreSSG[uch]) {
-							isSetTreSSG[uch] = true;
-							if (isPrevPos) opnaCtrl_->setTremoloEffectSSG(ch, eff.value >> 4, eff.value & 0x0f);
-						}
-						break;
-					case EffectType::VolumeSlide:
-						if (!isSetVolSldSSG[uch]) {
-							isSetVolSldSSG[uch] = true;
-							if (isPrevPos) {
-								int hi = eff.value >> 4;
-								int low = eff.value & 0x0f;
-								if (hi && !low) opnaCtrl_->setVolumeSlideSSG(ch, hi, true);	// Slide up
-								else if (!hi) opnaCtrl_->setVolumeSlideSSG(ch, low, false);	// Slide down
-							}
-						}
-						break;
-					case EffectType::SpeedTempoChange:
-						if (!(speedStates & 0x4)) {
-							if (eff.value < 0x20) {				// Speed change
-								if (!(speedStates & 0x1)) {
-									speedStates |= 0x1;
-									if (isPrevPos) effSpeedChange(eff.value);
-								}
-							}
-							else if (!(speedStates & 0x2)) {	// Tempo change
-								speedStates |= 0x2;
-								if (isPrevPos) effTempoChange(eff.value);
-							}
-						}
-						break;
-					case EffectType::Groove:
-						if (eff.value < static_cast<int>(mod_.lock()->getGrooveCount()) && !speedStates) {
-							speedStates |= 0x4;
-							if (isPrevPos) effGrooveChange(eff.value);
-						}
-						break;
-					case EffectType::Detune:
-						if (!isSetDtnSSG[uch]) {
-							isSetDtnSSG[uch] = true;
-							if (isPrevPos) opnaCtrl_->setDetuneSSG(ch, eff.value - 0x80);
-						}
-						break;
-					case EffectType::FineDetune:
-						if (!isSetFiDtnSSG[uch]) {
-							isSetFiDtnSSG[uch] = true;
-							if (isPrevPos) opnaCtrl_->setFineDetuneSSG(ch, eff.value - 0x80);
-						}
-						break;
-					case EffectType::ToneNoiseMix:
-						if (-1 < eff.value && eff.value < 4 && !isSetTNMixSSG[uch]) {
-							isSetTNMixSSG[uch] = true;
-							if (isPrevPos) opnaCtrl_->setToneNoiseMixSSG(ch, eff.value);
-						}
-						break;
-					case EffectType::NoisePitch:
-						if (-1 < eff.value && eff.value < 32 && !isSetNoisePitchSSG) {
-							isSetNoisePitchSSG = true;
-							if (isPrevPos) opnaCtrl_->setNoisePitchSSG(ch, eff.value);
-						}
-						break;
-					case EffectType::HardEnvHighPeriod:
-						if (!isSetHardEnvPeriodHighSSG) {
-							isSetHardEnvPeriodHighSSG = true;
-							if (isPrevPos) opnaCtrl_->setHardEnvelopePeriod(ch, true, eff.value);
-						}
-						break;
-					case EffectType::HardEnvLowPeriod:
-						if (!isSetHardEnvPeriodLowSSG) {
-							isSetHardEnvPeriodLowSSG = true;
-							if (isPrevPos) opnaCtrl_->setHardEnvelopePeriod(ch, false, eff.value);
-						}
-						break;
-					case EffectType::AutoEnvelope:
-						if (!isSetAutoEnvSSG) {
-							isSetAutoEnvSSG = true;
-							if (isPrevPos) opnaCtrl_->setAutoEnvelopeSSG(ch, (eff.value >> 4) - 8, eff.value & 0x0f);
-						}
-						break;
-					default:
-						break;
-					}
-				}
-				// Tone
-				int t = step.getNoteNumber();
-				if (isPrevPos && t != -1 && t != -2) {
-					--tonesCntSSG[uch];
-					for (auto it2 = toneSSG[uch].rbegin();
-						 it2 != toneSSG[uch].rend(); ++it2) {
-						if (*it2 == -1 || *it2 == tonesCntSSG[uch]) {
-							if (t >= 0) {
-								*it2 = t;
-							}
-							else if (t < -2) {
-								*it2 = tonesCntSSG[uch] - t + 2;
-							}
-							break;
-						}
-					}
-				}
+				int op = v >> 8;
+				int val = v & 0x00ff;
+				if (0 < op && op < 5 && -1 < val && val < 128)
+					opnaCtrl_->setTLControlFM(ch, op - 1, val);
 				break;
 			}
-			case SoundSource::RHYTHM:
+			case Param::MLControl:
 			{
-				// Volume
-				int vol = step.getVolume();
-				if (!isSetVolRhythm[uch] && 0 <= vol && vol < 0x20) {
-					isSetVolRhythm[uch] = true;
-					if (isPrevPos)
-						opnaCtrl_->setVolumeRhythm(ch, vol);
-				}
-				// Effects
-				for (int i = 3; i > -1; --i) {
-					Effect eff = Effect::makeEffectData(SoundSource::RHYTHM, step.getEffectID(i), step.getEffectValue(i));
-					switch (eff.type) {
-					case EffectType::Pan:
-						if (-1 < eff.value && eff.value < 4 && !isSetPanRhythm[uch]) {
-							isSetPanRhythm[uch] = true;
-							if (isPrevPos) opnaCtrl_->setPanRhythm(ch, eff.value);
-						}
-						break;
-					case EffectType::SpeedTempoChange:
-						if (!(speedStates & 0x4)) {
-							if (eff.value < 0x20) {				// Speed change
-								if (!(speedStates & 0x1)) {
-									speedStates |= 0x1;
-									if (isPrevPos) effSpeedChange(eff.value);
-								}
-							}
-							else if (!(speedStates & 0x2)) {	// Tempo change
-								speedStates |= 0x2;
-								if (isPrevPos) effTempoChange(eff.value);
-							}
-						}
-						break;
-					case EffectType::Groove:
-						if (eff.value < static_cast<int>(mod_.lock()->getGrooveCount()) && !speedStates) {
-							speedStates |= 0x4;
-							if (isPrevPos) effGrooveChange(eff.value);
-						}
-						break;
-					case EffectType::MasterVolume:
-						if (-1 < eff.value && eff.value < 64 && !isSetMVolRhythm) {
-							isSetMVolRhythm = true;
-							if (isPrevPos) opnaCtrl_->setMasterVolumeRhythm(eff.value);
-						}
-						break;
-					default:
-						break;
-					}
-				}
+				int op = v >> 4;
+				int val = v & 0x0f;
+				if (0 < op && op < 5 && -1 < val && val < 16)
+					opnaCtrl_->setMLControlFM(ch, op - 1, val);
 				break;
 			}
-			case SoundSource::ADPCM:
+			case Param::ARControl:
 			{
-				// Volume
-				int vol = step.getVolume();
-				if (!isSetVolADPCM && 0 <= vol && vol < 0x100) {
-					isSetVolADPCM = true;
-					if (isPrevPos)
-						opnaCtrl_->setVolumeADPCM(step.getVolume());
-				}
-				// Instrument
-				if (!isSetInstADPCM && step.getInstrumentNumber() != -1) {
-					if (auto inst = std::dynamic_pointer_cast<InstrumentADPCM>(
-								instMan_.lock()->getInstrumentSharedPtr(step.getInstrumentNumber()))) {
-						isSetInstADPCM = true;
-						if (isPrevPos)
-							opnaCtrl_->setInstrumentADPCM(inst);
-					}
-				}
-				// Effects
-				for (int i = 3; i > -1; --i) {
-					Effect eff = Effect::makeEffectData(SoundSource::ADPCM, step.getEffectID(i), step.getEffectValue(i));
-					switch (eff.type) {
-					case EffectType::Arpeggio:
-						if (!isSetArpADPCM) {
-							isSetArpADPCM = true;
-							if (isPrevPos) opnaCtrl_->setArpeggioEffectADPCM(eff.value >> 4, eff.value & 0x0f);
-						}
-						break;
-					case EffectType::PortamentoUp:
-						if (!isSetPrtADPCM) {
-							isSetPrtADPCM = true;
-							if (isPrevPos) opnaCtrl_->setPortamentoEffectADPCM(eff.value);
-						}
-						break;
-					case EffectType::PortamentoDown:
-						if (!isSetPrtADPCM) {
-							isSetPrtADPCM = true;
-							if (isPrevPos) opnaCtrl_->setPortamentoEffectADPCM(-eff.value);
-						}
-						break;
-					case EffectType::TonePortamento:
-						if (!isSetPrtADPCM) {
-							isSetPrtADPCM = true;
-							if (isPrevPos) opnaCtrl_->setPortamentoEffectADPCM(eff.value, true);
-						}
-						break;
-					case EffectType::Vibrato:
-						if (!isSetVibADPCM) {
-							isSetVibADPCM = true;
-							if (isPrevPos) opnaCtrl_->setVibratoEffectADPCM(eff.value >> 4, eff.value & 0x0f);
-						}
-						break;
-					case EffectType::Tremolo:
-						if (!isSetTreADPCM) {
-							isSetTreADPCM = true;
-							if (isPrevPos) opnaCtrl_->setTremoloEffectADPCM(eff.value >> 4, eff.value & 0x0f);
-						}
-						break;
-					case EffectType::Pan:
-						if (-1 < eff.value && eff.value < 4 && !isSetPanADPCM) {
-							isSetPanADPCM = true;
-							if (isPrevPos) opnaCtrl_->setPanADPCM(eff.value);
-						}
-						break;
-					case EffectType::VolumeSlide:
-						if (!isSetVolSldADPCM) {
-							isSetVolSldADPCM = true;
-							if (isPrevPos) {
-								int hi = eff.value >> 4;
-								int low = eff.value & 0x0f;
-								if (hi && !low) opnaCtrl_->setVolumeSlideADPCM(hi, true);	// Slide up
-								else if (!hi) opnaCtrl_->setVolumeSlideADPCM(low, false);	// Slide down
-							}
-						}
-						break;
-					case EffectType::SpeedTempoChange:
-						if (!(speedStates & 0x4)) {
-							if (eff.value < 0x20 && !(speedStates & 0x1)) {	// Speed change
-								speedStates |= 0x1;
-								if (isPrevPos) effSpeedChange(eff.value);
-							}
-							else if (!(speedStates & 0x2)) {			// Tempo change
-								speedStates |= 0x2;
-								if (isPrevPos) effTempoChange(eff.value);
-							}
-						}
-						break;
-					case EffectType::Groove:
-						if (eff.value < static_cast<int>(mod_.lock()->getGrooveCount()) && !speedStates) {
-							speedStates |= 0x4;
-							if (isPrevPos) effGrooveChange(eff.value);
-						}
-						break;
-					case EffectType::Detune:
-						if (!isSetDtnADPCM) {
-							isSetDtnADPCM = true;
-							if (isPrevPos) opnaCtrl_->setDetuneADPCM(eff.value - 0x80);
-						}
-						break;
-					case EffectType::FineDetune:
-						if (!isSetFiDtnADPCM) {
-							isSetFiDtnADPCM = true;
-							if (isPrevPos) opnaCtrl_->setFineDetuneADPCM(eff.value - 0x80);
-						}
-						break;
-					default:
-						break;
-					}
-				}
-				// Tone
-				int t = step.getNoteNumber();
-				if (isPrevPos && t != -1 && t != -2) {
-					--tonesCntADPCM;
-					for (auto it2 = toneADPCM.rbegin();
-						 it2 != toneADPCM.rend(); ++it2) {
-						if (*it2 == -1 || *it2 == tonesCntADPCM) {
-							if (t >= 0) {
-								*it2 = t;
-							}
-							else if (t < -2) {
-								*it2 = tonesCntADPCM - t + 2;
-							}
-							break;
-						}
-					}
-				}
+				int op = v >> 8;
+				int val = v & 0x00ff;
+				if (0 < op && op < 5 && -1 < val && val < 32)
+					opnaCtrl_->setARControlFM(ch, op - 1, val);
+				break;
+			}
+			case Param::DRControl:
+			{
+				int op = v >> 8;
+				int val = v & 0x00ff;
+				if (0 < op && op < 5 && -1 < val && val < 32)
+					opnaCtrl_->setDRControlFM(ch, op - 1, val);
+				break;
+			}
+			case Param::RRControl:
+			{
+				int op = v >> 4;
+				int val = v & 0x0f;
+				if (0 < op && op < 5 && -1 < val && val < 16)
+					opnaCtrl_->setRRControlFM(ch, op - 1, val);
+				break;
+			}
+			case Param::Brightness:
+				if (0 < v) opnaCtrl_->setBrightnessFM(ch, v - 0x80);
+				break;
+			default:
+				break;
+			}
+			break;
+		case SoundSource::SSG:
+			switch (change.param) {
+			case Param::Volume:
+				opnaCtrl_->setVolumeSSG(ch, v);
+				break;
+			case Param::Instrument:
+				opnaCtrl_->setInstrumentSSG(
+							ch, std::dynamic_pointer_cast<InstrumentSSG>(instMan_.lock()->getInstrumentSharedPtr(v)));
+				break;
+			case Param::Arpeggio:
+				opnaCtrl_->setArpeggioEffectSSG(ch, v >> 4, v & 0x0f);
+				break;
+			case Param::Portamento:
+				if (sub == 2) opnaCtrl_->setPortamentoEffectSSG(ch, v, true);
+				else opnaCtrl_->setPortamentoEffectSSG(ch, sub ? -v : v);
+				break;
+			case Param::Vibrato:
+				opnaCtrl_->setVibratoEffectSSG(ch, v >> 4, v & 0x0f);
+				break;
+			case Param::Tremolo:
+				opnaCtrl_->setTremoloEffectSSG(ch, v >> 4, v & 0x0f);
+				break;
+			case Param::VolumeSlide:
+			{
+				int hi = v >> 4;
+				int low = v & 0x0f;
+				if (hi && !low) opnaCtrl_->setVolumeSlideSSG(ch, hi, true);	// Slide up
+				else if (!hi) opnaCtrl_->setVolumeSlideSSG(ch, low, false);	// Slide down
+				break;
+			}
+			case Param::Detune:
+				opnaCtrl_->setDetuneSSG(ch, v - 0x80);
+				break;
+			case Param::FineDetune:
+				opnaCtrl_->setFineDetuneSSG(ch, v - 0x80);
+				break;
+			case Param::ToneNoiseMix:
+				opnaCtrl_->setToneNoiseMixSSG(ch, v);
+				break;
+			// Global states
+			case Param::NoisePitch:
+				opnaCtrl_->setNoisePitchSSG(sub, v);
+				break;
+			case Param::HardEnvHighPeriod:
+				opnaCtrl_->setHardEnvelopePeriod(sub, true, v);
+				break;
+			case Param::HardEnvLowPeriod:
+				opnaCtrl_->setHardEnvelopePeriod(sub, false, v);
+				break;
+			case Param::AutoEnvelope:
+				opnaCtrl_->setAutoEnvelopeSSG(sub, (v >> 4) - 8, v & 0x0f);
+				break;
+			case Param::MasterVolume:
+				opnaCtrl_->setMasterVolumeRhythm(v);
+				break;
+			default:
+				break;
+			}
+			break;
+		case SoundSource::RHYTHM:
+			switch (change.param) {
+			case Param::Volume:
+				opnaCtrl_->setVolumeRhythm(ch, v);
+				break;
+			case Param::Pan:
+				opnaCtrl_->setPanRhythm(ch, v);
+				break;
+			default:
+				break;
+			}
+			break;
+		case SoundSource::ADPCM:
+			switch (change.param) {
+			case Param::Volume:
+				opnaCtrl_->setVolumeADPCM(v);
+				break;
+			case Param::Instrument:
+				opnaCtrl_->setInstrumentADPCM(
+							std::dynamic_pointer_cast<InstrumentADPCM>(instMan_.lock()->getInstrumentSharedPtr(v)));
+				break;
+			case Param::Arpeggio:
+				opnaCtrl_->setArpeggioEffectADPCM(v >> 4, v & 0x0f);
+				break;
+			case Param::Portamento:
+				if (sub == 2) opnaCtrl_->setPortamentoEffectADPCM(v, true);
+				else opnaCtrl_->setPortamentoEffectADPCM(sub ? -v : v);
+				break;
+			case Param::Vibrato:
+				opnaCtrl_->setVibratoEffectADPCM(v >> 4, v & 0x0f);
+				break;
+			case Param::Tremolo:
+				opnaCtrl_->setTremoloEffectADPCM(v >> 4, v & 0x0f);
+				break;
+			case Param::Pan:
+				opnaCtrl_->setPanADPCM(v);
+				break;
+			case Param::VolumeSlide:
+			{
+				int hi = v >> 4;
+				int low = v & 0x0f;
+				if (hi && !low) opnaCtrl_->setVolumeSlideADPCM(hi, true);	// Slide up
+				else if (!hi) opnaCtrl_->setVolumeSlideADPCM(low, false);	// Slide down
 				break;
 			}
+			case Param::Detune:
+				opnaCtrl_->setDetuneADPCM(v - 0x80);
+				break;
+			case Param::FineDetune:
+				opnaCtrl_->setFineDetuneADPCM(v - 0x80);
+				break;
+			default:
+				break;
 			}
+			break;
 		}
+	}
 
-		// Move position
-		isPrevPos = true;
-		if (--s < 0) {
-			if (--o < 0) break;
-			s = static_cast<int>(getPatternSizeFromOrderNumber(curSongNum_, o)) - 1;
+	// Speed, tempo and groove
+	/// bit0: step
+	/// bit1: tempo
+	/// bit2: groove
+	uint8_t speedStates = 0;
+	for (const TimelineState::TempoEvent& event : state.getTempoEvents()) {
+		switch (event.type) {
+		case TimelineState::TempoEventType::Groove:
+			if (event.value < static_cast<int>(mod_.lock()->getGrooveCount()) && !speedStates) {
+				speedStates |= 0x4;
+				if (!event.isHeld) effGrooveChange(event.value);
+			}
+			break;
+		case TimelineState::TempoEventType::Speed:
+			if (!(speedStates & 0x4) && !(speedStates & 0x1)) {
+				speedStates |= 0x1;
+				if (!event.isHeld) effSpeedChange(event.value);
+			}
+			break;
+		case TimelineState::TempoEventType::Tempo:
+			if (!(speedStates & 0x4) && !(speedStates & 0x2)) {
+				speedStates |= 0x2;
+				if (!event.isHeld) effTempoChange(event.value);
+			}
+			break;
+		case TimelineState::TempoEventType::SpeedOrTempo:
+			if (!(speedStates & 0x4)) {
+				if (!(speedStates & 0x1)) {
+					speedStates |= 0x1;
+					if (!event.isHeld) effSpeedChange(event.value);
+				}
+				else if (!(speedStates & 0x2)) {
+					speedStates |= 0x2;
+					if (!event.isHeld) effTempoChange(event.value);
+				}
+			}
+			break;
 		}
 	}
 
 	// Echo & sequence reset
-	for (size_t ch = 0; ch < fmch; ++ch) {
-		for (size_t i = 0; i < 3; ++i) {
-			if (toneFM.at(ch).at(i) >= 0) {
-				std::pair<int, Note> octNote = noteNumberToOctaveAndNote(toneFM[ch][i]);
-				opnaCtrl_->updateEchoBufferFM(static_cast<int>(ch), octNote.first, octNote.second, 0);
+	auto getEchoTones = [&](SoundSource src, int ch) {
+		// Previous tones are stored from the last slot of the echo buffer
+		const std::vector<int>& tones = state.getTones(TimelineState::toSlot(src, ch));
+		std::vector<int> echo(TimelineState::MAX_TONE_CNT, -1);
+		for (size_t i = 0; i < tones.size(); ++i) {
+			int t = tones[i];
+			int cnt = -static_cast<int>(i + 1);
+			echo[TimelineState::MAX_TONE_CNT - 1 - i] = (t >= 0) ? t : (cnt - t + 2);
+		}
+		return echo;
+	};
+	for (int ch = 0; ch < static_cast<int>(getFMChannelCount(songStyle_.type)); ++ch) {
+		for (const int t : getEchoTones(SoundSource::FM, ch)) {
+			if (t >= 0) {
+				std::pair<int, Note> octNote = noteNumberToOctaveAndNote(t);
+				opnaCtrl_->updateEchoBufferFM(ch, octNote.first, octNote.second, 0);
 			}
 		}
-		opnaCtrl_->haltSequencesFM(static_cast<int>(ch));
+		opnaCtrl_->haltSequencesFM(ch);
 	}
-	for (size_t ch = 0; ch < 3; ++ch) {
-		for (size_t i = 0; i < 3; ++i) {
-			if (toneSSG.at(ch).at(i) >= 0) {
-				std::pair<int, Note> octNote = noteNumberToOctaveAndNote(toneSSG[ch][i]);
-				opnaCtrl_->updateEchoBufferSSG(static_cast<int>(ch), octNote.first, octNote.second, 0);
+	for (int ch = 0; ch < 3; ++ch) {
+		for (const int t : getEchoTones(SoundSource::SSG, ch)) {
+			if (t >= 0) {
+				std::pair<int, Note> octNote = noteNumberToOctaveAndNote(t);
+				opnaCtrl_->updateEchoBufferSSG(ch, octNote.first, octNote.second, 0);
 			}
 		}
-		opnaCtrl_->haltSequencesSSG(static_cast<int>(ch));
+		opnaCtrl_->haltSequencesSSG(ch);
 	}
-	for (size_t i = 0; i < 3; ++i) {
-		if (toneADPCM.at(i) >= 0) {
-			std::pair<int, Note> octNote = noteNumberToOctaveAndNote(toneADPCM[i]);
+	for (const int t : getEchoTones(SoundSource::ADPCM, 0)) {
+		if (t >= 0) {
+			std::pair<int, Note> octNote = noteNumberToOctaveAndNote(t);
 			opnaCtrl_->updateEchoBufferADPCM(octNote.first, octNote.second, 0);
 		}
 	}
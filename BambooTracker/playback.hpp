@@ -29,12 +29,14 @@
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <functional>
 #include "opna_controller.hpp"
 #include "instruments_manager.hpp"
 #include "module.hpp"
 #include "tick_counter.hpp"
 #include "effect.hpp"
 #include "enum_hash.hpp"
+#include "song_timeline.hpp"
 
 struct RegisterUnit
 {
@@ -52,6 +54,7 @@ public:
 					std::weak_ptr<Module> mod, bool isRetrieveChannel);
 
 	void setSong(std::weak_ptr<Module> mod, int songNum);
+	void setInstrumentsManager(std::weak_ptr<InstrumentsManager> instMan);
 
 	// Play song
 	void startPlaySong(int order);
@@ -74,6 +77,15 @@ public:
 	void checkPlayPosition(int maxStepSize);
 
 	void setChannelRetrieving(bool enabled);
+	/// Retrieve channel states by scanning the song from the head instead of using the song timeline.
+	/// Used to verify the timeline checkpoints
+	void setChannelRetrievingByFullScan(bool enabled);
+	/// Retrieve channel states with [retriever] instead of the song timeline.
+	/// Used to verify the retrieval against another implementation
+	using ChannelRetriever = std::function<void(PlaybackManager&)>;
+	void setChannelRetriever(ChannelRetriever retriever);
+	/// Retrieval before the song timeline, defined by the timeline check
+	friend void retrieveChannelStatesByLegacyScan(PlaybackManager& pb);
 
 private:
 	std::shared_ptr<OPNAController> opnaCtrl_;
@@ -167,8 +179,10 @@ private:
 	void clearADPCMDelayBeyondStepCounts();
 	void updateDelayEventCounts();
 
-	bool isRetrieveChannel_;
+	bool isRetrieveChannel_, isRetrieveByFullScan_;
+	ChannelRetriever retriever_;
 	void retrieveChannelStates();
+	void applyTimelineState(const TimelineState& state);
 
 	size_t getOrderSize(int songNum) const;
 	size_t getPatternSizeFromOrderNumber(int songNum, int orderNum) const;
@@ -37,6 +37,9 @@ SongLengthCalculator::SongLengthCalculator(Module& mod, int songNum)
 double SongLengthCalculator::calculateBySecond() const
 {
 	Song& song = mod_.getSong(songNum_);
+	SongAnalysis& analysis = song.getAnalysis();
+	if (analysis.hasLength) return analysis.lengthBySecond;
+
 	std::unordered_set<int> visitedOrder;
 	double tickCnt = 0.;
 
@@ -59,16 +62,20 @@ double SongLengthCalculator::calculateBySecond() const
 		int maxStep = static_cast<int>(song.getPatternSizeFromOrderNumber(orderNum));
 		std::unordered_map<EffectType, int> jumpEffMap;
 		for (; stepNum < maxStep; ++stepNum) {
-			std::unordered_map<EffectType, int> speedEffMap;
+			// The last ones in the step are used
+			int speedTempoEff = -1;
+			int grooveEff = -1;
 			// Load effects
 			for (const TrackAttribute& attrib : attribs) {
 				Step& step = song.getTrack(attrib.number).getPatternFromOrderNumber(orderNum).getStep(stepNum);
 				for (int e = 0; e < 4; ++e) {
-					const Effect&& eff = Effect::makeEffectData(attrib.source, step.getEffectID(e), step.getEffectValue(e));
+					const Effect&& eff = Effect::makeEffectData(attrib.source, step.getEffectIDCode(e), step.getEffectValue(e));
 					switch (eff.type) {
 					case EffectType::SpeedTempoChange:
+						speedTempoEff = eff.value;
+						break;
 					case EffectType::Groove:
-						speedEffMap[eff.type] = eff.value;
+						grooveEff = eff.value;
 						break;
 					case EffectType::PositionJump:
 					case EffectType::SongEnd:
@@ -82,31 +89,22 @@ double SongLengthCalculator::calculateBySecond() const
 			}
 
 			// Update playback state
-			auto&& it = speedEffMap.find(EffectType::SpeedTempoChange);
-			if (it != speedEffMap.end()) {
-				if (it->second < 0x20 && speed != it->second) {
-					speed = it->second;
+			if (speedTempoEff != -1) {
+				if (speedTempoEff < 0x20 && speed != speedTempoEff) {
+					speed = speedTempoEff;
 					isTempo = true;
 					stepTicks = getStrictStepTicks(rate, tempo, speed);
 				}
-				else if (tempo != it->second) {
-					tempo = it->second;
+				else if (tempo != speedTempoEff) {
+					tempo = speedTempoEff;
 					isTempo = true;
 					stepTicks = getStrictStepTicks(rate, tempo, speed);
 				}
 			}
-			for (const auto& eff : speedEffMap) {
-				switch (eff.first) {
-				case EffectType::Groove:
-					if (eff.second < static_cast<int>(mod_.getGrooveCount())) {
-						groove = mod_.getGroove(eff.second).getSequence();
-						isTempo = false;
-						grooveIdx = 0;
-					}
-					break;
-				default:
-					break;
-				}
+			if (grooveEff != -1 && grooveEff < static_cast<int>(mod_.getGrooveCount())) {
+				groove = mod_.getGroove(grooveEff).getSequence();
+				isTempo = false;
+				grooveIdx = 0;
 			}
 
 			// Add step ticks
@@ -144,5 +142,86 @@ double SongLengthCalculator::calculateBySecond() const
 	}
 
 	// Calculate time by seconds
-	return tickCnt / rate;
+	analysis.lengthBySecond = tickCnt / rate;
+	analysis.hasLength = true;
+	return analysis.lengthBySecond;
+}
+
+void SongLengthCalculator::checkNextPositionOfLastStepAndStepSize(int& endOrder, int& endStep,
+																  size_t& nIntroStep, size_t& nLoopStep) const
+{
+	Song& song = mod_.getSong(songNum_);
+	SongAnalysis& analysis = song.getAnalysis();
+	if (analysis.hasStructure) {
+		endOrder = analysis.endOrder;
+		endStep = analysis.endStep;
+		nIntroStep = analysis.nIntroStep;
+		nLoopStep = analysis.nLoopStep;
+		return;
+	}
+
+	endOrder = 0;
+	endStep = 0;
+
+	std::vector<TrackAttribute> attribs = song.getTrackAttributes();
+	int lastOrder = static_cast<int>(song.getOrderSize()) - 1;
+	std::unordered_map<int, size_t> orderStepMap;
+	int orderN = 0;
+	size_t stepCnt = 0;
+	do {
+		endOrder = (endOrder + 1) % (lastOrder + 1);
+		endStep = 0;
+
+		int stepN = static_cast<int>(song.getPatternSizeFromOrderNumber(orderN)) - 1;
+		for (const TrackAttribute& attrib : attribs) {
+			Step& step = song.getTrack(attrib.number).getPatternFromOrderNumber(orderN).getStep(stepN);
+			for (int i = 0; i < 4; ++i) {
+				const Effect&& eff = Effect::makeEffectData(attrib.source, step.getEffectIDCode(i), step.getEffectValue(i));
+				switch (eff.type) {
+				case EffectType::PositionJump:
+					if (eff.value <= lastOrder) {
+						endOrder = eff.value;
+						endStep = 0;
+					}
+					break;
+				case EffectType::SongEnd:
+					endOrder = -1;
+					endStep = -1;
+					break;
+				case EffectType::PatternBreak:
+					if (orderN == lastOrder
+							&& eff.value < static_cast<int>(song.getPatternSizeFromOrderNumber(0))) {
+						endOrder = 0;
+						endStep = eff.value;
+					}
+					else if (eff.value < static_cast<int>(song.getPatternSizeFromOrderNumber(orderN + 1))) {
+						endOrder = orderN + 1;
+						endStep = eff.value;
+					}
+					break;
+				default:
+					break;
+				}
+			}
+		}
+
+		orderStepMap[orderN] = stepCnt;
+		stepCnt += song.getPatternSizeFromOrderNumber(orderN);
+		orderN = endOrder;
+	} while (orderN != -1 && !orderStepMap.count(orderN));	// stopped song or jumped to played order
+
+	if (orderN == -1) {
+		nIntroStep = stepCnt;
+		nLoopStep = 0;
+	}
+	else {
+		nIntroStep = orderStepMap[orderN];
+		nLoopStep = stepCnt - orderStepMap[orderN];
+	}
+
+	analysis.endOrder = endOrder;
+	analysis.endStep = endStep;
+	analysis.nIntroStep = nIntroStep;
+	analysis.nLoopStep = nLoopStep;
+	analysis.hasStructure = true;
 }
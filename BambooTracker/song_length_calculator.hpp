@@ -27,11 +27,16 @@
 
 #include "module.hpp"
 
+/// The results are cached in the song until it is changed.
 class SongLengthCalculator
 {
 public:
 	SongLengthCalculator(Module& mod, int songNum);
 	double calculateBySecond() const;
+	/// Find the position played after the last step and count steps of the intro and loop part
+	/// endOrder, endStep: -1 if the song ends without loop
+	void checkNextPositionOfLastStepAndStepSize(int& endOrder, int& endStep,
+												size_t& nIntroStep, size_t& nLoopStep) const;
 
 private:
 	Module& mod_;
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <memory>
+
+/// Lock-free single-producer/single-consumer ring.
+/// The capacity is rounded up to a power of 2.
+template <typename T>
+class SPSCQueue
+{
+public:
+	explicit SPSCQueue(size_t capacity)
+	{
+		size_t size = 1;
+		while (size < capacity) size <<= 1;
+		buf_ = std::make_unique<T[]>(size);
+		mask_ = size - 1;
+		head_.store(0);
+		tail_.store(0);
+	}
+
+	/// Producer side. Return false if the queue is full.
+	bool push(const T& item)
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail - head_.load(std::memory_order_acquire) > mask_) return false;
+		buf_[tail & mask_] = item;
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// Consumer side. Return nullptr if the queue is empty.
+	const T* front() const
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire)) return nullptr;
+		return &buf_[head & mask_];
+	}
+
+	/// Consumer side. Discard the front item.
+	void pop()
+	{
+		head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	std::unique_ptr<T[]> buf_;
+	size_t mask_;
+	std::atomic<size_t> head_, tail_;
+};
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "stem_exporter.hpp"
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include "offline_renderer.hpp"
+#include "module.hpp"
+#include "instruments_manager.hpp"
+#include "module_io.hpp"
+
+StemExporter::StemExporter(std::shared_ptr<const BinaryContainer> data, int songNum,
+						   chip::Emu emu, int duration)
+	: data_(data),
+	  songNum_(songNum),
+	  emu_(emu),
+	  duration_(duration),
+	  masterVol_(100),
+	  masterVolFM_(0),
+	  masterVolSSG_(0),
+	  storeOnlyUsedSamples_(true)
+{
+	auto mod = std::make_shared<Module>();
+	auto instMan = std::make_shared<InstrumentsManager>(false);
+	ModuleIO::loadModule(*data_, mod, instMan);
+	type_ = mod->getSong(songNum_).getStyle().type;
+
+	muteState_ = {
+		{ SoundSource::FM, std::vector<bool>(getFMChannelCount(type_), false) },
+		{ SoundSource::SSG, std::vector<bool>(3, false) },
+		{ SoundSource::RHYTHM, std::vector<bool>(6, false) },
+		{ SoundSource::ADPCM, std::vector<bool>(1, false) },
+	};
+}
+
+/********** Mixer **********/
+void StemExporter::setMuteState(SoundSource src, int chInSrc, bool isMute)
+{
+	muteState_.at(src).at(static_cast<size_t>(chInSrc)) = isMute;
+}
+
+void StemExporter::setMasterVolume(int percentage)
+{
+	masterVol_ = percentage;
+}
+
+void StemExporter::setMasterVolumeFM(double dB)
+{
+	masterVolFM_ = dB;
+}
+
+void StemExporter::setMasterVolumeSSG(double dB)
+{
+	masterVolSSG_ = dB;
+}
+
+/********** ADPCM **********/
+void StemExporter::setStoreOnlyUsedSamples(bool enabled)
+{
+	storeOnlyUsedSamples_ = enabled;
+}
+
+/********** Render **********/
+std::vector<StemExporter::Stem> StemExporter::getStems() const
+{
+	std::vector<Stem> stems = { { true, SoundSource::FM, 0, "Master" } };
+
+	const std::vector<bool>& muteFM = muteState_.at(SoundSource::FM);
+	for (size_t i = 0; i < muteFM.size(); ++i) {
+		if (muteFM[i]) continue;
+		int ch = static_cast<int>(i);
+		std::string name = "FM" + std::to_string(ch + 1);
+		if (type_ == SongType::FM3chExpanded) {
+			switch (ch) {
+			case 2:	name = "OP1";	break;
+			case 6:	name = "OP2";	break;
+			case 7:	name = "OP3";	break;
+			case 8:	name = "OP4";	break;
+			default:	break;
+			}
+		}
+		stems.push_back({ false, SoundSource::FM, ch, name });
+	}
+
+	const std::vector<bool>& muteSSG = muteState_.at(SoundSource::SSG);
+	for (size_t i = 0; i < muteSSG.size(); ++i) {
+		if (!muteSSG[i])
+			stems.push_back({ false, SoundSource::SSG, static_cast<int>(i), "SG" + std::to_string(i + 1) });
+	}
+
+	static const char* RHYTHM_NAMES[] = { "BD", "SD", "TOP", "HH", "TOM", "RIM" };
+	const std::vector<bool>& muteRhythm = muteState_.at(SoundSource::RHYTHM);
+	for (size_t i = 0; i < muteRhythm.size(); ++i) {
+		if (!muteRhythm[i])
+			stems.push_back({ false, SoundSource::RHYTHM, static_cast<int>(i), RHYTHM_NAMES[i] });
+	}
+
+	if (!muteState_.at(SoundSource::ADPCM).front())
+		stems.push_back({ false, SoundSource::ADPCM, 0, "AP" });
+
+	return stems;
+}
+
+bool StemExporter::render(const std::vector<WavWriter*>& writers, int loopCnt,
+						  std::function<bool()> bar, size_t nThreads)
+{
+	const std::vector<Stem> stems = getStems();
+	if (writers.size() != stems.size()) throw std::invalid_argument("Invalid number of WAV writers");
+	if (!nThreads) nThreads = std::max(1u, std::thread::hardware_concurrency());
+	nThreads = std::min(nThreads, stems.size());
+
+	std::atomic<size_t> next(0);
+	std::atomic_bool isCanceled(false);
+	std::mutex mutex;
+	std::condition_variable cv;
+	size_t nSteps = 0, nFinished = 0;
+	std::exception_ptr ep;
+
+	auto stepCountUp = [&] {
+		{
+			std::lock_guard<std::mutex> lg(mutex);
+			++nSteps;
+		}
+		cv.notify_one();
+		return isCanceled.load();
+	};
+	auto work = [&] {
+		for (size_t i = next++; i < stems.size(); i = next++) {
+			try {
+				renderStem(stems[i], *writers[i], loopCnt, stepCountUp);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lg(mutex);
+				if (!ep) ep = std::current_exception();
+				isCanceled.store(true);
+			}
+			{
+				std::lock_guard<std::mutex> lg(mutex);
+				++nFinished;
+			}
+			cv.notify_one();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < nThreads; ++i) workers.emplace_back(work);
+
+	// Report the progress averaged over all stems on this thread
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		size_t nReported = 0;
+		while (nFinished < stems.size()) {
+			cv.wait(lock);
+			while (nReported < nSteps / stems.size()) {
+				++nReported;
+				lock.unlock();
+				if (bar()) isCanceled.store(true);
+				lock.lock();
+			}
+		}
+	}
+	for (auto& th : workers) th.join();
+
+	if (ep) std::rethrow_exception(ep);
+	return !isCanceled.load();
+}
+
+bool StemExporter::renderStem(const Stem& stem, WavWriter& writer, int loopCnt, std::function<bool()> bar) const
+{
+	auto mod = std::make_shared<Module>();
+	auto instMan = std::make_shared<InstrumentsManager>(false);
+	ModuleIO::loadModule(*data_, mod, instMan);
+
+	OfflineRenderer renderer(*mod, instMan, songNum_, emu_, duration_);
+	renderer.setStoreOnlyUsedSamples(storeOnlyUsedSamples_);
+	renderer.assignSampleADPCMRawSamples();
+	renderer.setMasterVolume(masterVol_);
+	renderer.setMasterVolumeFM(masterVolFM_);
+	renderer.setMasterVolumeSSG(masterVolSSG_);
+	for (auto& pair : muteState_) {
+		for (size_t i = 0; i < pair.second.size(); ++i) {
+			int ch = static_cast<int>(i);
+			bool isMute = stem.isMaster ? pair.second[i]
+										: (pair.first != stem.source || ch != stem.channelInSource);
+			renderer.setMuteState(pair.first, ch, isMute);
+		}
+	}
+
+	return renderer.renderToWav(writer, loopCnt, bar);
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2020 Rerrah
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include "binary_container.hpp"
+#include "wav_writer.hpp"
+#include "chips/chip_misc.hpp"
+#include "enum_hash.hpp"
+#include "misc.hpp"
+
+/// Render the master mix and one WAV per channel of a song in a single pass.
+/// Each stem is rendered concurrently by its own chip and playback routine
+/// with every other channel muted, and streamed to its writer.
+/// Workers parse their own module and instruments from the shared module data.
+class StemExporter
+{
+public:
+	struct Stem
+	{
+		bool isMaster;
+		SoundSource source;
+		int channelInSource;
+		std::string name;	// "Master" or the track name ("FM1", "SG1", "BD", "AP", ...)
+	};
+
+	/// throw FileIOError when the module cannot be loaded
+	StemExporter(std::shared_ptr<const BinaryContainer> data, int songNum,
+				 chip::Emu emu = chip::Emu::Mame, int duration = 40);
+
+	// Mixer
+	/// Muted channels are left out of the master and get no stem
+	void setMuteState(SoundSource src, int chInSrc, bool isMute);
+	void setMasterVolume(int percentage);
+	void setMasterVolumeFM(double dB);
+	void setMasterVolumeSSG(double dB);
+
+	// ADPCM
+	void setStoreOnlyUsedSamples(bool enabled);
+
+	/// Return stems in the order of rendering, the master is the first
+	std::vector<Stem> getStems() const;
+
+	/// Render all stems, [writers] must be in the order of getStems()
+	/// [bar] called on this thread each time the song advances a step, return true to cancel
+	/// [nThreads] 0: hardware concurrency
+	/// Return false if canceled
+	bool render(const std::vector<WavWriter*>& writers, int loopCnt,
+				std::function<bool()> bar, size_t nThreads = 0);
+
+private:
+	std::shared_ptr<const BinaryContainer> data_;
+	int songNum_;
+	chip::Emu emu_;
+	int duration_;
+	SongType type_;
+	std::unordered_map<SoundSource, std::vector<bool>> muteState_;
+	int masterVol_;
+	double masterVolFM_, masterVolSSG_;
+	bool storeOnlyUsedSamples_;
+
+	bool renderStem(const Stem& stem, WavWriter& writer, int loopCnt, std::function<bool()> bar) const;
+};
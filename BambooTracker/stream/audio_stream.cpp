@@ -36,7 +36,12 @@ AudioStream::AudioStream(QObject *parent)
 	  intrCountRest_(0),
 	  gcb_(nullptr),
 	  gcbPtr_(nullptr),
-	  tuState_(-1),
+	  tucb_(nullptr),
+	  tucbPtr_(nullptr),
+	  eucb_(nullptr),
+	  eucbPtr_(nullptr),
+	  lastGenTime_(std::chrono::steady_clock::now()),
+	  tuStates_(TICK_STATE_QUEUE_SIZE_),
 	  started_(false),
 	  quitNotify_(false),
 	  tickNotifier_([this]() { tickNotifierRun(); })
@@ -64,6 +69,13 @@ void AudioStream::setTickUpdateCallback(TickUpdateCallback* cb, void* cbPtr)
 	tucbPtr_ = cbPtr;
 }
 
+void AudioStream::setEventUpdateCallback(EventUpdateCallback* cb, void* cbPtr)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	eucb_ = cb;
+	eucbPtr_ = cbPtr;
+}
+
 bool AudioStream::initialize(uint32_t rate, uint32_t duration, uint32_t intrRate,
 							 const QString& backend, const QString& device, QString* errDetail)
 {
@@ -102,11 +114,14 @@ void AudioStream::stop()
 	started_ = false;
 }
 
-void AudioStream::generate(int16_t* container, uint32_t nSamples)
+void AudioStream::generate(float* container, uint32_t nSamples)
 {
 	GenerateCallback* gcb = nullptr;
 	void* gcbPtr = nullptr;
 	TickUpdateCallback* tucb = nullptr;
+	void* tucbPtr = nullptr;
+	EventUpdateCallback* eucb = nullptr;
+	void* eucbPtr = nullptr;
 	bool started = false;
 
 	std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
@@ -114,35 +129,46 @@ void AudioStream::generate(int16_t* container, uint32_t nSamples)
 		gcb = gcb_;
 		gcbPtr = gcbPtr_;
 		tucb = tucb_;
+		tucbPtr = tucbPtr_;
+		eucb = eucb_;
+		eucbPtr = eucbPtr_;
 		started = started_;
 	}
 
+	auto now = std::chrono::steady_clock::now();
+	auto begin = lastGenTime_;
+	lastGenTime_ = now;
+
 	if (!gcb || !tucb || !started) {
-		std::fill(container, container + (nSamples << 1), 0);
+		std::fill(container, container + (nSamples << 1), 0.f);
 		return;
 	}
 
-	int16_t* destPtr = container;
-	while (nSamples) {
+	// Process all ticks in the block first.
+	// Register writes are stamped with the sample offset of their tick,
+	// and the chip applies them at that position while generating the whole block.
+	// Events queued by other threads are applied between the ticks in the same way.
+	uint32_t offset = 0;
+	while (offset < nSamples) {
 		if (!intrCountRest_) {	// Interruption
 			intrCountRest_ = intrCount_;    // Set counts to next interruption
-			generateTick();
+			if (eucb) eucb(offset, nSamples, begin, now, eucbPtr);
+			generateTick(offset, tucb, tucbPtr);
 		}
 
-		size_t count = std::min(intrCountRest_, nSamples);
-		nSamples -= count;
+		uint32_t count = std::min(intrCountRest_, nSamples - offset);
+		offset += count;
 		intrCountRest_ -= count;
-
-		gcb(destPtr, count, gcbPtr);
-
-		destPtr += (count << 1);	// Move head
 	}
+	if (eucb) eucb(nSamples, nSamples, begin, now, eucbPtr);
+
+	gcb(container, nSamples, gcbPtr);
 }
 
-void AudioStream::generateTick()
+void AudioStream::generateTick(size_t offset, TickUpdateCallback* tucb, void* tucbPtr)
 {
-	tuState_.store(tucb_(tucbPtr_));
-	tickNotifierSem_.release();
+	// Every tick is notified in order, the GUI needs the step changes (state 0)
+	if (tuStates_.push(tucb(offset, tucbPtr))) tickNotifierSem_.release();
 }
 
 void AudioStream::tickNotifierRun()
@@ -152,6 +178,10 @@ void AudioStream::tickNotifierRun()
 
 		if (quitNotify_.load()) return;
 
-		emit streamInterrupted(tuState_.load());
+		if (const int* state = tuStates_.front()) {
+			int s = *state;
+			tuStates_.pop();
+			emit streamInterrupted(s);
+		}
 	}
 }
@@ -32,7 +32,9 @@
 #include <mutex>
 #include <memory>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
+#include "spsc_queue.hpp"
 
 class AudioStream : public QObject
 {
@@ -42,12 +44,22 @@ public:
 	explicit AudioStream(QObject* parent = nullptr);
 	virtual ~AudioStream();
 
-	using GenerateCallback = void (int16_t*, size_t, void*);
+	/// Interleaved float samples, 1.0 is the 16-bit full scale
+	using GenerateCallback = void (float*, size_t, void*);
 	void setGenerateCallback(GenerateCallback* cb, void* cbPtr);
 
-	using TickUpdateCallback = int (void*);
+	/// The first argument is the sample offset of the tick in the next generated block
+	using TickUpdateCallback = int (size_t, void*);
 	void setTickUpdateCallback(TickUpdateCallback* cb, void* cbPtr);
 
+	/// Apply events queued by other threads in order with the ticks.
+	/// It is called before each tick with its sample offset, and at the end of the block
+	/// with the block size. Events that arrived in the period of the previous block
+	/// (from the third to the fourth argument) are spread over the next generated block.
+	using EventUpdateCallback = void (size_t, size_t, std::chrono::steady_clock::time_point,
+									  std::chrono::steady_clock::time_point, void*);
+	void setEventUpdateCallback(EventUpdateCallback* cb, void* cbPtr);
+
 	// duration: miliseconds
 	virtual bool initialize(uint32_t rate, uint32_t duration, uint32_t intrRate,
 							const QString& backend, const QString& device,
@@ -72,7 +84,7 @@ signals:
 
 protected:
 	static const std::string AUDIO_OUT_CLIENT_NAME;
-	void generate(int16_t* container, uint32_t nSamples);
+	void generate(float* container, uint32_t nSamples);
 
 private:
 	uint32_t rate_;
@@ -85,14 +97,20 @@ private:
 	void* gcbPtr_;
 	TickUpdateCallback* tucb_;
 	void* tucbPtr_;
-	std::atomic_int tuState_;
+	EventUpdateCallback* eucb_;
+	void* eucbPtr_;
+	std::chrono::steady_clock::time_point lastGenTime_;
+	/// Tick states passed from the stream to the notifier thread
+	SPSCQueue<int> tuStates_;
 	bool started_;
 
 	std::atomic_bool quitNotify_;
 	QSemaphore tickNotifierSem_;
 	std::thread tickNotifier_;
 
-	void generateTick();
+	static constexpr size_t TICK_STATE_QUEUE_SIZE_ = 256;
+
+	void generateTick(size_t offset, TickUpdateCallback* tucb, void* tucbPtr);
 
 	void tickNotifierRun();
 };
@@ -26,6 +26,8 @@
 #include "audio_stream_rtaudio.hpp"
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include "RtAudio/RtAudio.hpp"
 
 AudioStreamRtAudio::AudioStreamRtAudio(QObject* parent)
@@ -68,7 +70,7 @@ bool AudioStreamRtAudio::initialize(uint32_t rate, uint32_t duration, uint32_t i
 			+[](void* outputBuffer, void*, unsigned int nFrames,
 			double, RtAudioStreamStatus, void* userData) -> int {
 		auto stream = reinterpret_cast<AudioStreamRtAudio*>(userData);
-		stream->generate(static_cast<int16_t*>(outputBuffer), nFrames);
+		stream->generateToDevice(static_cast<int16_t*>(outputBuffer), nFrames);
 		return 0;
 	};
 
@@ -79,6 +81,7 @@ bool AudioStreamRtAudio::initialize(uint32_t rate, uint32_t duration, uint32_t i
 		if (errDetail) *errDetail = "";
 		isSuccessed = true;
 		rate = audio->getStreamSampleRate();	// Match to real rate (for ALSA)
+		mixBuf_.resize(bufferSize << 1);
 	}
 	catch (RtAudioError& error) {
 		error.printMessage();
@@ -89,6 +92,18 @@ bool AudioStreamRtAudio::initialize(uint32_t rate, uint32_t duration, uint32_t i
 	return isSuccessed;
 }
 
+void AudioStreamRtAudio::generateToDevice(int16_t* container, uint32_t nSamples)
+{
+	if (mixBuf_.size() < (nSamples << 1)) mixBuf_.resize(nSamples << 1);	// Not expected
+	generate(mixBuf_.data(), nSamples);
+
+	// Convert the float bus to the device format
+	const float* src = mixBuf_.data();
+	for (uint32_t i = 0, n = nSamples << 1; i < n; ++i) {
+		container[i] = static_cast<int16_t>(std::lrint(std::min(std::max(src[i] * 32768.f, -32768.f), 32767.f)));
+	}
+}
+
 void AudioStreamRtAudio::shutdown()
 {
 	if (audio_->isStreamOpen())	audio_->closeStream();
@@ -27,6 +27,7 @@
 
 #include "audio_stream.hpp"
 #include <memory>
+#include <vector>
 
 class RtAudio;
 
@@ -53,6 +54,9 @@ public:
 
 private:
 	std::unique_ptr<RtAudio> audio_;
+	std::vector<float> mixBuf_;
 
 	void setBackend(const QString& backend);
+	/// Generate on the float bus and convert it to 16-bit samples
+	void generateToDevice(int16_t* container, uint32_t nSamples);
 };
@@ -24,8 +24,15 @@
  */
 
 #include "timer.hpp"
+#include <algorithm>
+#include <cmath>
 
-Timer::Timer() {}
+Timer::Timer()
+	: time_(0),
+	  isContinue_(false)
+{
+	resetStatistics();
+}
 
 Timer::~Timer()
 {
@@ -44,13 +51,9 @@ void Timer::setInterval(const int microsec)
 
 void Timer::start()
 {
+	resetStatistics();
 	isContinue_.store(true);
-	thread_ = std::thread([&] {
-		while (isContinue_.load()) {
-			std::this_thread::sleep_for(std::chrono::microseconds(time_.load()));
-			func_();
-		}
-	});
+	thread_ = std::thread([this] { run(); });
 }
 
 void Timer::stop()
@@ -60,3 +63,57 @@ void Timer::stop()
 		thread_.join();
 	}
 }
+
+Timer::Statistics Timer::getStatistics() const
+{
+	std::lock_guard<std::mutex> lock(statsMutex_);
+	Statistics stats = { nTicks_, nSkippedTicks_, 0., maxLatency_, 0. };
+	if (nTicks_) {
+		stats.meanLatency = latencySum_ / nTicks_;
+		stats.jitter = std::sqrt(std::max(0., latencySqSum_ / nTicks_ - stats.meanLatency * stats.meanLatency));
+	}
+	return stats;
+}
+
+void Timer::resetStatistics()
+{
+	std::lock_guard<std::mutex> lock(statsMutex_);
+	nTicks_ = 0;
+	nSkippedTicks_ = 0;
+	latencySum_ = 0.;
+	latencySqSum_ = 0.;
+	maxLatency_ = 0.;
+}
+
+void Timer::run()
+{
+	using Clock = std::chrono::steady_clock;
+
+	Clock::time_point deadline = Clock::now();
+	while (isContinue_.load()) {
+		std::chrono::microseconds interval(std::max(1, time_.load()));
+		deadline += interval;
+		std::this_thread::sleep_until(deadline);
+		if (!isContinue_.load()) break;
+
+		auto late = Clock::now() - deadline;
+		uint64_t skipped = 0;
+		if (late > interval * MAX_CATCH_UP_TICKS_) {
+			// Give up catching up and restart from the current time
+			skipped = static_cast<uint64_t>(late / interval);
+			deadline += interval * skipped;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(statsMutex_);
+			double latency = std::chrono::duration<double, std::micro>(late).count();
+			++nTicks_;
+			nSkippedTicks_ += skipped;
+			latencySum_ += latency;
+			latencySqSum_ += latency * latency;
+			maxLatency_ = std::max(maxLatency_, latency);
+		}
+
+		func_();
+	}
+}
@@ -29,10 +29,26 @@
 #include <chrono>
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <cstdint>
 
+/// Call the function periodically on its own thread.
+/// Each call is scheduled at an absolute deadline so that processing time does not accumulate.
 class Timer
 {
 public:
+	/// Lateness of the calls from their deadlines in microseconds
+	struct Statistics
+	{
+		uint64_t ticks;
+		/// Ticks dropped to resynchronize after a long stall
+		uint64_t skippedTicks;
+		double meanLatency;
+		double maxLatency;
+		/// Standard deviation of the latency
+		double jitter;
+	};
+
 	Timer();
 	~Timer();
 
@@ -42,9 +58,21 @@ public:
 	void start();
 	void stop();
 
+	Statistics getStatistics() const;
+	void resetStatistics();
+
 private:
 	std::atomic<int> time_;
 	std::function<void()> func_;
 	std::thread thread_;
 	std::atomic_bool isContinue_;
+
+	mutable std::mutex statsMutex_;
+	uint64_t nTicks_, nSkippedTicks_;
+	double latencySum_, latencySqSum_, maxLatency_;
+
+	/// Late ticks are called back to back up to this count, and the rest are skipped
+	static constexpr int MAX_CATCH_UP_TICKS_ = 4;
+
+	void run();
 };